@@ -223,11 +223,13 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             cacheRow(i);
         }
     }
+    vector<int> blockRows, indexReverse(numRows, -1);
     for (int startrow = 0; startrow < numRows; startrow += numCacheRows)
     {
         int endrow = startrow + numCacheRows;
         if (endrow > numRows) endrow = numRows;
         outRows.resize(endrow - startrow);
+        blockRows.resize(endrow - startrow);
         for (int i = startrow; i < endrow; ++i)
         {
             if (!cacheFullInput)
@@ -238,41 +240,14 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             {
                 outRows[i - startrow] = CaretArray<float>(numRows);
             }
+            blockRows[i - startrow] = i;
+            indexReverse[i] = i - startrow;
         }
-        int curRow = 0;//because we can't trust the order threads hit the critical section
-#pragma omp CARET_PARFOR schedule(dynamic)
-        for (int i = 0; i < numRows; ++i)
-        {
-            float movingRrs;
-            int myrow;
-            const float* movingRow;
-#pragma omp critical
-            {//CiftiFile may explode if we request multiple rows concurrently (needs mutexes), but we should force sequential requests anyway
-                myrow = curRow;//so, manually force it to read sequentially
-                ++curRow;
-                movingRow = getRow(myrow, movingRrs);
-            }
-            for (int j = startrow; j < endrow; ++j)
-            {
-                if (myrow >= startrow && myrow < endrow)//check whether we are in the output memory area
-                {
-                    if (j >= myrow)//if so, only compute one half, and store both places
-                    {
-                        float cacheRrs;
-                        const float* cacheRow = getRow(j, cacheRrs, true);
-                        outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                        outRows[myrow - startrow][j] = outRows[j - startrow][myrow];
-                    }
-                } else {
-                    float cacheRrs;
-                    const float* cacheRow = getRow(j, cacheRrs, true);
-                    outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                }
-            }
-        }
+        correlateBlock(blockRows, indexReverse, outRows, fisherZ);
         for (int i = startrow; i < endrow; ++i)
         {
             myCiftiOut->setRow(outRows[i - startrow], i);
+            indexReverse[i] = -1;
         }
         if (!cacheFullInput)
         {
@@ -409,13 +384,13 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             cacheRow(i);
         }
     }
-    CaretArray<int> indexReverse(numRows, -1);
+    vector<int> blockRows, indexReverse(numRows, -1);
     for (int startrow = 0; startrow < numSelected; startrow += numCacheRows)
     {
         int endrow = startrow + numCacheRows;
         if (endrow > numSelected) endrow = numSelected;
         outRows.resize(endrow - startrow);
-        int curRow = 0;//because we can't trust the order threads hit the critical section
+        blockRows.resize(endrow - startrow);
         for (int i = startrow; i < endrow; ++i)
         {
             if (!cacheFullInput)
@@ -426,38 +401,10 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             {
                 outRows[i - startrow] = CaretArray<float>(numRows);
             }
-            indexReverse[ciftiIndexList[i].first] = i;
-        }
-#pragma omp CARET_PARFOR schedule(dynamic)
-        for (int i = 0; i < numRows; ++i)
-        {
-            float movingRrs;
-            int myrow;
-            const float* movingRow;
-#pragma omp critical
-            {//CiftiFile may explode if we request multiple rows concurrently (needs mutexes), but we should force sequential requests anyway
-                myrow = curRow;//so, manually force it to read sequentially
-                ++curRow;
-                movingRow = getRow(myrow, movingRrs);
-            }
-            for (int j = startrow; j < endrow; ++j)
-            {
-                if (indexReverse[myrow] != -1)//check if we are on a row that is in the output memory range
-                {
-                    if (indexReverse[myrow] <= j)//if so, only compute one of the elements, then store it both places
-                    {
-                        float cacheRrs;
-                        const float* cacheRow = getRow(ciftiIndexList[j].first, cacheRrs, true);
-                        outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                        outRows[indexReverse[myrow] - startrow][ciftiIndexList[j].first] = outRows[j - startrow][myrow];
-                    }
-                } else {
-                    float cacheRrs;
-                    const float* cacheRow = getRow(ciftiIndexList[j].first, cacheRrs, true);
-                    outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                }
-            }
+            blockRows[i - startrow] = ciftiIndexList[i].first;
+            indexReverse[ciftiIndexList[i].first] = i - startrow;
         }
+        correlateBlock(blockRows, indexReverse, outRows, fisherZ);
         for (int i = startrow; i < endrow; ++i)
         {
             myCiftiOut->setRow(outRows[i - startrow], ciftiIndexList[i].second);
@@ -517,30 +464,98 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
     AlgorithmCiftiCorrelation(myProgObj, myCifti, myCiftiOut, leftRoiPtr, rightRoiPtr, cerebRoiPtr, volRoiPtr, weights, fisherZ, memLimitGB, noDemean, covariance);//HACK: pass through our progress object
 }
 
-float AlgorithmCiftiCorrelation::correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const bool& fisherZ)
+void AlgorithmCiftiCorrelation::correlateBlock(const vector<int>& blockRows, const vector<int>& indexReverse, vector<CaretArray<float> >& outRows, const bool& fisherZ)
+{//tiled version of the row by row scan: a panel of moving rows is multiplied against tiles of the cached block rows, so each tile is reused from cache for the whole panel
+    int numRows = m_inputCifti->getNumberOfRows(), blockSize = (int)blockRows.size();
+    int rowLength = m_numCols;
+    if (m_weightedMode) rowLength = (int)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
+    vector<const float*> blockPtrs(blockSize);
+    vector<float> blockRrs(blockSize);
+    for (int b = 0; b < blockSize; ++b)
+    {
+        blockPtrs[b] = getRow(blockRows[b], blockRrs[b], true);
+    }
+    int numPanels = (numRows + m_panelRows - 1) / m_panelRows;
+    int curRow = 0;//because we can't trust the order threads hit the critical section
+    const bool parallelRead = m_inputCifti->hasParallelRowIO();//memory, mmap, or pread: no need to funnel reads through one thread
+#pragma omp CARET_PAR
+    {
+        vector<float> panelScratch((int64_t)m_panelRows * m_numCols);//rows that aren't cached get read into here
+        vector<const float*> panelPtrs(m_panelRows);
+        vector<float> panelRrs(m_panelRows);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int panel = 0; panel < numPanels; ++panel)
+        {
+            int panelStart, panelCount;
+#pragma omp critical
+            {//when reads serialize on a lock anyway (compressed file), keep requests sequential so we don't seek backwards
+                panelStart = curRow;//so, manually force it to read sequentially
+                panelCount = min(m_panelRows, numRows - panelStart);
+                curRow += panelCount;
+                if (!parallelRead)
+                {
+                    for (int p = 0; p < panelCount; ++p)
+                    {
+                        panelPtrs[p] = getRowInto(panelStart + p, panelScratch.data() + (int64_t)p * m_numCols, panelRrs[p]);
+                    }
+                }
+            }
+            if (parallelRead)
+            {//panels are still claimed in order, so the file is read roughly front to back
+                for (int p = 0; p < panelCount; ++p)
+                {
+                    panelPtrs[p] = getRowInto(panelStart + p, panelScratch.data() + (int64_t)p * m_numCols, panelRrs[p]);
+                }
+            }
+            for (int tileStart = 0; tileStart < blockSize; tileStart += m_panelRows)
+            {
+                int tileEnd = min(tileStart + m_panelRows, blockSize);
+                for (int p = 0; p < panelCount; ++p)
+                {
+                    int myrow = panelStart + p;
+                    int myReverse = indexReverse[myrow];
+                    for (int b = tileStart; b < tileEnd; ++b)
+                    {
+                        if (myReverse != -1)//check whether we are on a row that is in the output memory area
+                        {
+                            if (myReverse <= b)//if so, only compute one half, and store both places
+                            {
+                                double accum = dsdot(panelPtrs[p], blockPtrs[b], rowLength);
+                                outRows[b][myrow] = finishCorrelation(accum, panelRrs[p], blockRrs[b], myrow == blockRows[b], fisherZ);
+                                outRows[myReverse][blockRows[b]] = outRows[b][myrow];
+                            }
+                        } else {
+                            double accum = dsdot(panelPtrs[p], blockPtrs[b], rowLength);
+                            outRows[b][myrow] = finishCorrelation(accum, panelRrs[p], blockRrs[b], false, fisherZ);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+float AlgorithmCiftiCorrelation::finishCorrelation(const double& accum, const float& rrs1, const float& rrs2, const bool& sameRow, const bool& fisherZ)
 {
     double r;
-    if (row1 == row2 && !m_covariance)
+    if (sameRow && !m_covariance)
     {
         r = 1.0;//short circuit for same row
     } else {
         if (m_weightedMode)
         {
-            int numWeights = (int)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
-            double accum = dsdot(row1, row2, numWeights);//these have already had the weighted row means subtracted out, and weights applied
             if (m_covariance)
             {
                 if (m_binaryWeights)
                 {
-                    r = accum / numWeights;
+                    r = accum / m_weightIndexes.size();
                 } else {
                     r = accum / rrs1;//NOTE: will equal rrs2 as it only depends on weights, and is not square root
                 }
             } else {
-                r = accum / (rrs1 * rrs2);//as do these
+                r = accum / (rrs1 * rrs2);
             }
         } else {
-            double accum = dsdot(row1, row2, m_numCols);//these have already had the row means subtracted out
             if (m_covariance)
             {
                 r = accum / m_numCols;
@@ -605,6 +620,11 @@ void AlgorithmCiftiCorrelation::init(const CiftiFile* input, const vector<float>
     } else {
         m_weightedMode = false;
     }
+    int rowLength = m_numCols;
+    if (m_weightedMode) rowLength = (int)m_weightIndexes.size();
+    const int64_t tileBytes = 128 * 1024;//a panel and a tile of the block should both fit in a typical L2 cache
+    int64_t rowBytes = max(rowLength, 1) * sizeof(float);
+    m_panelRows = (int)max((int64_t)1, min((int64_t)64, tileBytes / rowBytes));
 }
 
 void AlgorithmCiftiCorrelation::cacheRow(const int& ciftiIndex)
@@ -640,25 +660,36 @@ void AlgorithmCiftiCorrelation::clearCache()
 
 const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached)
 {
-    float* ret;
     CaretAssertVectorIndex(m_rowInfo, ciftiIndex);
-    if (m_rowInfo[ciftiIndex].m_cacheIndex != -1)
+    if (m_rowInfo[ciftiIndex].m_cacheIndex == -1)
     {
-        ret = m_rowCache[m_rowInfo[ciftiIndex].m_cacheIndex].m_row.data();
-    } else {
         CaretAssert(!mustBeCached);
         if (mustBeCached)//largely so it doesn't give warning about unused when compiled in release
         {
             throw AlgorithmException("something very bad happened, notify the developers");
         }
-        ret = getTempRow();
-        m_inputCifti->getRow(ret, ciftiIndex);
+        return getRowInto(ciftiIndex, getTempRow(), rootResidSqr);
+    }
+    return getRowInto(ciftiIndex, NULL, rootResidSqr);
+}
+
+const float* AlgorithmCiftiCorrelation::getRowInto(const int& ciftiIndex, float* scratch, float& rootResidSqr)
+{//returns the cached row if there is one, otherwise reads and demeans the row into scratch, which must hold m_numCols floats
+    const float* ret;
+    CaretAssertVectorIndex(m_rowInfo, ciftiIndex);
+    if (m_rowInfo[ciftiIndex].m_cacheIndex != -1)
+    {
+        ret = m_rowCache[m_rowInfo[ciftiIndex].m_cacheIndex].m_row.data();
+    } else {
+        CaretAssert(scratch != NULL);
+        m_inputCifti->getRow(scratch, ciftiIndex);
         if (!m_rowInfo[ciftiIndex].m_haveCalculated)
         {
-            computeRowStats(ret, m_rowInfo[ciftiIndex].m_mean, m_rowInfo[ciftiIndex].m_rootResidSqr);
+            computeRowStats(scratch, m_rowInfo[ciftiIndex].m_mean, m_rowInfo[ciftiIndex].m_rootResidSqr);
             m_rowInfo[ciftiIndex].m_haveCalculated = true;
         }
-        doSubtract(ret, m_rowInfo[ciftiIndex].m_mean);
+        doSubtract(scratch, m_rowInfo[ciftiIndex].m_mean);
+        ret = scratch;
     }
     rootResidSqr = m_rowInfo[ciftiIndex].m_rootResidSqr;
     return ret;
@@ -710,7 +741,7 @@ void AlgorithmCiftiCorrelation::computeRowStats(const float* row, float& mean, f
             {
                 accum += m_weights[i];
             }
-            rootResidSqr = accum;//repurpose this variable to store the weight sum - NOTE: don't take sqrt in case negative sum (whatever that means), so must not divide by both in correlate() in covariance mode
+            rootResidSqr = accum;//repurpose this variable to store the weight sum - NOTE: don't take sqrt in case negative sum (whatever that means), so must not divide by both in finishCorrelation() in covariance mode
         }
     } else {
         if (m_weightedMode)
@@ -800,9 +831,9 @@ int AlgorithmCiftiCorrelation::numRowsForMem(const float& memLimitGB, bool& cach
     int64_t targetBytes = (int64_t)(memLimitGB * 1024 * 1024 * 1024);
     if (m_inputCifti->isInMemory()) targetBytes -= numRows * m_numCols * 4;//count in-memory input against the total too
 #ifdef CARET_OMP
-    targetBytes -= inrowBytes * omp_get_max_threads();
+    targetBytes -= (int64_t)inrowBytes * m_panelRows * omp_get_max_threads();
 #else
-    targetBytes -= inrowBytes;//1 row in memory that isn't a reference to cache
+    targetBytes -= (int64_t)inrowBytes * m_panelRows;//1 panel of rows in memory that aren't references to cache
 #endif
     targetBytes -= numRows * sizeof(RowInfo);//storage for mean, stdev, and info about caching
     int64_t perRowBytes = inrowBytes + outrowBytes;//cache and memory collation for output rows
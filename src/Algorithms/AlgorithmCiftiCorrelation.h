@@ -54,14 +54,17 @@ namespace caret {
         bool m_binaryWeights, m_weightedMode, m_noDemean, m_covariance;
         int m_cacheUsed;//reuse cache entries instead of reallocating them
         int m_numCols;
+        int m_panelRows;//number of rows in a tile for the blocked multiply, chosen so two tiles fit in L2
         const CiftiFile* m_inputCifti;//so that accesses work through the cache functions
         void cacheRow(const int& ciftiIndex);
         void computeRowStats(const float* row, float& mean, float& rootResidSqr);
         void doSubtract(float* row, const float& mean);
         void clearCache();
         const float* getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached = false);
+        const float* getRowInto(const int& ciftiIndex, float* scratch, float& rootResidSqr);
         float* getTempRow();
-        float correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const bool& fisherZ);
+        float finishCorrelation(const double& accum, const float& rrs1, const float& rrs2, const bool& sameRow, const bool& fisherZ);
+        void correlateBlock(const std::vector<int>& blockRows, const std::vector<int>& indexReverse, std::vector<CaretArray<float> >& outRows, const bool& fisherZ);
         void init(const CiftiFile* input, const std::vector<float>* weights, const bool& noDemean, const bool& covariance);
         int numRowsForMem(const float& memLimitGB, bool& cacheFullInput);
     protected:
@@ -21,6 +21,7 @@
 #include "AlgorithmCiftiParcellate.h"
 #include "AlgorithmException.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
@@ -29,6 +30,7 @@
 #include "ReductionOperation.h"
 #include "SurfaceFile.h"
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 
@@ -52,7 +54,7 @@ OperationParameters* AlgorithmCiftiParcellate::getParameters()
     
     ret->addCiftiParameter(2, "cifti-label", "a cifti label file to use for the parcellation");
     
-    ret->addStringParameter(3, "direction", "which mapping to parcellate (integer, ROW, or COLUMN)");
+    ret->addStringParameter(3, "direction", "which mapping to parcellate (integer, ROW, COLUMN, or BOTH)");
     
     ret->addCiftiOutputParameter(4, "cifti-out", "output cifti file");
     
@@ -97,7 +99,9 @@ OperationParameters* AlgorithmCiftiParcellate::getParameters()
         "If -legacy-mode is specified, parcels will be defined as the overlap between a label and the data, with no errors for missing data vertices or voxels, and empty parcels discarded.  " +
         CiftiXML::directionFromStringExplanation() + "  " +
         "For dtseries or dscalar, use COLUMN.  " +
-        "If you are parcellating a dconn in both directions, parcellating by ROW first will use much less memory.\n\n" +
+        "If you are parcellating a dconn in both directions, parcellating by ROW first will use much less memory.  " +
+        "Alternatively, specify BOTH as the direction to parcellate a dconn into a pconn in a single pass over the input, this only supports MEAN and SUM, " +
+        "and can't be used with weights, outlier exclusion, -only-numeric, or -nonempty-mask-out.\n\n" +
         "The parameter to the -method option must be one of the following:\n\n" + ReductionOperation::getHelpInfo() +
         "\nThe -*-weights options are mutually exclusive and may only be used with MEAN (default), SUM, STDEV, SAMPSTDEV, VARIANCE, MEDIAN, or MODE (default for label data)."
     );
@@ -108,7 +112,13 @@ void AlgorithmCiftiParcellate::useParameters(OperationParameters* myParams, Prog
 {
     CiftiFile* myCiftiIn = myParams->getCifti(1);
     CiftiFile* myCiftiLabel = myParams->getCifti(2);
-    int direction = CiftiXML::directionFromString(myParams->getString(3));
+    AString directionString = myParams->getString(3);
+    bool bothDirections = (directionString == "BOTH");
+    int direction = CiftiXML::ALONG_COLUMN;
+    if (!bothDirections)
+    {
+        direction = CiftiXML::directionFromString(directionString);
+    }
     CiftiFile* myCiftiOut = myParams->getOutputCifti(4);
     const CiftiXML& myXML = myCiftiIn->getCiftiXML();
     vector<int64_t> dims = myXML.getDimensions();
@@ -161,6 +171,10 @@ void AlgorithmCiftiParcellate::useParameters(OperationParameters* myParams, Prog
     {
         throw AlgorithmException("only one of -spatial-weights and -cifti-weights may be specified");
     }
+    if (bothDirections && (spatialWeightOpt->m_present || ciftiWeightOpt->m_present))
+    {
+        throw AlgorithmException("weights can't be used when parcellating both directions");
+    }
     if (spatialWeightOpt->m_present)
     {
         if (direction >= myXML.getNumberOfDimensions()) throw AlgorithmException("input cifti file does not have the specified dimension");
@@ -234,29 +248,203 @@ void AlgorithmCiftiParcellate::useParameters(OperationParameters* myParams, Prog
     }
     AlgorithmCiftiParcellate(myProgObj, myCiftiIn, myCiftiLabel, direction, myCiftiOut,
                              method, excludeLow, excludeHigh, onlyNumeric,
-                             legacyMode, emptyFillValue, emptyMaskOut);
+                             legacyMode, emptyFillValue, emptyMaskOut, bothDirections);
+}
+
+namespace
+{
+    ///parcel membership as compressed sparse rows, built once from indexToParcel so every reduction walks only the members of each parcel
+    struct ParcelMembership
+    {
+        vector<int64_t> m_start;//numParcels + 1 offsets into m_members
+        vector<int64_t> m_members;//ascending within each parcel, the same order values were collected in before
+        ParcelMembership(const vector<int>& indexToParcel, const int& numParcels) : m_start(numParcels + 1, 0)
+        {
+            int64_t numIndices = (int64_t)indexToParcel.size();
+            for (int64_t i = 0; i < numIndices; ++i)
+            {
+                int parcel = indexToParcel[i];
+                CaretAssert(parcel > -2 && parcel < numParcels);
+                if (parcel != -1)
+                {
+                    ++m_start[parcel + 1];
+                }
+            }
+            for (int p = 0; p < numParcels; ++p)
+            {
+                m_start[p + 1] += m_start[p];
+            }
+            m_members.resize(m_start[numParcels]);
+            vector<int64_t> nextPos(m_start.begin(), m_start.end() - 1);
+            for (int64_t i = 0; i < numIndices; ++i)
+            {
+                int parcel = indexToParcel[i];
+                if (parcel != -1)
+                {
+                    m_members[nextPos[parcel]++] = i;
+                }
+            }
+        }
+        int64_t getCount(const int& parcel) const { return m_start[parcel + 1] - m_start[parcel]; }
+        const int64_t* getMembers(const int& parcel) const { return m_members.data() + m_start[parcel]; }
+    };
+    
+    //MEAN and SUM don't need the values gathered, the membership is applied as a sparse product instead
+    bool isSumReduction(const ReductionEnum::Enum& method, const bool& isLabel, const float& excludeLow, const float& excludeHigh, const bool& onlyNumeric)
+    {
+        return (method == ReductionEnum::MEAN || method == ReductionEnum::SUM) && !isLabel && !(excludeLow > 0.0f && excludeHigh > 0.0f) && !onlyNumeric;
+    }
+    
+    float reduceParcelValues(const float* data, const int64_t& numElems, const ReductionEnum::Enum& method, const float& excludeLow, const float& excludeHigh, const bool& onlyNumeric)
+    {
+        if (excludeLow > 0.0f && excludeHigh > 0.0f)
+        {
+            return ReductionOperation::reduceExcludeDev(data, numElems, method, excludeLow, excludeHigh);
+        }
+        if (onlyNumeric)
+        {
+            return ReductionOperation::reduceOnlyNumeric(data, numElems, method);
+        }
+        return ReductionOperation::reduce(data, numElems, method);
+    }
+    
+    int64_t getRowsPerBlock(const int64_t& rowLength)
+    {
+        return max((int64_t)1, ((int64_t)1 << 24) / max((int64_t)1, rowLength));//keep blocks of input rows around 64MB
+    }
+    
+    void doBothDirectionParcellation(const CiftiFile* myCiftiIn, const CiftiFile* myCiftiLabel, CiftiFile* myCiftiOut, const ReductionEnum::Enum& method,
+                                     const bool& legacyMode, const float& emptyFillVal)
+    {
+        const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
+        if (myInputXML.getNumberOfDimensions() != 2 ||
+            myInputXML.getMappingType(CiftiXML::ALONG_ROW) != CiftiMappingType::BRAIN_MODELS ||
+            myInputXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS)
+        {
+            throw AlgorithmException("parcellating both directions requires an input with brain models along both dimensions (dconn)");
+        }
+        if (method != ReductionEnum::MEAN && method != ReductionEnum::SUM)
+        {
+            throw AlgorithmException("parcellating both directions only supports MEAN and SUM, parcellate by ROW and then COLUMN for other methods");
+        }
+        const CiftiBrainModelsMap& labelDense = myCiftiLabel->getCiftiXML().getBrainModelsMap(CiftiXML::ALONG_COLUMN);
+        vector<int> indexToParcel[2];
+        CiftiXML myOutXML = myInputXML;
+        for (int dir = 0; dir < 2; ++dir)
+        {
+            const CiftiBrainModelsMap& inputDense = myInputXML.getBrainModelsMap(dir);
+            if (inputDense.hasVolumeData() && labelDense.hasVolumeData() && !inputDense.getVolumeSpace().matches(labelDense.getVolumeSpace()))
+            {
+                throw AlgorithmException("input cifti files must have the same volume space");
+            }
+            CiftiParcelsMap outParcelMap = AlgorithmCiftiParcellate::parcellateMapping(myCiftiLabel, inputDense, indexToParcel[dir], legacyMode);
+            if (outParcelMap.getLength() < 1)
+            {
+                throw AlgorithmException("no parcels found, output file would be empty, aborting");
+            }
+            myOutXML.setMap(dir, outParcelMap);
+        }
+        myCiftiOut->setCiftiXML(myOutXML);
+        int numRowParcels = myOutXML.getDimensionLength(CiftiXML::ALONG_ROW), numColumnParcels = myOutXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+        ParcelMembership rowMembership(indexToParcel[CiftiXML::ALONG_ROW], numRowParcels), columnMembership(indexToParcel[CiftiXML::ALONG_COLUMN], numColumnParcels);
+        int64_t numCols = myInputXML.getDimensionLength(CiftiXML::ALONG_ROW), numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+        vector<double> parcelSums((int64_t)numColumnParcels * numRowParcels, 0.0);
+        const int64_t rowsPerBlock = getRowsPerBlock(numCols);
+        vector<int64_t> blockRows;
+        vector<float> blockIn;
+        vector<double> blockOut;
+        int64_t nextRow = 0;
+        while (nextRow < numRows)
+        {//one pass over the input: reduce each row into row parcels, then add it into its column parcel
+            blockRows.clear();
+            for (; nextRow < numRows && (int64_t)blockRows.size() < rowsPerBlock; ++nextRow)
+            {
+                if (indexToParcel[CiftiXML::ALONG_COLUMN][nextRow] != -1)
+                {
+                    blockRows.push_back(nextRow);
+                }
+            }
+            int64_t numBlockRows = (int64_t)blockRows.size();
+            blockIn.resize(numBlockRows * numCols);
+            blockOut.resize(numBlockRows * numRowParcels);
+            for (int64_t r = 0; r < numBlockRows; ++r)
+            {
+                myCiftiIn->getRow(blockIn.data() + r * numCols, blockRows[r]);
+            }
+#pragma omp CARET_PARFOR schedule(dynamic)
+            for (int64_t r = 0; r < numBlockRows; ++r)
+            {
+                const float* inRow = blockIn.data() + r * numCols;
+                double* outRow = blockOut.data() + r * numRowParcels;
+                for (int q = 0; q < numRowParcels; ++q)
+                {
+                    int64_t count = rowMembership.getCount(q);
+                    const int64_t* members = rowMembership.getMembers(q);
+                    double sum = 0.0;
+                    for (int64_t k = 0; k < count; ++k)
+                    {
+                        sum += inRow[members[k]];
+                    }
+                    outRow[q] = sum;
+                }
+            }
+            for (int64_t r = 0; r < numBlockRows; ++r)
+            {//add in row order, so the result doesn't depend on thread count
+                double* sumRow = parcelSums.data() + (int64_t)indexToParcel[CiftiXML::ALONG_COLUMN][blockRows[r]] * numRowParcels;
+                const double* blockRow = blockOut.data() + r * numRowParcels;
+                for (int q = 0; q < numRowParcels; ++q)
+                {
+                    sumRow[q] += blockRow[q];
+                }
+            }
+        }
+        vector<float> scratchOutRow(numRowParcels);
+        for (int p = 0; p < numColumnParcels; ++p)
+        {
+            int64_t columnCount = columnMembership.getCount(p);
+            for (int q = 0; q < numRowParcels; ++q)
+            {
+                int64_t count = columnCount * rowMembership.getCount(q);
+                if (count > 0)
+                {
+                    double sum = parcelSums[(int64_t)p * numRowParcels + q];
+                    scratchOutRow[q] = (method == ReductionEnum::MEAN ? sum / count : sum);
+                } else {
+                    scratchOutRow[q] = emptyFillVal;
+                }
+            }
+            myCiftiOut->setRow(scratchOutRow.data(), p);
+        }
+    }
 }
 
 AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const CiftiFile* myCiftiLabel, const int& direction, CiftiFile* myCiftiOut,
                                                    const ReductionEnum::Enum& method, const float& excludeLow, const float& excludeHigh, const bool& onlyNumeric,
-                                                   const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut) : AbstractAlgorithm(myProgObj)
+                                                   const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut, const bool& bothDirections) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     CaretAssert(direction >= 0);
     const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
     const CiftiXML& myLabelXML = myCiftiLabel->getCiftiXML();
     vector<int64_t> dims = myInputXML.getDimensions();
-    if (direction >= (int)dims.size()) throw AlgorithmException("specified direction doesn't exist in input file");
-    if (myInputXML.getMappingType(direction) != CiftiMappingType::BRAIN_MODELS)
-    {
-        throw AlgorithmException("input cifti file does not have brain models mapping type in specified direction");
-    }
     if (myLabelXML.getNumberOfDimensions() != 2 ||
         myLabelXML.getMappingType(CiftiXML::ALONG_ROW) != CiftiMappingType::LABELS ||
         myLabelXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS)
     {
         throw AlgorithmException("input cifti label file has the wrong mapping types");
     }
+    if (bothDirections)
+    {
+        if (excludeLow > 0.0f || excludeHigh > 0.0f || onlyNumeric) throw AlgorithmException("outlier exclusion and -only-numeric are not supported when parcellating both directions");
+        if (emptyMaskOut != NULL) throw AlgorithmException("-nonempty-mask-out is not supported when parcellating both directions");
+        doBothDirectionParcellation(myCiftiIn, myCiftiLabel, myCiftiOut, method, legacyMode, emptyFillVal);
+        return;
+    }
+    if (direction >= (int)dims.size()) throw AlgorithmException("specified direction doesn't exist in input file");
+    if (myInputXML.getMappingType(direction) != CiftiMappingType::BRAIN_MODELS)
+    {
+        throw AlgorithmException("input cifti file does not have brain models mapping type in specified direction");
+    }
     const CiftiBrainModelsMap& inputDense = myInputXML.getBrainModelsMap(direction);
     const CiftiBrainModelsMap& labelDense = myLabelXML.getBrainModelsMap(CiftiXML::ALONG_COLUMN);
     if (inputDense.hasVolumeData())
@@ -278,16 +466,7 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
     myCiftiOut->setCiftiXML(myOutXML);
     int64_t numCols = myInputXML.getDimensionLength(CiftiXML::ALONG_ROW);
     vector<float> scratchRow(numCols);
-    vector<int64_t> parcelCounts(numParcels, 0);
-    for (int64_t j = 0; j < (int64_t)indexToParcel.size(); ++j)
-    {
-        int parcel = indexToParcel[j];
-        CaretAssert(parcel > -2 && parcel < numParcels);
-        if (parcel != -1)
-        {
-            ++parcelCounts[parcel];
-        }
-    }
+    ParcelMembership membership(indexToParcel, numParcels);
     if (emptyMaskOut != NULL)
     {
         CiftiXML maskOutXML;
@@ -301,7 +480,7 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
         vector<float> emptyMaskData(numParcels, 1.0f);
         for (int i = 0; i < numParcels; ++i)
         {
-            if (parcelCounts[i] == 0)
+            if (membership.getCount(i) == 0)
             {
                 emptyMaskData[i] = 0.0f;
             }
@@ -323,72 +502,108 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
     {
         CaretLogWarning(ReductionEnum::toName(method) + " reduction requested while parcellating label data");
     }
+    const bool sumReduction = isSumReduction(method, isLabel, excludeLow, excludeHigh, onlyNumeric);
     if (direction == CiftiXML::ALONG_ROW)
     {
-        vector<float> scratchOutRow(numParcels);
-        vector<vector<float> > parcelData(numParcels);//float so we can use ReductionOperation
-        for (int j = 0; j < numParcels; ++j)
-        {
-            parcelData[j].reserve(parcelCounts[j]);
-        }
-        for (MultiDimIterator<int64_t> iter(vector<int64_t>(dims.begin() + 1, dims.end())); !iter.atEnd(); ++iter)
-        {
-            for (int j = 0; j < numParcels; ++j)
+        const int64_t rowsPerBlock = getRowsPerBlock(numCols);
+        vector<vector<int64_t> > blockIndices;
+        vector<float> blockIn, blockOut, blockEmptyVal;
+        MultiDimIterator<int64_t> iter(vector<int64_t>(dims.begin() + 1, dims.end()));
+        while (!iter.atEnd())
+        {//read a block of rows, reduce the rows in parallel, then write them in order
+            blockIndices.clear();
+            for (; !iter.atEnd() && (int64_t)blockIndices.size() < rowsPerBlock; ++iter)
             {
-                parcelData[j].clear();//doesn't change allocation
+                blockIndices.push_back(*iter);
             }
-            myCiftiIn->getRow(scratchRow.data(), *iter);
-            for (int64_t j = 0; j < numCols; ++j)
+            int64_t numBlockRows = (int64_t)blockIndices.size();
+            blockIn.resize(numBlockRows * numCols);
+            blockOut.resize(numBlockRows * numParcels);
+            blockEmptyVal.resize(numBlockRows);
+            for (int64_t r = 0; r < numBlockRows; ++r)
             {
-                int parcel = indexToParcel[j];
-                if (parcel != -1)
-                {
-                    if (isLabel)
-                    {
-                        parcelData[parcel].push_back(floor(scratchRow[j] + 0.5f));//round to nearest integer to be safe
-                    } else {
-                        parcelData[parcel].push_back(scratchRow[j]);
-                    }
+                myCiftiIn->getRow(blockIn.data() + r * numCols, blockIndices[r]);
+                if (isLabel)
+                {//labelDir can't be 0 (row) because we are parcellating along row, so row must be dense
+                    blockEmptyVal[r] = myOutXML.getLabelsMap(labelDir).getMapLabelTable(blockIndices[r][labelDir - 1])->getUnassignedLabelKey();//can add a label, so not inside the parallel loop
+                } else {
+                    blockEmptyVal[r] = emptyFillVal;//odd corner case, but probably fine: with nonzero empty fill value and SAMPSTDEV, parcels with only one element get the fill value, but aren't technically empty
                 }
             }
-            for (int j = 0; j < numParcels; ++j)
+            AString errorMessage;
+#pragma omp CARET_PAR
             {
-                CaretAssert(parcelCounts[j] == (int64_t)parcelData[j].size());
-                if (parcelCounts[j] > 0 && (method != ReductionEnum::SAMPSTDEV || parcelCounts[j] > 1))
+                vector<float> parcelScratch;//float so we can use ReductionOperation
+#pragma omp CARET_FOR schedule(dynamic)
+                for (int64_t r = 0; r < numBlockRows; ++r)
                 {
-                    if (excludeLow > 0.0f && excludeHigh > 0.0f)
+                    const float* inRow = blockIn.data() + r * numCols;
+                    float* outRow = blockOut.data() + r * numParcels;
+                    try
                     {
-                        scratchOutRow[j] = ReductionOperation::reduceExcludeDev(parcelData[j].data(), parcelData[j].size(), method, excludeLow, excludeHigh);
-                    } else {
-                        if (onlyNumeric)
+                        for (int j = 0; j < numParcels; ++j)
                         {
-                            scratchOutRow[j] = ReductionOperation::reduceOnlyNumeric(parcelData[j].data(), parcelData[j].size(), method);
-                        } else {
-                            scratchOutRow[j] = ReductionOperation::reduce(parcelData[j].data(), parcelData[j].size(), method);
+                            int64_t count = membership.getCount(j);
+                            const int64_t* members = membership.getMembers(j);
+                            if (count > 0 && (method != ReductionEnum::SAMPSTDEV || count > 1))
+                            {
+                                if (sumReduction)
+                                {
+                                    double sum = 0.0;
+                                    for (int64_t k = 0; k < count; ++k)
+                                    {
+                                        sum += inRow[members[k]];
+                                    }
+                                    outRow[j] = (method == ReductionEnum::MEAN ? sum / count : sum);
+                                } else {
+                                    parcelScratch.resize(count);
+                                    for (int64_t k = 0; k < count; ++k)
+                                    {
+                                        if (isLabel)
+                                        {
+                                            parcelScratch[k] = floor(inRow[members[k]] + 0.5f);//round to nearest integer to be safe
+                                        } else {
+                                            parcelScratch[k] = inRow[members[k]];
+                                        }
+                                    }
+                                    outRow[j] = reduceParcelValues(parcelScratch.data(), count, method, excludeLow, excludeHigh, onlyNumeric);
+                                }
+                            } else {
+                                outRow[j] = blockEmptyVal[r];
+                            }
+                        }
+                    } catch (CaretException& e) {
+#pragma omp critical
+                        {
+                            if (errorMessage.isEmpty()) errorMessage = e.whatString();
                         }
-                    }
-                } else {//labelDir can't be 0 (row) because we are parcellating along row, so row must be dense
-                    if (isLabel)
-                    {
-                        scratchOutRow[j] = myOutXML.getLabelsMap(labelDir).getMapLabelTable((*iter)[labelDir - 1])->getUnassignedLabelKey();
-                    } else {
-                        scratchOutRow[j] = emptyFillVal;//odd corner case, but probably fine: with nonzero empty fill value and SAMPSTDEV, parcels with only one element get the fill value, but aren't technically empty
                     }
                 }
             }
-            myCiftiOut->setRow(scratchOutRow.data(), *iter);
+            if (!errorMessage.isEmpty()) throw AlgorithmException(errorMessage);
+            for (int64_t r = 0; r < numBlockRows; ++r)
+            {
+                myCiftiOut->setRow(blockOut.data() + r * numParcels, blockIndices[r]);
+            }
         }
     } else {
         vector<float> scratchOutRow(numCols);
         vector<int64_t> otherDims = dims;
         otherDims.erase(otherDims.begin() + direction);//direction being parcellated
         otherDims.erase(otherDims.begin());//row
-        vector<vector<vector<float> > > parcelData(numParcels, vector<vector<float> >(numCols));//float so we can use ReductionOperation
-        for (int i = 0; i < numParcels; ++i)
+        vector<double> parcelSums;//sum reductions accumulate whole rows, instead of keeping every member row around
+        vector<vector<vector<float> > > parcelData;//float so we can use ReductionOperation
+        if (sumReduction)
         {
-            for (int j = 0; j < numCols; ++j)
+            parcelSums.resize((int64_t)numParcels * numCols);
+        } else {
+            parcelData.resize(numParcels, vector<vector<float> >(numCols));
+            for (int i = 0; i < numParcels; ++i)
             {
-                parcelData[i][j].reserve(parcelCounts[i]);
+                for (int j = 0; j < numCols; ++j)
+                {
+                    parcelData[i][j].reserve(membership.getCount(i));
+                }
             }
         }
         for (MultiDimIterator<int64_t> iter(otherDims); !iter.atEnd(); ++iter)
@@ -403,11 +618,16 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
                     indices[i + 1] = (*iter)[i];
                 }
             }//indices[direction - 1] is uninitialized, as it is the dimension to be parcellated
-            for (int i = 0; i < numParcels; ++i)
+            if (sumReduction)
             {
-                for (int j = 0; j < numCols; ++j)
+                fill(parcelSums.begin(), parcelSums.end(), 0.0);
+            } else {
+                for (int i = 0; i < numParcels; ++i)
                 {
-                    parcelData[i][j].clear();//doesn't change allocation
+                    for (int j = 0; j < numCols; ++j)
+                    {
+                        parcelData[i][j].clear();//doesn't change allocation
+                    }
                 }
             }
             for (int64_t i = 0; i < dims[direction]; ++i)
@@ -417,14 +637,23 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
                 {
                     indices[direction - 1] = i;
                     myCiftiIn->getRow(scratchRow.data(), indices);
-                    vector<vector<float> >& parcelRef = parcelData[parcel];
-                    for (int j = 0; j < numCols; ++j)
+                    if (sumReduction)
                     {
-                        if (isLabel)
+                        double* sumRow = parcelSums.data() + (int64_t)parcel * numCols;
+                        for (int64_t j = 0; j < numCols; ++j)
                         {
-                            parcelRef[j].push_back(floor(scratchRow[j] + 0.5f));
-                        } else {
-                            parcelRef[j].push_back(scratchRow[j]);
+                            sumRow[j] += scratchRow[j];
+                        }
+                    } else {
+                        vector<vector<float> >& parcelRef = parcelData[parcel];
+                        for (int j = 0; j < numCols; ++j)
+                        {
+                            if (isLabel)
+                            {
+                                parcelRef[j].push_back(floor(scratchRow[j] + 0.5f));
+                            } else {
+                                parcelRef[j].push_back(scratchRow[j]);
+                            }
                         }
                     }
                 }
@@ -432,29 +661,38 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
             for (int i = 0; i < numParcels; ++i)
             {
                 indices[direction - 1] = i;
-                int64_t count = parcelCounts[i];
-                vector<vector<float> >& parcelRef = parcelData[i];
+                int64_t count = membership.getCount(i);
                 if (count > 0 && (method != ReductionEnum::SAMPSTDEV || count > 1))
                 {
-                    for (int j = 0; j < numCols; ++j)
+                    if (sumReduction)
                     {
-                        CaretAssert((int64_t)parcelRef[j].size() == count);
-                        if (excludeLow > 0.0f && excludeHigh > 0.0f)
+                        const double* sumRow = parcelSums.data() + (int64_t)i * numCols;
+                        for (int64_t j = 0; j < numCols; ++j)
                         {
-                            scratchOutRow[j] = ReductionOperation::reduceExcludeDev(parcelRef[j].data(), parcelRef[j].size(), method, excludeLow, excludeHigh);
-                        } else {
-                            if (onlyNumeric)
+                            scratchOutRow[j] = (method == ReductionEnum::MEAN ? sumRow[j] / count : sumRow[j]);
+                        }
+                    } else {
+                        const vector<vector<float> >& parcelRef = parcelData[i];
+                        AString errorMessage;
+#pragma omp CARET_PARFOR schedule(dynamic, 64)
+                        for (int64_t j = 0; j < numCols; ++j)
+                        {
+                            CaretAssert((int64_t)parcelRef[j].size() == count);
+                            try
                             {
-                                scratchOutRow[j] = ReductionOperation::reduceOnlyNumeric(parcelRef[j].data(), parcelRef[j].size(), method);
-                            } else {
-                                scratchOutRow[j] = ReductionOperation::reduce(parcelRef[j].data(), parcelRef[j].size(), method);
+                                scratchOutRow[j] = reduceParcelValues(parcelRef[j].data(), parcelRef[j].size(), method, excludeLow, excludeHigh, onlyNumeric);
+                            } catch (CaretException& e) {
+#pragma omp critical
+                                {
+                                    if (errorMessage.isEmpty()) errorMessage = e.whatString();
+                                }
                             }
                         }
+                        if (!errorMessage.isEmpty()) throw AlgorithmException(errorMessage);
                     }
                 } else {
                     for (int j = 0; j < numCols; ++j)
                     {
-                        CaretAssert((int64_t)parcelRef[j].size() == count);
                         if (isLabel)
                         {
                             if (labelDir == CiftiXML::ALONG_ROW)
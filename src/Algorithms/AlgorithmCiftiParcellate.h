@@ -39,7 +39,7 @@ namespace caret {
         AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const CiftiFile* myCiftiLabel, const int& direction, CiftiFile* myCiftiOut,
                                  const ReductionEnum::Enum& method = ReductionEnum::MEAN,
                                  const float& excludeLow = -1.0f, const float& excludeHigh = -1.0f, const bool& onlyNumeric = false,
-                                 const bool& legacyMode = false, const float& emptyFillVal = 0.0f, CiftiFile* emptyMaskOut = NULL);
+                                 const bool& legacyMode = false, const float& emptyFillVal = 0.0f, CiftiFile* emptyMaskOut = NULL, const bool& bothDirections = false);
         AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const CiftiFile* myCiftiLabel, const int& direction, CiftiFile* myCiftiOut,
                                  const MetricFile* leftWeights, const MetricFile* rightWeights = NULL, const MetricFile* cerebWeights = NULL,
                                  const ReductionEnum::Enum& method = ReductionEnum::MEAN,
@@ -0,0 +1,136 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmCiftiRegression.h"
+#include "AlgorithmException.h"
+
+#include "CiftiFile.h"
+#include "RegressionHelper.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmCiftiRegression::getCommandSwitch()
+{
+    return "-cifti-regression";
+}
+
+AString AlgorithmCiftiRegression::getShortDescription()
+{
+    return "REGRESS TIMESERIES OUT OF A CIFTI FILE";
+}
+
+OperationParameters* AlgorithmCiftiRegression::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addCiftiParameter(1, "cifti-in", "the cifti file to regress from");
+    
+    ret->addCiftiOutputParameter(2, "cifti-out", "the output cifti file");
+    
+    ParameterComponent* removeOpt = ret->createRepeatableParameter(3, "-remove", "specify regressors to regress out");
+    removeOpt->addStringParameter(1, "regressor-file", "text file with one line per column of the input, and one regressor per column of the text file");
+    
+    ParameterComponent* keepOpt = ret->createRepeatableParameter(4, "-keep", "specify regressors to include in regression, but not remove");
+    keepOpt->addStringParameter(1, "regressor-file", "text file with one line per column of the input, and one regressor per column of the text file");
+    
+    ret->setHelpText(
+        AString("For each regressor, its mean is subtracted from its data.  ") +
+        "Each row of the input is then regressed against these, and a constant term.  The resulting regressed slopes of all regressors specified with -remove " +
+        "are multiplied with their respective regressors, and these are subtracted from the row.  " +
+        "For a dtseries, the regressor files should have one line per timepoint, as with motion parameter files."
+    );
+    return ret;
+}
+
+void AlgorithmCiftiRegression::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    CiftiFile* myCiftiIn = myParams->getCifti(1);
+    CiftiFile* myCiftiOut = myParams->getOutputCifti(2);
+    vector<vector<float> > remove, keep;
+    const vector<ParameterComponent*>& removeInstances = *(myParams->getRepeatableParameterInstances(3));
+    int numRemove = (int)removeInstances.size();
+    if (numRemove == 0) throw AlgorithmException("you must specify at least one 'remove' file");
+    for (int i = 0; i < numRemove; ++i)
+    {
+        vector<vector<float> > fileRegressors = RegressionHelper::readRegressorText(removeInstances[i]->getString(1));
+        remove.insert(remove.end(), fileRegressors.begin(), fileRegressors.end());
+    }
+    const vector<ParameterComponent*>& keepInstances = *(myParams->getRepeatableParameterInstances(4));
+    int numKeep = (int)keepInstances.size();
+    for (int i = 0; i < numKeep; ++i)
+    {
+        vector<vector<float> > fileRegressors = RegressionHelper::readRegressorText(keepInstances[i]->getString(1));
+        keep.insert(keep.end(), fileRegressors.begin(), fileRegressors.end());
+    }
+    AlgorithmCiftiRegression(myProgObj, myCiftiIn, myCiftiOut, remove, keep);
+}
+
+AlgorithmCiftiRegression::AlgorithmCiftiRegression(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, CiftiFile* myCiftiOut, const vector<vector<float> >& remove,
+                                                   const vector<vector<float> >& keep) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    const CiftiXML& myXML = myCiftiIn->getCiftiXML();
+    if (myXML.getNumberOfDimensions() != 2) throw AlgorithmException("regression only supports 2D cifti");
+    if (remove.empty()) throw AlgorithmException("empty remove list in AlgorithmCiftiRegression");
+    const int64_t numRows = myCiftiIn->getNumberOfRows(), numCols = myCiftiIn->getNumberOfColumns();
+    vector<vector<float> > regressors = remove;
+    regressors.insert(regressors.end(), keep.begin(), keep.end());//only the first remove.size() get subtracted
+    RegressionHelper myHelper(regressors, (int64_t)remove.size());
+    regressors.clear();
+    if (myHelper.getNumberOfObservations() != numCols)
+    {
+        throw AlgorithmException("regressors have " + AString::number(myHelper.getNumberOfObservations()) +
+                                 " values, but the input cifti file has " + AString::number(numCols) + " columns");
+    }
+    myCiftiOut->setCiftiXML(myXML);
+    const int64_t rowsPerBlock = max((int64_t)1, ((int64_t)1<<24) / numCols);//64MB of rows at a time
+    vector<float> blockData(min(rowsPerBlock, numRows) * numCols);
+    for (int64_t blockStart = 0; blockStart < numRows; blockStart += rowsPerBlock)
+    {
+        const int64_t blockCount = min(rowsPerBlock, numRows - blockStart);
+        vector<const float*> inPtrs(blockCount);
+        vector<float*> outPtrs(blockCount);
+        for (int64_t r = 0; r < blockCount; ++r)
+        {
+            outPtrs[r] = blockData.data() + r * numCols;
+            inPtrs[r] = outPtrs[r];
+            myCiftiIn->getRow(outPtrs[r], blockStart + r);
+        }
+        myHelper.removeFit(inPtrs, outPtrs);//in place, parallel over rows
+        for (int64_t r = 0; r < blockCount; ++r)
+        {
+            myCiftiOut->setRow(outPtrs[r], blockStart + r);
+        }
+        myProgress.reportProgress(((float)(blockStart + blockCount)) / numRows);
+    }
+}
+
+float AlgorithmCiftiRegression::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmCiftiRegression::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
@@ -29,6 +29,7 @@
 #include "AlgorithmMetricResample.h"
 #include "AlgorithmVolumeAffineResample.h"
 #include "AlgorithmVolumeWarpfieldResample.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 #include "LabelFile.h"
 #include "MetricFile.h"
@@ -132,6 +133,9 @@ OperationParameters* AlgorithmCiftiResample::getParameters()
             cerebAreaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for the current mesh");
             cerebAreaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for the new mesh");
     
+    OptionalParameter* weightsCacheOpt = ret->createOptionalParameter(16, "-weights-cache", "reuse surface resampling weights across invocations");
+        weightsCacheOpt->addStringParameter(1, "directory", "an existing directory to store and look up weight files in");
+    
     AString myHelpText =
         AString("Resample cifti data to a different brainordinate space.  Use COLUMN for the direction to resample dscalar, dlabel, or dtseries.  ") +
         "Resampling both dimensions of a dconn requires running this command twice, once with COLUMN and once with ROW.  " +
@@ -143,6 +147,8 @@ OperationParameters* AlgorithmCiftiResample::getParameters()
         "If neither -affine nor -warpfield are specified, the identity transform is assumed for the volume data.\n\n" +
         "The recommended resampling methods are ADAP_BARY_AREA and CUBIC (cubic spline), except for label data which should use ADAP_BARY_AREA and ENCLOSING_VOXEL.  " +
         "Using ADAP_BARY_AREA requires specifying an area option to each used -*-spheres option.\n\n" +
+        "The -weights-cache option saves the computed surface vertex weights in the given directory, in files named by a hash of the spheres, area data, and roi, " +
+        "so that later runs with identical inputs (for instance, other subjects' data on the same meshes) load them instead of recomputing them.\n\n" +
         "The <volume-method> argument must be one of the following:\n\n" +
         "CUBIC\nENCLOSING_VOXEL\nTRILINEAR\n\n" +
         "The <surface-method> argument must be one of the following:\n\n";
@@ -407,19 +413,25 @@ void AlgorithmCiftiResample::useParameters(OperationParameters* myParams, Progre
             newCerebAreas = cerebAreaMetricsOpt->getMetric(2);
         }
     }
+    AString weightsCacheDir;
+    OptionalParameter* weightsCacheOpt = myParams->getOptionalParameter(16);
+    if (weightsCacheOpt->m_present)
+    {
+        weightsCacheDir = weightsCacheOpt->getString(1);
+    }
     if (warpfieldOpt->m_present)
     {
         AlgorithmCiftiResample(myProgObj, myCiftiIn, direction, myTemplate, templateDir, mySurfMethod, myVolMethod, myCiftiOut, surfLargest, voldilatemm, surfdilatemm, myWarpfield.getWarpfield(),
                                curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                                curRightSphere, newRightSphere, curRightAreas, newRightAreas,
                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
-                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent, volLegacyCutoff, surfLegacyCutoff);
+                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent, volLegacyCutoff, surfLegacyCutoff, weightsCacheDir);
     } else {//rely on AffineFile() being the identity transform for if neither option is specified
         AlgorithmCiftiResample(myProgObj, myCiftiIn, direction, myTemplate, templateDir, mySurfMethod, myVolMethod, myCiftiOut, surfLargest, voldilatemm, surfdilatemm, myAffine.getMatrix(),
                                curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                                curRightSphere, newRightSphere, curRightAreas, newRightAreas,
                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
-                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent, volLegacyCutoff, surfLegacyCutoff);
+                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent, volLegacyCutoff, surfLegacyCutoff, weightsCacheDir);
     }
 }
 
@@ -522,7 +534,7 @@ namespace
     };
     
     void setupRowResampling(map<StructureEnum::Enum, ResampleCache>& surfCache, map<StructureEnum::Enum, ResampleCache>& volCache, const CiftiFile* myCiftiIn, CiftiFile* myCiftiOut,
-                            const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const float& voldilatemm, const FloatMatrix* affine, const VolumeFile* warpfield,
+                            const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const float& voldilatemm, const AString& weightsCacheDir, const FloatMatrix* affine, const VolumeFile* warpfield,
                             const SurfaceFile* curLeftSphere, const SurfaceFile* newLeftSphere, const MetricFile* curLeftAreas, const MetricFile* newLeftAreas,
                             const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
                             const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas)
@@ -583,7 +595,7 @@ namespace
             {
                 tempRoi[myCache.inSurfMap[j].m_surfaceNode] = 1.0f;
             }
-            myCache.surfResamp = SurfaceResamplingHelper(mySurfMethod, curSphere, newSphere, curAreasPtr, newAreasPtr, tempRoi.data());//resampling is already a helper, so use it as such
+            myCache.surfResamp = SurfaceResamplingHelper(mySurfMethod, curSphere, newSphere, curAreasPtr, newAreasPtr, tempRoi.data(), weightsCacheDir);//resampling is already a helper, so use it as such
             tempRoi.resize(newSphere->getNumberOfNodes());
             myCache.surfResamp.getResampleValidROI(tempRoi.data());
             myCache.surfDilateRoi.setNumberOfNodesAndColumns(newSphere->getNumberOfNodes(), 1);
@@ -869,6 +881,103 @@ namespace
                                                                                     myCache.outVolMap[j].m_ijk[2] - myCache.refOffset[2]);
         }
     }
+    
+    void makeScratchPrivate(map<StructureEnum::Enum, ResampleCache>& cacheMap)
+    {//for the copies used by other threads - the weights, maps and rois are only read, but the scratch volumes get written to
+        for (map<StructureEnum::Enum, ResampleCache>::iterator iter = cacheMap.begin(); iter != cacheMap.end(); ++iter)
+        {
+            ResampleCache& myCache = iter->second;
+            if (myCache.inputVol != NULL) myCache.inputVol.grabNew(new VolumeFile(*(myCache.inputVol)));
+            if (myCache.tempVol2 != NULL) myCache.tempVol2.grabNew(new VolumeFile(*(myCache.tempVol2)));
+            if (myCache.tempVol3 != NULL) myCache.tempVol3.grabNew(new VolumeFile(*(myCache.tempVol3)));
+        }
+    }
+    
+    void resampleRows(map<StructureEnum::Enum, ResampleCache>& surfCache, map<StructureEnum::Enum, ResampleCache>& volCache, const CiftiFile* myCiftiIn, CiftiFile* myCiftiOut,
+                      const float& surfdilatemm, const bool& surfLargest, const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent, const bool surfLegacyCutoff,
+                      const float& voldilatemm, const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent, const bool volLegacyCutoff,
+                      const VolumeFile* warpfield, const FloatMatrix* affine, const VolumeFile::InterpType& myVolMethod)
+    {
+        const CiftiXML& myInputXML = myCiftiIn->getCiftiXML(), &myOutXML = myCiftiOut->getCiftiXML();
+        bool labelMode = (myInputXML.getMappingType(CiftiXML::ALONG_COLUMN) == CiftiMappingType::LABELS);
+        const CiftiBrainModelsMap& outModels = myOutXML.getBrainModelsMap(CiftiXML::ALONG_ROW);
+        vector<StructureEnum::Enum> surfList = outModels.getSurfaceStructureList(), volList = outModels.getVolumeStructureList();
+        int numSurfStructs = (int)surfList.size(), numVolStructs = (int)volList.size();
+        int64_t numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+        vector<int> unassignedLabelKey(numRows, 0);
+        if (labelMode)
+        {
+            const CiftiLabelsMap& myLabelMap = myInputXML.getLabelsMap(CiftiXML::ALONG_COLUMN);
+            for (int64_t i = 0; i < numRows; ++i)
+            {
+                unassignedLabelKey[i] = myLabelMap.getMapLabelTable(i)->getUnassignedLabelKey();
+            }
+        }
+        int numThreads = 1;
+#ifdef CARET_OMP
+        numThreads = omp_get_max_threads();
+#endif
+        vector<map<StructureEnum::Enum, ResampleCache> > threadSurfCache(numThreads - 1, surfCache), threadVolCache(numThreads - 1, volCache);//thread 0 uses the originals
+        for (int i = 0; i < numThreads - 1; ++i)
+        {
+            makeScratchPrivate(threadSurfCache[i]);
+            makeScratchPrivate(threadVolCache[i]);
+        }
+        int64_t inLength = myInputXML.getDimensionLength(CiftiXML::ALONG_ROW), outLength = myOutXML.getDimensionLength(CiftiXML::ALONG_ROW);
+        int64_t batchSize = max((int64_t)1, min((int64_t)(numThreads * 4), (int64_t)(1<<24) / (inLength + outLength)));//rows are read and written in order, a batch at a time, and resampled in parallel
+        vector<vector<float> > inRows(batchSize, vector<float>(inLength)), outRows(batchSize, vector<float>(outLength));
+        for (int64_t batchStart = 0; batchStart < numRows; batchStart += batchSize)
+        {
+            int64_t batchEnd = min(batchStart + batchSize, numRows);
+            for (int64_t row = batchStart; row < batchEnd; ++row)
+            {
+                myCiftiIn->getRow(inRows[row - batchStart].data(), row);
+            }
+            bool failed = false;
+            AString failMessage;
+#pragma omp CARET_PAR
+            {
+                int myThread = 0;
+#ifdef CARET_OMP
+                myThread = omp_get_thread_num();
+#endif
+                map<StructureEnum::Enum, ResampleCache>& mySurfCache = (myThread == 0 ? surfCache : threadSurfCache[myThread - 1]);
+                map<StructureEnum::Enum, ResampleCache>& myVolCache = (myThread == 0 ? volCache : threadVolCache[myThread - 1]);
+#pragma omp CARET_FOR schedule(dynamic)
+                for (int64_t row = batchStart; row < batchEnd; ++row)
+                {
+                    try
+                    {
+                        const vector<float>& inRow = inRows[row - batchStart];
+                        vector<float>& outRow = outRows[row - batchStart];
+                        for (int i = 0; i < numSurfStructs; ++i)
+                        {
+                            map<StructureEnum::Enum, ResampleCache>::iterator iter = mySurfCache.find(surfList[i]);
+                            CaretAssert(iter != mySurfCache.end());
+                            processRowSurface(iter->second, inRow, outRow, myInputXML, surfdilatemm, surfLargest, unassignedLabelKey[row], row, surfDilateMethod, surfDilateExponent, surfLegacyCutoff);
+                        }
+                        for (int i = 0; i < numVolStructs; ++i)
+                        {
+                            map<StructureEnum::Enum, ResampleCache>::iterator iter = myVolCache.find(volList[i]);
+                            CaretAssert(iter != myVolCache.end());
+                            processRowVolume(iter->second, inRow, outRow, myInputXML, voldilatemm, volDilateMethod, volDilateExponent, unassignedLabelKey[row], warpfield, affine, myVolMethod, volLegacyCutoff);
+                        }
+                    } catch (CaretException& e) {//exceptions can't leave a parallel region
+#pragma omp critical
+                        {
+                            failed = true;
+                            failMessage = e.whatString();
+                        }
+                    }
+                }
+            }
+            if (failed) throw AlgorithmException(failMessage);
+            for (int64_t row = batchStart; row < batchEnd; ++row)
+            {
+                myCiftiOut->setRow(outRows[row - batchStart].data(), row);
+            }
+        }
+    }
 }
 
 AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const int& direction, const CiftiFile* myTemplate, const int& templateDir,
@@ -880,7 +989,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                                                const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
                                                const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
                                                const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
-                                               const bool volLegacyCutoff, const bool surfLegacyCutoff) : AbstractAlgorithm(myProgObj)
+                                               const bool volLegacyCutoff, const bool surfLegacyCutoff, const AString& weightsCacheDir) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     pair<bool, AString> myError = checkForErrors(myCiftiIn, direction, myTemplate, templateDir, mySurfMethod,
@@ -924,50 +1033,20 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
                     break;
             }
-            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfLegacyCutoff);
+            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfLegacyCutoff, weightsCacheDir);
         }
         for (int i = 0; i < (int)volList.size(); ++i)
         {
             processVolume(myCiftiIn, direction, volList[i], myVolMethod, myCiftiOut, voldilatemm, warpfield, NULL, volDilateMethod, volDilateExponent, volLegacyCutoff);
         }
     } else {//avoid cifti separate/replace with ALONG_ROW
-        bool labelMode = (myInputXML.getMappingType(CiftiXML::ALONG_COLUMN) == CiftiMappingType::LABELS);
-        vector<StructureEnum::Enum> surfList = outModels.getSurfaceStructureList(), volList = outModels.getVolumeStructureList();
-        int numSurfStructs = (int)surfList.size(), numVolStructs = (int)volList.size();
-        vector<int> unassignedLabelKey;
-        if (labelMode)
-        {
-            const CiftiLabelsMap& myLabelMap = myInputXML.getLabelsMap(CiftiXML::ALONG_COLUMN);
-            unassignedLabelKey.resize(myLabelMap.getLength());
-            for (int i = 0; i < myLabelMap.getLength(); ++i)
-            {
-                unassignedLabelKey[i] = myLabelMap.getMapLabelTable(i)->getUnassignedLabelKey();
-            }
-        }
         map<StructureEnum::Enum, ResampleCache> surfCache, volCache;//could make them different types, but whatever - two variables in case of structure overlap in surface and volume, as some members may get used by both
-        setupRowResampling(surfCache, volCache, myCiftiIn, myCiftiOut, mySurfMethod, voldilatemm, NULL, warpfield,
+        setupRowResampling(surfCache, volCache, myCiftiIn, myCiftiOut, mySurfMethod, voldilatemm, weightsCacheDir, NULL, warpfield,
                            curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                            curRightSphere, newRightSphere, curRightAreas, newRightAreas,
                            curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
-        int64_t numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
-        vector<float> inRow(myInputXML.getDimensionLength(CiftiXML::ALONG_ROW)), outRow(myOutXML.getDimensionLength(CiftiXML::ALONG_ROW));
-        for (int64_t row = 0; row < numRows; ++row)
-        {
-            myCiftiIn->getRow(inRow.data(), row);
-            for (int i = 0; i < numSurfStructs; ++i)
-            {
-                map<StructureEnum::Enum, ResampleCache>::iterator iter = surfCache.find(surfList[i]);
-                CaretAssert(iter != surfCache.end());
-                processRowSurface(iter->second, inRow, outRow, myInputXML, surfdilatemm, surfLargest, unassignedLabelKey[row], row, surfDilateMethod, surfDilateExponent, surfLegacyCutoff);
-            }
-            for (int i = 0; i < numVolStructs; ++i)
-            {
-                map<StructureEnum::Enum, ResampleCache>::iterator iter = volCache.find(volList[i]);
-                CaretAssert(iter != volCache.end());
-                processRowVolume(iter->second, inRow, outRow, myInputXML, voldilatemm, volDilateMethod, volDilateExponent, unassignedLabelKey[row], warpfield, NULL, myVolMethod, volLegacyCutoff);
-            }
-            myCiftiOut->setRow(outRow.data(), row);
-        }
+        resampleRows(surfCache, volCache, myCiftiIn, myCiftiOut, surfdilatemm, surfLargest, surfDilateMethod, surfDilateExponent, surfLegacyCutoff,
+                     voldilatemm, volDilateMethod, volDilateExponent, volLegacyCutoff, warpfield, NULL, myVolMethod);
     }
 }
 
@@ -980,7 +1059,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                                                const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
                                                const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
                                                const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
-                                               const bool volLegacyCutoff, const bool surfLegacyCutoff) : AbstractAlgorithm(myProgObj)
+                                               const bool volLegacyCutoff, const bool surfLegacyCutoff, const AString& weightsCacheDir) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     pair<bool, AString> myError = checkForErrors(myCiftiIn, direction, myTemplate, templateDir, mySurfMethod,
@@ -1024,57 +1103,27 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
                     break;
             }
-            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfLegacyCutoff);
+            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfLegacyCutoff, weightsCacheDir);
         }
         for (int i = 0; i < (int)volList.size(); ++i)
         {
             processVolume(myCiftiIn, direction, volList[i], myVolMethod, myCiftiOut, voldilatemm, NULL, &affine, volDilateMethod, volDilateExponent, volLegacyCutoff);
         }
     } else {//avoid cifti separate/replace with ALONG_ROW
-        bool labelMode = (myInputXML.getMappingType(CiftiXML::ALONG_COLUMN) == CiftiMappingType::LABELS);
-        vector<StructureEnum::Enum> surfList = outModels.getSurfaceStructureList(), volList = outModels.getVolumeStructureList();
-        int numSurfStructs = (int)surfList.size(), numVolStructs = (int)volList.size();
-        vector<int> unassignedLabelKey;
-        if (labelMode)
-        {
-            const CiftiLabelsMap& myLabelMap = myInputXML.getLabelsMap(CiftiXML::ALONG_COLUMN);
-            unassignedLabelKey.resize(myLabelMap.getLength());
-            for (int i = 0; i < myLabelMap.getLength(); ++i)
-            {
-                unassignedLabelKey[i] = myLabelMap.getMapLabelTable(i)->getUnassignedLabelKey();
-            }
-        }
         map<StructureEnum::Enum, ResampleCache> surfCache, volCache;//could make them different types, but whatever - two variables in case of structure overlap in surface and volume, as some members may get used by both
-        setupRowResampling(surfCache, volCache, myCiftiIn, myCiftiOut, mySurfMethod, voldilatemm, &affine, NULL,
+        setupRowResampling(surfCache, volCache, myCiftiIn, myCiftiOut, mySurfMethod, voldilatemm, weightsCacheDir, &affine, NULL,
                            curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                            curRightSphere, newRightSphere, curRightAreas, newRightAreas,
                            curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
-        int64_t numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
-        vector<float> inRow(myInputXML.getDimensionLength(CiftiXML::ALONG_ROW)), outRow(myOutXML.getDimensionLength(CiftiXML::ALONG_ROW));
-        for (int64_t row = 0; row < numRows; ++row)
-        {
-            myCiftiIn->getRow(inRow.data(), row);
-            for (int i = 0; i < numSurfStructs; ++i)
-            {
-                map<StructureEnum::Enum, ResampleCache>::iterator iter = surfCache.find(surfList[i]);
-                CaretAssert(iter != surfCache.end());
-                processRowSurface(iter->second, inRow, outRow, myInputXML, surfdilatemm, surfLargest, unassignedLabelKey[row], row, surfDilateMethod, surfDilateExponent, surfLegacyCutoff);
-            }
-            for (int i = 0; i < numVolStructs; ++i)
-            {
-                map<StructureEnum::Enum, ResampleCache>::iterator iter = volCache.find(volList[i]);
-                CaretAssert(iter != volCache.end());
-                processRowVolume(iter->second, inRow, outRow, myInputXML, voldilatemm, volDilateMethod, volDilateExponent, unassignedLabelKey[row], NULL, &affine, myVolMethod, volLegacyCutoff);
-            }
-            myCiftiOut->setRow(outRow.data(), row);
-        }
+        resampleRows(surfCache, volCache, myCiftiIn, myCiftiOut, surfdilatemm, surfLargest, surfDilateMethod, surfDilateExponent, surfLegacyCutoff,
+                     voldilatemm, volDilateMethod, volDilateExponent, volLegacyCutoff, NULL, &affine, myVolMethod);
     }
 }
 
 void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
                                                      CiftiFile* myCiftiOut, const bool& surfLargest, const float& surfdilatemm, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                      const MetricFile* curAreas, const MetricFile* newAreas,
-                                                     const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent, const bool surfLegacyCutoff)
+                                                     const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent, const bool surfLegacyCutoff, const AString& weightsCacheDir)
 {
     const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
     if (myInputXML.getMappingType(1 - direction) == CiftiMappingType::LABELS)
@@ -1085,7 +1134,7 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
         LabelFile newLabel, newDilate, *newUse = &newLabel;
         if (curSphere != NULL)
         {
-            AlgorithmLabelResample(NULL, &origLabel, curSphere, newSphere, mySurfMethod, &newLabel, curAreas, newAreas, &origRoi, &resampleROI, surfLargest);
+            AlgorithmLabelResample(NULL, &origLabel, curSphere, newSphere, mySurfMethod, &newLabel, curAreas, newAreas, &origRoi, &resampleROI, surfLargest, weightsCacheDir);
             origLabel.clear();//delete the data we no longer need to keep memory use down
             if (surfdilatemm > 0.0f)
             {
@@ -1110,7 +1159,7 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
         MetricFile newMetric, newDilate, resampleROI, *newUse = &newMetric;
         if (curSphere != NULL)
         {
-            AlgorithmMetricResample(NULL, &origMetric, curSphere, newSphere, mySurfMethod, &newMetric, curAreas, newAreas, &origROI, &resampleROI, surfLargest);
+            AlgorithmMetricResample(NULL, &origMetric, curSphere, newSphere, mySurfMethod, &newMetric, curAreas, newAreas, &origROI, &resampleROI, surfLargest, weightsCacheDir);
             origMetric.clear();//ditto
             if (surfdilatemm > 0.0f)
             {
@@ -55,16 +55,22 @@ OperationParameters* AlgorithmCiftiSmoothing::getParameters()
     leftSurfOpt->addSurfaceParameter(1, "surface", "the left surface file");
     OptionalParameter* leftCorrAreasOpt = leftSurfOpt->createOptionalParameter(2, "-left-corrected-areas", "vertex areas to use instead of computing them from the left surface");
     leftCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    OptionalParameter* leftWeightsOpt = leftSurfOpt->createOptionalParameter(3, "-left-weights-file", "reuse precomputed smoothing weights for the left surface");
+    leftWeightsOpt->addStringParameter(1, "file", "the file to load the weights from, or save them to");
     
     OptionalParameter* rightSurfOpt = ret->createOptionalParameter(7, "-right-surface", "specify the right surface to use");
     rightSurfOpt->addSurfaceParameter(1, "surface", "the right surface file");
     OptionalParameter* rightCorrAreasOpt = rightSurfOpt->createOptionalParameter(2, "-right-corrected-areas", "vertex areas to use instead of computing them from the right surface");
     rightCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    OptionalParameter* rightWeightsOpt = rightSurfOpt->createOptionalParameter(3, "-right-weights-file", "reuse precomputed smoothing weights for the right surface");
+    rightWeightsOpt->addStringParameter(1, "file", "the file to load the weights from, or save them to");
     
     OptionalParameter* cerebSurfOpt = ret->createOptionalParameter(8, "-cerebellum-surface", "specify the cerebellum surface to use");
     cerebSurfOpt->addSurfaceParameter(1, "surface", "the cerebellum surface file");
     OptionalParameter* cerebCorrAreasOpt = cerebSurfOpt->createOptionalParameter(2, "-cerebellum-corrected-areas", "vertex areas to use instead of computing them from the cerebellum surface");
     cerebCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    OptionalParameter* cerebWeightsOpt = cerebSurfOpt->createOptionalParameter(3, "-cerebellum-weights-file", "reuse precomputed smoothing weights for the cerebellum surface");
+    cerebWeightsOpt->addStringParameter(1, "file", "the file to load the weights from, or save them to");
     
     OptionalParameter* roiOpt = ret->createOptionalParameter(9, "-cifti-roi", "smooth only within regions of interest");
     roiOpt->addCiftiParameter(1, "roi-cifti", "the regions to smooth within, as a cifti file");
@@ -82,6 +88,7 @@ OperationParameters* AlgorithmCiftiSmoothing::getParameters()
         "Surface smoothing uses the GEO_GAUSS_AREA smoothing method.\n\n" +
         "The -*-corrected-areas options are intended for when it is unavoidable to smooth on group average surfaces, it is only an approximate correction " +
         "for the reduction of structure in a group average surface.  It is better to smooth the data on individuals before averaging, when feasible.\n\n" +
+        "The -*-weights-file options behave as -weights-file in -metric-smoothing, the weights also depend on which vertices the input has data for.\n\n" +
         "The -fix-zeros-* options will treat values of zero as lack of data, and not use that value when generating the smoothed values, but will fill zeros with extrapolated values.  " +
         "The ROI should have a brain models mapping along columns, exactly matching the mapping of the chosen direction in the input file.  " +
         "Data outside the ROI is ignored."
@@ -107,6 +114,7 @@ void AlgorithmCiftiSmoothing::useParameters(OperationParameters* myParams, Progr
     CiftiFile* myCiftiOut = myParams->getOutputCifti(5);
     SurfaceFile* myLeftSurf = NULL, *myRightSurf = NULL, *myCerebSurf = NULL;
     MetricFile* myLeftAreas = NULL, *myRightAreas = NULL, *myCerebAreas = NULL;
+    AString leftWeightsFile, rightWeightsFile, cerebWeightsFile;
     OptionalParameter* leftSurfOpt = myParams->getOptionalParameter(6);
     if (leftSurfOpt->m_present)
     {
@@ -116,6 +124,11 @@ void AlgorithmCiftiSmoothing::useParameters(OperationParameters* myParams, Progr
         {
             myLeftAreas = leftCorrAreasOpt->getMetric(1);
         }
+        OptionalParameter* leftWeightsOpt = leftSurfOpt->getOptionalParameter(3);
+        if (leftWeightsOpt->m_present)
+        {
+            leftWeightsFile = leftWeightsOpt->getString(1);
+        }
     }
     OptionalParameter* rightSurfOpt = myParams->getOptionalParameter(7);
     if (rightSurfOpt->m_present)
@@ -126,6 +139,11 @@ void AlgorithmCiftiSmoothing::useParameters(OperationParameters* myParams, Progr
         {
             myRightAreas = rightCorrAreasOpt->getMetric(1);
         }
+        OptionalParameter* rightWeightsOpt = rightSurfOpt->getOptionalParameter(3);
+        if (rightWeightsOpt->m_present)
+        {
+            rightWeightsFile = rightWeightsOpt->getString(1);
+        }
     }
     OptionalParameter* cerebSurfOpt = myParams->getOptionalParameter(8);
     if (cerebSurfOpt->m_present)
@@ -136,6 +154,11 @@ void AlgorithmCiftiSmoothing::useParameters(OperationParameters* myParams, Progr
         {
             myCerebAreas = cerebCorrAreasOpt->getMetric(1);
         }
+        OptionalParameter* cerebWeightsOpt = cerebSurfOpt->getOptionalParameter(3);
+        if (cerebWeightsOpt->m_present)
+        {
+            cerebWeightsFile = cerebWeightsOpt->getString(1);
+        }
     }
     CiftiFile* roiCifti = NULL;
     OptionalParameter* roiOpt = myParams->getOptionalParameter(9);
@@ -149,13 +172,15 @@ void AlgorithmCiftiSmoothing::useParameters(OperationParameters* myParams, Progr
     AlgorithmCiftiSmoothing(myProgObj, myCifti, surfKern, volKern, myDir, myCiftiOut,
                             myLeftSurf, myRightSurf, myCerebSurf,
                             roiCifti, fixZerosVol, fixZerosSurf,
-                            myLeftAreas, myRightAreas, myCerebAreas, mergedVolume);
+                            myLeftAreas, myRightAreas, myCerebAreas, mergedVolume,
+                            leftWeightsFile, rightWeightsFile, cerebWeightsFile);
 }
 
 AlgorithmCiftiSmoothing::AlgorithmCiftiSmoothing(ProgressObject* myProgObj, const CiftiFile* myCifti, const float& surfKern, const float& volKern, const int& myDir, CiftiFile* myCiftiOut,
                                                  const SurfaceFile* myLeftSurf, const SurfaceFile* myRightSurf, const SurfaceFile* myCerebSurf,
                                                  const CiftiFile* roiCifti, bool fixZerosVol, bool fixZerosSurf,
-                                                 const MetricFile* myLeftAreas, const MetricFile* myRightAreas, const MetricFile* myCerebAreas, const bool& mergedVolume) : AbstractAlgorithm(myProgObj)
+                                                 const MetricFile* myLeftAreas, const MetricFile* myRightAreas, const MetricFile* myCerebAreas, const bool& mergedVolume,
+                                                 const AString& leftWeightsFile, const AString& rightWeightsFile, const AString& cerebWeightsFile) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     if (!(surfKern > 0.0f) && !(volKern > 0.0f)) throw AlgorithmException("zero smoothing kernels requested for both volume and surface");
@@ -230,19 +255,23 @@ AlgorithmCiftiSmoothing::AlgorithmCiftiSmoothing(ProgressObject* myProgObj, cons
     {
         const SurfaceFile* mySurf = NULL;
         const MetricFile* myAreas = NULL;
+        AString myWeightsFile;
         switch (surfaceList[whichStruct])
         {
             case StructureEnum::CORTEX_LEFT:
                 mySurf = myLeftSurf;
                 myAreas = myLeftAreas;
+                myWeightsFile = leftWeightsFile;
                 break;
             case StructureEnum::CORTEX_RIGHT:
                 mySurf = myRightSurf;
                 myAreas = myRightAreas;
+                myWeightsFile = rightWeightsFile;
                 break;
             case StructureEnum::CEREBELLUM:
                 mySurf = myCerebSurf;
                 myAreas = myCerebAreas;
+                myWeightsFile = cerebWeightsFile;
                 break;
             default:
                 break;
@@ -255,7 +284,8 @@ AlgorithmCiftiSmoothing::AlgorithmCiftiSmoothing(ProgressObject* myProgObj, cons
             {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
                 AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, surfaceList[whichStruct], &myRoi);
             }
-            AlgorithmMetricSmoothing(NULL, mySurf, &myMetric, surfKern, &myMetricOut, &myRoi, false, fixZerosSurf, -1, myAreas);
+            AlgorithmMetricSmoothing(NULL, mySurf, &myMetric, surfKern, &myMetricOut, &myRoi, false, fixZerosSurf, -1, myAreas,
+                                     MetricSmoothingObject::GEO_GAUSS_AREA, myWeightsFile);
             AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myMetricOut);
         } else {
             AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myMetric);
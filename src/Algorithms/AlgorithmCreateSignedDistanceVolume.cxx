@@ -271,16 +271,18 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
     }
     myProgress.reportProgress(markweight);
     myProgress.setTask("computing exact distances");
-#pragma omp CARET_PAR
     {
         CaretPointer<SignedDistanceHelper> myDist = mySurf->getSignedDistanceHelper();
         int numExact = (int)exactVoxelList.size();
-        Vector3D thisCoord;
-#pragma omp CARET_FOR schedule(dynamic)
+        vector<float> exactCoords(numExact), exactDists(numExact / 3);
         for (int i = 0; i < numExact; i += 3)
         {
-            myVolOut->indexToSpace(exactVoxelList.data() + i, thisCoord);
-            myVolOut->setValue(myDist->dist(thisCoord, myWinding), exactVoxelList.data() + i);
+            myVolOut->indexToSpace(exactVoxelList.data() + i, exactCoords.data() + i);
+        }
+        myDist->dist(exactCoords.data(), numExact / 3, exactDists.data(), myWinding);//batched, runs in parallel
+        for (int i = 0; i < numExact; i += 3)
+        {
+            myVolOut->setValue(exactDists[i / 3], exactVoxelList.data() + i);
             volMarked[myVolOut->getIndex(exactVoxelList.data() + i)] |= 22;//set marked to have valid value (positive and negative), and frozen
         }
     }
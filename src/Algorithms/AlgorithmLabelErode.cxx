@@ -130,7 +130,7 @@ namespace
                     vector<int32_t> geoNodes;
                     vector<float> geoDists;
                     myGeoHelp->getNodesToGeoDist(i, distance, geoNodes, geoDists);
-                    const vector<int32_t>& topoNodes = myTopoHelp->getNodeNeighbors(i);
+                    const CaretSpan<int32_t> topoNodes = myTopoHelp->getNodeNeighbors(i);
                     set<int32_t> mergeSet(geoNodes.begin(), geoNodes.end());
                     mergeSet.insert(topoNodes.begin(), topoNodes.end());
                     mergeSet.erase(i);//center of stencil is already 0 if stencil is used, so don't set it again
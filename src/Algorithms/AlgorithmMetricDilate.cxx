@@ -406,7 +406,7 @@ void AlgorithmMetricDilate::processColumn(float* colScratch, const float* myInpu
                 int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
                 if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                    const CaretSpan<int32_t> nodeList = myTopoHelp->getNodeNeighbors(i);
                     vector<float> distList;
                     myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
                     const int numInRange = (int)nodeList.size();
@@ -640,7 +640,7 @@ void AlgorithmMetricDilate::precomputeStencils(vector<pair<int, StencilElem> >&
                 int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
                 if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                    const CaretSpan<int32_t> nodeList = myTopoHelp->getNodeNeighbors(i);
                     vector<float> distList;
                     myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
                     const int numInRange = (int)nodeList.size();
@@ -772,7 +772,7 @@ void AlgorithmMetricDilate::precomputeNearest(vector<pair<int, int> >& myNearest
                 int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
                 if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                    const CaretSpan<int32_t> nodeList = myTopoHelp->getNodeNeighbors(i);
                     vector<float> distList;
                     myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
                     const int numInRange = (int)nodeList.size();
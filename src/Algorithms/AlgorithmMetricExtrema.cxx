@@ -414,7 +414,7 @@ void AlgorithmMetricExtrema::precomputeNeighborhoods(const SurfaceFile* mySurf,
         {
             if (roiColumn != NULL)
             {
-                const vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(i);
+                const CaretSpan<int32_t> neighbors = myTopoHelp->getNodeNeighbors(i);
                 int numNeigh = (int)neighbors.size();
                 bool good = true;
                 for (int j = 0; j < numNeigh; ++j)
@@ -581,7 +581,7 @@ void AlgorithmMetricExtrema::findExtremaConsolidate(const SurfaceFile* mySurf, c
         bool canBeMin = minPos[i] && !ignoreMinima, canBeMax = maxPos[i] && !ignoreMaxima;
         if (canBeMin || canBeMax)
         {
-            const vector<int32_t>& myneighbors = myTopoHelp->getNodeNeighbors(i);
+            const CaretSpan<int32_t> myneighbors = myTopoHelp->getNodeNeighbors(i);
             int numNeigh = (int)myneighbors.size();
             if (numNeigh == 0) continue;//don't count isolated nodes as minima or maxima
             float myval = data[i];
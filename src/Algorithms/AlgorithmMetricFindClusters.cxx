@@ -22,6 +22,7 @@
 #include "AlgorithmException.h"
 
 #include "CaretLogger.h"
+#include "ClusterFindHelper.h"
 #include "GeodesicHelper.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
@@ -145,19 +146,13 @@ void AlgorithmMetricFindClusters::useParameters(OperationParameters* myParams, P
 
 namespace
 {
-    struct Cluster
+    ///outData gets the cluster number within the column, starting from 1, returns the number of clusters kept
+    int64_t processColumn(const float* data, const float* roiData, const ClusterFindHelper& myClusterHelp, GeodesicHelper* myGeoHelp,
+                          const float& threshVal, const float& minArea, const bool& lessThan, const float& areaRatio, const float& distanceCutoff,
+                          float* outData)
     {
-        Cluster() { area = 0.0; }
-        vector<int32_t> members;
-        double area;
-    };
-    
-    void processColumn(const float* data, const float* roiData, const float* nodeAreas, TopologyHelper* myTopoHelp, GeodesicHelper* myGeoHelp,
-                       const float& threshVal, const float& minArea, const bool& lessThan, const float& areaRatio, const float& distanceCutoff,
-                       float* outData, int& markVal)
-    {
-        int numNodes = myTopoHelp->getNumberOfNodes();
-        vector<int> marked(numNodes, 0);
+        int numNodes = (int)myClusterHelp.getNumberOfElements();
+        vector<char> marked(numNodes, 0);
         if (lessThan)
         {
             for (int i = 0; i < numNodes; ++i)
@@ -176,48 +171,33 @@ namespace
                 }
             }
         }
-        vector<Cluster> clusters;
+        ClusterFindHelper::ClusterList allClusters;
+        myClusterHelp.findClusters(marked.data(), allClusters);
+        vector<int64_t> clusters;//indices into allClusters of the clusters that are large enough
         float biggestSize = 0.0f;
         int biggestCluster = -1;
-        for (int i = 0; i < numNodes; ++i)
+        for (int64_t c = 0; c < allClusters.getNumberOfClusters(); ++c)
         {
-            if (marked[i])
+            if (allClusters.sizes[c] > minArea)
             {
-                Cluster newCluster;
-                newCluster.members.push_back(i);
-                marked[i] = 0;//unmark it when added to list to prevent multiples
-                for (int index = 0; index < (int)newCluster.members.size(); ++index)//NOTE: vector grows inside loop
+                if (allClusters.sizes[c] > biggestSize)
                 {
-                    int node = newCluster.members[index];//keep list around so we can put it into the output immediately if it is large enough
-                    newCluster.area += nodeAreas[node];
-                    const vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(node);
-                    int numNeigh = (int)neighbors.size();
-                    for (int n = 0; n < numNeigh; ++n)
-                    {
-                        const int32_t& neighbor = neighbors[n];
-                        if (marked[neighbor])
-                        {
-                            newCluster.members.push_back(neighbor);
-                            marked[neighbor] = 0;
-                        }
-                    }
-                }
-                if (newCluster.area > minArea)
-                {
-                    if (newCluster.area > biggestSize)
-                    {
-                        biggestSize = newCluster.area;
-                        biggestCluster = (int)clusters.size();
-                    }
-                    clusters.push_back(newCluster);
+                    biggestSize = allClusters.sizes[c];
+                    biggestCluster = (int)clusters.size();
                 }
+                clusters.push_back(c);
             }
         }
-        vector<int32_t> pathScratch;
-        vector<float> distScratch;
         if (!clusters.empty() && biggestCluster == -1) CaretLogWarning("clusters found, but none have positive area, check your vertex areas for negatives");
         if (biggestCluster != -1 && (distanceCutoff > 0.0f || areaRatio > 0.0f))
         {
+            vector<int32_t> pathScratch, biggestMembers, thisMembers;
+            vector<float> distScratch;
+            if (distanceCutoff > 0.0f)
+            {
+                const int64_t* members = allClusters.getMembers(clusters[biggestCluster]);
+                biggestMembers.assign(members, members + allClusters.getNumberOfMembers(clusters[biggestCluster]));
+            }
             for (size_t i = 0; i < clusters.size(); ++i)
             {
                 if ((int)i != biggestCluster)
@@ -225,7 +205,7 @@ namespace
                     bool erase = false;
                     if (areaRatio > 0.0f)
                     {
-                        if ((clusters[i].area / biggestSize) < areaRatio)
+                        if ((allClusters.sizes[clusters[i]] / biggestSize) < areaRatio)
                         {
                             erase = true;
                         }
@@ -233,7 +213,9 @@ namespace
                     if (!erase && distanceCutoff > 0.0f)
                     {
                         CaretAssert(myGeoHelp != NULL);
-                        myGeoHelp->getPathBetweenNodeLists(clusters[i].members, clusters[biggestCluster].members, distanceCutoff, pathScratch, distScratch, true);
+                        const int64_t* members = allClusters.getMembers(clusters[i]);
+                        thisMembers.assign(members, members + allClusters.getNumberOfMembers(clusters[i]));
+                        myGeoHelp->getPathBetweenNodeLists(thisMembers, biggestMembers, distanceCutoff, pathScratch, distScratch, true);
                         if (pathScratch.empty())//empty path means no path found
                         {
                             erase = true;
@@ -248,7 +230,29 @@ namespace
                 }
             }
         }
+        for (int i = 0; i < numNodes; ++i)
+        {
+            outData[i] = 0.0f;
+        }
         for (size_t i = 0; i < clusters.size(); ++i)
+        {
+            float tempVal = i + 1;//the caller checks that the count is exactly representable, before relabeling
+            int64_t numMembers = allClusters.getNumberOfMembers(clusters[i]);
+            const int64_t* members = allClusters.getMembers(clusters[i]);
+            for (int64_t index = 0; index < numMembers; ++index)
+            {
+                outData[members[index]] = tempVal;
+            }
+        }
+        return (int64_t)clusters.size();
+    }
+    
+    ///cluster numbers continue across columns, so they are assigned in column order after the columns are processed in parallel
+    vector<float> getClusterMarkings(const int64_t& numClusters, int& markVal)
+    {
+        if ((int64_t)(float)numClusters != numClusters) throw AlgorithmException("too many clusters, unable to mark them uniquely");
+        vector<float> ret(numClusters);
+        for (int64_t i = 0; i < numClusters; ++i)
         {
             if (markVal == 0)
             {
@@ -257,13 +261,10 @@ namespace
             }
             float tempVal = markVal;
             if ((int)tempVal != markVal) throw AlgorithmException("too many clusters, unable to mark them uniquely");
-            int numMembers = (int)clusters[i].members.size();
-            for (int index = 0; index < numMembers; ++index)
-            {
-                outData[clusters[i].members[index]] = tempVal;
-            }
+            ret[i] = tempVal;
             ++markVal;
         }
+        return ret;
     }
 }
 
@@ -302,41 +303,86 @@ AlgorithmMetricFindClusters::AlgorithmMetricFindClusters(ProgressObject* myProgO
     } else {
         nodeAreas = myAreas->getValuePointerForColumn(0);
     }
-    CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
-    CaretPointer<GeodesicHelper> myGeoHelp;
-    CaretPointer<GeodesicHelperBase> myGeoBase;
-    if (distanceCutoff > 0.0f)//geodesic is only needed for distance cutoff
+    vector<int64_t> neighborStart(1, 0), neighbors;//the topology is the same for every column, so set up the cluster graph once
     {
-        if (myAreas == NULL)
+        CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
+        for (int i = 0; i < numNodes; ++i)
         {
-            myGeoHelp = mySurf->getGeodesicHelper();
-        } else {
-            myGeoBase.grabNew(new GeodesicHelperBase(mySurf, myAreas->getValuePointerForColumn(0)));
-            myGeoHelp.grabNew(new GeodesicHelper(myGeoBase));
+            const CaretSpan<int32_t> nodeNeighbors = myTopoHelp->getNodeNeighbors(i);
+            neighbors.insert(neighbors.end(), nodeNeighbors.begin(), nodeNeighbors.end());
+            neighborStart.push_back((int64_t)neighbors.size());
         }
     }
-    vector<int> toSearch;
+    ClusterFindHelper myClusterHelp(neighborStart, neighbors, vector<float>(nodeAreas, nodeAreas + numNodes));
+    CaretPointer<GeodesicHelperBase> myGeoBase;
+    if (distanceCutoff > 0.0f && myAreas != NULL)//geodesic is only needed for distance cutoff
+    {
+        myGeoBase.grabNew(new GeodesicHelperBase(mySurf, myAreas->getValuePointerForColumn(0)));
+    }
     int markVal = startVal;//give each cluster a different value, including across maps
+    vector<int> columns;
     if (columnNum == -1)
     {
         myMetricOut->setNumberOfNodesAndColumns(numNodes, numCols);
-        myMetricOut->setStructure(mySurf->getStructure());
         for (int c = 0; c < numCols; ++c)
         {
-            myMetricOut->setColumnName(c, myMetric->getColumnName(c));
-            vector<float> outData(numNodes, 0.0f);
-            const float* data = myMetric->getValuePointerForColumn(c);
-            processColumn(data, roiData, nodeAreas, myTopoHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, outData.data(), markVal);
-            myMetricOut->setValuesForColumn(c, outData.data());
+            columns.push_back(c);
         }
     } else {
         myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
-        myMetricOut->setStructure(mySurf->getStructure());
-        myMetricOut->setColumnName(0, myMetric->getColumnName(columnNum));
+        columns.push_back(columnNum);
+    }
+    myMetricOut->setStructure(mySurf->getStructure());
+    int numOutCols = (int)columns.size();
+    for (int outCol = 0; outCol < numOutCols; ++outCol)
+    {
+        myMetricOut->setColumnName(outCol, myMetric->getColumnName(columns[outCol]));
+    }
+    vector<int64_t> clusterCounts(numOutCols, 0);
+    vector<const float*> columnData(numOutCols);
+    for (int outCol = 0; outCol < numOutCols; ++outCol)
+    {//read any deferred columns here, read errors can't be thrown out of the parallel loop
+        columnData[outCol] = myMetric->getValuePointerForColumn(columns[outCol]);
+    }
+#pragma omp CARET_PAR
+    {
+        CaretPointer<GeodesicHelper> myGeoHelp;//not thread safe, so each thread gets its own
+        if (distanceCutoff > 0.0f)
+        {
+            if (myAreas == NULL)
+            {
+                myGeoHelp = mySurf->getGeodesicHelper();
+            } else {
+                myGeoHelp.grabNew(new GeodesicHelper(myGeoBase));
+            }
+        }
         vector<float> outData(numNodes, 0.0f);
-        const float* data = myMetric->getValuePointerForColumn(columnNum);
-        processColumn(data, roiData, nodeAreas, myTopoHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, outData.data(), markVal);
-        myMetricOut->setValuesForColumn(0, outData.data());
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int outCol = 0; outCol < numOutCols; ++outCol)
+        {
+            clusterCounts[outCol] = processColumn(columnData[outCol], roiData, myClusterHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, outData.data());
+            myMetricOut->setValuesForColumn(outCol, outData.data());
+        }
+    }
+    vector<vector<float> > markings(numOutCols);
+    for (int outCol = 0; outCol < numOutCols; ++outCol)
+    {
+        markings[outCol] = getClusterMarkings(clusterCounts[outCol], markVal);
+    }
+#pragma omp CARET_PAR
+    {
+        vector<float> outData(numNodes);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int outCol = 0; outCol < numOutCols; ++outCol)
+        {
+            if (clusterCounts[outCol] == 0) continue;
+            const float* localData = myMetricOut->getValuePointerForColumn(outCol);
+            for (int i = 0; i < numNodes; ++i)
+            {
+                outData[i] = (localData[i] > 0.0f ? markings[outCol][(int64_t)localData[i] - 1] : 0.0f);
+            }
+            myMetricOut->setValuesForColumn(outCol, outData.data());
+        }
     }
     if (endVal != NULL) *endVal = markVal;
 }
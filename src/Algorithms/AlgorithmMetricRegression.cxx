@@ -21,9 +21,11 @@
 #include "AlgorithmMetricRegression.h"
 #include "AlgorithmException.h"
 
-#include "FloatMatrix.h"
 #include "MetricFile.h"
 #include "PaletteColorMapping.h"
+#include "RegressionHelper.h"
+
+#include <algorithm>
 
 using namespace caret;
 using namespace std;
@@ -132,7 +134,7 @@ AlgorithmMetricRegression::AlgorithmMetricRegression(ProgressObject* myProgObj,
                                                      const vector<pair<const MetricFile*, int> >& keep, const int& myColumn, const MetricFile* myRoi) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
-    vector<vector<float> > regressCols;//because we are going to de-mean the input data
+    vector<vector<float> > regressCols;//only the values inside the roi, the helper de-means them
     int removeCount = 0;
     int numNodes = myMetricIn->getNumberOfNodes();
     int numColumns = myMetricIn->getNumberOfColumns();
@@ -143,16 +145,15 @@ AlgorithmMetricRegression::AlgorithmMetricRegression(ProgressObject* myProgObj,
     int numRemove = (int)remove.size();
     if (numRemove == 0) throw AlgorithmException("empty remove list in AlgorithmMetricRegression");
     const float* roiData = NULL;
-    int numUsedNodes = numNodes;
     if (myRoi != NULL)
     {
         if (myRoi->getNumberOfNodes() != numNodes) throw AlgorithmException("roi metric has different number of nodes");
         roiData = myRoi->getValuePointerForColumn(0);
-        numUsedNodes = 0;
-        for (int i = 0; i < numNodes; ++i)
-        {
-            if (roiData[i] > 0.0f) ++numUsedNodes;
-        }
+    }
+    vector<int64_t> usedNodes;//observation i is node usedNodes[i], so the input columns can be used directly
+    for (int i = 0; i < numNodes; ++i)
+    {
+        if (roiData == NULL || roiData[i] > 0.0f) usedNodes.push_back(i);
     }
     for (int i = 0; i < numRemove; ++i)
     {
@@ -169,13 +170,13 @@ AlgorithmMetricRegression::AlgorithmMetricRegression(ProgressObject* myProgObj,
             for (int j = 0; j < endCol; ++j)
             {
                 regressCols.push_back(vector<float>());
-                demeanCol(thisMetric->getValuePointerForColumn(j), numNodes, roiData, regressCols.back());
+                roiCol(thisMetric->getValuePointerForColumn(j), numNodes, roiData, regressCols.back());
             }
         } else {
             if (thisCol < 0 || thisCol >= thisMetric->getNumberOfColumns()) throw AlgorithmException("invalid column specified for metric '" + thisMetric->getFileName() + "'");
             ++removeCount;
             regressCols.push_back(vector<float>());
-            demeanCol(thisMetric->getValuePointerForColumn(thisCol), numNodes, roiData, regressCols.back());
+            roiCol(thisMetric->getValuePointerForColumn(thisCol), numNodes, roiData, regressCols.back());
         }
     }
     int numKeep = (int)keep.size();//repeat, without increasing removeCount - this separates what gets removed after regression
@@ -193,135 +194,76 @@ AlgorithmMetricRegression::AlgorithmMetricRegression(ProgressObject* myProgObj,
             for (int j = 0; j < endCol; ++j)
             {
                 regressCols.push_back(vector<float>());
-                demeanCol(thisMetric->getValuePointerForColumn(j), numNodes, roiData, regressCols.back());
+                roiCol(thisMetric->getValuePointerForColumn(j), numNodes, roiData, regressCols.back());
             }
         } else {
             if (thisCol < 0 || thisCol >= thisMetric->getNumberOfColumns()) throw AlgorithmException("invalid column specified for metric '" + thisMetric->getFileName() + "'");
             regressCols.push_back(vector<float>());
-            demeanCol(thisMetric->getValuePointerForColumn(thisCol), numNodes, roiData, regressCols.back());
+            roiCol(thisMetric->getValuePointerForColumn(thisCol), numNodes, roiData, regressCols.back());
         }
     }
-    FloatMatrix xtrans(regressCols);//use naive matrix math - not particularly efficient, but it works
+    RegressionHelper myHelper(regressCols, removeCount);//factorizes the design once, for all columns
     regressCols.clear();//don't need this any more, should call destructor on each member vector and release the memory
-    xtrans = xtrans.concatVert(FloatMatrix::ones(1, numUsedNodes));//add constant term
-    FloatMatrix toInvert = xtrans * xtrans.transpose();
-    int invertSize = toInvert.getNumberOfRows();
-    //a bit of a hack, but it should work, though this causes the work of inversion to be done twice
-    if (toInvert.reducedRowEchelon()[invertSize - 1][invertSize - 1] != 1.0f) throw AlgorithmException("regression encountered a non-invertible matrix, check your inputs for linear independence");
-    FloatMatrix solver = toInvert.inverse() * xtrans;//do most of the math in temporaries
-    if (myColumn == -1)
+    int startColumn = 0, numOutColumns = numColumns;
+    if (myColumn != -1)
+    {
+        startColumn = myColumn;
+        numOutColumns = 1;
+    }
+    myMetricOut->setNumberOfNodesAndColumns(numNodes, numOutColumns);
+    myMetricOut->setStructure(myMetricIn->getStructure());
+    vector<const float*> inPtrs(numOutColumns);
+    for (int i = 0; i < numOutColumns; ++i)
+    {
+        myMetricOut->setColumnName(i, myMetricIn->getColumnName(startColumn + i) + " regressed");
+        *(myMetricOut->getPaletteColorMapping(i)) = *(myMetricIn->getPaletteColorMapping(startColumn + i));
+        inPtrs[i] = myMetricIn->getValuePointerForColumn(startColumn + i);//get pointers before the parallel part, in case columns are read on first access
+    }
+    const int columnsPerBlock = max(1, (1<<24) / numNodes);//64MB of output columns at a time
+    vector<float> blockData((int64_t)min(columnsPerBlock, numOutColumns) * numNodes, 0.0f);//nodes outside the roi are never written, so they stay zero
+    for (int blockStart = 0; blockStart < numOutColumns; blockStart += columnsPerBlock)
     {
-        myMetricOut->setNumberOfNodesAndColumns(numNodes, numColumns);
-        myMetricOut->setStructure(myMetricIn->getStructure());
-        for (int i = 0; i < numColumns; ++i)
+        const int blockCount = min(columnsPerBlock, numOutColumns - blockStart);
+        vector<const float*> blockIn(inPtrs.begin() + blockStart, inPtrs.begin() + blockStart + blockCount);
+        vector<float*> blockOut(blockCount);
+        for (int i = 0; i < blockCount; ++i)
         {
-            myMetricOut->setColumnName(i, myMetricIn->getColumnName(i) + " regressed");
-            *(myMetricOut->getPaletteColorMapping(i)) = *(myMetricIn->getPaletteColorMapping(i));
-            FloatMatrix y(numUsedNodes, 1);//create column vector for input - note that column vectors are extremely inefficient currently, as is copying the data...
-            const float* data = myMetricIn->getValuePointerForColumn(i);
-            int m = 0;
-            for (int j = 0; j < numNodes; ++j)
-            {
-                if (roiData == NULL || roiData[j] > 0.0f)
-                {
-                    y[m][0] = data[j];
-                    ++m;
-                }
-            }
-            FloatMatrix regressed = solver * y;
-            vector<float> outscratch(numNodes);
-            m = 0;
-            for (int j = 0; j < numNodes; ++j)
-            {
-                if (roiData == NULL || roiData[j] > 0.0f)
-                {
-                    outscratch[j] = data[j];
-                    for (int k = 0; k < removeCount; ++k)
-                    {
-                        outscratch[j] -= regressed[k][0] * xtrans[k][m];
-                    }
-                    ++m;
-                } else {
-                    outscratch[j] = 0.0f;
-                }
-            }
-            myMetricOut->setValuesForColumn(i, outscratch.data());
+            blockOut[i] = blockData.data() + (int64_t)i * numNodes;
         }
-    } else {
-        myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
-        myMetricOut->setStructure(myMetricIn->getStructure());
-        myMetricOut->setColumnName(0, myMetricIn->getColumnName(myColumn) + " regressed");
-        *(myMetricOut->getPaletteColorMapping(0)) = *(myMetricIn->getPaletteColorMapping(myColumn));
-        FloatMatrix y(numUsedNodes, 1);//create column vector for input - note that column vectors are extremely inefficient currently, as is copying the data...
-        const float* data = myMetricIn->getValuePointerForColumn(myColumn);
-        int m = 0;
-        for (int j = 0; j < numNodes; ++j)
+        myHelper.removeFit(blockIn, blockOut, usedNodes);//parallel over columns
+        for (int i = 0; i < blockCount; ++i)
         {
-            if (roiData == NULL || roiData[j] > 0.0f)
-            {
-                y[m][0] = data[j];
-                ++m;
-            }
+            myMetricOut->setValuesForColumn(blockStart + i, blockOut[i]);
         }
-        FloatMatrix regressed = solver * y;
-        vector<float> outscratch(numNodes);
-        m = 0;
-        for (int j = 0; j < numNodes; ++j)
-        {
-            if (roiData == NULL || roiData[j] > 0.0f)
-            {
-                outscratch[j] = data[j];
-                for (int k = 0; k < removeCount; ++k)
-                {
-                    outscratch[j] -= regressed[k][0] * xtrans[k][m];
-                }
-                ++m;
-            } else {
-                outscratch[j] = 0.0f;
-            }
-        }
-        myMetricOut->setValuesForColumn(0, outscratch.data());
     }
 }
 
-void AlgorithmMetricRegression::demeanCol(const float* data, const int& count, const float* roiData, std::vector< float >& out)
+void AlgorithmMetricRegression::roiCol(const float* data, const int& count, const float* roiData, float* out)
 {
-    if (roiData == NULL)
+    int m = 0;
+    for (int i = 0; i < count; ++i)
     {
-        double accum = 0.0;
-        for (int i = 0; i < count; ++i)
-        {
-            accum += data[i];
-        }
-        accum /= count;
-        out.resize(count);
-        for (int i = 0; i < count; ++i)
+        if (roiData == NULL || roiData[i] > 0.0f)
         {
-            out[i] = data[i] - accum;
+            out[m] = data[i];
+            ++m;
         }
-    } else {
-        int usedCount = 0;
-        double accum = 0.0;
-        for (int i = 0; i < count; ++i)
-        {
-            if (roiData[i] > 0.0f)
-            {
-                accum += data[i];
-                ++usedCount;
-            }
-        }
-        accum /= usedCount;
-        out.resize(usedCount);
-        int m = 0;
+    }
+}
+
+void AlgorithmMetricRegression::roiCol(const float* data, const int& count, const float* roiData, std::vector<float>& out)
+{
+    int usedCount = count;
+    if (roiData != NULL)
+    {
+        usedCount = 0;
         for (int i = 0; i < count; ++i)
         {
-            if (roiData[i] > 0.0f)
-            {
-                out[m] = data[i] - accum;
-                ++m;
-            }
+            if (roiData[i] > 0.0f) ++usedCount;
         }
     }
+    out.resize(usedCount);
+    roiCol(data, count, roiData, out.data());
 }
 
 float AlgorithmMetricRegression::getAlgorithmInternalWeight()
@@ -31,7 +31,8 @@ namespace caret {
     class AlgorithmMetricRegression : public AbstractAlgorithm
     {
         AlgorithmMetricRegression();
-        void demeanCol(const float* data, const int& count, const float* roiData, std::vector<float>& out);
+        static void roiCol(const float* data, const int& count, const float* roiData, float* out);
+        static void roiCol(const float* data, const int& count, const float* roiData, std::vector<float>& out);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
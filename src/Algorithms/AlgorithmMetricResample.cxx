@@ -69,6 +69,9 @@ OperationParameters* AlgorithmMetricResample::getParameters()
     
     ret->createOptionalParameter(10, "-largest", "use only the value of the vertex with the largest weight");
     
+    OptionalParameter* weightsCacheOpt = ret->createOptionalParameter(11, "-weights-cache", "reuse resampling weights across invocations");
+    weightsCacheOpt->addStringParameter(1, "directory", "an existing directory to store and look up weight files in");
+    
     AString myHelpText =
         AString("Resamples a metric file, given two spherical surfaces that are in register.  ") +
         "If ADAP_BARY_AREA is used, exactly one of -area-surfs or -area-metrics must be specified.\n\n" +
@@ -78,6 +81,8 @@ OperationParameters* AlgorithmMetricResample::getParameters()
         "when using -current-roi.\n\n" +
         "The -largest option results in nearest vertex behavior when used with BARYCENTRIC.  " +
         "When resampling a binary metric, consider thresholding at 0.5 after resampling rather than using -largest.\n\n" +
+        "The -weights-cache option saves the computed vertex weights in the given directory, in a file named by a hash of the spheres, area data, and roi, " +
+        "and later runs with identical inputs load the weights from there instead of recomputing them.\n\n" +
         "The <method> argument must be one of the following:\n\n";
     
     vector<SurfaceResamplingMethodEnum::Enum> allEnums;
@@ -159,12 +164,18 @@ void AlgorithmMetricResample::useParameters(OperationParameters* myParams, Progr
         validRoiOut = validRoiOutOpt->getOutputMetric(1);
     }
     bool largest = myParams->getOptionalParameter(10)->m_present;
-    AlgorithmMetricResample(myProgObj, metricIn, curSphere, newSphere, myMethod, metricOut, curAreas, newAreas, currentRoi, validRoiOut, largest);
+    AString weightsCacheDir;
+    OptionalParameter* weightsCacheOpt = myParams->getOptionalParameter(11);
+    if (weightsCacheOpt->m_present)
+    {
+        weightsCacheDir = weightsCacheOpt->getString(1);
+    }
+    AlgorithmMetricResample(myProgObj, metricIn, curSphere, newSphere, myMethod, metricOut, curAreas, newAreas, currentRoi, validRoiOut, largest, weightsCacheDir);
 }
 
 AlgorithmMetricResample::AlgorithmMetricResample(ProgressObject* myProgObj, const MetricFile* metricIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                  const SurfaceResamplingMethodEnum::Enum& myMethod, MetricFile* metricOut, const MetricFile* curAreas, const MetricFile* newAreas,
-                                                 const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest) : AbstractAlgorithm(myProgObj)
+                                                 const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest, const AString& weightsCacheDir) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     if (metricIn->getNumberOfNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("input metric has different number of nodes than input sphere");
@@ -187,7 +198,7 @@ AlgorithmMetricResample::AlgorithmMetricResample(ProgressObject* myProgObj, cons
     vector<float> colScratch(numNewNodes, 0.0f);
     const float* roiCol = NULL;
     if (currentRoi != NULL) roiCol = currentRoi->getValuePointerForColumn(0);
-    SurfaceResamplingHelper myHelp(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+    SurfaceResamplingHelper myHelp(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol, weightsCacheDir);
     if (validRoiOut != NULL)
     {
         validRoiOut->setNumberOfNodesAndColumns(numNewNodes, 1);
@@ -68,6 +68,9 @@ OperationParameters* AlgorithmMetricSmoothing::getParameters()
     OptionalParameter* methodSelect = ret->createOptionalParameter(9, "-method", "select smoothing method, default GEO_GAUSS_AREA");
     methodSelect->addStringParameter(1, "method", "the name of the smoothing method");
     
+    OptionalParameter* weightsFileOpt = ret->createOptionalParameter(10, "-weights-file", "reuse precomputed smoothing weights");
+    weightsFileOpt->addStringParameter(1, "file", "the file to load the weights from, or save them to");
+    
     ret->setHelpText(
         AString("Smooth a metric file on a surface.  ") +
         "By default, smooths all input columns on the entire surface, specify -column to use only one input column, and -roi to smooth only where " +
@@ -87,6 +90,10 @@ OperationParameters* AlgorithmMetricSmoothing::getParameters()
         "The -corrected-areas option is intended for when it is unavoidable to smooth on a group average surface, it is only an approximate correction " +
         "for the reduction of structure in a group average surface.  It is better to smooth the data on individuals before averaging, when feasible.\n\n" +
         
+        "The -weights-file option saves the precomputed smoothing weights, which can take longer than the smoothing itself, to the specified file.  " +
+        "If the file already exists and was made with the same surface, kernel, method, corrected areas, and (non-matched) roi, the weights are loaded from it instead, " +
+        "otherwise they are recomputed and the file is overwritten.  The file is not portable between machines with different byte order.\n\n" +
+        
         "Valid values for <method> are:\n\n" +
         "GEO_GAUSS_AREA - uses a geodesic gaussian kernel, and normalizes based on vertex area in order to work more reliably on irregular surfaces\n\n" +
         "GEO_GAUSS_EQUAL - uses a geodesic gaussian kernel, and normalizes assuming each vertex has equal importance\n\n" +
@@ -148,12 +155,19 @@ void AlgorithmMetricSmoothing::useParameters(OperationParameters* myParams, Prog
             throw AlgorithmException("unknown smoothing method name");
         }
     }
-    AlgorithmMetricSmoothing(myProgObj, mySurf, myMetric, myKernel, myMetricOut, myRoi, matchRoiColumns, fixZeros, columnNum, corrAreaMetric, myMethod);
+    AString weightsFileName;
+    OptionalParameter* weightsFileOpt = myParams->getOptionalParameter(10);
+    if (weightsFileOpt->m_present)
+    {
+        weightsFileName = weightsFileOpt->getString(1);
+    }
+    AlgorithmMetricSmoothing(myProgObj, mySurf, myMetric, myKernel, myMetricOut, myRoi, matchRoiColumns, fixZeros, columnNum, corrAreaMetric, myMethod, weightsFileName);
 }
 
 AlgorithmMetricSmoothing::AlgorithmMetricSmoothing(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric,
                                                    const double myKernel, MetricFile* myMetricOut, const MetricFile* myRoi, const bool matchRoiColumns,
-                                                   const bool fixZeros, const int64_t columnNum, const MetricFile* corrAreaMetric, const MetricSmoothingObject::Method myMethod) : AbstractAlgorithm(myProgObj)
+                                                   const bool fixZeros, const int64_t columnNum, const MetricFile* corrAreaMetric, const MetricSmoothingObject::Method myMethod,
+                                                   const AString& weightsFileName) : AbstractAlgorithm(myProgObj)
 {
     float precomputeWeightWork = 5.0f;//TODO: adjust this based on number of columns to smooth, if we ever end up using progress indicators
     LevelProgress myProgress(myProgObj, 1.0f + precomputeWeightWork);
@@ -192,9 +206,9 @@ AlgorithmMetricSmoothing::AlgorithmMetricSmoothing(ProgressObject* myProgObj, co
     myProgress.setTask("Precomputing Smoothing Weights");
     if (matchRoiColumns)
     {
-        mySmoothObj.grabNew(new MetricSmoothingObject(mySurf, myKernel, NULL, myMethod, areaData));//don't use an ROI to build weights when the ROI changes each time
+        mySmoothObj.grabNew(new MetricSmoothingObject(mySurf, myKernel, NULL, myMethod, areaData, weightsFileName));//don't use an ROI to build weights when the ROI changes each time
     } else {
-        mySmoothObj.grabNew(new MetricSmoothingObject(mySurf, myKernel, myRoi, myMethod, areaData));
+        mySmoothObj.grabNew(new MetricSmoothingObject(mySurf, myKernel, myRoi, myMethod, areaData, weightsFileName));
     }
     myProgress.reportProgress(precomputeWeightWork);
     if (columnNum == -1)
@@ -23,14 +23,14 @@
 
 #include "AlgorithmMetricSmoothing.h"
 #include "CaretAssert.h"
-#include "CaretHeap.h"
 #include "CaretOMP.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
+#include "TFCEHelper.h"
 #include "TopologyHelper.h"
 
 #include <cmath>
-#include <set>
+#include <fstream>
 #include <vector>
 
 using namespace caret;
@@ -72,6 +72,9 @@ OperationParameters* AlgorithmMetricTFCE::getParameters()
     OptionalParameter* corrAreaOpt = ret->createOptionalParameter(8, "-corrected-areas", "vertex areas to use instead of computing them from the surface");
     corrAreaOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
     
+    OptionalParameter* maxValuesOpt = ret->createOptionalParameter(9, "-max-values", "also write the maximum absolute TFCE value of each column to a text file");
+    maxValuesOpt->addStringParameter(1, "text-out", "output text file, one value per line");
+    
     ret->setHelpText(
         AString("Threshold-free cluster enhancement is a method to increase the relative value of regions that would form clusters in a standard thresholding test.  ") +
         "This is accomplished by evaluating the integral of:\n\n" +
@@ -80,6 +83,8 @@ OperationParameters* AlgorithmMetricTFCE::getParameters()
         "Negative values are similarly enhanced by negating the data, running the same process, and negating the result.\n\n" +
         "When using -presmooth with -corrected-areas, note that it is an approximate correction within the smoothing algorithm (the TFCE correction is exact).  " +
         "Doing smoothing on individual surfaces before averaging/TFCE is preferred, when possible, in order to better tie the smoothing kernel size to the original feature size.\n\n" +
+        "When -max-values is specified, the text file gets one line per output column, containing the maximum absolute TFCE value of that column.  " +
+        "This is intended for building the null distribution from a file of permuted statistics.\n\n" +
         "The TFCE method is explained in: Smith SM, Nichols TE., \"Threshold-free cluster enhancement: addressing problems of smoothing, threshold dependence and localisation in cluster inference.\" Neuroimage. 2009 Jan 1;44(1):83-98. PMID: 18501637"
     );
     return ret;
@@ -126,27 +131,54 @@ void AlgorithmMetricTFCE::useParameters(OperationParameters* myParams, ProgressO
     {
         corrAreaMetric = corrAreaOpt->getMetric(1);
     }
-    AlgorithmMetricTFCE(myProgObj, mySurf, myMetric, myMetricOut, presmooth, myRoi, param_e, param_h, columnNum, corrAreaMetric);
+    OptionalParameter* maxValuesOpt = myParams->getOptionalParameter(9);
+    vector<float> maxValues;
+    AlgorithmMetricTFCE(myProgObj, mySurf, myMetric, myMetricOut, presmooth, myRoi, param_e, param_h, columnNum, corrAreaMetric,
+                        (maxValuesOpt->m_present ? &maxValues : NULL));
+    if (maxValuesOpt->m_present)
+    {
+        ofstream maxFile(maxValuesOpt->getString(1).toLocal8Bit().constData());
+        if (!maxFile)
+        {
+            throw AlgorithmException("failed to open max values output file for writing");
+        }
+        maxFile.precision(8);
+        for (size_t i = 0; i < maxValues.size(); ++i)
+        {
+            maxFile << maxValues[i] << endl;
+        }
+    }
 }
 
 AlgorithmMetricTFCE::AlgorithmMetricTFCE(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric, MetricFile* myMetricOut, const float& presmooth,
-                                         const MetricFile* myRoi, const float& param_e, const float& param_h, const int& columnNum, const MetricFile* corrAreaMetric) : AbstractAlgorithm(myProgObj)
+                                         const MetricFile* myRoi, const float& param_e, const float& param_h, const int& columnNum, const MetricFile* corrAreaMetric,
+                                         vector<float>* maxValuesOut) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     if (mySurf->getNumberOfNodes() != myMetric->getNumberOfNodes()) throw AlgorithmException("metric and surface have different number of vertices");
     if (myRoi != NULL && mySurf->getNumberOfNodes() != myRoi->getNumberOfNodes()) throw AlgorithmException("roi metric and surface have different number of vertices");
     if (corrAreaMetric != NULL && mySurf->getNumberOfNodes() != corrAreaMetric->getNumberOfNodes()) throw AlgorithmException("corrected area metric and surface have different number of vertices");
     if (columnNum < -1 || columnNum >= myMetric->getNumberOfColumns()) throw AlgorithmException("invalid column specified");
-    const float* roiData = NULL, *areaData = NULL;
-    vector<float> surfAreaData;
+    const float* roiData = NULL;
+    int numNodes = mySurf->getNumberOfNodes();
+    vector<float> areaData;
     if (corrAreaMetric == NULL)
     {
-        mySurf->computeNodeAreas(surfAreaData);
-        areaData = surfAreaData.data();
+        mySurf->computeNodeAreas(areaData);
     } else {
-        areaData = corrAreaMetric->getValuePointerForColumn(0);
+        const float* corrAreaData = corrAreaMetric->getValuePointerForColumn(0);
+        areaData.assign(corrAreaData, corrAreaData + numNodes);
     }
     if (myRoi != NULL) roiData = myRoi->getValuePointerForColumn(0);
+    vector<int64_t> neighborStart(1, 0), neighbors;//the topology is the same for every column, so set up the TFCE graph once
+    CaretPointer<TopologyHelper> myHelper = mySurf->getTopologyHelper();
+    for (int i = 0; i < numNodes; ++i)
+    {
+        const CaretSpan<int32_t> nodeNeighbors = myHelper->getNodeNeighbors(i);
+        neighbors.insert(neighbors.end(), nodeNeighbors.begin(), nodeNeighbors.end());
+        neighborStart.push_back((int64_t)neighbors.size());
+    }
+    TFCEHelper myTFCE(neighborStart, neighbors, areaData, roiData, param_e, param_h);
     if (columnNum == -1)
     {
         const MetricFile* toUse = myMetric;
@@ -157,17 +189,20 @@ AlgorithmMetricTFCE::AlgorithmMetricTFCE(ProgressObject* myProgObj, const Surfac
             toUse = &postSmooth;
         }
         int numCols = myMetric->getNumberOfColumns();
-        myMetricOut->setNumberOfNodesAndColumns(mySurf->getNumberOfNodes(), numCols);
+        toUse->readAllDeferredData();//read errors can't be thrown out of the parallel loops
+        if (maxValuesOut != NULL) maxValuesOut->resize(numCols);
+        myMetricOut->setNumberOfNodesAndColumns(numNodes, numCols);
         myMetricOut->setStructure(mySurf->getStructure());
 #pragma omp CARET_PAR
         {
-            vector<float> outcol(mySurf->getNumberOfNodes(), 0.0f);
+            vector<float> outcol(numNodes, 0.0f);
 #pragma omp CARET_FOR
             for (int col = 0; col < numCols; ++col)
             {
-                processColumn(mySurf, toUse->getValuePointerForColumn(col), outcol.data(), roiData, param_e, param_h, areaData);
+                float maxTFCE = myTFCE.computeTFCE(toUse->getValuePointerForColumn(col), outcol.data());
                 myMetricOut->setValuesForColumn(col, outcol.data());
                 myMetricOut->setMapName(col, myMetric->getMapName(col));
+                if (maxValuesOut != NULL) (*maxValuesOut)[col] = maxTFCE;
             }
         }
     } else {
@@ -180,195 +215,13 @@ AlgorithmMetricTFCE::AlgorithmMetricTFCE(ProgressObject* myProgObj, const Surfac
             toUse = &postSmooth;
             useCol = 0;
         }
-        myMetricOut->setNumberOfNodesAndColumns(mySurf->getNumberOfNodes(), 1);
+        myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
         myMetricOut->setStructure(mySurf->getStructure());
-        vector<float> outcol(mySurf->getNumberOfNodes(), 0.0f);
-        processColumn(mySurf, toUse->getValuePointerForColumn(useCol), outcol.data(), roiData, param_e, param_h, areaData);
+        vector<float> outcol(numNodes, 0.0f);
+        float maxTFCE = myTFCE.computeTFCE(toUse->getValuePointerForColumn(useCol), outcol.data());
         myMetricOut->setValuesForColumn(0, outcol.data());
         myMetricOut->setMapName(0, myMetric->getMapName(columnNum));
-    }
-}
-
-void AlgorithmMetricTFCE::processColumn(const SurfaceFile* mySurf, const float* colData, float* outData, const float* roiData, const float& param_e, const float& param_h, const float* areaData)
-{
-    int numNodes = mySurf->getNumberOfNodes();
-    vector<double> accum(numNodes, 0.0);
-    CaretPointer<TopologyHelper> myHelper = mySurf->getTopologyHelper();
-    tfce_pos(myHelper, colData, accum.data(), roiData, param_e, param_h, areaData);
-    vector<float> negData(numNodes);
-    for (int i = 0; i < numNodes; ++i)
-    {
-        negData[i] = -colData[i];
-    }
-    tfce_pos(myHelper, negData.data(), accum.data(), roiData, param_e, param_h, areaData);//negatives and positives don't overlap, so reuse the accum array
-    for (int i = 0; i < numNodes; ++i)
-    {
-        if (roiData == NULL || roiData[i] > 0.0f)
-        {
-            if (colData[i] < 0.0f)
-            {
-                outData[i] = (float)-accum[i];
-            } else {
-                outData[i] = (float)accum[i];
-            }
-        } else {
-            outData[i] = 0.0f;
-        }
-    }
-}
-
-namespace
-{//hidden namespace just to make sure things don't collide
-    struct Cluster
-    {
-        double accumVal, totalArea;
-        vector<int> members;
-        float lastVal;
-        bool first;
-        Cluster()
-        {
-            first = true;
-            accumVal = 0.0;
-            totalArea = 0.0;
-        }
-        void addMember(const int& node, const float& val, const float& area, const float& param_e, const float& param_h)
-        {
-            update(val, param_e, param_h);
-            members.push_back(node);
-            totalArea += area;
-        }
-        void update(const float& bottomVal, const float& param_e, const float& param_h)
-        {
-            if (first)
-            {
-                lastVal = bottomVal;
-                first = false;
-            } else {
-                if (bottomVal != lastVal)//skip computing if there is no difference
-                {
-                    CaretAssert(bottomVal < lastVal);
-                    double integrated_h = param_h + 1.0f;//integral(x^h) = (x^(h + 1))/(h + 1) + C
-                    double newSlice = pow(totalArea, (double)param_e) * (pow((double)lastVal, integrated_h) - pow((double)bottomVal, integrated_h)) / integrated_h;
-                    accumVal += newSlice;
-                    lastVal = bottomVal;//computing in double precision, with float for inputs, puts the smallest difference between values far greater than the instability of the computation
-                }
-            }
-        }
-    };
-    
-    int allocCluster(vector<Cluster>& clusterList, set<int>& deadClusters)
-    {
-        if (deadClusters.empty())
-        {
-            clusterList.push_back(Cluster());
-            return (int)(clusterList.size() - 1);
-        } else {
-            set<int>::iterator iter = deadClusters.begin();
-            int ret = *iter;
-            deadClusters.erase(iter);
-            clusterList[ret] = Cluster();//reinitialize
-            return ret;
-        }
-    }
-}
-
-void AlgorithmMetricTFCE::tfce_pos(TopologyHelper* myHelper, const float* colData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const float* areaData)
-{
-    int numNodes = myHelper->getNumberOfNodes();
-    vector<int> membership(numNodes, -1);//int is enough as long as numNodes is fine as an int, for obvious reasons
-    vector<Cluster> clusterList;
-    set<int> deadClusters;//to allow reallocation without changing indices
-    CaretSimpleMaxHeap<int, float> nodeHeap;
-    for (int i = 0; i < numNodes; ++i)
-    {
-        if ((roiData == NULL || roiData[i] > 0.0f) && colData[i] > 0.0f)
-        {
-            nodeHeap.push(i, colData[i]);
-        }
-    }
-    while (!nodeHeap.isEmpty())
-    {
-        float value;
-        int node = nodeHeap.pop(&value);
-        const vector<int32_t>& neighbors = myHelper->getNodeNeighbors(node);
-        int numNeigh = (int)neighbors.size();
-        set<int> touchingClusters;
-        for (int i = 0; i < numNeigh; ++i)
-        {
-            if (membership[neighbors[i]] != -1)
-            {
-                touchingClusters.insert(membership[neighbors[i]]);
-            }
-        }
-        int numTouching = (int)touchingClusters.size();
-        switch (numTouching)
-        {
-            case 0://make new cluster
-            {
-                int newCluster = allocCluster(clusterList, deadClusters);
-                clusterList[newCluster].addMember(node, value, areaData[node], param_e, param_h);
-                membership[node] = newCluster;
-                break;
-            }
-            case 1://add to cluster
-            {
-                int whichCluster = *(touchingClusters.begin());
-                clusterList[whichCluster].addMember(node, value, areaData[node], param_e, param_h);
-                membership[node] = whichCluster;
-                accumData[node] -= clusterList[whichCluster].accumVal;//the accum value is the current amount less than the peak value that the edge of the cluster has (this node is on the edge)
-                break;//so, when the cluster merges or reaches 0, we add the accum value to every member and zero the accum value of the merged cluster, and we get the correct value in the end (with far fewer flops than integrating everywhere)
-            }
-            default://merge all touching clusters
-            {
-                int mergedIndex = -1, biggestSize = 0;//find the biggest cluster (in number of members) and use as merged cluster, for optimization purposes
-                for (set<int>::iterator iter = touchingClusters.begin(); iter != touchingClusters.end(); ++iter)
-                {
-                    if ((int)clusterList[*iter].members.size() > biggestSize)
-                    {
-                        mergedIndex = *iter;
-                        biggestSize = (int)clusterList[*iter].members.size();
-                    }
-                }
-                CaretAssertVectorIndex(clusterList, mergedIndex);
-                Cluster& mergedCluster = clusterList[mergedIndex];
-                mergedCluster.update(value, param_e, param_h);//recalculate to align cluster bottoms
-                for (set<int>::iterator iter = touchingClusters.begin(); iter != touchingClusters.end(); ++iter)
-                {
-                    if (*iter != mergedIndex)//if we are the largest cluster, don't modify the per-vertex accum for members, so merges between small and large clusters are cheap
-                    {
-                        Cluster& thisCluster = clusterList[*iter];
-                        thisCluster.update(value, param_e, param_h);//recalculate to align cluster bottoms
-                        int numMembers = (int)thisCluster.members.size();
-                        double correctionVal = thisCluster.accumVal - mergedCluster.accumVal;//fix the accum values in the side cluster so we can add the merged cluster's accum to everything at the end
-                        for (int j = 0; j < numMembers; ++j)//add the correction value to every member so that we have the current integrated values correct
-                        {
-                            accumData[thisCluster.members[j]] += correctionVal;//apply the correction
-                            membership[thisCluster.members[j]] = mergedIndex;//change the membership lookup
-                        }
-                        mergedCluster.members.insert(mergedCluster.members.end(), thisCluster.members.begin(), thisCluster.members.end());//copy all members
-                        mergedCluster.totalArea += thisCluster.totalArea;
-                        deadClusters.insert(*iter);//kill it
-                        vector<int>().swap(clusterList[*iter].members);//also try to deallocate member list
-                    }
-                }
-                mergedCluster.addMember(node, value, areaData[node], param_e, param_h);//will not trigger recomputation, we already recomputed at this value
-                accumData[node] -= mergedCluster.accumVal;//the vertex they merge on must not get the peak value of the cluster, obviously, so again, record its difference from peak
-                membership[node] = mergedIndex;
-                break;//NOTE: do not reset the accum value of the merged cluster, we specifically avoided modifying the per-vertex accum for its members, so the cluster accum is still in play
-            }
-        }
-    }
-    int listSize = (int)clusterList.size();//final cleanup of accum values
-    for (int i = 0; i < listSize; ++i)
-    {
-        if (deadClusters.find(i) != deadClusters.end()) continue;//ignore clusters that don't exist
-        Cluster& thisCluster = clusterList[i];
-        thisCluster.update(0.0f, param_e, param_h);//update to include the to-zero slice
-        int numMembers = (int)thisCluster.members.size();
-        for (int j = 0; j < numMembers; ++j)
-        {
-            accumData[thisCluster.members[j]] += thisCluster.accumVal;//add the resulting slice to all members - their stored data contains the offset between the cluster peak and their corect value
-        }
+        if (maxValuesOut != NULL) maxValuesOut->assign(1, maxTFCE);
     }
 }
 
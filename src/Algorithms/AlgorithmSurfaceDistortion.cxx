@@ -170,7 +170,7 @@ AlgorithmSurfaceDistortion::AlgorithmSurfaceDistortion(ProgressObject* myProgObj
         CaretPointer<TopologyHelper> myhelp = referenceSurf->getTopologyHelper();
         for (int i = 0; i < numNodes; ++i)
         {
-            const vector<int32_t>& myTiles = myhelp->getNodeTiles(i);
+            const CaretSpan<int32_t> myTiles = myhelp->getNodeTiles(i);
             int tileCount = (int)myTiles.size();
             double accum = 0.0;
             for (int j = 0; j < tileCount; ++j)
@@ -203,7 +203,7 @@ AlgorithmSurfaceDistortion::AlgorithmSurfaceDistortion(ProgressObject* myProgObj
         {
             Vector3D refCenter = refCoords + i * 3;
             Vector3D distortCenter = distortCoords + i * 3;
-            const vector<int32_t>& neighbors = myhelp->getNodeNeighbors(i);
+            const CaretSpan<int32_t> neighbors = myhelp->getNodeNeighbors(i);
             int numNeigh = (int)neighbors.size();
             float accum = 0.0f;
             for (int j = 0; j < numNeigh; ++j)
@@ -270,7 +270,7 @@ AlgorithmSurfaceDistortion::AlgorithmSurfaceDistortion(ProgressObject* myProgObj
         CaretPointer<TopologyHelper> myTopoHelp = referenceSurf->getTopologyHelper();
         for (int i = 0; i < numNodes; ++i)
         {
-            const vector<int32_t>& myTiles = myTopoHelp->getNodeTiles(i);
+            const CaretSpan<int32_t> myTiles = myTopoHelp->getNodeTiles(i);
             double accumJ = 0.0, accumR = 0.0;
             for (int j = 0; j < (int)myTiles.size(); ++j)
             {
@@ -19,8 +19,6 @@
  */
 /*LICENSE_END*/
 
-#include <cmath>
-
 #include "AlgorithmSurfaceInflation.h"
 #include "AlgorithmSurfaceSmoothing.h"
 #include "AlgorithmException.h"
@@ -28,6 +26,7 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "SurfaceFile.h"
+#include "SurfaceSmoothingHelper.h"
 
 using namespace caret;
 
@@ -138,12 +137,16 @@ AlgorithmSurfaceInflation::AlgorithmSurfaceInflation(ProgressObject* myProgObj,
                                                      const float inflationFactorIn)
    : AbstractAlgorithm(myProgObj)
 {
-    std::vector<ProgressObject*> subAlgProgress;
-    if (myProgObj != NULL) {
-        subAlgProgress.resize(cycles);
-        for (int32_t i = 0; i < cycles; ++i)
-        {
-            subAlgProgress[i] = myProgObj->addAlgorithm(AlgorithmSurfaceSmoothing::getAlgorithmWeight());
+    if (cycles > 0) {
+        if ((strength < 0.0)
+            || (strength > 1.0)) {
+            throw AlgorithmException("Invalid smoothing strength outside [0.0, 1.0]: "
+                                     + QString::number(strength, 'f', 5));
+        }
+        
+        if (iterations <= 0) {
+            throw AlgorithmException("Invalid iterations value [1, infinity]: "
+                                     + QString::number(iterations));
         }
     }
     
@@ -151,7 +154,7 @@ AlgorithmSurfaceInflation::AlgorithmSurfaceInflation(ProgressObject* myProgObj,
      * Sets the algorithm up to use the progress object, and will
      * finish the progress object automatically when the algorithm terminates
      */
-    LevelProgress myProgress(myProgObj, 1.0f, 0.1f);//lower the internal weight
+    LevelProgress myProgress(myProgObj);
     
     const float inflationFactor = inflationFactorIn - 1.0;
     
@@ -159,52 +162,40 @@ AlgorithmSurfaceInflation::AlgorithmSurfaceInflation(ProgressObject* myProgObj,
     outputSurfaceFile->translateToCenterOfMass();
     
     const BoundingBox* anatomicalBoundingBox = anatomicalSurfaceFile->getBoundingBox();
-    const float anatomicalRangeX = anatomicalBoundingBox->getDifferenceX();
-    const float anatomicalRangeY = anatomicalBoundingBox->getDifferenceY();
-    const float anatomicalRangeZ = anatomicalBoundingBox->getDifferenceZ();
+    const float anatomicalRanges[3] = {
+        anatomicalBoundingBox->getDifferenceX(),
+        anatomicalBoundingBox->getDifferenceY(),
+        anatomicalBoundingBox->getDifferenceZ()
+    };
     
-    const int32_t numberOfNodes = outputSurfaceFile->getNumberOfNodes();
+    /*
+     * Topology is flattened once and coordinates stay in the
+     * helper for all cycles
+     */
+    SurfaceSmoothingHelper smoothingHelper(outputSurfaceFile);
     
     for (int iCycle = 0; iCycle < cycles; iCycle++) {
         /*
          * Smooth
          */
-        ProgressObject* subProgress = NULL;
-        if (myProgObj != NULL)
-        {
-            subProgress = subAlgProgress[iCycle];
+        for (int32_t iter = 0; iter < iterations; iter++) {
+            smoothingHelper.smooth(strength);
+            myProgress.reportProgress(static_cast<float>(iCycle * iterations + iter + 1)
+                                      / static_cast<float>(cycles * iterations));
         }
-        AlgorithmSurfaceSmoothing(subProgress,
-                                  outputSurfaceFile,
-                                  outputSurfaceFile,
-                                  strength,
-                                  iterations);
         
         /*
          * Inflate
          */
-        float xyz[3];
-        for (int32_t iNode = 0; iNode < numberOfNodes; iNode++) {
-            outputSurfaceFile->getCoordinate(iNode,
-                                             xyz);
-            
-            const float x = xyz[0] / anatomicalRangeX;
-            const float y = xyz[1] / anatomicalRangeY;
-            const float z = xyz[2] / anatomicalRangeZ;
-            
-            const float radius = std::sqrt(x*x + y*y + z*z);
-            const float scale  = 1.0 + inflationFactor * (1.0 - radius);
-            
-            xyz[0] *= scale;
-            xyz[1] *= scale;
-            xyz[2] *= scale;
-            
-            outputSurfaceFile->setCoordinate(iNode,
-                                             xyz);
-        }
-        
-        myProgress.reportProgress(static_cast<float>(iCycle +1)
-                                  / static_cast<float>(cycles));
+        smoothingHelper.inflate(inflationFactor,
+                                anatomicalRanges);
+    }
+    
+    if ((cycles > 0)
+        && (smoothingHelper.getNumberOfNodes() > 0)) {
+        std::vector<float> coords;
+        smoothingHelper.getCoordinates(coords);
+        outputSurfaceFile->setCoordinates(&coords[0]);
     }
     
     outputSurfaceFile->computeNormals();
@@ -219,7 +210,7 @@ AlgorithmSurfaceInflation::getAlgorithmInternalWeight()
     /*
      * override this if needed, if the progress bar isn't smooth
      */
-    return 0.1f;//all this does internally is rescale the coordinates, lower the internal weight
+    return AlgorithmSurfaceSmoothing::getAlgorithmWeight() + 0.1f;//smoothing is done internally through SurfaceSmoothingHelper, rescaling the coordinates is cheap
 }
 
 /**
@@ -231,6 +222,6 @@ AlgorithmSurfaceInflation::getSubAlgorithmWeight()
     /*
      * If you use a subalgorithm
      */
-    return AlgorithmSurfaceSmoothing::getAlgorithmWeight();
+    return 0.0f;
 }
 
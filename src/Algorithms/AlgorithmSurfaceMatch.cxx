@@ -64,6 +64,7 @@ AlgorithmSurfaceMatch::getParameters()
     
     ret->addSurfaceParameter(1, "Match Surface File", "Match (Reference) Surface");
     ret->addSurfaceParameter(2, "Input Surface File", "File containing surface that will be transformed");
+    ret->setInputModifiedInPlace(2);//transformed in memory before writing
     ret->addStringParameter(3, "Output Surface Name", "Surface File after transformation");
     
     AString helpText = ("The Input Surface File will be transformed so that its coordinate "
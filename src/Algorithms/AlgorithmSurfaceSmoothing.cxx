@@ -24,9 +24,8 @@
 
 #include "AlgorithmSurfaceSmoothing.h"
 #include "AlgorithmException.h"
-#include "MathFunctions.h"
 #include "SurfaceFile.h"
-#include "TopologyHelper.h"
+#include "SurfaceSmoothingHelper.h"
 
 using namespace caret;
 
@@ -142,139 +141,22 @@ AlgorithmSurfaceSmoothing::AlgorithmSurfaceSmoothing(ProgressObject* myProgObj,
     
     *outputSurfaceFile = *inputSurfaceFile;
     
-    CaretPointer<TopologyHelper> myTopoHelp = outputSurfaceFile->getTopologyHelper(true);
-    
     const int32_t numNodes = outputSurfaceFile->getNumberOfNodes();
     if (numNodes <= 0) {
         return;
     }
     
     /*
-     * Storage for coordinates, input and output of each iteration
+     * Flattened topology, with the coordinates held by the helper
+     * between iterations
      */
-    std::vector<float> coordsIn(numNodes * 3);
-    std::vector<float> coordsOut(numNodes * 3);
-    
-    /*
-     * Copy coordinates from surface
-     */
-    for (int32_t i = 0; i < numNodes; i++) {
-        const float* xyz = outputSurfaceFile->getCoordinate(i);
-        
-        const int32_t i3 = i * 3;
-        coordsIn[i3]   = xyz[0];
-        coordsIn[i3+1] = xyz[1];
-        coordsIn[i3+2] = xyz[2];
-        coordsOut[i3]   = xyz[0];
-        coordsOut[i3+1] = xyz[1];
-        coordsOut[i3+2] = xyz[2];
-    }
-    
-    std::vector<float> triangleAreas(100);
-    std::vector<float> triangleCenters(100*3);
-    
-    const float inverseStrength = 1.0 - strength;
+    SurfaceSmoothingHelper smoothingHelper(outputSurfaceFile);
     
     /*
      * Perform the requested number of iterations
      */
     for (int32_t iter = 1; iter <= iterations; iter++) {
-        /*
-         * Copy coordinates from previous iteration
-         */
-        if (iter > 1) {
-            coordsIn = coordsOut;
-        }
-        
-        /*
-         * Process each node
-         */
-        for (int32_t iNode = 0; iNode < numNodes; iNode++) {
-            /*
-             * Get node's neighbors
-             */
-            int32_t numNeighbors = 0;
-            const int32_t* neighbors = myTopoHelp->getNodeNeighbors(iNode, numNeighbors);
-            
-            if (numNeighbors < 2) {
-                coordsOut[iNode*3]   = coordsIn[iNode*3];
-                coordsOut[iNode*3+1] = coordsIn[iNode*3+1];
-                coordsOut[iNode*3+2] = coordsIn[iNode*3+2];
-            }
-            else {
-                /*
-                 * Ensure adequate space for triangle areas and center coordinate
-                 */
-                if (numNeighbors > static_cast<int32_t>(triangleAreas.size())) {
-                    triangleAreas.resize(numNeighbors);
-                    triangleCenters.resize(numNeighbors * 3);
-                }
-                double totalArea = 0.0;
-                
-                /*
-                 * Average node with its neighbors
-                 */
-                for (int jn = 0; jn < numNeighbors; jn++) {
-                    /*
-                     * Get two consecutive neighbors
-                     */
-                    const int32_t n1 = neighbors[jn];
-                    int nextNeighborIndex = jn + 1;
-                    if (nextNeighborIndex >= numNeighbors) {
-                        nextNeighborIndex = 0;
-                    }
-                    const int32_t n2 = neighbors[nextNeighborIndex];
-                    
-                    /*
-                     * Coordinates of nodes and neighbors
-                     */
-                    const float* c1 = &coordsIn[iNode*3];
-                    const float* c2 = &coordsIn[n1*3];
-                    const float* c3 = &coordsIn[n2*3];
-                    const float area = MathFunctions::triangleArea(c1,
-                                                                   c2,
-                                                                   c3);
-                    
-                    /*
-                     * Area of triangle formed by node and neighbors
-                     */
-                    triangleAreas[jn] = area;
-                    totalArea += area;
-                    
-                    /*
-                     * Average of nodes that form triangle
-                     */
-                    for (int32_t k = 0; k < 3; k++) {
-                        triangleCenters[jn*3+k] = (c1[k] + c2[k] + c3[k]) / 3.0;
-                    }
-                }
-                    
-                /*
-                 * Influence of neighbors
-                 */
-                float neighborAverageX = 0.0;
-                float neighborAverageY = 0.0;
-                float neighborAverageZ = 0.0;
-                for (int j = 0; j < numNeighbors; j++) {
-                    if (triangleAreas[j] > 0.0) {
-                        const float weight = triangleAreas[j] / totalArea;
-                        neighborAverageX += (weight * triangleCenters[j*3]);
-                        neighborAverageY += (weight * triangleCenters[j*3+1]);
-                        neighborAverageZ += (weight * triangleCenters[j*3+2]);
-                    }
-                }
-                
-                /*
-                 * Update coordinates
-                 */
-                coordsOut[iNode*3]   = ((coordsIn[iNode*3] * inverseStrength)
-                                        + (neighborAverageX * strength));
-                coordsOut[iNode*3+1] = ((coordsIn[iNode*3+1] * inverseStrength)
-                                        + (neighborAverageY * strength));
-                coordsOut[iNode*3+2] = ((coordsIn[iNode*3+2] * inverseStrength)
-                                        + (neighborAverageZ * strength));
-            }
-        }
+        smoothingHelper.smooth(strength);
         
         /*
          * Update progress
@@ -288,6 +170,8 @@ AlgorithmSurfaceSmoothing::AlgorithmSurfaceSmoothing(ProgressObject* myProgObj,
     /*
      * Copy coordinates into surface
      */
+    std::vector<float> coordsOut;
+    smoothingHelper.getCoordinates(coordsOut);
     outputSurfaceFile->setCoordinates(&coordsOut[0]);
 
     myProgress.reportProgress(1.0f);
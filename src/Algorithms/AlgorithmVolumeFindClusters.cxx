@@ -25,6 +25,7 @@
 #include "CaretLogger.h"
 #include "CaretPointer.h"
 #include "CaretPointLocator.h"
+#include "ClusterFindHelper.h"
 #include "VolumeFile.h"
 #include "VoxelIJK.h"
 
@@ -135,23 +136,21 @@ void AlgorithmVolumeFindClusters::useParameters(OperationParameters* myParams, P
 
 namespace
 {
-    void processSubvol(const float* inFrame, VolumeFile* volOut, const int64_t& outSubvol, const int64_t& outComponent, const float& threshValue, const float& minVolume,
-                       const bool& lessThan, const float* roiFrame, const float& sizeRatio, const float& distanceCutoff, int& markVal)
+    VoxelIJK indexToIJK(const VolumeSpace& mySpace, const int64_t& index)
     {
-        vector<int64_t> dims = volOut->getDimensions();
-        int64_t frameSize = dims[0] * dims[1] * dims[2];
-        const VolumeSpace& mySpace = volOut->getVolumeSpace();
+        const int64_t* dims = mySpace.getDims();
+        return VoxelIJK(index % dims[0], (index / dims[0]) % dims[1], index / (dims[0] * dims[1]));
+    }
+    
+    ///outFrame gets the cluster number within the frame, starting from 1, returns the number of clusters kept
+    int64_t processSubvol(const float* inFrame, const VolumeSpace& mySpace, const ClusterFindHelper& myClusterHelp, const float& threshValue, const float& minVolume,
+                          const bool& lessThan, const float* roiFrame, const float& sizeRatio, const float& distanceCutoff, float* outFrame)
+    {
+        int64_t frameSize = myClusterHelp.getNumberOfElements();
         Vector3D ivec, jvec, kvec, origin;
         mySpace.getSpacingVectors(ivec, jvec, kvec, origin);
         float voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
         int64_t minVoxels = (int64_t)ceil(minVolume / voxelVolume);
-        vector<VoxelIJK> neighbors;
-        neighbors.push_back(VoxelIJK(1, 0, 0));
-        neighbors.push_back(VoxelIJK(-1, 0, 0));
-        neighbors.push_back(VoxelIJK(0, 1, 0));
-        neighbors.push_back(VoxelIJK(0, -1, 0));
-        neighbors.push_back(VoxelIJK(0, 0, 1));
-        neighbors.push_back(VoxelIJK(0, 0, -1));
         vector<char> marked(frameSize, 0);
         if (lessThan)
         {
@@ -171,51 +170,22 @@ namespace
                 }
             }
         }
-        vector<vector<VoxelIJK> > clusters;
-        size_t biggestCount = 0;
+        ClusterFindHelper::ClusterList allClusters;
+        myClusterHelp.findClusters(marked.data(), allClusters);
+        vector<int64_t> clusters;//indices into allClusters of the clusters that are large enough
+        int64_t biggestCount = 0;
         int64_t biggestCluster = -1;
-        for (int64_t k = 0; k < dims[2]; ++k)
+        for (int64_t c = 0; c < allClusters.getNumberOfClusters(); ++c)
         {
-            for (int64_t j = 0; j < dims[1]; ++j)
+            int64_t count = allClusters.getNumberOfMembers(c);
+            if (count >= minVoxels)
             {
-                for (int64_t i = 0; i < dims[0]; ++i)
+                if (count > biggestCount)
                 {
-                    int64_t myIndex = mySpace.getIndex(i, j, k);
-                    if (marked[myIndex])
-                    {
-                        vector<VoxelIJK> voxelList;
-                        voxelList.push_back(VoxelIJK(i, j, k));
-                        marked[myIndex] = 0;//don't let voxels get duplicated in the list
-                        for (int64_t index = 0; index < (int64_t)voxelList.size(); ++index)//NOTE: vector grows inside loop
-                        {
-                            const VoxelIJK& thisVoxel = voxelList[index];
-                            for (int n = 0; n < (int)neighbors.size(); ++n)
-                            {
-                                VoxelIJK neighVox(thisVoxel.m_ijk[0] + neighbors[n].m_ijk[0],
-                                                    thisVoxel.m_ijk[1] + neighbors[n].m_ijk[1],
-                                                    thisVoxel.m_ijk[2] + neighbors[n].m_ijk[2]);
-                                if (mySpace.indexValid(neighVox.m_ijk))
-                                {
-                                    int64_t neighIndex = mySpace.getIndex(neighVox.m_ijk);
-                                    if (marked[neighIndex])
-                                    {
-                                        voxelList.push_back(neighVox);
-                                        marked[neighIndex] = 0;
-                                    }
-                                }
-                            }
-                        }
-                        if ((int64_t)voxelList.size() >= minVoxels)
-                        {
-                            if (voxelList.size() > biggestCount)
-                            {
-                                biggestCount = voxelList.size();
-                                biggestCluster = (int64_t)clusters.size();
-                            }
-                            clusters.push_back(voxelList);
-                        }
-                    }
+                    biggestCount = count;
+                    biggestCluster = (int64_t)clusters.size();
                 }
+                clusters.push_back(c);
             }
         }
         if (!clusters.empty()) CaretAssert(biggestCluster != -1);
@@ -226,10 +196,11 @@ namespace
             {
                 vector<float> biggestCoords;//gather coordinates of biggest cluster voxels
                 biggestCoords.reserve(biggestCount * 3);
-                for (size_t i = 0; i < clusters[biggestCluster].size(); ++i)
+                const int64_t* members = allClusters.getMembers(clusters[biggestCluster]);
+                for (int64_t i = 0; i < biggestCount; ++i)
                 {
                     float thisCoord[3];
-                    mySpace.indexToSpace(clusters[biggestCluster][i].m_ijk, thisCoord);
+                    mySpace.indexToSpace(indexToIJK(mySpace, members[i]), thisCoord);
                     biggestCoords.push_back(thisCoord[0]);
                     biggestCoords.push_back(thisCoord[1]);
                     biggestCoords.push_back(thisCoord[2]);
@@ -241,17 +212,19 @@ namespace
                 if ((int64_t)i != biggestCluster)
                 {
                     bool erase = false;
-                    if (sizeRatio > 0.0f && ((float)clusters[i].size()) / biggestCount < sizeRatio)
+                    int64_t count = allClusters.getNumberOfMembers(clusters[i]);
+                    if (sizeRatio > 0.0f && ((float)count) / biggestCount < sizeRatio)
                     {
                         erase = true;
                     }
                     if (!erase && distanceCutoff > 0.0f)
                     {
                         erase = true;//erase unless we find a point close enough to the biggest cluster
-                        for (size_t j = 0; j < clusters[i].size(); ++j)
+                        const int64_t* members = allClusters.getMembers(clusters[i]);
+                        for (int64_t j = 0; j < count; ++j)
                         {
                             float thisCoord[3];
-                            mySpace.indexToSpace(clusters[i][j].m_ijk, thisCoord);
+                            mySpace.indexToSpace(indexToIJK(mySpace, members[j]), thisCoord);
                             int32_t ret = myLocator->closestPointLimited(thisCoord, distanceCutoff);
                             if (ret == -1)
                             {
@@ -269,7 +242,29 @@ namespace
                 }
             }
         }
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            outFrame[i] = 0.0f;
+        }
         for (size_t i = 0; i < clusters.size(); ++i)
+        {
+            float tempVal = i + 1;//the caller checks that the count is exactly representable, before relabeling
+            int64_t count = allClusters.getNumberOfMembers(clusters[i]);
+            const int64_t* members = allClusters.getMembers(clusters[i]);
+            for (int64_t index = 0; index < count; ++index)
+            {
+                outFrame[members[index]] = tempVal;
+            }
+        }
+        return (int64_t)clusters.size();
+    }
+    
+    ///cluster numbers continue across frames, so they are assigned in frame order after the frames are processed in parallel
+    vector<float> getClusterMarkings(const int64_t& numClusters, int& markVal)
+    {
+        if ((int64_t)(float)numClusters != numClusters) throw AlgorithmException("too many clusters, unable to mark them uniquely");
+        vector<float> ret(numClusters);
+        for (int64_t i = 0; i < numClusters; ++i)
         {
             if (markVal == 0)
             {
@@ -278,12 +273,10 @@ namespace
             }
             float tempVal = markVal;
             if ((int)tempVal != markVal) throw AlgorithmException("too many clusters, unable to mark them uniquely");
-            for (size_t index = 0; index < clusters[i].size(); ++index)
-            {
-                volOut->setValue(tempVal, clusters[i][index].m_ijk, outSubvol, outComponent);
-            }
+            ret[i] = tempVal;
             ++markVal;
         }
+        return ret;
     }
 }
 
@@ -304,28 +297,59 @@ AlgorithmVolumeFindClusters::AlgorithmVolumeFindClusters(ProgressObject* myProgO
         roiFrame = myRoi->getFrame();
     }
     vector<int64_t> dims = volIn->getDimensions();
+    const int64_t frameSize = dims[0] * dims[1] * dims[2];
+    Vector3D ivec, jvec, kvec, origin;
+    mySpace.getSpacingVectors(ivec, jvec, kvec, origin);
+    ClusterFindHelper myClusterHelp(dims.data(), abs(ivec.dot(jvec.cross(kvec))));//face neighbors, the same for every frame
     int markVal = startVal;
+    vector<int64_t> inBricks;
     if (subvolNum == -1)
     {
         volOut->reinitialize(volIn->getOriginalDimensions(), volIn->getSform(), dims[4]);
-        volOut->setValueAllVoxels(0.0f);
-        for (int64_t c = 0; c < dims[4]; ++c)
+        for (int64_t s = 0; s < dims[3]; ++s)
         {
-            for (int64_t s = 0; s < dims[3]; ++s)
-            {
-                const float* inFrame = volIn->getFrame(s, c);
-                processSubvol(inFrame, volOut, s, c, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, markVal);
-            }
+            inBricks.push_back(s);
         }
     } else {
         vector<int64_t> outDims = volIn->getOriginalDimensions();
         outDims.resize(3);
         volOut->reinitialize(outDims, volIn->getSform(), dims[4]);
-        volOut->setValueAllVoxels(0.0f);
-        for (int64_t c = 0; c < dims[4]; ++c)
+        inBricks.push_back(subvolNum);
+    }
+    const int64_t numInBricks = (int64_t)inBricks.size();
+    const int64_t numOutFrames = numInBricks * dims[4];//component major, to match the order clusters were always numbered in
+    vector<int64_t> clusterCounts(numOutFrames, 0);
+#pragma omp CARET_PAR
+    {
+        vector<float> outFrame(frameSize);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t f = 0; f < numOutFrames; ++f)
         {
-            const float* inFrame = volIn->getFrame(subvolNum, c);
-            processSubvol(inFrame, volOut, 0, c, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, markVal);
+            int64_t b = f % numInBricks, c = f / numInBricks;
+            const float* inFrame = volIn->getFrame(inBricks[b], c);
+            clusterCounts[f] = processSubvol(inFrame, mySpace, myClusterHelp, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, outFrame.data());
+            volOut->setFrame(outFrame.data(), b, c);
+        }
+    }
+    vector<vector<float> > markings(numOutFrames);
+    for (int64_t f = 0; f < numOutFrames; ++f)
+    {
+        markings[f] = getClusterMarkings(clusterCounts[f], markVal);
+    }
+#pragma omp CARET_PAR
+    {
+        vector<float> outFrame(frameSize);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t f = 0; f < numOutFrames; ++f)
+        {
+            if (clusterCounts[f] == 0) continue;
+            int64_t b = f % numInBricks, c = f / numInBricks;
+            const float* localFrame = volOut->getFrame(b, c);
+            for (int64_t i = 0; i < frameSize; ++i)
+            {
+                outFrame[i] = (localFrame[i] > 0.0f ? markings[f][(int64_t)localFrame[i] - 1] : 0.0f);
+            }
+            volOut->setFrame(outFrame.data(), b, c);
         }
     }
     if (endVal != NULL) *endVal = markVal;
@@ -0,0 +1,134 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmVolumeRegression.h"
+#include "AlgorithmException.h"
+
+#include "RegressionHelper.h"
+#include "VolumeFile.h"
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmVolumeRegression::getCommandSwitch()
+{
+    return "-volume-regression";
+}
+
+AString AlgorithmVolumeRegression::getShortDescription()
+{
+    return "REGRESS TIMESERIES OUT OF A VOLUME FILE";
+}
+
+OperationParameters* AlgorithmVolumeRegression::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addVolumeParameter(1, "volume-in", "the volume file to regress from");
+    
+    ret->addVolumeOutputParameter(2, "volume-out", "the output volume file");
+    
+    ParameterComponent* removeOpt = ret->createRepeatableParameter(3, "-remove", "specify regressors to regress out");
+    removeOpt->addStringParameter(1, "regressor-file", "text file with one line per subvolume of the input, and one regressor per column of the text file");
+    
+    ParameterComponent* keepOpt = ret->createRepeatableParameter(4, "-keep", "specify regressors to include in regression, but not remove");
+    keepOpt->addStringParameter(1, "regressor-file", "text file with one line per subvolume of the input, and one regressor per column of the text file");
+    
+    ret->setHelpText(
+        AString("For each regressor, its mean is subtracted from its data.  ") +
+        "The timeseries of each voxel is then regressed against these, and a constant term.  The resulting regressed slopes of all regressors specified with -remove " +
+        "are multiplied with their respective regressors, and these are subtracted from the timeseries."
+    );
+    return ret;
+}
+
+void AlgorithmVolumeRegression::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    VolumeFile* myVolIn = myParams->getVolume(1);
+    VolumeFile* myVolOut = myParams->getOutputVolume(2);
+    vector<vector<float> > remove, keep;
+    const vector<ParameterComponent*>& removeInstances = *(myParams->getRepeatableParameterInstances(3));
+    int numRemove = (int)removeInstances.size();
+    if (numRemove == 0) throw AlgorithmException("you must specify at least one 'remove' file");
+    for (int i = 0; i < numRemove; ++i)
+    {
+        vector<vector<float> > fileRegressors = RegressionHelper::readRegressorText(removeInstances[i]->getString(1));
+        remove.insert(remove.end(), fileRegressors.begin(), fileRegressors.end());
+    }
+    const vector<ParameterComponent*>& keepInstances = *(myParams->getRepeatableParameterInstances(4));
+    int numKeep = (int)keepInstances.size();
+    for (int i = 0; i < numKeep; ++i)
+    {
+        vector<vector<float> > fileRegressors = RegressionHelper::readRegressorText(keepInstances[i]->getString(1));
+        keep.insert(keep.end(), fileRegressors.begin(), fileRegressors.end());
+    }
+    AlgorithmVolumeRegression(myProgObj, myVolIn, myVolOut, remove, keep);
+}
+
+AlgorithmVolumeRegression::AlgorithmVolumeRegression(ProgressObject* myProgObj, const VolumeFile* myVolIn, VolumeFile* myVolOut, const vector<vector<float> >& remove,
+                                                     const vector<vector<float> >& keep) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    if (myVolIn->getType() == SubvolumeAttributes::LABEL) throw AlgorithmException("regression can't be performed on a label volume");
+    if (remove.empty()) throw AlgorithmException("empty remove list in AlgorithmVolumeRegression");
+    vector<int64_t> myDims;
+    myVolIn->getDimensions(myDims);
+    vector<vector<float> > regressors = remove;
+    regressors.insert(regressors.end(), keep.begin(), keep.end());//only the first remove.size() get subtracted
+    RegressionHelper myHelper(regressors, (int64_t)remove.size());
+    regressors.clear();
+    if (myHelper.getNumberOfObservations() != myDims[3])
+    {
+        throw AlgorithmException("regressors have " + AString::number(myHelper.getNumberOfObservations()) +
+                                 " values, but the input volume has " + AString::number(myDims[3]) + " subvolumes");
+    }
+    myVolOut->reinitialize(myVolIn->getOriginalDimensions(), myVolIn->getSform(), myDims[4], myVolIn->getType());
+    for (int64_t s = 0; s < myDims[3]; ++s)
+    {
+        myVolOut->setMapName(s, myVolIn->getMapName(s));
+    }
+    const int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
+    vector<float> coefs, outFrame(frameSize);//only the coefficients of the removed regressors and one output frame, rather than a copy of the whole volume
+    vector<const float*> inPtrs(myDims[3]);
+    for (int64_t c = 0; c < myDims[4]; ++c)
+    {
+        for (int64_t s = 0; s < myDims[3]; ++s)
+        {
+            inPtrs[s] = myVolIn->getFrame(s, c);
+        }
+        myHelper.fitObservationMajor(inPtrs, frameSize, coefs);//frames are contiguous, so work on blocks of voxels across all frames
+        for (int64_t s = 0; s < myDims[3]; ++s)
+        {
+            myHelper.removeFitFromObservation(inPtrs[s], outFrame.data(), s, coefs, frameSize);
+            myVolOut->setFrame(outFrame.data(), s, c);
+        }
+        myProgress.reportProgress(((float)(c + 1)) / myDims[4]);
+    }
+}
+
+float AlgorithmVolumeRegression::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmVolumeRegression::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
@@ -23,13 +23,13 @@
 
 #include "AlgorithmVolumeSmoothing.h"
 #include "CaretAssert.h"
-#include "CaretHeap.h"
 #include "CaretOMP.h"
+#include "TFCEHelper.h"
+#include "Vector3D.h"
 #include "VolumeFile.h"
-#include "VoxelIJK.h"
 
 #include <cmath>
-#include <set>
+#include <fstream>
 #include <vector>
 
 using namespace caret;
@@ -66,12 +66,17 @@ OperationParameters* AlgorithmVolumeTFCE::getParameters()
     OptionalParameter* subvolSelect = ret->createOptionalParameter(6, "-subvolume", "select a single subvolume");
     subvolSelect->addStringParameter(1, "subvolume", "the subvolume number or name");
     
+    OptionalParameter* maxValuesOpt = ret->createOptionalParameter(7, "-max-values", "also write the maximum absolute TFCE value of each subvolume to a text file");
+    maxValuesOpt->addStringParameter(1, "text-out", "output text file, one value per line");
+    
     ret->setHelpText(
         AString("Threshold-free cluster enhancement is a method to increase the relative value of regions that would form clusters in a standard thresholding test.  ") +
         "This is accomplished by evaluating the integral of:\n\n" +
         "e(h, p)^E * h^H * dh\n\n" +
         "at each vertex p, where h ranges from 0 to the maximum value in the data, and e(h, p) is the extent of the cluster containing vertex p at threshold h.  " +
         "Negative values are similarly enhanced by negating the data, running the same process, and negating the result.\n\n" +
+        "When -max-values is specified, the text file gets one line per output subvolume, containing the maximum absolute TFCE value of that subvolume.  " +
+        "This is intended for building the null distribution from a file of permuted statistics.\n\n" +
         "This method is explained in: Smith SM, Nichols TE., \"Threshold-free cluster enhancement: addressing problems of smoothing, threshold dependence and localisation in cluster inference.\" Neuroimage. 2009 Jan 1;44(1):83-98. PMID: 18501637"
     );
     return ret;
@@ -111,11 +116,27 @@ void AlgorithmVolumeTFCE::useParameters(OperationParameters* myParams, ProgressO
             throw AlgorithmException("invalid subvolume specified");
         }
     }
-    AlgorithmVolumeTFCE(myProgObj, myVol, myVolOut, presmooth, myRoi, param_e, param_h, subvolNum);
+    OptionalParameter* maxValuesOpt = myParams->getOptionalParameter(7);
+    vector<float> maxValues;
+    AlgorithmVolumeTFCE(myProgObj, myVol, myVolOut, presmooth, myRoi, param_e, param_h, subvolNum,
+                        (maxValuesOpt->m_present ? &maxValues : NULL));
+    if (maxValuesOpt->m_present)
+    {
+        ofstream maxFile(maxValuesOpt->getString(1).toLocal8Bit().constData());
+        if (!maxFile)
+        {
+            throw AlgorithmException("failed to open max values output file for writing");
+        }
+        maxFile.precision(8);
+        for (size_t i = 0; i < maxValues.size(); ++i)
+        {
+            maxFile << maxValues[i] << endl;
+        }
+    }
 }
 
 AlgorithmVolumeTFCE::AlgorithmVolumeTFCE(ProgressObject* myProgObj, const VolumeFile* myVol, VolumeFile* myVolOut, const float& presmooth, const VolumeFile* myRoi,
-                                         const float& param_e, const float& param_h, const int64_t& subvolNum) : AbstractAlgorithm(myProgObj)
+                                         const float& param_e, const float& param_h, const int64_t& subvolNum, vector<float>* maxValuesOut) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     if (myRoi != NULL && !myVol->getVolumeSpace().matches(myRoi->getVolumeSpace())) throw AlgorithmException("roi volume has different volume space than input");
@@ -123,9 +144,35 @@ AlgorithmVolumeTFCE::AlgorithmVolumeTFCE(ProgressObject* myProgObj, const Volume
     vector<int64_t> dims = myVol->getDimensions();
     const float* roiFrame = NULL;
     if (myRoi != NULL) roiFrame = myRoi->getFrame();
+    const int64_t frameSize = dims[0] * dims[1] * dims[2];
+    Vector3D ivec, jvec, kvec, origin;//compute the volume of a voxel so different resolutions have comparable values - as if it matters, but hey
+    myVol->getVolumeSpace().getSpacingVectors(ivec, jvec, kvec, origin);//who knows, maybe we'll have distortion correction in volume someday
+    vector<float> voxelVolumes(frameSize, abs(ivec.dot(jvec.cross(kvec))));
+    vector<int64_t> neighborStart(1, 0), neighbors;//face neighbors, the same for every frame, so set up the TFCE graph once
+    const int STENCIL_SIZE = 18;
+    int64_t stencil[STENCIL_SIZE] = { 0, 0, -1,
+                                      0, -1, 0,
+                                      -1, 0, 0,
+                                      1, 0, 0,
+                                      0, 1, 0,
+                                      0, 0, 1 };
+    for (int64_t index = 0; index < frameSize; ++index)
+    {
+        int64_t ijk[3] = { index % dims[0], (index / dims[0]) % dims[1], index / (dims[0] * dims[1]) };
+        CaretAssert(myVol->getIndex(ijk) == index);
+        for (int i = 0; i < STENCIL_SIZE; i += 3)
+        {
+            int64_t neighIJK[3] = { ijk[0] + stencil[i], ijk[1] + stencil[i + 1], ijk[2] + stencil[i + 2] };
+            if (myVol->indexValid(neighIJK))
+            {
+                neighbors.push_back(myVol->getIndex(neighIJK));
+            }
+        }
+        neighborStart.push_back((int64_t)neighbors.size());
+    }
+    TFCEHelper myTFCE(neighborStart, neighbors, voxelVolumes, roiFrame, param_e, param_h);
     if (subvolNum == -1)
     {
-        myVolOut->reinitialize(myVol->getOriginalDimensions(), myVol->getSform(), dims[4]);
         const VolumeFile* toUse = myVol;
         VolumeFile smoothed;
         if (presmooth > 0.0f)
@@ -133,23 +180,23 @@ AlgorithmVolumeTFCE::AlgorithmVolumeTFCE(ProgressObject* myProgObj, const Volume
             AlgorithmVolumeSmoothing(NULL, myVol, presmooth, &smoothed, myRoi);
             toUse = &smoothed;
         }
+        if (maxValuesOut != NULL) maxValuesOut->resize(dims[3] * dims[4]);
+        myVolOut->reinitialize(myVol->getOriginalDimensions(), myVol->getSform(), dims[4]);
 #pragma omp CARET_PAR
         {
-            vector<float> outframe(dims[0] * dims[1] * dims[2]);
+            vector<float> outframe(frameSize);
 #pragma omp CARET_FOR
             for (int64_t b = 0; b < dims[3]; ++b)
             {
                 for (int64_t c = 0; c < dims[4]; ++c)
                 {
-                    processFrame(toUse, b, c, outframe.data(), roiFrame, param_e, param_h);
+                    float maxTFCE = myTFCE.computeTFCE(toUse->getFrame(b, c), outframe.data());
                     myVolOut->setFrame(outframe.data(), b, c);
+                    if (maxValuesOut != NULL) (*maxValuesOut)[b + c * dims[3]] = maxTFCE;
                 }
             }
         }
     } else {
-        vector<int64_t> outDims = dims;
-        outDims.resize(3);
-        myVolOut->reinitialize(outDims, myVol->getSform(), dims[4]);
         const VolumeFile* toUse = myVol;
         int useFrame = subvolNum;
         VolumeFile smoothed;
@@ -159,220 +206,16 @@ AlgorithmVolumeTFCE::AlgorithmVolumeTFCE(ProgressObject* myProgObj, const Volume
             toUse = &smoothed;
             useFrame = 0;
         }
-        vector<float> outframe(dims[0] * dims[1] * dims[2]);
+        if (maxValuesOut != NULL) maxValuesOut->resize(dims[4]);
+        vector<int64_t> outDims = dims;
+        outDims.resize(3);
+        myVolOut->reinitialize(outDims, myVol->getSform(), dims[4]);
+        vector<float> outframe(frameSize);
         for (int64_t c = 0; c < dims[4]; ++c)
         {
-            processFrame(toUse, useFrame, c, outframe.data(), roiFrame, param_e, param_h);
+            float maxTFCE = myTFCE.computeTFCE(toUse->getFrame(useFrame, c), outframe.data());
             myVolOut->setFrame(outframe.data(), 0, c);
-        }
-    }
-}
-
-void AlgorithmVolumeTFCE::processFrame(const VolumeFile* inVol, const int64_t& b, const int64_t& c, float* outData, const float* roiData, const float& param_e, const float& param_h)
-{
-    vector<int64_t> dims = inVol->getDimensions();
-    int64_t frameSize = dims[0] * dims[1] * dims[2];
-    vector<double> accum(frameSize, 0.0);
-    tfce(inVol, b, c, accum.data(), roiData, param_e, param_h, false);//don't negate - positives
-    tfce(inVol, b, c, accum.data(), roiData, param_e, param_h, true);//negate - negatives - NOTE: output is still positive!!!
-    const float* inData = inVol->getFrame(b, c);
-    for (int64_t i = 0; i < frameSize; ++i)
-    {
-        if (inData[i] > 0.0f)//negate the results from negative inputs
-        {
-            outData[i] = accum[i];
-        } else {//the areas outside the roi will have zeros, so we don't have to worry about them
-            outData[i] = -accum[i];
-        }
-    }
-}
-
-namespace
-{//hidden namespace just to make sure things don't collide
-    struct Cluster
-    {
-        double accumVal, totalVolume;
-        vector<VoxelIJK> members;
-        float lastVal;
-        bool first;
-        Cluster()
-        {
-            first = true;
-            accumVal = 0.0;
-            totalVolume = 0.0;
-        }
-        void addMember(const VoxelIJK& voxel, const float& val, const float& voxel_volume, const float& param_e, const float& param_h)
-        {
-            update(val, param_e, param_h);
-            members.push_back(voxel);
-            totalVolume += voxel_volume;
-        }
-        void update(const float& bottomVal, const float& param_e, const float& param_h)
-        {
-            if (first)
-            {
-                lastVal = bottomVal;
-                first = false;
-            } else {
-                if (bottomVal != lastVal)//skip computing if there is no difference
-                {
-                    CaretAssert(bottomVal < lastVal);
-                    double integrated_h = param_h + 1.0f;//integral(x^h) = (x^(h + 1))/(h + 1) + C
-                    double newSlice = pow(totalVolume, (double)param_e) * (pow((double)lastVal, integrated_h) - pow((double)bottomVal, integrated_h)) / integrated_h;
-                    accumVal += newSlice;
-                    lastVal = bottomVal;//computing in double precision, with float for inputs, puts the smallest difference between values far greater than the instability of the computation
-                }
-            }
-        }
-    };
-    
-    int64_t allocCluster(vector<Cluster>& clusterList, set<int64_t>& deadClusters)
-    {
-        if (deadClusters.empty())
-        {
-            clusterList.push_back(Cluster());
-            return (int64_t)(clusterList.size() - 1);
-        } else {
-            set<int64_t>::iterator iter = deadClusters.begin();
-            int64_t ret = *iter;
-            deadClusters.erase(iter);
-            clusterList[ret] = Cluster();//reinitialize
-            return ret;
-        }
-    }
-}
-
-void AlgorithmVolumeTFCE::tfce(const VolumeFile* inVol, const int64_t& b, const int64_t& c, double* accumData, const float* roiData, const float& param_e, const float& param_h, const bool& negate)
-{
-    vector<int64_t> dims = inVol->getDimensions();
-    Vector3D ivec, jvec, kvec, origin;//compute the volume of a voxel so different resolutions have comparable values - as if it matters, but hey
-    inVol->getVolumeSpace().getSpacingVectors(ivec, jvec, kvec, origin);//who knows, maybe we'll have distortion correction in volume someday
-    float voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
-    const int64_t frameSize = dims[0] * dims[1] * dims[2];
-    const float* frameData = inVol->getFrame(b, c);
-    vector<int64_t> membership(frameSize, -1);//use int64_t just in case we get an absurd number of clusters
-    vector<Cluster> clusterList;
-    set<int64_t> deadClusters;//to allow reallocation without changing indices
-    CaretSimpleMaxHeap<VoxelIJK, float> voxelHeap;
-    for (int64_t i = 0; i < dims[0]; ++i)
-    {
-        for (int64_t j = 0; j < dims[1]; ++j)
-        {
-            for (int64_t k = 0; k < dims[2]; ++k)
-            {
-                int64_t index = inVol->getIndex(i, j, k);
-                if ((roiData == NULL || roiData[index] > 0.0f))
-                {
-                    if (negate)
-                    {
-                        if (frameData[index] < 0.0f)
-                        {
-                            voxelHeap.push(VoxelIJK(i, j, k), -frameData[index]);
-                        }
-                    } else {
-                        if (frameData[index] > 0.0f)
-                        {
-                            voxelHeap.push(VoxelIJK(i, j, k), frameData[index]);
-                        }
-                    }
-                }
-            }
-        }
-    }
-    const int STENCIL_SIZE = 18;
-    int64_t stencil[STENCIL_SIZE] = { 0, 0, -1,
-                                      0, -1, 0,
-                                      -1, 0, 0,
-                                      1, 0, 0,
-                                      0, 1, 0,
-                                      0, 0, 1 };
-    while (!voxelHeap.isEmpty())
-    {
-        float value;
-        VoxelIJK voxel = voxelHeap.pop(&value);
-        int64_t voxelIndex = inVol->getIndex(voxel.m_ijk);
-        set<int64_t> touchingClusters;
-        for (int i = 0; i < STENCIL_SIZE; i += 3)
-        {
-            VoxelIJK neighVoxel(voxel.m_ijk[0] + stencil[i], voxel.m_ijk[1] + stencil[i + 1], voxel.m_ijk[2] + stencil[i + 2]);
-            if (inVol->indexValid(neighVoxel.m_ijk))
-            {
-                int64_t neighIndex = inVol->getIndex(neighVoxel.m_ijk);
-                if (membership[neighIndex] != -1)
-                {
-                    touchingClusters.insert(membership[neighIndex]);
-                }
-            }
-        }
-        int numTouching = (int)touchingClusters.size();
-        switch (numTouching)
-        {
-            case 0://make new cluster
-            {
-                int64_t newCluster = allocCluster(clusterList, deadClusters);
-                clusterList[newCluster].addMember(voxel, value, voxelVolume, param_e, param_h);
-                membership[voxelIndex] = newCluster;
-                break;
-            }
-            case 1://add to cluster
-            {
-                int64_t whichCluster = *(touchingClusters.begin());
-                clusterList[whichCluster].addMember(voxel, value, voxelVolume, param_e, param_h);
-                membership[voxelIndex] = whichCluster;
-                accumData[voxelIndex] -= clusterList[whichCluster].accumVal;//the accum value is the current amount less than the peak value that the edge of the cluster has (this node is on the edge)
-                break;//so, when the cluster merges or reaches 0, we add the accum value to every member and zero the accum value of the merged cluster, and we get the correct value in the end (with far fewer flops than integrating everywhere)
-            }
-            default://merge all touching clusters
-            {
-                int64_t mergedIndex = -1, biggestSize = 0;//find the biggest cluster (in number of members) and use as merged cluster, for optimization purposes
-                for (set<int64_t>::iterator iter = touchingClusters.begin(); iter != touchingClusters.end(); ++iter)
-                {
-                    if ((int64_t)clusterList[*iter].members.size() > biggestSize)
-                    {
-                        mergedIndex = *iter;
-                        biggestSize = (int64_t)clusterList[*iter].members.size();
-                    }
-                }
-                CaretAssertVectorIndex(clusterList, mergedIndex);
-                Cluster& mergedCluster = clusterList[mergedIndex];
-                mergedCluster.update(value, param_e, param_h);//recalculate to align cluster bottoms
-                for (set<int64_t>::iterator iter = touchingClusters.begin(); iter != touchingClusters.end(); ++iter)
-                {
-                    if (*iter != mergedIndex)//if we are the largest cluster, don't modify the per-voxel accum for members, so merges between small and large clusters are cheap
-                    {
-                        Cluster& thisCluster = clusterList[*iter];
-                        thisCluster.update(value, param_e, param_h);
-                        int64_t numMembers = (int64_t)thisCluster.members.size();
-                        double correctionVal = thisCluster.accumVal - mergedCluster.accumVal;//fix the accum values in the side cluster so we can add the merged cluster's accum to everything at the end
-                        for (int64_t j = 0; j < numMembers; ++j)//add the correction value to every member so that we have the current integrated values correct
-                        {
-                            int64_t memberIndex = inVol->getIndex(thisCluster.members[j].m_ijk);
-                            accumData[memberIndex] += correctionVal;//apply the correction
-                            membership[memberIndex] = mergedIndex;//and update membership
-                        }
-                        mergedCluster.members.insert(mergedCluster.members.end(), thisCluster.members.begin(), thisCluster.members.end());//copy all members
-                        mergedCluster.totalVolume += thisCluster.totalVolume;
-                        deadClusters.insert(*iter);//kill it
-                        vector<VoxelIJK>().swap(clusterList[*iter].members);//also try to deallocate member list
-                    }
-                }
-                mergedCluster.addMember(voxel, value, voxelVolume, param_e, param_h);//will not trigger recomputation, we already recomputed at this value
-                accumData[voxelIndex] -= mergedCluster.accumVal;//the voxel they merge on must not get the peak value of the cluster, obviously, so again, record its difference from peak
-                membership[voxelIndex] = mergedIndex;
-                break;//NOTE: do not reset the accum value of the merged cluster, we specifically avoided modifying the per-voxel accum for its members, so the cluster accum is still in play
-            }
-        }
-    }
-    int listSize = (int)clusterList.size();//final cleanup of accum values
-    for (int i = 0; i < listSize; ++i)
-    {
-        if (deadClusters.find(i) != deadClusters.end()) continue;//ignore clusters that don't exist
-        Cluster& thisCluster = clusterList[i];
-        thisCluster.update(0.0f, param_e, param_h);//update to include the to-zero slice
-        int numMembers = (int)thisCluster.members.size();
-        for (int j = 0; j < numMembers; ++j)
-        {
-            accumData[inVol->getIndex(thisCluster.members[j].m_ijk)] += thisCluster.accumVal;//add the resulting slice to all members - their stored data contains the offset between the cluster peak and their corect value
+            if (maxValuesOut != NULL) (*maxValuesOut)[c] = maxTFCE;
         }
     }
 }
@@ -23,19 +23,19 @@
 
 #include "AbstractAlgorithm.h"
 
+#include <vector>
+
 namespace caret {
     
     class AlgorithmVolumeTFCE : public AbstractAlgorithm
     {
         AlgorithmVolumeTFCE();
-        void processFrame(const VolumeFile* inVol, const int64_t& b, const int64_t& c, float* outData, const float* roiData, const float& param_e, const float& param_h);
-        void tfce(const VolumeFile* inVol, const int64_t& b, const int64_t& c, double* accumData, const float* roiData, const float& param_e, const float& param_h, const bool& negate);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
     public:
         AlgorithmVolumeTFCE(ProgressObject* myProgObj, const VolumeFile* myVol, VolumeFile* myVolOut, const float& presmooth = 0.0f, const VolumeFile* myRoi = NULL,
-                            const float& param_e = 0.5f, const float& param_h = 2.0f, const int64_t& subvolNum = -1);
+                            const float& param_e = 0.5f, const float& param_h = 2.0f, const int64_t& subvolNum = -1, std::vector<float>* maxValuesOut = NULL);
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
@@ -0,0 +1,161 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+
+#include "ClusterFindHelper.h"
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //every root is the lowest index in its cluster, so roots are found in increasing order by a forward scan
+    int64_t findRoot(int64_t element, vector<int64_t>& parent)
+    {
+        while (parent[element] != element)
+        {
+            parent[element] = parent[parent[element]];//path halving
+            element = parent[element];
+        }
+        return element;
+    }
+    
+    void unionElements(const int64_t& first, const int64_t& second, vector<int64_t>& parent, vector<double>& sizes)
+    {
+        int64_t firstRoot = findRoot(first, parent), secondRoot = findRoot(second, parent);
+        if (firstRoot == secondRoot) return;
+        if (firstRoot > secondRoot) swap(firstRoot, secondRoot);
+        parent[secondRoot] = firstRoot;
+        sizes[firstRoot] += sizes[secondRoot];
+    }
+}
+
+ClusterFindHelper::ClusterFindHelper(const vector<int64_t>& neighborStart, const vector<int64_t>& neighbors, const vector<float>& areas)
+{
+    CaretAssert(neighborStart.size() == areas.size() + 1);
+    m_neighborStart = neighborStart;
+    m_neighbors = neighbors;
+    m_areas = areas;
+    m_dims[0] = 0; m_dims[1] = 0; m_dims[2] = 0;
+    m_voxelVolume = 0.0f;
+    m_gridMode = false;
+}
+
+ClusterFindHelper::ClusterFindHelper(const int64_t dims[3], const float& voxelVolume)
+{
+    m_dims[0] = dims[0]; m_dims[1] = dims[1]; m_dims[2] = dims[2];
+    m_voxelVolume = voxelVolume;
+    m_gridMode = true;
+}
+
+int64_t ClusterFindHelper::getNumberOfElements() const
+{
+    if (m_gridMode) return m_dims[0] * m_dims[1] * m_dims[2];
+    return (int64_t)m_areas.size();
+}
+
+void ClusterFindHelper::unionScanGraph(const char* marked, vector<int64_t>& parent, vector<double>& sizes) const
+{
+    int64_t numElements = (int64_t)m_areas.size();
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        if (!marked[i]) continue;
+        parent[i] = i;
+        sizes[i] = m_areas[i];
+        for (int64_t n = m_neighborStart[i]; n < m_neighborStart[i + 1]; ++n)
+        {
+            const int64_t& neighbor = m_neighbors[n];
+            if (neighbor < i && marked[neighbor])//only look backwards, later elements will find this one
+            {
+                unionElements(i, neighbor, parent, sizes);
+            }
+        }
+    }
+}
+
+void ClusterFindHelper::unionScanGrid(const char* marked, vector<int64_t>& parent, vector<double>& sizes) const
+{
+    const int64_t rowSize = m_dims[0], sliceSize = m_dims[0] * m_dims[1];
+    int64_t index = 0;
+    for (int64_t k = 0; k < m_dims[2]; ++k)
+    {
+        for (int64_t j = 0; j < m_dims[1]; ++j)
+        {
+            for (int64_t i = 0; i < m_dims[0]; ++i, ++index)
+            {
+                if (!marked[index]) continue;
+                parent[index] = index;
+                sizes[index] = m_voxelVolume;
+                if (i > 0 && marked[index - 1]) unionElements(index, index - 1, parent, sizes);//only look backwards, like the graph scan
+                if (j > 0 && marked[index - rowSize]) unionElements(index, index - rowSize, parent, sizes);
+                if (k > 0 && marked[index - sliceSize]) unionElements(index, index - sliceSize, parent, sizes);
+            }
+        }
+    }
+}
+
+void ClusterFindHelper::findClusters(const char* marked, ClusterList& clustersOut) const
+{
+    const int64_t numElements = getNumberOfElements();
+    vector<int64_t> parent(numElements, -1);
+    vector<double> sizes(numElements, 0.0);
+    if (m_gridMode)
+    {
+        unionScanGrid(marked, parent, sizes);
+    } else {
+        unionScanGraph(marked, parent, sizes);
+    }
+    clustersOut.memberStart.clear();
+    clustersOut.members.clear();
+    clustersOut.sizes.clear();
+    vector<int64_t> clusterIndex(numElements, -1), clusterCounts;
+    for (int64_t i = 0; i < numElements; ++i)//second scan: number the roots in order, roots always come before the rest of their cluster
+    {
+        if (!marked[i]) continue;
+        int64_t root = findRoot(i, parent);
+        if (root == i)
+        {
+            clusterIndex[i] = (int64_t)clusterCounts.size();
+            clusterCounts.push_back(0);
+            clustersOut.sizes.push_back(sizes[i]);
+        } else {
+            clusterIndex[i] = clusterIndex[root];
+        }
+        ++clusterCounts[clusterIndex[i]];
+    }
+    const int64_t numClusters = (int64_t)clusterCounts.size();
+    clustersOut.memberStart.resize(numClusters + 1);
+    clustersOut.memberStart[0] = 0;
+    for (int64_t c = 0; c < numClusters; ++c)
+    {
+        clustersOut.memberStart[c + 1] = clustersOut.memberStart[c] + clusterCounts[c];
+        clusterCounts[c] = clustersOut.memberStart[c];//now the next position to fill
+    }
+    clustersOut.members.resize(clustersOut.memberStart[numClusters]);
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        if (!marked[i]) continue;
+        clustersOut.members[clusterCounts[clusterIndex[i]]++] = i;
+    }
+}
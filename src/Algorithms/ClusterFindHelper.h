@@ -0,0 +1,64 @@
+#ifndef __CLUSTER_FIND_HELPER_H__
+#define __CLUSTER_FIND_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "stdint.h"
+#include <vector>
+
+namespace caret {
+    
+    ///connected components of marked elements, using union-find - the graph or grid is set up once, and can then be used on any number of columns, from any number of threads
+    class ClusterFindHelper
+    {
+        std::vector<int64_t> m_neighborStart, m_neighbors;//compressed rows, neighbors of element i are m_neighbors[m_neighborStart[i]] to m_neighbors[m_neighborStart[i + 1] - 1]
+        std::vector<float> m_areas;
+        int64_t m_dims[3];//grid mode uses the dimensions instead of neighbor lists, with face neighbors
+        float m_voxelVolume;
+        bool m_gridMode;
+        
+        void unionScanGraph(const char* marked, std::vector<int64_t>& parent, std::vector<double>& sizes) const;
+        void unionScanGrid(const char* marked, std::vector<int64_t>& parent, std::vector<double>& sizes) const;
+    public:
+        struct ClusterList
+        {
+            std::vector<int64_t> memberStart, members;//members of cluster i are members[memberStart[i]] to members[memberStart[i + 1] - 1], in increasing order
+            std::vector<double> sizes;//total area or volume of each cluster
+            int64_t getNumberOfClusters() const { return (int64_t)sizes.size(); }
+            int64_t getNumberOfMembers(const int64_t& cluster) const { return memberStart[cluster + 1] - memberStart[cluster]; }
+            const int64_t* getMembers(const int64_t& cluster) const { return members.data() + memberStart[cluster]; }
+        };
+        
+        ///graph given as compressed neighbor lists, areas are per element
+        ClusterFindHelper(const std::vector<int64_t>& neighborStart, const std::vector<int64_t>& neighbors, const std::vector<float>& areas);
+        
+        ///volume grid with face neighbors, elements are indexed as i + dims[0] * (j + dims[1] * k)
+        ClusterFindHelper(const int64_t dims[3], const float& voxelVolume);
+        
+        int64_t getNumberOfElements() const;
+        
+        ///clusters of the elements with nonzero marked, ordered by their lowest index member, sizes are accumulated while merging
+        void findClusters(const char* marked, ClusterList& clustersOut) const;
+    };
+    
+}
+
+#endif //__CLUSTER_FIND_HELPER_H__
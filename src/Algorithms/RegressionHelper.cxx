@@ -0,0 +1,309 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "RegressionHelper.h"
+
+#include "AlgorithmException.h"
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "FileInformation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace caret;
+using namespace std;
+
+RegressionHelper::RegressionHelper(const vector<vector<float> >& regressors, const int64_t& numRemove)
+{
+    const int64_t numInput = (int64_t)regressors.size();
+    CaretAssert(numRemove >= 0 && numRemove <= numInput);
+    if (numInput == 0) throw AlgorithmException("regression requires at least one regressor");
+    m_numObservations = (int64_t)regressors[0].size();
+    if (m_numObservations < 1) throw AlgorithmException("regressors must have at least one observation");
+    for (int64_t k = 1; k < numInput; ++k)
+    {
+        if ((int64_t)regressors[k].size() != m_numObservations) throw AlgorithmException("regressors have different numbers of observations");
+    }
+    m_numRegressors = numInput + 1;
+    m_numRemove = numRemove;
+    const int64_t numObs = m_numObservations, numRegs = m_numRegressors;
+    vector<double> design(numObs * numRegs);//observation-major, all regressors and the constant
+    for (int64_t k = 0; k < numInput; ++k)
+    {
+        double accum = 0.0;
+        for (int64_t i = 0; i < numObs; ++i)
+        {
+            accum += regressors[k][i];
+        }
+        accum /= numObs;
+        for (int64_t i = 0; i < numObs; ++i)
+        {
+            design[i * numRegs + k] = regressors[k][i] - accum;
+        }
+    }
+    for (int64_t i = 0; i < numObs; ++i)
+    {
+        design[i * numRegs + numInput] = 1.0;
+    }
+    vector<double> normal(numRegs * numRegs), origDiag(numRegs);
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t a = 0; a < numRegs; ++a)
+    {
+        for (int64_t b = 0; b <= a; ++b)
+        {
+            double accum = 0.0;
+            for (int64_t i = 0; i < numObs; ++i)
+            {
+                accum += design[i * numRegs + a] * design[i * numRegs + b];
+            }
+            normal[a * numRegs + b] = accum;
+        }
+    }
+    for (int64_t j = 0; j < numRegs; ++j)
+    {//cholesky, the lower triangle of normal becomes L
+        origDiag[j] = normal[j * numRegs + j];
+        double diag = origDiag[j];
+        for (int64_t m = 0; m < j; ++m)
+        {
+            diag -= normal[j * numRegs + m] * normal[j * numRegs + m];
+        }
+        if (!(diag > origDiag[j] * 1e-10))//also catches regressors that are constant, as they are zero after demeaning
+        {
+            throw AlgorithmException("regression encountered a non-invertible matrix, check your inputs for linear independence");
+        }
+        normal[j * numRegs + j] = sqrt(diag);
+        for (int64_t i = j + 1; i < numRegs; ++i)
+        {
+            double val = normal[i * numRegs + j];
+            for (int64_t m = 0; m < j; ++m)
+            {
+                val -= normal[i * numRegs + m] * normal[j * numRegs + m];
+            }
+            normal[i * numRegs + j] = val / normal[j * numRegs + j];
+        }
+    }
+    m_solver.resize(numObs * m_numRemove);
+    m_design.resize(numObs * m_numRemove);
+#pragma omp CARET_PAR
+    {
+        vector<double> scratch(numRegs);
+#pragma omp CARET_FOR schedule(dynamic, 4096)
+        for (int64_t i = 0; i < numObs; ++i)
+        {//solve L L' s = x_i, s is column i of (X'X)^-1 X'
+            const double* x = design.data() + i * numRegs;
+            for (int64_t k = 0; k < numRegs; ++k)
+            {
+                double val = x[k];
+                for (int64_t m = 0; m < k; ++m)
+                {
+                    val -= normal[k * numRegs + m] * scratch[m];
+                }
+                scratch[k] = val / normal[k * numRegs + k];
+            }
+            for (int64_t k = numRegs - 1; k >= 0; --k)
+            {
+                double val = scratch[k];
+                for (int64_t m = k + 1; m < numRegs; ++m)
+                {
+                    val -= normal[m * numRegs + k] * scratch[m];
+                }
+                scratch[k] = val / normal[k * numRegs + k];
+            }
+            for (int64_t k = 0; k < m_numRemove; ++k)
+            {
+                m_solver[i * m_numRemove + k] = scratch[k];
+                m_design[i * m_numRemove + k] = x[k];
+            }
+        }
+    }
+}
+
+void RegressionHelper::removeFit(const vector<const float*>& vectorsIn, const vector<float*>& vectorsOut) const
+{
+    removeFitIndexed(vectorsIn, vectorsOut, NULL);
+}
+
+void RegressionHelper::removeFit(const vector<const float*>& vectorsIn, const vector<float*>& vectorsOut, const vector<int64_t>& observationIndices) const
+{
+    CaretAssert((int64_t)observationIndices.size() == m_numObservations);
+    removeFitIndexed(vectorsIn, vectorsOut, observationIndices.data());
+}
+
+void RegressionHelper::removeFitIndexed(const vector<const float*>& vectorsIn, const vector<float*>& vectorsOut, const int64_t* observationIndices) const
+{
+    CaretAssert(vectorsIn.size() == vectorsOut.size());
+    const int64_t numVectors = (int64_t)vectorsIn.size(), numRemove = m_numRemove;
+#pragma omp CARET_PAR
+    {
+        vector<double> coefs(numRemove);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t v = 0; v < numVectors; ++v)
+        {//one pass over the data for the coefficients, one for the residual
+            const float* dataIn = vectorsIn[v];
+            float* dataOut = vectorsOut[v];
+            for (int64_t k = 0; k < numRemove; ++k)
+            {
+                coefs[k] = 0.0;
+            }
+            for (int64_t i = 0; i < m_numObservations; ++i)
+            {
+                const double* solverRow = m_solver.data() + i * numRemove;
+                const double value = dataIn[observationIndices == NULL ? i : observationIndices[i]];
+                for (int64_t k = 0; k < numRemove; ++k)
+                {
+                    coefs[k] += solverRow[k] * value;
+                }
+            }
+            for (int64_t i = 0; i < m_numObservations; ++i)
+            {
+                const int64_t element = (observationIndices == NULL ? i : observationIndices[i]);
+                const double* designRow = m_design.data() + i * numRemove;
+                double value = dataIn[element];
+                for (int64_t k = 0; k < numRemove; ++k)
+                {
+                    value -= designRow[k] * coefs[k];
+                }
+                dataOut[element] = value;
+            }
+        }
+    }
+}
+
+void RegressionHelper::fitObservationMajor(const vector<const float*>& observationsIn, const int64_t& numElements, vector<float>& coefsOut) const
+{
+    CaretAssert((int64_t)observationsIn.size() == m_numObservations);
+    const int64_t BLOCK_SIZE = 1024, numRemove = m_numRemove;
+    const int64_t numBlocks = (numElements + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    coefsOut.resize(numRemove * numElements);
+#pragma omp CARET_PAR
+    {
+        vector<double> coefs(numRemove * BLOCK_SIZE);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t block = 0; block < numBlocks; ++block)
+        {//accumulate a block of elements across all observations, so each observation is read contiguously
+            const int64_t start = block * BLOCK_SIZE, count = min(BLOCK_SIZE, numElements - start);
+            fill(coefs.begin(), coefs.end(), 0.0);
+            for (int64_t i = 0; i < m_numObservations; ++i)
+            {
+                const float* dataIn = observationsIn[i] + start;
+                const double* solverRow = m_solver.data() + i * numRemove;
+                for (int64_t k = 0; k < numRemove; ++k)
+                {
+                    const double weight = solverRow[k];
+                    double* coefRow = coefs.data() + k * BLOCK_SIZE;
+                    for (int64_t e = 0; e < count; ++e)
+                    {
+                        coefRow[e] += weight * dataIn[e];
+                    }
+                }
+            }
+            for (int64_t k = 0; k < numRemove; ++k)
+            {
+                const double* coefRow = coefs.data() + k * BLOCK_SIZE;
+                float* outRow = coefsOut.data() + k * numElements + start;
+                for (int64_t e = 0; e < count; ++e)
+                {
+                    outRow[e] = coefRow[e];
+                }
+            }
+        }
+    }
+}
+
+void RegressionHelper::removeFitFromObservation(const float* observationIn, float* observationOut, const int64_t& observation, const vector<float>& coefs, const int64_t& numElements) const
+{
+    CaretAssert(observation >= 0 && observation < m_numObservations);
+    CaretAssert((int64_t)coefs.size() == m_numRemove * numElements);
+    const int64_t BLOCK_SIZE = 1024, numRemove = m_numRemove;
+    const int64_t numBlocks = (numElements + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const double* designRow = m_design.data() + observation * numRemove;
+#pragma omp CARET_PAR
+    {
+        vector<double> residual(BLOCK_SIZE);
+#pragma omp CARET_FOR schedule(static)
+        for (int64_t block = 0; block < numBlocks; ++block)
+        {
+            const int64_t start = block * BLOCK_SIZE, count = min(BLOCK_SIZE, numElements - start);
+            for (int64_t e = 0; e < count; ++e)
+            {
+                residual[e] = observationIn[start + e];
+            }
+            for (int64_t k = 0; k < numRemove; ++k)
+            {
+                const double weight = designRow[k];
+                const float* coefRow = coefs.data() + k * numElements + start;
+                for (int64_t e = 0; e < count; ++e)
+                {
+                    residual[e] -= weight * coefRow[e];
+                }
+            }
+            for (int64_t e = 0; e < count; ++e)
+            {
+                observationOut[start + e] = residual[e];
+            }
+        }
+    }
+}
+
+vector<vector<float> > RegressionHelper::readRegressorText(const AString& filename)
+{
+    FileInformation textFileInfo(filename);
+    if (!textFileInfo.exists())
+    {
+        throw AlgorithmException("regressor file '" + filename + "' doesn't exist");
+    }
+    fstream regressorFile(filename.toLocal8Bit().constData(), fstream::in);
+    if (!regressorFile.good())
+    {
+        throw AlgorithmException("error reading regressor file '" + filename + "'");
+    }
+    vector<vector<float> > ret;//one vector per column of the file
+    string line;
+    int64_t numLines = 0;
+    while (getline(regressorFile, line))
+    {
+        istringstream lineStream(line);
+        vector<float> values;
+        float value;
+        while (lineStream >> value)
+        {
+            values.push_back(value);
+        }
+        if (!lineStream.eof()) throw AlgorithmException("non-numeric value found in regressor file '" + filename + "'");
+        if (values.empty()) continue;//allow blank lines
+        if (numLines == 0)
+        {
+            ret.resize(values.size());
+        } else if (values.size() != ret.size()) {
+            throw AlgorithmException("regressor file '" + filename + "' has lines with different numbers of values");
+        }
+        for (size_t k = 0; k < values.size(); ++k)
+        {
+            ret[k].push_back(values[k]);
+        }
+        ++numLines;
+    }
+    if (numLines == 0) throw AlgorithmException("regressor file '" + filename + "' contains no values");
+    return ret;
+}
@@ -0,0 +1,62 @@
+#ifndef __REGRESSION_HELPER_H__
+#define __REGRESSION_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+
+#include "stdint.h"
+#include <vector>
+
+namespace caret {
+    
+    ///least squares regression of many data vectors against one set of regressors - the design is factorized once on construction, then applied to any number of vectors
+    ///each regressor is demeaned and a constant term is added, only the fit of the first numRemove regressors is subtracted from the data
+    class RegressionHelper
+    {
+        int64_t m_numObservations, m_numRegressors, m_numRemove;//m_numRegressors includes the constant term
+        std::vector<double> m_design, m_solver;//observation-major, only the removed regressors, m_solver is rows of (X'X)^-1 X', so the fitted coefficients are m_solver times the data
+        void removeFitIndexed(const std::vector<const float*>& vectorsIn, const std::vector<float*>& vectorsOut, const int64_t* observationIndices) const;
+    public:
+        ///regressors[k] has one value per observation
+        RegressionHelper(const std::vector<std::vector<float> >& regressors, const int64_t& numRemove);
+        
+        int64_t getNumberOfObservations() const { return m_numObservations; }
+        
+        ///each pointer is one data vector of all observations, output may be the same as input, vectors are processed in parallel
+        void removeFit(const std::vector<const float*>& vectorsIn, const std::vector<float*>& vectorsOut) const;
+        
+        ///same, but observation i is element observationIndices[i] of each vector (like nodes inside an roi), other output elements are not touched
+        void removeFit(const std::vector<const float*>& vectorsIn, const std::vector<float*>& vectorsOut, const std::vector<int64_t>& observationIndices) const;
+        
+        ///each pointer is one observation of numElements values (like volume frames), coefsOut gets the coefficient of removed regressor k for element e at [k * numElements + e]
+        void fitObservationMajor(const std::vector<const float*>& observationsIn, const int64_t& numElements, std::vector<float>& coefsOut) const;
+        
+        ///subtract the fit from one observation of numElements values, using coefficients from fitObservationMajor, output may be the same as input
+        void removeFitFromObservation(const float* observationIn, float* observationOut, const int64_t& observation, const std::vector<float>& coefs, const int64_t& numElements) const;
+        
+        ///text file with one line per observation, and one column per regressor
+        static std::vector<std::vector<float> > readRegressorText(const AString& filename);
+    };
+    
+}
+
+#endif //__REGRESSION_HELPER_H__
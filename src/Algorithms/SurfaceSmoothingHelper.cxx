@@ -0,0 +1,145 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SurfaceSmoothingHelper.h"
+
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "CaretPointer.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+
+#include <cmath>
+
+using namespace caret;
+using namespace std;
+
+SurfaceSmoothingHelper::SurfaceSmoothingHelper(const SurfaceFile* surfaceFile)
+{
+    CaretAssert(surfaceFile != NULL);
+    m_numNodes = surfaceFile->getNumberOfNodes();
+    CaretPointer<TopologyHelper> myTopoHelp = surfaceFile->getTopologyHelper(true);//sorted, so consecutive neighbors form a triangle with the node
+    m_neighborStart.resize(m_numNodes + 1);
+    m_neighborStart[0] = 0;
+    for (int32_t i = 0; i < m_numNodes; ++i)
+    {
+        int32_t numNeighbors = 0;
+        const int32_t* neighbors = myTopoHelp->getNodeNeighbors(i, numNeighbors);
+        for (int32_t j = 0; j < numNeighbors; ++j)
+        {
+            m_neighbors.push_back(neighbors[j]);
+            m_nextNeighbors.push_back(neighbors[(j + 1) % numNeighbors]);
+        }
+        m_neighborStart[i + 1] = (int32_t)m_neighbors.size();
+    }
+    const float* coordData = surfaceFile->getCoordinateData();
+    for (int k = 0; k < 3; ++k)
+    {
+        m_coords[k].resize(m_numNodes);
+        m_scratch[k].resize(m_numNodes);
+    }
+    for (int32_t i = 0; i < m_numNodes; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            m_coords[k][i] = coordData[i * 3 + k];
+        }
+    }
+}
+
+void SurfaceSmoothingHelper::smooth(const float& strength, const int32_t& iterations)
+{
+    const float inverseStrength = 1.0f - strength;
+    const int32_t* neighbors = m_neighbors.data(), *nextNeighbors = m_nextNeighbors.data(), *neighborStart = m_neighborStart.data();
+    for (int32_t iter = 0; iter < iterations; ++iter)
+    {
+        const float* xIn = m_coords[0].data(), *yIn = m_coords[1].data(), *zIn = m_coords[2].data();
+        float* xOut = m_scratch[0].data(), *yOut = m_scratch[1].data(), *zOut = m_scratch[2].data();
+#pragma omp CARET_PARFOR schedule(dynamic, 4096)
+        for (int32_t node = 0; node < m_numNodes; ++node)
+        {
+            const int32_t start = neighborStart[node], end = neighborStart[node + 1];
+            const float x = xIn[node], y = yIn[node], z = zIn[node];
+            if (end - start < 2)
+            {
+                xOut[node] = x;
+                yOut[node] = y;
+                zOut[node] = z;
+                continue;
+            }
+            double totalArea = 0.0, sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+            for (int32_t j = start; j < end; ++j)
+            {//weight each triangle's center by its area
+                const int32_t n1 = neighbors[j], n2 = nextNeighbors[j];
+                const double ax = xIn[n1] - x, ay = yIn[n1] - y, az = zIn[n1] - z;
+                const double bx = xIn[n2] - x, by = yIn[n2] - y, bz = zIn[n2] - z;
+                const double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+                const double area = 0.5 * sqrt(cx * cx + cy * cy + cz * cz);
+                totalArea += area;
+                sumX += area * (x + xIn[n1] + xIn[n2]);
+                sumY += area * (y + yIn[n1] + yIn[n2]);
+                sumZ += area * (z + zIn[n1] + zIn[n2]);
+            }
+            float averageX = 0.0f, averageY = 0.0f, averageZ = 0.0f;//if all triangles are degenerate, the average stays at the origin
+            if (totalArea > 0.0)
+            {
+                averageX = sumX / (3.0 * totalArea);
+                averageY = sumY / (3.0 * totalArea);
+                averageZ = sumZ / (3.0 * totalArea);
+            }
+            xOut[node] = x * inverseStrength + averageX * strength;
+            yOut[node] = y * inverseStrength + averageY * strength;
+            zOut[node] = z * inverseStrength + averageZ * strength;
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            m_coords[k].swap(m_scratch[k]);
+        }
+    }
+}
+
+void SurfaceSmoothingHelper::inflate(const float& inflationFactor, const float ranges[3])
+{
+    float* xData = m_coords[0].data(), *yData = m_coords[1].data(), *zData = m_coords[2].data();
+#pragma omp CARET_PARFOR schedule(dynamic, 4096)
+    for (int32_t node = 0; node < m_numNodes; ++node)
+    {
+        const float x = xData[node] / ranges[0];
+        const float y = yData[node] / ranges[1];
+        const float z = zData[node] / ranges[2];
+        const float radius = sqrt(x * x + y * y + z * z);
+        const float scale = 1.0f + inflationFactor * (1.0f - radius);
+        xData[node] *= scale;
+        yData[node] *= scale;
+        zData[node] *= scale;
+    }
+}
+
+void SurfaceSmoothingHelper::getCoordinates(vector<float>& xyzOut) const
+{
+    xyzOut.resize(m_numNodes * 3);
+    for (int32_t i = 0; i < m_numNodes; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            xyzOut[i * 3 + k] = m_coords[k][i];
+        }
+    }
+}
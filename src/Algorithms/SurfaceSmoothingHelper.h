@@ -0,0 +1,56 @@
+#ifndef __SURFACE_SMOOTHING_HELPER_H__
+#define __SURFACE_SMOOTHING_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "stdint.h"
+#include <vector>
+
+namespace caret {
+    
+    class SurfaceFile;
+    
+    ///area weighted laplacian smoothing of surface coordinates, shared by the smoothing and inflation algorithms
+    ///neighbors are flattened once, coordinates are kept as separate x, y, z arrays, and iterations alternate between two sets of them
+    class SurfaceSmoothingHelper
+    {
+        std::vector<int32_t> m_neighborStart, m_neighbors, m_nextNeighbors;//compressed rows, m_nextNeighbors[j] is the neighbor after m_neighbors[j] around the node, wrapping
+        std::vector<float> m_coords[3], m_scratch[3];
+        int32_t m_numNodes;
+    public:
+        ///uses sorted topology, so the surface must have consistent triangles
+        SurfaceSmoothingHelper(const SurfaceFile* surfaceFile);
+        
+        int32_t getNumberOfNodes() const { return m_numNodes; }
+        
+        ///each node moves toward the area weighted average of the centers of its triangles, strength in [0, 1]
+        void smooth(const float& strength, const int32_t& iterations = 1);
+        
+        ///scale each node by 1 + inflationFactor * (1 - radius), where radius is computed after dividing coordinates by the ranges
+        void inflate(const float& inflationFactor, const float ranges[3]);
+        
+        ///interleaved xyz, as used by SurfaceFile::setCoordinates
+        void getCoordinates(std::vector<float>& xyzOut) const;
+    };
+    
+}
+
+#endif //__SURFACE_SMOOTHING_HELPER_H__
@@ -0,0 +1,199 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TFCEHelper.h"
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct ValueGreater
+    {
+        const float* m_data;
+        bool m_negate;
+        ValueGreater(const float* data, const bool& negate) : m_data(data), m_negate(negate) { }
+        bool operator()(const int64_t& left, const int64_t& right) const
+        {
+            if (m_negate) return m_data[left] < m_data[right];
+            return m_data[left] > m_data[right];
+        }
+    };
+    
+    //parent >= 0 is another element, -1 is not yet in a cluster, less than -1 marks a root, and encodes its cluster index
+    int64_t findRoot(int64_t element, vector<int64_t>& parent, vector<double>& offset, vector<int64_t>& pathScratch)
+    {
+        pathScratch.clear();
+        while (parent[element] >= 0)
+        {
+            pathScratch.push_back(element);
+            element = parent[element];
+        }
+        for (int64_t i = (int64_t)pathScratch.size() - 2; i >= 0; --i)//compress the path, the last one is already a child of the root
+        {//offsets are relative to the parent, so accumulate them from the top down
+            offset[pathScratch[i]] += offset[pathScratch[i + 1]];
+            parent[pathScratch[i]] = element;
+        }
+        return element;
+    }
+}
+
+void TFCEHelper::Cluster::update(const float& bottomVal, const float& param_e, const float& param_h)
+{
+    if (bottomVal != lastVal)//skip computing if there is no difference
+    {
+        CaretAssert(bottomVal < lastVal);
+        double integrated_h = param_h + 1.0f;//integral(x^h) = (x^(h + 1))/(h + 1) + C
+        double newSlice = pow(totalArea, (double)param_e) * (pow((double)lastVal, integrated_h) - pow((double)bottomVal, integrated_h)) / integrated_h;
+        accumVal += newSlice;
+        lastVal = bottomVal;//computing in double precision, with float for inputs, puts the smallest difference between values far greater than the instability of the computation
+    }
+}
+
+TFCEHelper::TFCEHelper(const vector<int64_t>& neighborStart, const vector<int64_t>& neighbors, const vector<float>& areas,
+                       const float* roiData, const float& param_e, const float& param_h)
+{
+    int64_t numElements = (int64_t)areas.size();
+    CaretAssert((int64_t)neighborStart.size() == numElements + 1);
+    m_areas = areas;
+    m_param_e = param_e;
+    m_param_h = param_h;
+    m_inRoi.resize(numElements);
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        m_inRoi[i] = (roiData == NULL || roiData[i] > 0.0f);
+    }
+    m_neighborStart.reserve(numElements + 1);
+    m_neighborStart.push_back(0);
+    for (int64_t i = 0; i < numElements; ++i)
+    {//drop neighbors outside the roi, they can never join a cluster
+        if (m_inRoi[i])
+        {
+            for (int64_t j = neighborStart[i]; j < neighborStart[i + 1]; ++j)
+            {
+                if (m_inRoi[neighbors[j]]) m_neighbors.push_back(neighbors[j]);
+            }
+        }
+        m_neighborStart.push_back((int64_t)m_neighbors.size());
+    }
+}
+
+void TFCEHelper::tfce_pos(const float* data, const bool& negate, double* accumData) const
+{
+    int64_t numElements = (int64_t)m_areas.size();
+    vector<int64_t> order;
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        if (m_inRoi[i] && (negate ? data[i] < 0.0f : data[i] > 0.0f))
+        {
+            order.push_back(i);
+        }
+    }
+    if (order.empty()) return;
+    sort(order.begin(), order.end(), ValueGreater(data, negate));
+    vector<int64_t> parent(numElements, -1), touching, pathScratch;
+    vector<double> offset(numElements, 0.0);//difference from the final cluster value, relative to the parent - always 0 on roots
+    vector<Cluster> clusters;
+    int64_t numOrdered = (int64_t)order.size();
+    for (int64_t o = 0; o < numOrdered; ++o)
+    {
+        int64_t element = order[o];
+        float value = (negate ? -data[element] : data[element]);
+        touching.clear();
+        for (int64_t j = m_neighborStart[element]; j < m_neighborStart[element + 1]; ++j)
+        {
+            int64_t neighbor = m_neighbors[j];
+            if (parent[neighbor] == -1) continue;
+            int64_t root = findRoot(neighbor, parent, offset, pathScratch);
+            if (find(touching.begin(), touching.end(), root) == touching.end()) touching.push_back(root);
+        }
+        if (touching.empty())
+        {//make new cluster
+            Cluster newCluster;
+            newCluster.accumVal = 0.0;
+            newCluster.totalArea = m_areas[element];
+            newCluster.size = 1;
+            newCluster.lastVal = value;
+            parent[element] = -2 - (int64_t)clusters.size();
+            clusters.push_back(newCluster);
+            continue;
+        }
+        int64_t mergedRoot = touching[0];//use the largest cluster as the merged cluster, so that its members never need updating
+        for (int i = 1; i < (int)touching.size(); ++i)
+        {
+            if (clusters[-2 - parent[touching[i]]].size > clusters[-2 - parent[mergedRoot]].size) mergedRoot = touching[i];
+        }
+        Cluster& mergedCluster = clusters[-2 - parent[mergedRoot]];
+        mergedCluster.update(value, m_param_e, m_param_h);//recalculate to align cluster bottoms
+        for (int i = 0; i < (int)touching.size(); ++i)
+        {
+            if (touching[i] == mergedRoot) continue;
+            Cluster& thisCluster = clusters[-2 - parent[touching[i]]];
+            thisCluster.update(value, m_param_e, m_param_h);
+            CaretAssert(offset[touching[i]] == 0.0);
+            offset[touching[i]] = thisCluster.accumVal - mergedCluster.accumVal;//the members were accumulating toward the side cluster's total, which will now be replaced by the merged cluster's total
+            parent[touching[i]] = mergedRoot;
+            mergedCluster.totalArea += thisCluster.totalArea;
+            mergedCluster.size += thisCluster.size;
+        }
+        mergedCluster.totalArea += m_areas[element];
+        ++mergedCluster.size;
+        parent[element] = mergedRoot;
+        offset[element] = -mergedCluster.accumVal;//the element joins at the current bottom of the cluster, so it must not get what has been integrated so far
+    }
+    for (int64_t o = 0; o < numOrdered; ++o)
+    {
+        int64_t element = order[o];
+        if (parent[element] < -1) clusters[-2 - parent[element]].update(0.0f, m_param_e, m_param_h);//update to include the to-zero slice
+    }
+    for (int64_t o = 0; o < numOrdered; ++o)
+    {
+        int64_t element = order[o];
+        int64_t root = findRoot(element, parent, offset, pathScratch);
+        accumData[element] += offset[element] + clusters[-2 - parent[root]].accumVal;//offset is now relative to the root, which has offset 0
+    }
+}
+
+float TFCEHelper::computeTFCE(const float* data, float* outData) const
+{
+    int64_t numElements = (int64_t)m_areas.size();
+    vector<double> accum(numElements, 0.0);
+    tfce_pos(data, false, accum.data());
+    tfce_pos(data, true, accum.data());//negatives and positives don't overlap, so reuse the accum array
+    float ret = 0.0f;
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        if (!m_inRoi[i])
+        {
+            outData[i] = 0.0f;
+        } else if (data[i] < 0.0f) {
+            outData[i] = (float)-accum[i];
+        } else {
+            outData[i] = (float)accum[i];
+        }
+        ret = max(ret, abs(outData[i]));
+    }
+    return ret;
+}
@@ -0,0 +1,59 @@
+#ifndef __TFCE_HELPER_H__
+#define __TFCE_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "stdint.h"
+#include <vector>
+
+namespace caret {
+    
+    ///TFCE on any graph, using union-find to merge clusters - the graph and roi are set up once, and can then be used on any number of columns, from any number of threads
+    class TFCEHelper
+    {
+        std::vector<int64_t> m_neighborStart, m_neighbors;//compressed rows, neighbors of element i are m_neighbors[m_neighborStart[i]] to m_neighbors[m_neighborStart[i + 1] - 1]
+        std::vector<float> m_areas;
+        std::vector<char> m_inRoi;
+        float m_param_e, m_param_h;
+        
+        struct Cluster
+        {
+            double accumVal, totalArea;
+            int64_t size;
+            float lastVal;
+            void update(const float& bottomVal, const float& param_e, const float& param_h);
+        };
+        
+        void tfce_pos(const float* data, const bool& negate, double* accumData) const;
+    public:
+        ///areas are per element (vertex area, voxel volume), roiData may be NULL for all elements
+        TFCEHelper(const std::vector<int64_t>& neighborStart, const std::vector<int64_t>& neighbors, const std::vector<float>& areas,
+                   const float* roiData, const float& param_e, const float& param_h);
+        
+        int64_t getNumberOfElements() const { return (int64_t)m_areas.size(); }
+        
+        ///TFCE of positive and negative values, with the sign of the input, zero outside the roi, returns the maximum absolute value of the output
+        float computeTFCE(const float* data, float* outData) const;
+    };
+    
+}
+
+#endif //__TFCE_HELPER_H__
@@ -37,6 +37,7 @@
 #include "BrowserTabContent.h"
 #include "CaretDataFileHelper.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CaretPreferences.h"
 #include "ChartingDataManager.h"
 #include "ChartableTwoFileDelegate.h"
@@ -3180,6 +3181,27 @@ Brain::initializeDenseDataSeriesFile(CiftiBrainordinateDataSeriesFile* dataSerie
      * Enable dynamic connectivity using preferences
      */
     CaretPreferences* prefs = SessionManager::get()->getCaretPreferences();
+    
+    /*
+     * Row storage must be set before the dense dynamic file is
+     * created since it is read when it is created.
+     */
+    switch (prefs->getDynamicConnectivityRowStorage()) {
+        case CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_PARENT_FILE:
+            CiftiConnectivityMatrixDenseDynamicFile::setDefaultRowStorage(CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_PARENT_FILE);
+            break;
+        case CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_FLOAT:
+            CiftiConnectivityMatrixDenseDynamicFile::setDefaultRowStorage(CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_FLOAT);
+            break;
+        case CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_INT8:
+            CiftiConnectivityMatrixDenseDynamicFile::setDefaultRowStorage(CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_INT8);
+            break;
+        case CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_INT16:
+        default:
+            CiftiConnectivityMatrixDenseDynamicFile::setDefaultRowStorage(CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_INT16);
+            break;
+    }
+    
     CiftiConnectivityMatrixDenseDynamicFile* denseDynFile = dataSeriesFile->getConnectivityMatrixDenseDynamicFile();
     denseDynFile->setEnabledAsLayer(prefs->isDynamicConnectivityDefaultedOn());
 }
@@ -5377,7 +5399,9 @@ Brain::addReadOrReloadDataFile(const FileModeAddReadReload fileMode,
                                 false,
                                 false);
         
-        AString msg = ("Time to read "
+        AString msg = (((fileMode == FILE_MODE_ADD)
+                        ? "Time to add "
+                        : "Time to read ")
                        + dataFileName
                        + " was "
                        + AString::number(et.getElapsedTimeSeconds())
@@ -5387,10 +5411,13 @@ Brain::addReadOrReloadDataFile(const FileModeAddReadReload fileMode,
     catch (DataFileException& dfe) {
         /*
          * If "caretDataFile" is not NULL, then we were trying to
-         * RELOAD a file so remove it from the "loaded files"
+         * RELOAD a file so remove it from the "loaded files", or
+         * ADD a file that remains owned by the caller
          */
         if (caretDataFile != NULL) {
-            m_specFile->removeCaretDataFile(caretDataFile);
+            if (fileMode == FILE_MODE_RELOAD) {
+                m_specFile->removeCaretDataFile(caretDataFile);
+            }
         }
         else {
             if (caretDataFileRead != NULL) {
@@ -5463,6 +5490,237 @@ Brain::readDataFile(const DataFileTypeEnum::Enum dataFileType,
     return caretDataFileRead;
 }
 
+/**
+ * Create a new, empty data file for a type that may be read on a worker
+ * thread.  Files are created here, on the main thread, since some
+ * constructors register with the event manager.  The type of file
+ * MUST match the type created by the corresponding addReadOrReload method.
+ *
+ * @param dataFileType
+ *    Type of data file.
+ * @return
+ *    New data file or NULL if the type of file must be read while it
+ *    is added to the brain.
+ */
+CaretDataFile*
+Brain::createDataFileForParallelReading(const DataFileTypeEnum::Enum dataFileType)
+{
+    CaretDataFile* caretDataFile = NULL;
+    
+    switch (dataFileType) {
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_LABEL:
+            caretDataFile = new CiftiBrainordinateLabelFile();
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_SCALAR:
+            caretDataFile = new CiftiBrainordinateScalarFile();
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_TIME_SERIES:
+            caretDataFile = new CiftiBrainordinateDataSeriesFile();
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_LABEL:
+            caretDataFile = new CiftiParcelLabelFile();
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_SCALAR:
+            caretDataFile = new CiftiParcelScalarFile();
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_SERIES:
+            caretDataFile = new CiftiParcelSeriesFile();
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_SCALAR_DATA_SERIES:
+            caretDataFile = new CiftiScalarDataSeriesFile();
+            break;
+        case DataFileTypeEnum::LABEL:
+            caretDataFile = new LabelFile();
+            break;
+        case DataFileTypeEnum::METRIC:
+            caretDataFile = new MetricFile();
+            break;
+        case DataFileTypeEnum::RGBA:
+            caretDataFile = new RgbaFile();
+            break;
+        case DataFileTypeEnum::SURFACE:
+            caretDataFile = new Surface();
+            break;
+        case DataFileTypeEnum::VOLUME:
+            caretDataFile = new VolumeFile();
+            break;
+        default:
+            break;
+    }
+    
+    return caretDataFile;
+}
+
+/**
+ * Read, on worker threads, the files whose type does not need the brain
+ * while reading.  Files on the network, files that do not exist, and other
+ * types of files are left for addParallelReadDataFile() to read.
+ *
+ * @param filesToRead
+ *    Files selected for loading.  Successfully read files are placed
+ *    into the entry and must be added with addParallelReadDataFile()
+ *    or deleted with deleteParallelReadDataFiles().
+ */
+void
+Brain::readDataFilesInParallel(std::vector<ParallelReadDataFile>& filesToRead)
+{
+    ElapsedTimer timer;
+    timer.start();
+    
+    std::vector<int32_t> parallelIndices;
+    const int32_t numFiles = static_cast<int32_t>(filesToRead.size());
+    for (int32_t i = 0; i < numFiles; i++) {
+        ParallelReadDataFile& prdf = filesToRead[i];
+        CaretAssert(prdf.m_caretDataFile == NULL);
+        
+        /*
+         * Network reading uses the shared username and password
+         * and is left on the main thread
+         */
+        if (DataFile::isFileOnNetwork(prdf.m_filename)) {
+            continue;
+        }
+        
+        prdf.m_filename = convertFilePathNameToAbsolutePathName(prdf.m_filename);
+        FileInformation fileInfo(prdf.m_filename);
+        if ( ! fileInfo.exists()) {
+            continue;
+        }
+        
+        prdf.m_caretDataFile = createDataFileForParallelReading(prdf.m_dataFileType);
+        if (prdf.m_caretDataFile != NULL) {
+            parallelIndices.push_back(i);
+        }
+    }
+    
+    const int32_t numParallel = static_cast<int32_t>(parallelIndices.size());
+    if (numParallel <= 0) {
+        return;
+    }
+    
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int32_t i = 0; i < numParallel; i++) {
+        ParallelReadDataFile& prdf = filesToRead[parallelIndices[i]];
+        ElapsedTimer fileTimer;
+        fileTimer.start();
+        try {
+            try {
+                prdf.m_caretDataFile->readFile(prdf.m_filename);
+            }
+            catch (const std::bad_alloc&) {
+                throw DataFileException(prdf.m_filename,
+                                        CaretDataFileHelper::createBadAllocExceptionMessage(prdf.m_filename));
+            }
+        }
+        catch (const DataFileException& dfe) {
+            prdf.m_errorMessage = dfe.whatString();
+        }
+        catch (const std::exception& e) {
+            prdf.m_errorMessage = DataFileException(prdf.m_filename,
+                                                    e.what()).whatString();
+        }
+        if ( ! prdf.m_errorMessage.isEmpty()) {
+            delete prdf.m_caretDataFile;
+            prdf.m_caretDataFile = NULL;
+        }
+        prdf.m_readTimeSeconds = fileTimer.getElapsedTimeSeconds();
+    }
+    
+    double totalReadTime = 0.0;
+    for (int32_t i = 0; i < numParallel; i++) {
+        const ParallelReadDataFile& prdf = filesToRead[parallelIndices[i]];
+        totalReadTime += prdf.m_readTimeSeconds;
+        CaretLogInfo("Time to read "
+                     + prdf.m_filename
+                     + " was "
+                     + AString::number(prdf.m_readTimeSeconds)
+                     + " seconds.");
+    }
+    CaretLogInfo("Time to read "
+                 + AString::number(numParallel)
+                 + " files in parallel was "
+                 + AString::number(timer.getElapsedTimeSeconds())
+                 + " seconds (sum of file read times was "
+                 + AString::number(totalReadTime)
+                 + " seconds).");
+}
+
+/**
+ * Add a file to the brain.  If the file was read by readDataFilesInParallel()
+ * it is added, otherwise it is read now.
+ *
+ * @param fileToAdd
+ *    File selected for loading.  On return, it no longer owns a data file.
+ * @throws DataFileException
+ *    If there is an error reading or adding the file.
+ * @return
+ *    Pointer to file that was added, if no errors.
+ */
+CaretDataFile*
+Brain::addParallelReadDataFile(ParallelReadDataFile& fileToAdd)
+{
+    if ( ! fileToAdd.m_errorMessage.isEmpty()) {
+        CaretAssert(fileToAdd.m_caretDataFile == NULL);
+        throw DataFileException(fileToAdd.m_errorMessage);
+    }
+    
+    if (fileToAdd.m_caretDataFile == NULL) {
+        return readDataFile(fileToAdd.m_dataFileType,
+                            fileToAdd.m_structure,
+                            fileToAdd.m_filename,
+                            false);
+    }
+    
+    CaretDataFile* caretDataFile = fileToAdd.m_caretDataFile;
+    fileToAdd.m_caretDataFile = NULL;
+    
+    CaretDataFile* caretDataFileAdded = NULL;
+    try {
+        /*
+         * Validation needs the surfaces that were added before this file
+         */
+        CiftiMappableDataFile* ciftiMapFile = dynamic_cast<CiftiMappableDataFile*>(caretDataFile);
+        if (ciftiMapFile != NULL) {
+            validateCiftiMappableDataFile(ciftiMapFile);
+        }
+        
+        caretDataFileAdded = addReadOrReloadDataFile(FILE_MODE_ADD,
+                                                     caretDataFile,
+                                                     fileToAdd.m_dataFileType,
+                                                     fileToAdd.m_structure,
+                                                     fileToAdd.m_filename,
+                                                     false);
+    }
+    catch (const DataFileException& dfe) {
+        /*
+         * Files that fail to be added are not owned by the brain
+         */
+        delete caretDataFile;
+        throw dfe;
+    }
+    
+    return caretDataFileAdded;
+}
+
+/**
+ * Delete any files that were read in parallel but not added to the brain.
+ *
+ * @param filesToRead
+ *    Files selected for loading.
+ */
+void
+Brain::deleteParallelReadDataFiles(std::vector<ParallelReadDataFile>& filesToRead)
+{
+    for (std::vector<ParallelReadDataFile>::iterator iter = filesToRead.begin();
+         iter != filesToRead.end();
+         iter++) {
+        if (iter->m_caretDataFile != NULL) {
+            delete iter->m_caretDataFile;
+            iter->m_caretDataFile = NULL;
+        }
+    }
+}
+
 /**
  * Processing performed after adding or removing a data file.
  */
@@ -5544,6 +5802,7 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
      * Note: Need to read palette first since some of the individual file
      * reading routines update palette coloring when file is read
      */
+    std::vector<ParallelReadDataFile> filesToRead;
     const int32_t numFileGroups = sf->getNumberOfDataFileTypeGroups();
     for (int32_t ig = -1; ig < numFileGroups; ig++) {
         const SpecFileDataFileTypeGroup* group = ((ig == -1)
@@ -5559,42 +5818,61 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
         for (int32_t iFile = 0; iFile < numFiles; iFile++) {
             const SpecFileDataFile* dataFileInfo = group->getFileInformation(iFile);
             if (dataFileInfo->isLoadingSelected()) {
-                const AString filename = dataFileInfo->getFileName();
-                const StructureEnum::Enum structure = dataFileInfo->getStructure();
-
-                /*
-                 * Send event indicating progress of file reading
-                 */
-                FileInformation fileInfo(dataFileInfo->getFileName());
-                progressUpdate.setProgress(fileReadCounter,
-                                           ("Reading "
-                                            + fileInfo.getFileName()));
-                EventManager::get()->sendEvent(progressUpdate.getPointer());
-                
-                /*
-                 * If user cancelled, reset brain and get out!
-                 */
-                if (progressUpdate.isCancelled()) {
-                    resetBrain();
-                    return;
-                }
-                
-                try {
-                    readDataFile(dataFileType,
-                                 structure,
-                                 filename,
-                                 false);
-                }
-                catch (const DataFileException& e) {
-                    if (errorMessage.isEmpty() == false) {
-                        errorMessage += "\n";
-                    }
-                    errorMessage += e.whatString();
-                }
-                
-                fileReadCounter++;
+                filesToRead.push_back(ParallelReadDataFile(dataFileType,
+                                                           dataFileInfo->getStructure(),
+                                                           dataFileInfo->getFileName()));
+            }
+        }
+    }
+    
+    /*
+     * Files are read in parallel but added to the brain in the
+     * order above since some files (metric, CIFTI) require that
+     * surfaces are loaded first
+     */
+    progressUpdate.setProgress(fileReadCounter,
+                               "Reading selected files");
+    EventManager::get()->sendEvent(progressUpdate.getPointer());
+    if (progressUpdate.isCancelled()) {
+        resetBrain();
+        return;
+    }
+    readDataFilesInParallel(filesToRead);
+    
+    for (std::vector<ParallelReadDataFile>::iterator iter = filesToRead.begin();
+         iter != filesToRead.end();
+         iter++) {
+        /*
+         * Send event indicating progress of file reading
+         */
+        FileInformation fileInfo(iter->m_filename);
+        progressUpdate.setProgress(fileReadCounter,
+                                   (((iter->m_caretDataFile != NULL)
+                                     ? "Adding "
+                                     : "Reading ")
+                                    + fileInfo.getFileName()));
+        EventManager::get()->sendEvent(progressUpdate.getPointer());
+        
+        /*
+         * If user cancelled, reset brain and get out!
+         */
+        if (progressUpdate.isCancelled()) {
+            deleteParallelReadDataFiles(filesToRead);
+            resetBrain();
+            return;
+        }
+        
+        try {
+            addParallelReadDataFile(*iter);
+        }
+        catch (const DataFileException& e) {
+            if (errorMessage.isEmpty() == false) {
+                errorMessage += "\n";
             }
+            errorMessage += e.whatString();
         }
+        
+        fileReadCounter++;
     }
     
     m_specFile->clearModified();
@@ -5800,13 +6078,50 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
     
     
     /*
-     * Load new files and add existing files that were previously loaded.
+     * Read, in parallel, the new files that are not previously loaded files
      */
+    std::vector<ParallelReadDataFile> filesToRead;
     const int32_t numFileGroups = specFileToLoad->getNumberOfDataFileTypeGroups();
     for (int32_t ig = 0; ig < numFileGroups; ig++) {
         const SpecFileDataFileTypeGroup* group = specFileToLoad->getDataFileTypeGroupByIndex(ig);
         const DataFileTypeEnum::Enum dataFileType = group->getDataFileType();
         const int32_t numFiles = group->getNumberOfFiles();
+        for (int32_t iFile = 0; iFile < numFiles; iFile++) {
+            const SpecFileDataFile* fileInfo = group->getFileInformation(iFile);
+            if (fileInfo->isLoadingSelected()) {
+                if (specFilesEntryToNonModifiedFile.find(fileInfo) != specFilesEntryToNonModifiedFile.end()) {
+                    continue;
+                }
+                
+                AString filename = fileInfo->getFileName();
+                if (sceneFileOnNetwork) {
+                    if (DataFile::isFileOnNetwork(filename) == false) {
+                        const int32_t lastSlashIndex = sceneFileName.lastIndexOf("/");
+                        if (lastSlashIndex >= 0) {
+                            const AString newName = (sceneFileName.left(lastSlashIndex)
+                                                     + "/"
+                                                     + filename);
+                            filename = newName;
+                        }
+                    }
+                }
+                filesToRead.push_back(ParallelReadDataFile(dataFileType,
+                                                           fileInfo->getStructure(),
+                                                           filename));
+            }
+        }
+    }
+    readDataFilesInParallel(filesToRead);
+    
+    /*
+     * Load new files and add existing files that were previously loaded.
+     * Files are added in spec file order since some files (metric, CIFTI)
+     * require that surfaces are loaded first.
+     */
+    std::vector<ParallelReadDataFile>::iterator fileToReadIter = filesToRead.begin();
+    for (int32_t ig = 0; ig < numFileGroups; ig++) {
+        const SpecFileDataFileTypeGroup* group = specFileToLoad->getDataFileTypeGroupByIndex(ig);
+        const int32_t numFiles = group->getNumberOfFiles();
         for (int32_t iFile = 0; iFile < numFiles; iFile++) {
             const SpecFileDataFile* fileInfo = group->getFileInformation(iFile);
             if (fileInfo->isLoadingSelected()) {
@@ -5821,6 +6136,7 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
                         progressEvent.setProgressMessage(msg);
                         EventManager::get()->sendEvent(progressEvent.getPointer());
                         if (progressEvent.isCancelled()) {
+                            deleteParallelReadDataFiles(filesToRead);
                             resetBrain(keepSceneFiles,
                                        keepSpecFile);
                             return;
@@ -5835,33 +6151,22 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
                                                 false);
                     }
                     else {
-                        const StructureEnum::Enum structure = fileInfo->getStructure();
+                        CaretAssert(fileToReadIter != filesToRead.end());
+                        ParallelReadDataFile& fileToRead = *fileToReadIter;
+                        fileToReadIter++;
                         
                         const QString msg = ("Loading "
-                                             + FileInformation(filename).getFileName());
+                                             + FileInformation(fileToRead.m_filename).getFileName());
                         progressEvent.setProgressMessage(msg);
                         EventManager::get()->sendEvent(progressEvent.getPointer());
                         if (progressEvent.isCancelled()) {
+                            deleteParallelReadDataFiles(filesToRead);
                             resetBrain(keepSceneFiles,
                                        keepSpecFile);
                             return;
                         }
                         
-                        if (sceneFileOnNetwork) {
-                            if (DataFile::isFileOnNetwork(filename) == false) {
-                                const int32_t lastSlashIndex = sceneFileName.lastIndexOf("/");
-                                if (lastSlashIndex >= 0) {
-                                    const AString newName = (sceneFileName.left(lastSlashIndex)
-                                                             + "/"
-                                                             + filename);
-                                    filename = newName;
-                                }
-                            }
-                        }
-                        readDataFile(dataFileType,
-                                     structure,
-                                     filename,
-                                     false);
+                        addParallelReadDataFile(fileToRead);
                     }
                 }
                 catch (const DataFileException& e) {
@@ -473,7 +473,37 @@ namespace caret {
             /** Reload the file */
             FILE_MODE_RELOAD
         };
-        
+
+        /**
+         * A data file selected for loading.  Files whose type can be read
+         * without the brain are read on worker threads and then added to
+         * the brain, in their original order, on the main thread.
+         */
+        struct ParallelReadDataFile {
+            ParallelReadDataFile(const DataFileTypeEnum::Enum dataFileType,
+                                 const StructureEnum::Enum structure,
+                                 const AString& filename)
+            : m_dataFileType(dataFileType),
+            m_structure(structure),
+            m_filename(filename),
+            m_caretDataFile(NULL),
+            m_readTimeSeconds(0.0) { }
+
+            DataFileTypeEnum::Enum m_dataFileType;
+
+            StructureEnum::Enum m_structure;
+
+            AString m_filename;
+
+            /** File that was read and not yet added to the brain, NULL if not read in parallel */
+            CaretDataFile* m_caretDataFile;
+
+            /** Error message if reading in parallel failed */
+            AString m_errorMessage;
+
+            double m_readTimeSeconds;
+        };
+
         void addDataFile(CaretDataFile* caretDataFile);
         
         bool removeWithoutDeleteDataFile(const CaretDataFile* caretDataFile);
@@ -500,7 +530,15 @@ namespace caret {
                           const StructureEnum::Enum structure,
                           const AString& dataFileName,
                           const bool markDataFileAsModified);
-        
+
+        static CaretDataFile* createDataFileForParallelReading(const DataFileTypeEnum::Enum dataFileType);
+
+        void readDataFilesInParallel(std::vector<ParallelReadDataFile>& filesToRead);
+
+        CaretDataFile* addParallelReadDataFile(ParallelReadDataFile& fileToAdd);
+
+        static void deleteParallelReadDataFiles(std::vector<ParallelReadDataFile>& filesToRead);
+
         void createModelChartTwo();
         
         /**
@@ -52,6 +52,7 @@
 #include "BrainOpenGLShapeCylinder.h"
 #include "BrainOpenGLShapeRing.h"
 #include "BrainOpenGLShapeSphere.h"
+#include "BrainOpenGLSurfaceBuffers.h"
 #include "BrainOpenGLViewportContent.h"
 #include "BrainStructure.h"
 #include "BrowserTabContent.h"
@@ -2599,6 +2600,21 @@ void
 BrainOpenGLFixedPipeline::drawSurfaceTrianglesWithVertexArrays(const Surface* surface,
                                                                const float* nodeColoringRGBA)
 {
+    /*
+     * Geometry stays in buffer objects until the surface changes and only
+     * the (byte) coloring is reloaded when the coloring changes.
+     */
+    if (BrainOpenGL::isVertexBuffersSupported()) {
+        if (nodeColoringRGBA == NULL) {
+            glColor3fv(m_backgroundColorFloat);
+        }
+        if (surface->getOpenGLSurfaceBuffers()->drawTriangles(getContextSharingGroupPointer(),
+                                                              surface,
+                                                              nodeColoringRGBA)) {
+            return;
+        }
+    }
+    
     glEnableClientState(GL_VERTEX_ARRAY);
     if (nodeColoringRGBA != NULL) {
         glEnableClientState(GL_COLOR_ARRAY);
@@ -0,0 +1,292 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __BRAIN_OPEN_GL_SURFACE_BUFFERS_DECLARE__
+#include "BrainOpenGLSurfaceBuffers.h"
+#undef __BRAIN_OPEN_GL_SURFACE_BUFFERS_DECLARE__
+
+#include "BrainConstants.h"
+#include "CaretAssert.h"
+#include "EventGraphicsOpenGLCreateBufferObject.h"
+#include "EventManager.h"
+#include "GraphicsOpenGLBufferObject.h"
+#include "SurfaceFile.h"
+
+using namespace caret;
+
+
+    
+/**
+ * \class caret::BrainOpenGLSurfaceBuffers 
+ * \brief OpenGL buffer objects holding a surface for drawing.
+ * \ingroup Brain
+ *
+ * Coordinates, normal vectors, and triangles are loaded into buffer
+ * objects only when the surface's geometry changes.  Node coloring is
+ * converted to unsigned bytes and kept in separate buffers, one for
+ * each coloring (tab and model) that is drawn, so that changing the
+ * overlays only reloads the coloring.
+ */
+
+/**
+ * Constructor.
+ */
+BrainOpenGLSurfaceBuffers::BrainOpenGLSurfaceBuffers()
+: CaretObject()
+{
+    
+}
+
+/**
+ * Destructor.
+ */
+BrainOpenGLSurfaceBuffers::~BrainOpenGLSurfaceBuffers()
+{
+    deleteBuffers();
+}
+
+/**
+ * Delete the buffers.  Buffer objects are deleted later
+ * in the OpenGL context in which they were created.
+ */
+void
+BrainOpenGLSurfaceBuffers::deleteBuffers()
+{
+    m_coordinateBufferObject.reset();
+    m_normalVectorBufferObject.reset();
+    m_triangleBufferObject.reset();
+    m_colorBuffers.clear();
+    m_geometryModificationCount = -1;
+    m_openglContextPointer = NULL;
+}
+
+/**
+ * @return A new buffer object for the current OpenGL context or NULL if failure.
+ */
+GraphicsOpenGLBufferObject*
+BrainOpenGLSurfaceBuffers::createBufferObject()
+{
+    EventGraphicsOpenGLCreateBufferObject createEvent;
+    EventManager::get()->sendEvent(createEvent.getPointer());
+    return createEvent.getOpenGLBufferObject();
+}
+
+/**
+ * Draw the surface's triangles using buffer objects, loading the
+ * buffers if they are not valid.
+ *
+ * @param openglContextPointer
+ *     Context sharing group of the current OpenGL context.
+ * @param surface
+ *     Surface that is drawn.
+ * @param nodeColoringRGBA
+ *     RGBA coloring for the nodes, if NULL the current OpenGL color is used.
+ * @return
+ *     True if the surface was drawn, false if the buffers could not be created.
+ */
+bool
+BrainOpenGLSurfaceBuffers::drawTriangles(void* openglContextPointer,
+                                         const SurfaceFile* surface,
+                                         const float* nodeColoringRGBA)
+{
+    CaretAssert(surface);
+    
+    if (openglContextPointer != m_openglContextPointer) {
+        deleteBuffers();
+        m_openglContextPointer = openglContextPointer;
+    }
+    if (m_geometryModificationCount != surface->getGeometryModificationCount()
+        || m_triangleBufferObject == NULL) {
+        loadGeometryBuffers(surface);
+    }
+    if (m_triangleBufferObject == NULL) {
+        return false;
+    }
+    
+    GLuint colorBufferName = 0;
+    if (nodeColoringRGBA != NULL) {
+        colorBufferName = loadColorBuffer(surface,
+                                          nodeColoringRGBA);
+        if (colorBufferName == 0) {
+            return false;
+        }
+    }
+    
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_coordinateBufferObject->getBufferObjectName());
+    glVertexPointer(3,
+                    GL_FLOAT,
+                    0,
+                    (GLvoid*)0);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_normalVectorBufferObject->getBufferObjectName());
+    glNormalPointer(GL_FLOAT,
+                    0,
+                    (GLvoid*)0);
+    if (colorBufferName > 0) {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER,
+                     colorBufferName);
+        glColorPointer(4,
+                       GL_UNSIGNED_BYTE,
+                       0,
+                       (GLvoid*)0);
+    }
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                 m_triangleBufferObject->getBufferObjectName());
+    glDrawElements(GL_TRIANGLES,
+                   (3 * m_numberOfTriangles),
+                   GL_UNSIGNED_INT,
+                   (GLvoid*)0);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    
+    return true;
+}
+
+/**
+ * Load the coordinates, normal vectors, and triangles into buffers.
+ *
+ * @param surface
+ *     Surface whose geometry is loaded.
+ */
+void
+BrainOpenGLSurfaceBuffers::loadGeometryBuffers(const SurfaceFile* surface)
+{
+    m_numberOfNodes = surface->getNumberOfNodes();
+    m_numberOfTriangles = surface->getNumberOfTriangles();
+    if ((m_numberOfNodes <= 0)
+        || (m_numberOfTriangles <= 0)) {
+        deleteBuffers();
+        return;
+    }
+    
+    if (m_triangleBufferObject == NULL) {
+        m_coordinateBufferObject.reset(createBufferObject());
+        m_normalVectorBufferObject.reset(createBufferObject());
+        m_triangleBufferObject.reset(createBufferObject());
+        if ((m_coordinateBufferObject == NULL)
+            || (m_normalVectorBufferObject == NULL)
+            || (m_triangleBufferObject == NULL)) {
+            deleteBuffers();
+            return;
+        }
+    }
+    
+    const GLsizeiptr xyzSizeBytes = m_numberOfNodes * 3 * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_coordinateBufferObject->getBufferObjectName());
+    glBufferData(GL_ARRAY_BUFFER,
+                 xyzSizeBytes,
+                 surface->getCoordinateData(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_normalVectorBufferObject->getBufferObjectName());
+    glBufferData(GL_ARRAY_BUFFER,
+                 xyzSizeBytes,
+                 surface->getNormalData(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                 m_triangleBufferObject->getBufferObjectName());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 m_numberOfTriangles * 3 * sizeof(int32_t),
+                 surface->getTriangle(0),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    
+    m_geometryModificationCount = surface->getGeometryModificationCount();
+}
+
+/**
+ * Get the buffer containing the given coloring, converting it to bytes
+ * and loading it if the surface's coloring has changed since it was loaded.
+ *
+ * @param surface
+ *     Surface that is colored.
+ * @param nodeColoringRGBA
+ *     RGBA coloring for the nodes, ranging 0.0 to 1.0.
+ * @return
+ *     Name of the buffer object, zero if failure.
+ */
+GLuint
+BrainOpenGLSurfaceBuffers::loadColorBuffer(const SurfaceFile* surface,
+                                           const float* nodeColoringRGBA)
+{
+    const int64_t coloringModificationCount = surface->getNodeColoringModificationCount();
+    
+    std::map<const float*, ColorBuffer>::iterator iter = m_colorBuffers.find(nodeColoringRGBA);
+    if (iter == m_colorBuffers.end()) {
+        /*
+         * Coloring pointers change as colorings are invalidated,
+         * so prevent unused buffers from accumulating.
+         */
+        if (m_colorBuffers.size() >= static_cast<size_t>(3 * BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS)) {
+            m_colorBuffers.clear();
+        }
+        iter = m_colorBuffers.insert(std::make_pair(nodeColoringRGBA, ColorBuffer())).first;
+    }
+    ColorBuffer& colorBuffer = iter->second;
+    if (colorBuffer.m_bufferObject == NULL) {
+        colorBuffer.m_bufferObject.reset(createBufferObject());
+        if (colorBuffer.m_bufferObject == NULL) {
+            m_colorBuffers.erase(iter);
+            return 0;
+        }
+        colorBuffer.m_modificationCount = -1;
+    }
+    
+    if (colorBuffer.m_modificationCount != coloringModificationCount) {
+        const int64_t numComponents = static_cast<int64_t>(m_numberOfNodes) * 4;
+        m_colorBytes.resize(numComponents);
+        for (int64_t i = 0; i < numComponents; ++i) {
+            const float value = nodeColoringRGBA[i];
+            if (value <= 0.0f) {
+                m_colorBytes[i] = 0;
+            }
+            else if (value >= 1.0f) {
+                m_colorBytes[i] = 255;
+            }
+            else {
+                m_colorBytes[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER,
+                     colorBuffer.m_bufferObject->getBufferObjectName());
+        glBufferData(GL_ARRAY_BUFFER,
+                     numComponents,
+                     &m_colorBytes[0],
+                     GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        colorBuffer.m_modificationCount = coloringModificationCount;
+    }
+    
+    return colorBuffer.m_bufferObject->getBufferObjectName();
+}
+
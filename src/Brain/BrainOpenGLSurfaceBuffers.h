@@ -0,0 +1,102 @@
+#ifndef __BRAIN_OPEN_GL_SURFACE_BUFFERS_H__
+#define __BRAIN_OPEN_GL_SURFACE_BUFFERS_H__
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "CaretObject.h"
+#include "CaretOpenGLInclude.h"
+
+namespace caret {
+
+    class GraphicsOpenGLBufferObject;
+    class SurfaceFile;
+    
+    class BrainOpenGLSurfaceBuffers : public CaretObject {
+        
+    public:
+        BrainOpenGLSurfaceBuffers();
+        
+        virtual ~BrainOpenGLSurfaceBuffers();
+        
+        bool drawTriangles(void* openglContextPointer,
+                           const SurfaceFile* surface,
+                           const float* nodeColoringRGBA);
+        
+        void deleteBuffers();
+        
+        // ADD_NEW_METHODS_HERE
+
+    private:
+        /** A node coloring uploaded as unsigned bytes */
+        struct ColorBuffer {
+            std::unique_ptr<GraphicsOpenGLBufferObject> m_bufferObject;
+            
+            int64_t m_modificationCount = -1;
+        };
+        
+        BrainOpenGLSurfaceBuffers(const BrainOpenGLSurfaceBuffers&);
+
+        BrainOpenGLSurfaceBuffers& operator=(const BrainOpenGLSurfaceBuffers&);
+        
+        static GraphicsOpenGLBufferObject* createBufferObject();
+        
+        void loadGeometryBuffers(const SurfaceFile* surface);
+        
+        GLuint loadColorBuffer(const SurfaceFile* surface,
+                               const float* nodeColoringRGBA);
+        
+        /** Context sharing group in which the buffers were created */
+        void* m_openglContextPointer = NULL;
+        
+        /** Surface geometry modification count when buffers were loaded */
+        int64_t m_geometryModificationCount = -1;
+        
+        int32_t m_numberOfNodes = 0;
+        
+        int32_t m_numberOfTriangles = 0;
+        
+        std::unique_ptr<GraphicsOpenGLBufferObject> m_coordinateBufferObject;
+        
+        std::unique_ptr<GraphicsOpenGLBufferObject> m_normalVectorBufferObject;
+        
+        std::unique_ptr<GraphicsOpenGLBufferObject> m_triangleBufferObject;
+        
+        /** Color buffers keyed by the float coloring they were converted from (one per tab/model) */
+        std::map<const float*, ColorBuffer> m_colorBuffers;
+        
+        /** Reused for conversion of float colors to bytes */
+        std::vector<uint8_t> m_colorBytes;
+        
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+    
+#ifdef __BRAIN_OPEN_GL_SURFACE_BUFFERS_DECLARE__
+    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+#endif // __BRAIN_OPEN_GL_SURFACE_BUFFERS_DECLARE__
+
+} // namespace
+#endif  //__BRAIN_OPEN_GL_SURFACE_BUFFERS_H__
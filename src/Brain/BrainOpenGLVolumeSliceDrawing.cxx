@@ -52,6 +52,7 @@
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
 #include "GraphicsEngineDataOpenGL.h"
+#include "GraphicsOpenGLVolumeTexture.h"
 #include "GraphicsPrimitiveV3fC4f.h"
 #include "GraphicsUtilitiesOpenGL.h"
 #include "GroupAndNameHierarchyModel.h"
@@ -64,6 +65,8 @@
 #include "ModelVolume.h"
 #include "ModelWholeBrain.h"
 #include "NodeAndVoxelColoring.h"
+#include "PaletteColorMapping.h"
+#include "PaletteThresholdOutlineDrawingModeEnum.h"
 #include "SelectionItemFocusVolume.h"
 #include "SelectionItemVoxel.h"
 #include "SelectionItemVoxelEditing.h"
@@ -1677,6 +1680,50 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSlice(const VolumeSliceViewPlaneEnu
         startCoordinateXYZ[drawBottomToTopInfo.indexIntoXYZ] -= (drawBottomToTopInfo.voxelStepSize / 2.0);
         startCoordinateXYZ[viewPlaneDimIndex] = selectedSliceCoordinate;
         
+        const uint8_t volumeDrawingOpacity = static_cast<uint8_t>(volInfo.opacity * 255.0);
+        
+        if (m_modelWholeBrain != NULL) {
+            /*
+             * After the a slice is drawn in ALL view, some layers
+             * (volume surface outline) may be drawn in lines.  As the
+             * view is rotated, lines will partially appear and disappear
+             * due to the lines having the same (extremely close) depth
+             * values as the voxel polygons.  OpenGL's Polygon Offset
+             * only works with polygons and NOT with lines or points.
+             * So, polygon offset cannot be used to move the depth
+             * values for the lines and points "a little closer" to
+             * the user.  Instead, polygon offset is used to push
+             * the underlaying slices "a little bit away" from the
+             * user.
+             *
+             * Resolves WB-414
+             */
+            const float inverseSliceIndex = numberOfVolumesToDraw - iVol;
+            const float factor  = inverseSliceIndex * 1.0 + 1.0;
+            const float units  = inverseSliceIndex * 1.0 + 1.0;
+            glEnable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(factor, units);
+        }
+        
+        /*
+         * Draw the slice from the 3D texture of the map's coloring
+         * when possible, otherwise color the voxels in the slice.
+         */
+        if (drawOrthogonalSliceWithTexture(volumeFile,
+                                           volInfo,
+                                           viewPlaneDimIndex,
+                                           sliceIndexForDrawing,
+                                           sliceNormalVector,
+                                           startCoordinateXYZ,
+                                           rowStepXYZ,
+                                           columnStepXYZ,
+                                           drawLeftToRightInfo.numberOfVoxels,
+                                           drawBottomToTopInfo.numberOfVoxels,
+                                           volumeDrawingOpacity)) {
+            glDisable(GL_POLYGON_OFFSET_FILL);
+            continue;
+        }
+        
         /*
          * Stores RGBA values for each voxel.
          * Use a vector for voxel colors so no worries about memory being freed.
@@ -1736,31 +1783,6 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSlice(const VolumeSliceViewPlaneEnu
                                                                            ydim);
         }
     
-        const uint8_t volumeDrawingOpacity = static_cast<uint8_t>(volInfo.opacity * 255.0);
-        
-        if (m_modelWholeBrain != NULL) {
-            /*
-             * After the a slice is drawn in ALL view, some layers
-             * (volume surface outline) may be drawn in lines.  As the
-             * view is rotated, lines will partially appear and disappear
-             * due to the lines having the same (extremely close) depth
-             * values as the voxel polygons.  OpenGL's Polygon Offset
-             * only works with polygons and NOT with lines or points.
-             * So, polygon offset cannot be used to move the depth
-             * values for the lines and points "a little closer" to
-             * the user.  Instead, polygon offset is used to push
-             * the underlaying slices "a little bit away" from the
-             * user.
-             *
-             * Resolves WB-414
-             */
-            const float inverseSliceIndex = numberOfVolumesToDraw - iVol;
-            const float factor  = inverseSliceIndex * 1.0 + 1.0;
-            const float units  = inverseSliceIndex * 1.0 + 1.0;
-            glEnable(GL_POLYGON_OFFSET_FILL);
-            glPolygonOffset(factor, units);
-        }
-        
         /*
          * Draw the voxels in the slice.
          */
@@ -2150,6 +2172,7 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceWithCulling(const VolumeSliceV
         
         int64_t numVoxelsX = -1, numVoxelsY = -1, numVoxelsZ = -1;
         int64_t sliceIndexForDrawing = -1;
+        int64_t sliceDimIndexForDrawing = -1;
         int64_t dimIJK[3], numMaps, numComponents;
         volumeFile->getDimensions(dimIJK[0], dimIJK[1], dimIJK[2], numMaps, numComponents);
         
@@ -2168,6 +2191,7 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceWithCulling(const VolumeSliceV
                     if (sliceViewPlane == VolumeSliceViewPlaneEnum::PARASAGITTAL)
                     {
                         sliceIndexForDrawing = culledFirstVoxelIJK[whichDim];
+                        sliceDimIndexForDrawing = whichDim;
                         if ((sliceIndexForDrawing < 0) || (sliceIndexForDrawing >= dimIJK[whichDim]))
                         {
                             skipDraw = true;
@@ -2180,6 +2204,7 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceWithCulling(const VolumeSliceV
                     if (sliceViewPlane == VolumeSliceViewPlaneEnum::CORONAL)
                     {
                         sliceIndexForDrawing = culledFirstVoxelIJK[whichDim];
+                        sliceDimIndexForDrawing = whichDim;
                         if ((sliceIndexForDrawing < 0) || (sliceIndexForDrawing >= dimIJK[whichDim]))
                         {
                             skipDraw = true;
@@ -2192,6 +2217,7 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceWithCulling(const VolumeSliceV
                     if (sliceViewPlane == VolumeSliceViewPlaneEnum::AXIAL)
                     {
                         sliceIndexForDrawing = culledFirstVoxelIJK[whichDim];
+                        sliceDimIndexForDrawing = whichDim;
                         if ((sliceIndexForDrawing < 0) || (sliceIndexForDrawing >= dimIJK[whichDim]))
                         {
                             skipDraw = true;
@@ -2228,6 +2254,118 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceWithCulling(const VolumeSliceV
                 break;
         }
         
+        const uint8_t volumeDrawingOpacity = static_cast<uint8_t>(volInfo.opacity * 255.0);
+        
+        /*
+         * Setup for drawing the voxels in the slice.
+         */
+        float startCoordinate[3] = {
+            firstVoxelXYZ[0] - (voxelStepX / 2.0f),
+            firstVoxelXYZ[1] - (voxelStepY / 2.0f),
+            firstVoxelXYZ[2] - (voxelStepZ / 2.0f)
+        };
+        
+        float rowStep[3] = {
+            0.0,
+            0.0,
+            0.0
+        };
+        
+        float columnStep[3] = {
+            0.0,
+            0.0,
+            0.0
+        };
+        
+        
+        int64_t numberOfRows = 0;
+        int64_t numberOfColumns = 0;
+        switch (sliceViewPlane) {
+            case VolumeSliceViewPlaneEnum::ALL:
+                CaretAssert(0);
+                break;
+            case VolumeSliceViewPlaneEnum::AXIAL:
+                rowStep[1] = voxelStepY;
+                columnStep[0] = voxelStepX;
+                numberOfRows    = numVoxelsY;//WARNING: this is actually length of row, not number of rows, ditto for the rest
+                numberOfColumns = numVoxelsX;//leaving it alone for now...
+                break;
+            case VolumeSliceViewPlaneEnum::CORONAL:
+                rowStep[2] = voxelStepZ;
+                columnStep[0] = voxelStepX;
+                numberOfRows    = numVoxelsZ;
+                numberOfColumns = numVoxelsX;
+                break;
+            case VolumeSliceViewPlaneEnum::PARASAGITTAL:
+                rowStep[2] = voxelStepZ;
+                columnStep[1] = voxelStepY;
+                numberOfRows    = numVoxelsZ;
+                numberOfColumns = numVoxelsY;
+                break;
+        }
+        
+        if (m_modelWholeBrain != NULL) {
+            /*
+             * After the a slice is drawn in ALL view, some layers
+             * (volume surface outline) may be drawn in lines.  As the
+             * view is rotated, lines will partially appear and disappear
+             * due to the lines having the same (extremely close) depth
+             * values as the voxel polygons.  OpenGL's Polygon Offset
+             * only works with polygons and NOT with lines or points.
+             * So, polygon offset cannot be used to move the depth
+             * values for the lines and points "a little closer" to
+             * the user.  Instead, polygon offset is used to push
+             * the underlaying slices "a little bit away" from the
+             * user.
+             *
+             * Resolves WB-414
+             */
+            const float inverseSliceIndex = numberOfVolumesToDraw - iVol;
+            const float factor  = inverseSliceIndex * 1.0 + 1.0;
+            const float units  = inverseSliceIndex * 1.0 + 1.0;
+            glEnable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(factor, units);
+        }
+        else {
+            /*
+             * A layer may be "under" another layer and not be seen.
+             * Draw all layers at the selected slice coordinate.
+             */
+            switch (sliceViewPlane) {
+                case VolumeSliceViewPlaneEnum::ALL:
+                    CaretAssert(0);
+                    break;
+                case VolumeSliceViewPlaneEnum::AXIAL:
+                    startCoordinate[2] = selectedSliceCoordinate;
+                    break;
+                case VolumeSliceViewPlaneEnum::CORONAL:
+                    startCoordinate[1] = selectedSliceCoordinate;
+                    break;
+                case VolumeSliceViewPlaneEnum::PARASAGITTAL:
+                    startCoordinate[0] = selectedSliceCoordinate;
+                    break;
+            }
+        }
+        
+        /*
+         * Draw the slice from the 3D texture of the map's coloring
+         * when possible, otherwise color the voxels in the slice.
+         */
+        if (drawOrthogonalSliceWithTexture(volumeFile,
+                                           volInfo,
+                                           sliceDimIndexForDrawing,
+                                           sliceIndexForDrawing,
+                                           sliceNormalVector,
+                                           startCoordinate,
+                                           rowStep,
+                                           columnStep,
+                                           numberOfColumns,
+                                           numberOfRows,
+                                           volumeDrawingOpacity)) {
+            glDisable(GL_POLYGON_OFFSET_FILL);
+            continue;
+        }
+        
         /*
          * Stores RGBA values for each voxel.
          * Use a vector for voxel colors so no worries about memory being freed.
@@ -2328,99 +2466,6 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceWithCulling(const VolumeSliceV
                                                                            ydim);
         }
         
-        const uint8_t volumeDrawingOpacity = static_cast<uint8_t>(volInfo.opacity * 255.0);
-        
-        /*
-         * Setup for drawing the voxels in the slice.
-         */
-        float startCoordinate[3] = {
-            firstVoxelXYZ[0] - (voxelStepX / 2.0f),
-            firstVoxelXYZ[1] - (voxelStepY / 2.0f),
-            firstVoxelXYZ[2] - (voxelStepZ / 2.0f)
-        };
-        
-        float rowStep[3] = {
-            0.0,
-            0.0,
-            0.0
-        };
-        
-        float columnStep[3] = {
-            0.0,
-            0.0,
-            0.0
-        };
-        
-        
-        int64_t numberOfRows = 0;
-        int64_t numberOfColumns = 0;
-        switch (sliceViewPlane) {
-            case VolumeSliceViewPlaneEnum::ALL:
-                CaretAssert(0);
-                break;
-            case VolumeSliceViewPlaneEnum::AXIAL:
-                rowStep[1] = voxelStepY;
-                columnStep[0] = voxelStepX;
-                numberOfRows    = numVoxelsY;//WARNING: this is actually length of row, not number of rows, ditto for the rest
-                numberOfColumns = numVoxelsX;//leaving it alone for now...
-                break;
-            case VolumeSliceViewPlaneEnum::CORONAL:
-                rowStep[2] = voxelStepZ;
-                columnStep[0] = voxelStepX;
-                numberOfRows    = numVoxelsZ;
-                numberOfColumns = numVoxelsX;
-                break;
-            case VolumeSliceViewPlaneEnum::PARASAGITTAL:
-                rowStep[2] = voxelStepZ;
-                columnStep[1] = voxelStepY;
-                numberOfRows    = numVoxelsZ;
-                numberOfColumns = numVoxelsY;
-                break;
-        }
-        
-        if (m_modelWholeBrain != NULL) {
-            /*
-             * After the a slice is drawn in ALL view, some layers
-             * (volume surface outline) may be drawn in lines.  As the
-             * view is rotated, lines will partially appear and disappear
-             * due to the lines having the same (extremely close) depth
-             * values as the voxel polygons.  OpenGL's Polygon Offset
-             * only works with polygons and NOT with lines or points.
-             * So, polygon offset cannot be used to move the depth
-             * values for the lines and points "a little closer" to
-             * the user.  Instead, polygon offset is used to push
-             * the underlaying slices "a little bit away" from the
-             * user.
-             *
-             * Resolves WB-414
-             */
-            const float inverseSliceIndex = numberOfVolumesToDraw - iVol;
-            const float factor  = inverseSliceIndex * 1.0 + 1.0;
-            const float units  = inverseSliceIndex * 1.0 + 1.0;
-            glEnable(GL_POLYGON_OFFSET_FILL);
-            glPolygonOffset(factor, units);
-        }
-        else {
-            /*
-             * A layer may be "under" another layer and not be seen.
-             * Draw all layers at the selected slice coordinate.
-             */
-            switch (sliceViewPlane) {
-                case VolumeSliceViewPlaneEnum::ALL:
-                    CaretAssert(0);
-                    break;
-                case VolumeSliceViewPlaneEnum::AXIAL:
-                    startCoordinate[2] = selectedSliceCoordinate;
-                    break;
-                case VolumeSliceViewPlaneEnum::CORONAL:
-                    startCoordinate[1] = selectedSliceCoordinate;
-                    break;
-                case VolumeSliceViewPlaneEnum::PARASAGITTAL:
-                    startCoordinate[0] = selectedSliceCoordinate;
-                    break;
-            }
-        }
-        
         /*
          * Draw the voxels in the slice.
          */
@@ -3902,6 +3947,160 @@ BrainOpenGLVolumeSliceDrawing::setOrthographicProjection(const AllSliceViewMode
                               m_orthographicBounds);
 }
 
+/**
+ * Draw an orthogonal slice as a single quad textured with the volume
+ * map's 3D texture of voxel coloring.  The texture is built from the
+ * map's coloring once and reused until the coloring changes, so that
+ * slice changes do not require any CPU coloring of voxels.
+ *
+ * Labels (per-tab label selection, outline drawing), palette threshold
+ * outlines, and identification require per-slice processing of the
+ * voxel colors, in which case false is returned and the caller must
+ * draw the voxels.
+ *
+ * @param volumeInterface
+ *    The volume being drawn.
+ * @param volInfo
+ *    Drawing info for the volume.
+ * @param sliceDimIndex
+ *    Index of the volume dimension (IJK) that is perpendicular to the slice.
+ * @param sliceIndex
+ *    Index of the slice in the dimension perpendicular to the slice.
+ * @param sliceNormalVector
+ *    Normal vector of the slice plane.
+ * @param coordinate
+ *    Coordinate of corner of first voxel in the slice (bottom left as begin viewed)
+ * @param rowStep
+ *    Three-dimensional step to next row.
+ * @param columnStep
+ *    Three-dimensional step to next column.
+ * @param numberOfColumns
+ *    Number of columns in the slice.
+ * @param numberOfRows
+ *    Number of rows in the slice.
+ * @param sliceOpacity
+ *    Opacity for the slice.
+ * @return
+ *    True if the slice was drawn, else false.
+ */
+bool
+BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceWithTexture(const VolumeMappableInterface* volumeInterface,
+                                                              const BrainOpenGLFixedPipeline::VolumeDrawInfo& volInfo,
+                                                              const int64_t sliceDimIndex,
+                                                              const int64_t sliceIndex,
+                                                              const float sliceNormalVector[3],
+                                                              const float coordinate[3],
+                                                              const float rowStep[3],
+                                                              const float columnStep[3],
+                                                              const int64_t numberOfColumns,
+                                                              const int64_t numberOfRows,
+                                                              const uint8_t sliceOpacity)
+{
+    if (m_identificationModeFlag) {
+        return false;
+    }
+    if ((sliceDimIndex < 0)
+        || (sliceDimIndex > 2)) {
+        return false;
+    }
+    
+    const VolumeFile* volumeFile = dynamic_cast<const VolumeFile*>(volumeInterface);
+    if (volumeFile == NULL) {
+        return false;
+    }
+    
+    const int32_t mapIndex = volInfo.mapIndex;
+    if (volumeFile->isMappedWithPalette()) {
+        const PaletteColorMapping* pcm = volumeFile->getMapPaletteColorMapping(mapIndex);
+        if (pcm->getThresholdOutlineDrawingMode() != PaletteThresholdOutlineDrawingModeEnum::OFF) {
+            return false;
+        }
+    }
+    else if ( ! volumeFile->isMappedWithRGBA()) {
+        return false;
+    }
+    
+    const uint8_t* voxelRGBA = volumeFile->getVoxelColorsForMap(mapIndex);
+    if (voxelRGBA == NULL) {
+        return false;
+    }
+    
+    void* contextPointer = m_fixedPipelineDrawing->getContextSharingGroupPointer();
+    const int64_t modificationStamp = volumeFile->getVoxelColorsModificationStampForMap(mapIndex);
+    int64_t dims[3], numMaps, numComponents;
+    volumeFile->getDimensions(dims[0], dims[1], dims[2], numMaps, numComponents);
+    GraphicsOpenGLVolumeTexture* volumeTexture = volumeFile->getOpenGLVolumeTexture();
+    CaretAssert(volumeTexture);
+    if ( ! volumeTexture->isValid(contextPointer,
+                                  mapIndex,
+                                  modificationStamp)) {
+        if ( ! volumeTexture->loadTexture(contextPointer,
+                                          voxelRGBA,
+                                          dims,
+                                          mapIndex,
+                                          modificationStamp)) {
+            return false;
+        }
+    }
+    
+    /*
+     * Corners of the slice, counter-clockwise from the first voxel
+     */
+    float cornerXYZ[4][3];
+    for (int32_t m = 0; m < 3; m++) {
+        const float colOffset = numberOfColumns * columnStep[m];
+        const float rowOffset = numberOfRows    * rowStep[m];
+        cornerXYZ[0][m] = coordinate[m];
+        cornerXYZ[1][m] = coordinate[m] + colOffset;
+        cornerXYZ[2][m] = coordinate[m] + colOffset + rowOffset;
+        cornerXYZ[3][m] = coordinate[m] + rowOffset;
+    }
+    
+    /*
+     * Texture coordinates are at voxel centers, (index + 0.5) / dim.
+     * The slice coordinate may not be at the center of the slice's
+     * voxels so the slice's texture coordinate is set explicitly.
+     */
+    float cornerSTR[4][3];
+    const VolumeSpace& volumeSpace = volumeFile->getVolumeSpace();
+    for (int32_t iCorner = 0; iCorner < 4; iCorner++) {
+        float ijk[3];
+        volumeSpace.spaceToIndex(cornerXYZ[iCorner], ijk);
+        for (int32_t m = 0; m < 3; m++) {
+            cornerSTR[iCorner][m] = (ijk[m] + 0.5f) / static_cast<float>(dims[m]);
+        }
+        cornerSTR[iCorner][sliceDimIndex] = (sliceIndex + 0.5f) / static_cast<float>(dims[sliceDimIndex]);
+    }
+    
+    glPushAttrib(GL_ENABLE_BIT
+                 | GL_TEXTURE_BIT
+                 | GL_COLOR_BUFFER_BIT);
+    
+    glEnable(GL_TEXTURE_3D);
+    glBindTexture(GL_TEXTURE_3D, volumeTexture->getTextureName());
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    
+    /*
+     * Voxels that are not colored must not update the depth buffer
+     */
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0);
+    
+    glColor4ub(255, 255, 255, sliceOpacity);
+    glBegin(GL_QUADS);
+    glNormal3fv(sliceNormalVector);
+    for (int32_t iCorner = 0; iCorner < 4; iCorner++) {
+        glTexCoord3fv(cornerSTR[iCorner]);
+        glVertex3fv(cornerXYZ[iCorner]);
+    }
+    glEnd();
+    
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glPopAttrib();
+    
+    return true;
+}
+
 /**
  * Draw the voxels in an orthogonal slice.
  *
@@ -5771,6 +5970,50 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceAllView(const VolumeSliceViewP
         startCoordinateXYZ[drawLeftToRightInfo.indexIntoXYZ] -= (drawLeftToRightInfo.voxelStepSize / 2.0);
         startCoordinateXYZ[drawBottomToTopInfo.indexIntoXYZ] -= (drawBottomToTopInfo.voxelStepSize / 2.0);
         
+        const uint8_t volumeDrawingOpacity = static_cast<uint8_t>(volInfo.opacity * 255.0);
+        
+        if (m_modelWholeBrain != NULL) {
+            /*
+             * After the a slice is drawn in ALL view, some layers
+             * (volume surface outline) may be drawn in lines.  As the
+             * view is rotated, lines will partially appear and disappear
+             * due to the lines having the same (extremely close) depth
+             * values as the voxel polygons.  OpenGL's Polygon Offset
+             * only works with polygons and NOT with lines or points.
+             * So, polygon offset cannot be used to move the depth
+             * values for the lines and points "a little closer" to
+             * the user.  Instead, polygon offset is used to push
+             * the underlaying slices "a little bit away" from the
+             * user.
+             *
+             * Resolves WB-414
+             */
+            const float inverseSliceIndex = numberOfVolumesToDraw - iVol;
+            const float factor  = inverseSliceIndex * 1.0 + 1.0;
+            const float units  = inverseSliceIndex * 1.0 + 1.0;
+            glEnable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(factor, units);
+        }
+        
+        /*
+         * Draw the slice from the 3D texture of the map's coloring
+         * when possible, otherwise color the voxels in the slice.
+         */
+        if (drawOrthogonalSliceWithTexture(volumeInterface,
+                                           volInfo,
+                                           viewPlaneDimIndex,
+                                           sliceIndexForDrawing,
+                                           sliceNormalVector,
+                                           startCoordinateXYZ,
+                                           rowStepXYZ,
+                                           columnStepXYZ,
+                                           drawLeftToRightInfo.numberOfVoxels,
+                                           drawBottomToTopInfo.numberOfVoxels,
+                                           volumeDrawingOpacity)) {
+            glDisable(GL_POLYGON_OFFSET_FILL);
+            continue;
+        }
+        
         /*
          * Stores RGBA values for each voxel.
          * Use a vector for voxel colors so no worries about memory being freed.
@@ -5837,31 +6080,6 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceAllView(const VolumeSliceViewP
                                                                            ydim);
         }
         
-        const uint8_t volumeDrawingOpacity = static_cast<uint8_t>(volInfo.opacity * 255.0);
-        
-        if (m_modelWholeBrain != NULL) {
-            /*
-             * After the a slice is drawn in ALL view, some layers
-             * (volume surface outline) may be drawn in lines.  As the
-             * view is rotated, lines will partially appear and disappear
-             * due to the lines having the same (extremely close) depth
-             * values as the voxel polygons.  OpenGL's Polygon Offset
-             * only works with polygons and NOT with lines or points.
-             * So, polygon offset cannot be used to move the depth
-             * values for the lines and points "a little closer" to
-             * the user.  Instead, polygon offset is used to push
-             * the underlaying slices "a little bit away" from the
-             * user.
-             *
-             * Resolves WB-414
-             */
-            const float inverseSliceIndex = numberOfVolumesToDraw - iVol;
-            const float factor  = inverseSliceIndex * 1.0 + 1.0;
-            const float units  = inverseSliceIndex * 1.0 + 1.0;
-            glEnable(GL_POLYGON_OFFSET_FILL);
-            glPolygonOffset(factor, units);
-        }
-        
         /*
          * Draw the voxels in the slice.
          */
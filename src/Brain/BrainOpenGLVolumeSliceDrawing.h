@@ -300,6 +300,18 @@ namespace caret {
                                        const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
                                        const int viewport[4]);
         
+        bool drawOrthogonalSliceWithTexture(const VolumeMappableInterface* volumeInterface,
+                                            const BrainOpenGLFixedPipeline::VolumeDrawInfo& volInfo,
+                                            const int64_t sliceDimIndex,
+                                            const int64_t sliceIndex,
+                                            const float sliceNormalVector[3],
+                                            const float coordinate[3],
+                                            const float rowStep[3],
+                                            const float columnStep[3],
+                                            const int64_t numberOfColumns,
+                                            const int64_t numberOfRows,
+                                            const uint8_t sliceOpacity);
+        
         void drawOrthogonalSliceVoxels(const float sliceNormalVector[3],
                                        const float coordinate[3],
                                        const float rowStep[3],
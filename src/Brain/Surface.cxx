@@ -19,6 +19,7 @@
 /*LICENSE_END*/
 
 #include "BoundingBox.h"
+#include "BrainOpenGLSurfaceBuffers.h"
 #include "BrainStructure.h"
 #include "Surface.h"
 
@@ -105,6 +106,7 @@ void
 Surface::initializeMemberSurface()
 {
     this->brainStructure = NULL;
+    m_openGLSurfaceBuffers.reset();
 }
 
 /**
@@ -146,6 +148,15 @@ Surface::setBrainStructure(BrainStructure* brainStructure)
     this->brainStructure = brainStructure;
 }
 
-
-
-
+/**
+ * @return The OpenGL buffers used for drawing this surface.  The buffers
+ * are created on first use and are only reloaded when the surface changes.
+ */
+BrainOpenGLSurfaceBuffers*
+Surface::getOpenGLSurfaceBuffers() const
+{
+    if (m_openGLSurfaceBuffers == NULL) {
+        m_openGLSurfaceBuffers.reset(new BrainOpenGLSurfaceBuffers());
+    }
+    return m_openGLSurfaceBuffers.get();
+}
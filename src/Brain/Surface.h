@@ -22,6 +22,7 @@
  */
 /*LICENSE_END*/
 
+#include <memory>
 #include <vector>
 
 #include "SurfaceFile.h"
@@ -29,6 +30,7 @@
 namespace caret {
     
     class BoundingBox;
+    class BrainOpenGLSurfaceBuffers;
     class BrainStructure;
     
     /**
@@ -55,12 +57,17 @@ namespace caret {
         
         void setBrainStructure(BrainStructure* brainStructure);
         
+        BrainOpenGLSurfaceBuffers* getOpenGLSurfaceBuffers() const;
+        
     private:
         void initializeMemberSurface();
         
         void copyHelperSurface(const Surface& s);
 
         BrainStructure* brainStructure;
+        
+        /** OpenGL buffers for drawing, created when first drawn */
+        mutable std::unique_ptr<BrainOpenGLSurfaceBuffers> m_openGLSurfaceBuffers;
     };
 
 } // namespace
@@ -49,6 +49,7 @@ namespace
         const CiftiXML& getCiftiXML() const { return m_xml; }
         QString getFilename() const { return m_nifti.getFilename(); }
         bool isSwapped() const { return m_nifti.getHeader().isSwapped(); }
+        bool hasParallelRowIO() const { return m_nifti.hasParallelAccess(); }
         void setRow(const float* dataIn, const std::vector<int64_t>& indexSelect);
         void setColumn(const float* dataIn, const int64_t& index);
         void close();
@@ -62,6 +63,7 @@ namespace
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const;
         void getColumn(float* dataOut, const int64_t& index) const;
         bool isInMemory() const { return true; }
+        bool hasParallelRowIO() const { return true; }
         void setRow(const float* dataIn, const std::vector<int64_t>& indexSelect);
         void setColumn(const float* dataIn, const int64_t& index);
     };
@@ -242,6 +244,17 @@ bool CiftiFile::isInMemory() const
     }
 }
 
+bool CiftiFile::hasParallelRowIO() const
+{
+    if (m_readingImpl == NULL) return isInMemory();//what it would be after setting up writing
+    return m_readingImpl->hasParallelRowIO();
+}
+
+void CiftiFile::prepareForParallelWrites()
+{
+    verifyWriteImpl();
+}
+
 void CiftiFile::getRow(float* dataOut, const vector<int64_t>& indexSelect, const bool& tolerateShortRead) const
 {
     if (m_dims.empty()) throw DataFileException("getRow called on uninitialized CiftiFile");
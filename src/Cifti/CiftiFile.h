@@ -62,6 +62,10 @@ namespace caret
         QString getFileName() const { return m_fileName; }
         
         bool isInMemory() const;
+        ///getRow may always be called from multiple threads, as may setRow for different rows after prepareForParallelWrites()
+        ///this returns false if those calls will end up serialized on a lock (compressed or remote file), in which case callers should keep their requests in order
+        bool hasParallelRowIO() const;
+        void prepareForParallelWrites();//sets up the writing implementation, which otherwise happens in the first setRow
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead = false) const;//tolerateShortRead is useful for on-disk writing when it is easiest to do RMW multiple times on a new file
         const std::vector<int64_t>& getDimensions() const { return m_dims; }
         MultiDimIterator<int64_t> getIteratorOverRows() const
@@ -92,6 +96,7 @@ namespace caret
             virtual void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const = 0;
             virtual void getColumn(float* dataOut, const int64_t& index) const = 0;
             virtual bool isInMemory() const { return false; }
+            virtual bool hasParallelRowIO() const { return false; }
             virtual ~ReadImplInterface();
         };
         //assume if you can write to it, you can also read from it
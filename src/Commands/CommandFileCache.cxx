@@ -0,0 +1,156 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CommandFileCache.h"
+
+#include "CaretLogger.h"
+#include "CiftiFile.h"
+#include "SurfaceFile.h"
+#include "VolumeFile.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <map>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    template<typename T>
+    struct CacheEntry
+    {
+        qint64 m_modified, m_size;
+        CaretPointer<T> m_file;
+    };
+
+    bool g_cacheEnabled = false;
+    map<AString, CacheEntry<SurfaceFile> > g_surfaceCache;
+    map<AString, CacheEntry<VolumeFile> > g_volumeCache;
+    map<AString, CacheEntry<CiftiFile> > g_ciftiCache;
+
+    void readInto(SurfaceFile* file, const AString& fileName) { file->readFile(fileName); }
+    void readInto(VolumeFile* file, const AString& fileName) { file->readFile(fileName); }
+    void readInto(CiftiFile* file, const AString& fileName) { file->openFile(fileName); }
+
+    bool isModified(const SurfaceFile* file) { return file->isModified(); }
+    bool isModified(const VolumeFile* file) { return file->isModified(); }
+    bool isModified(const CiftiFile* file) { return file->getCiftiXML().mutablesModified(); }
+
+    template<typename T>
+    CaretPointer<T> getCachedFile(map<AString, CacheEntry<T> >& cache, const AString& fileName, const bool& privateCopy)
+    {
+        CaretPointer<T> ret;
+        QFileInfo myInfo(fileName);
+        AString canonical = myInfo.canonicalFilePath();//empty if it doesn't exist, let the reader generate the error
+        if (!g_cacheEnabled || canonical == "" || privateCopy)
+        {
+            ret.grabNew(new T());
+            readInto(ret.getPointer(), fileName);
+            return ret;
+        }
+        qint64 modified = myInfo.lastModified().toMSecsSinceEpoch(), size = myInfo.size();
+        typename map<AString, CacheEntry<T> >::iterator iter = cache.find(canonical);
+        if (iter != cache.end())
+        {
+            if (iter->second.m_modified == modified && iter->second.m_size == size)
+            {
+                CaretLogFine("using cached copy of '" + fileName + "'");
+                return iter->second.m_file;
+            }
+            cache.erase(iter);
+        }
+        ret.grabNew(new T());
+        readInto(ret.getPointer(), fileName);
+        CacheEntry<T>& newEntry = cache[canonical];
+        newEntry.m_modified = modified;
+        newEntry.m_size = size;
+        newEntry.m_file = ret;
+        return ret;
+    }
+
+    template<typename T>
+    void releaseModifiedFiles(map<AString, CacheEntry<T> >& cache)
+    {
+        typename map<AString, CacheEntry<T> >::iterator iter = cache.begin();
+        while (iter != cache.end())
+        {
+            if (isModified(iter->second.m_file.getPointer()))
+            {
+                CaretLogFine("dropping modified cached copy of '" + iter->first + "'");
+                cache.erase(iter++);
+            } else {
+                ++iter;
+            }
+        }
+    }
+}
+
+void CommandFileCache::setEnabled(const bool& enabled)
+{
+    g_cacheEnabled = enabled;
+    if (!enabled) clear();
+}
+
+bool CommandFileCache::isEnabled()
+{
+    return g_cacheEnabled;
+}
+
+CaretPointer<SurfaceFile> CommandFileCache::getSurface(const AString& fileName, const bool& privateCopy)
+{
+    return getCachedFile(g_surfaceCache, fileName, privateCopy);
+}
+
+CaretPointer<VolumeFile> CommandFileCache::getVolume(const AString& fileName, const bool& privateCopy)
+{
+    return getCachedFile(g_volumeCache, fileName, privateCopy);
+}
+
+CaretPointer<CiftiFile> CommandFileCache::getCifti(const AString& fileName, const bool& privateCopy)
+{
+    return getCachedFile(g_ciftiCache, fileName, privateCopy);
+}
+
+void CommandFileCache::invalidate(const AString& fileName)
+{
+    if (!g_cacheEnabled) return;
+    AString canonical = QFileInfo(fileName).canonicalFilePath();
+    if (canonical == "") return;//if it doesn't exist yet, we can't have cached it
+    g_surfaceCache.erase(canonical);
+    g_volumeCache.erase(canonical);
+    g_ciftiCache.erase(canonical);
+}
+
+void CommandFileCache::releaseModified()
+{//catches in-place changes that an operation didn't declare, unless it also wrote the file, which clears the flags
+    if (!g_cacheEnabled) return;
+    releaseModifiedFiles(g_surfaceCache);
+    releaseModifiedFiles(g_volumeCache);
+    releaseModifiedFiles(g_ciftiCache);
+}
+
+void CommandFileCache::clear()
+{
+    g_surfaceCache.clear();
+    g_volumeCache.clear();
+    g_ciftiCache.clear();
+}
@@ -0,0 +1,69 @@
+#ifndef __COMMAND_FILE_CACHE_H__
+#define __COMMAND_FILE_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+#include "CaretPointer.h"
+
+namespace caret {
+
+    class CiftiFile;
+    class SurfaceFile;
+    class VolumeFile;
+
+    /**
+     * Keeps input files open between commands run in one process (-batch), so that
+     * a surface used by many commands is only read once, and its topology/geodesic
+     * helpers are only built once.  Entries are keyed by canonical path, and are
+     * reread if the file's modification time or size changes.  Operations that change
+     * an input file object must mark that parameter with setInputModifiedInPlace(), so
+     * they get a private copy.  Disabled by default, in which case the get functions
+     * simply read the file.
+     */
+    class CommandFileCache
+    {
+    public:
+        ///turn caching on or off, turning it off releases all cached files
+        static void setEnabled(const bool& enabled);
+
+        static bool isEnabled();
+
+        ///privateCopy reads a separate copy that is never shared, for operations that modify their input object
+        static CaretPointer<SurfaceFile> getSurface(const AString& fileName, const bool& privateCopy = false);
+
+        static CaretPointer<VolumeFile> getVolume(const AString& fileName, const bool& privateCopy = false);
+
+        ///cifti files are opened ON_DISK as usual, only the XML and any loaded data are kept
+        static CaretPointer<CiftiFile> getCifti(const AString& fileName, const bool& privateCopy = false);
+
+        ///call before writing to a file, so later commands don't get a stale in-memory copy
+        static void invalidate(const AString& fileName);
+
+        ///call after each command, drops any cached file whose in-memory object reports modifications
+        static void releaseModified();
+
+        static void clear();
+    };
+
+} // namespace
+
+#endif // __COMMAND_FILE_CACHE_H__
@@ -53,6 +53,7 @@
 #include "AlgorithmCiftiParcellate.h"
 #include "AlgorithmCiftiParcelMappingToLabel.h"
 #include "AlgorithmCiftiReduce.h"
+#include "AlgorithmCiftiRegression.h"
 #include "AlgorithmCiftiReorder.h"
 #include "AlgorithmCiftiReplaceStructure.h"
 #include "AlgorithmCiftiResample.h"
@@ -130,6 +131,7 @@
 #include "AlgorithmVolumeParcelResamplingGeneric.h"
 #include "AlgorithmVolumeParcelSmoothing.h"
 #include "AlgorithmVolumeReduce.h"
+#include "AlgorithmVolumeRegression.h"
 #include "AlgorithmVolumeRemoveIslands.h"
 #include "AlgorithmVolumeROIsFromExtrema.h"
 #include "AlgorithmVolumeSmoothing.h"
@@ -231,6 +233,8 @@
 
 #include "AlgorithmException.h"
 #include "ApplicationInformation.h"
+#include "CaretCommandLine.h"
+#include "CommandFileCache.h"
 #include "CommandParser.h"
 #include "OperationException.h"
 
@@ -247,6 +251,8 @@
 #include "dot_wrapper.h"
 #include "StructureEnum.h"
 
+#include <QFile>
+
 #include <iostream>
 #include <map>
 
@@ -315,6 +321,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiParcellate()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiParcelMappingToLabel()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiReduce()));
+    this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiRegression()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiReorder()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiReplaceStructure()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiResample()));
@@ -393,6 +400,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeParcelResamplingGeneric()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeParcelSmoothing()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeReduce()));
+    this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeRegression()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeRemoveIslands()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeROIsFromExtrema()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeSmoothing()));
@@ -548,6 +556,68 @@ namespace
         }
         return iter->second;
     }
+    
+    //shell-like word splitting for -batch: whitespace separates words, '' quotes literally, "" allows \" and \\,
+    //backslash escapes the next character, backslash-newline joins lines, # at the start of a word begins a comment
+    //returns false if the text ends inside quotes or after a trailing backslash, so the caller can append the next line
+    bool splitBatchCommand(const AString& text, vector<AString>& wordsOut)
+    {
+        wordsOut.clear();
+        AString curWord;
+        bool inWord = false;
+        const int length = text.size();
+        for (int i = 0; i < length; ++i)
+        {
+            const QChar c = text[i];
+            if (c == '\\')
+            {
+                if (i + 1 >= length) return false;
+                ++i;
+                if (text[i] == '\n') continue;//line continuation, doesn't start or end a word
+                curWord += text[i];
+                inWord = true;
+            } else if (c == '\'') {
+                int end = text.indexOf('\'', i + 1);
+                if (end == -1) return false;
+                curWord += text.mid(i + 1, end - i - 1);
+                inWord = true;
+                i = end;
+            } else if (c == '"') {
+                inWord = true;
+                bool closed = false;
+                for (++i; i < length; ++i)
+                {
+                    if (text[i] == '"')
+                    {
+                        closed = true;
+                        break;
+                    }
+                    if (text[i] == '\\' && i + 1 < length && (text[i + 1] == '"' || text[i + 1] == '\\'))
+                    {
+                        ++i;
+                    }
+                    curWord += text[i];
+                }
+                if (!closed) return false;
+            } else if (c.isSpace()) {
+                if (inWord)
+                {
+                    wordsOut.push_back(curWord);
+                    curWord = "";
+                    inWord = false;
+                }
+            } else if (c == '#' && !inWord) {
+                int end = text.indexOf('\n', i);
+                if (end == -1) break;
+                i = end - 1;//let the newline end the comment
+            } else {
+                curWord += c;
+                inWord = true;
+            }
+        }
+        if (inWord) wordsOut.push_back(curWord);
+        return true;
+    }
 }
 
 /**
@@ -634,6 +704,10 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
         printDeprecatedCommands();
     } else if (commandSwitch == "-all-commands-help") {
         printAllCommandsHelpInfo(myProgramName);
+    } else if (commandSwitch == "-batch") {
+        AString scriptName = parameters.nextString("batch script");
+        parameters.verifyAllParametersProcessed();
+        runBatch(scriptName, parameters.getProgramName());
     } else {
         
         CommandOperation* operation = NULL;
@@ -682,6 +756,87 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
     }
 }
 
+/**
+ * Run the commands in a batch script in this process, so that input files used by
+ * more than one command are only read once (see CommandFileCache).
+ * Stops at the first command that fails.
+ *
+ * @param scriptName
+ *    Name of the script file, or "-" for standard input.
+ * @param programName
+ *    Program name to use in the provenance of each command.
+ * @throws CommandException
+ *    If a command failed or the script can't be read.
+ */
+void
+CommandOperationManager::runBatch(const AString& scriptName, const AString& programName)
+{
+    if (CommandFileCache::isEnabled())
+    {
+        throw CommandException("-batch can't be used inside a batch script");
+    }
+    QFile scriptFile;
+    bool opened = false;
+    if (scriptName == "-")
+    {
+        opened = scriptFile.open(stdin, QIODevice::ReadOnly);
+    } else {
+        scriptFile.setFileName(scriptName);
+        opened = scriptFile.open(QIODevice::ReadOnly);
+    }
+    if (!opened) throw CommandException("failed to open batch script '" + scriptName + "': " + scriptFile.errorString());
+    const AString batchCommandLine = caret_global_commandLine;
+    const QByteArray programNameLocal = programName.toLocal8Bit();
+    const char* const programArgv[] = { programNameLocal.constData() };
+    CommandFileCache::setEnabled(true);
+    AString pending;
+    int lineNum = 0, commandLine = 0;//commandLine is where a multi-line command started
+    vector<AString> words;
+    try
+    {
+        while (!scriptFile.atEnd())
+        {
+            AString line = QString::fromLocal8Bit(scriptFile.readLine());
+            ++lineNum;
+            while (line.endsWith('\n') || line.endsWith('\r')) line.chop(1);
+            if (pending == "")
+            {
+                commandLine = lineNum;
+                pending = line;
+            } else {
+                pending += "\n" + line;
+            }
+            if (!splitBatchCommand(pending, words)) continue;//unterminated quote or line continuation
+            pending = "";
+            int firstWord = 0;
+            if (!words.empty() && (words[0] == "wb_command" || words[0].endsWith("/wb_command"))) firstWord = 1;//allow existing shell scripts to be used with minimal editing
+            if (firstWord >= (int)words.size()) continue;
+            ProgramParameters lineParams(1, programArgv);
+            for (int i = firstWord; i < (int)words.size(); ++i)
+            {
+                lineParams.addParameter(words[i]);
+            }
+            caret_global_commandLine_init(lineParams);//so provenance and error messages show this command, not the -batch invocation
+            CaretLogFine("Running: " + caret_global_commandLine);
+            try
+            {
+                runCommand(lineParams);
+            } catch (CaretException& e) {
+                throw CommandException("line " + AString::number(commandLine) + " of batch script '" + scriptName + "': " + e.whatString());
+            }
+        }
+        if (pending != "")
+        {
+            throw CommandException("batch script '" + scriptName + "' ends inside a quoted string or line continuation, starting at line " + AString::number(commandLine));
+        }
+    } catch (...) {
+        CommandFileCache::setEnabled(false);
+        throw;//leave caret_global_commandLine as the failing command, for the error report
+    }
+    CommandFileCache::setEnabled(false);
+    caret_global_commandLine = batchCommandLine;
+}
+
 AString CommandOperationManager::doCompletion(ProgramParameters& parameters, const bool& useExtGlob)
 {
     AString ret;
@@ -727,7 +882,7 @@ AString CommandOperationManager::doCompletion(ProgramParameters& parameters, con
     const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
     if (!parameters.hasNext())
     {//suggest all commands, including deprecated and informational (order doesn't matter, bash sorts them before displaying)
-        ret += "\\ -help\\ -arguments-help\\ -global-options\\ -parallel-help\\ -cifti-help\\ -gifti-help\\ -volume-help\\ -version\\ -list-commands\\ -list-deprecated-commands\\ -all-commands-help";
+        ret += "\\ -batch\\ -help\\ -arguments-help\\ -global-options\\ -parallel-help\\ -cifti-help\\ -gifti-help\\ -volume-help\\ -version\\ -list-commands\\ -list-deprecated-commands\\ -all-commands-help";
         for (uint64_t i = 0; i < numberOfCommands; i++)
         {
             ret += "\\ " + commandOperations[i]->getCommandLineSwitch();
@@ -985,6 +1140,12 @@ void CommandOperationManager::printHelpInfo()
     cout << "   -all-commands-help          show all processing subcommands and their help" << endl;
     cout << "                                  info - VERY LONG" << endl;
     cout << endl;
+    cout << "Batch processing:" << endl;
+    cout << "   -batch <script>             run each line of a text file (or '-' for standard" << endl;
+    cout << "                                  input) as a wb_command command line, keeping" << endl;
+    cout << "                                  input surface, volume, and cifti files loaded" << endl;
+    cout << "                                  between commands" << endl;
+    cout << endl;
     cout << "To get the help information of a processing subcommand, run it without any" << endl;
     cout << "   additional arguments." << endl;
     cout << endl;
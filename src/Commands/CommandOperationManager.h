@@ -79,6 +79,8 @@ namespace caret {
         
         void printVersionInfo();
         
+        void runBatch(const AString& scriptName, const AString& programName);
+        
         bool getGlobalOption(ProgramParameters& parameters, const AString& optionString, const int& numArgs, std::vector<AString>& arguments);
         
         struct OptionInfo
@@ -29,6 +29,7 @@
 #include "CaretDataFileHelper.h"
 #include "CaretLogger.h"
 #include "CiftiFile.h"
+#include "CommandFileCache.h"
 #include "DataFileException.h"
 #include "FileInformation.h"
 #include "FociFile.h"
@@ -98,7 +99,14 @@ void CommandParser::executeOperation(ProgramParameters& parameters)
     makeOnDiskOutputs(myOutAssoc);//check for input on-disk files used as output on-disk files
     //code to show what arguments map to what parameters should go here
     if (m_doProvenance) provenanceBeforeOperation(myOutAssoc);
-    m_autoOper->useParameters(myAlgParams.getPointer(), NULL);//TODO: progress status for caret_command? would probably get messed up by any command info output
+    try
+    {
+        m_autoOper->useParameters(myAlgParams.getPointer(), NULL);//TODO: progress status for caret_command? would probably get messed up by any command info output
+    } catch (...) {
+        CommandFileCache::releaseModified();//a failed command in a batch may have left a cached input half-changed
+        throw;
+    }
+    CommandFileCache::releaseModified();
     vector<AString> uncheckedWarnings = myAlgParams->findUncheckedParams("the command");
     for (size_t i = 0; i < uncheckedWarnings.size(); ++i)
     {
@@ -217,8 +225,7 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
                 case OperationParametersEnum::CIFTI:
                 {
                     FileInformation myInfo(nextArg);
-                    CaretPointer<CiftiFile> myFile(new CiftiFile());
-                    myFile->openFile(nextArg);
+                    CaretPointer<CiftiFile> myFile = CommandFileCache::getCifti(nextArg, myComponent->m_paramList[i]->m_modifiedInPlace);//only reuses files in batch mode
                     m_inputCiftiNames[myInfo.getCanonicalFilePath()] = myFile;//track input cifti, so we can check their size
                     if (m_doProvenance)//just an optimization, if we aren't going to write provenance, don't generate it, either
                     {
@@ -349,8 +356,7 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
                 }
                 case OperationParametersEnum::SURFACE:
                 {
-                    CaretPointer<SurfaceFile> myFile(new SurfaceFile());
-                    myFile->readFile(nextArg);
+                    CaretPointer<SurfaceFile> myFile = CommandFileCache::getSurface(nextArg, myComponent->m_paramList[i]->m_modifiedInPlace);
                     if (m_doProvenance)
                     {
                         const GiftiMetaData* md = myFile->getFileMetaData();
@@ -373,8 +379,7 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
                 }
                 case OperationParametersEnum::VOLUME:
                 {
-                    CaretPointer<VolumeFile> myFile(new VolumeFile());
-                    myFile->readFile(nextArg);
+                    CaretPointer<VolumeFile> myFile = CommandFileCache::getVolume(nextArg, myComponent->m_paramList[i]->m_modifiedInPlace);
                     if (m_doProvenance)
                     {
                         const GiftiMetaData* md = myFile->getFileMetaData();
@@ -983,6 +988,7 @@ void CommandParser::makeOnDiskOutputs(const vector<OutputAssoc>& outAssociation)
     for (uint32_t i = 0; i < outAssociation.size(); ++i)
     {
         AbstractParameter* myParam = outAssociation[i].m_param;
+        CommandFileCache::invalidate(outAssociation[i].m_fileName);//in batch mode, don't let later commands reuse an old copy of a file we are about to overwrite
         switch (myParam->getType())
         {
             case OperationParametersEnum::CIFTI:
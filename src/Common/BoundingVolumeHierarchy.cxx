@@ -0,0 +1,186 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "BoundingVolumeHierarchy.h"
+
+#include "CaretException.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct BinInfo
+    {
+        float m_min[3], m_max[3];
+        int64_t m_count;
+        void reset()
+        {
+            m_count = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                m_min[i] = numeric_limits<float>::max();
+                m_max[i] = -numeric_limits<float>::max();
+            }
+        }
+        void grow(const float minIn[3], const float maxIn[3])
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                if (minIn[i] < m_min[i]) m_min[i] = minIn[i];
+                if (maxIn[i] > m_max[i]) m_max[i] = maxIn[i];
+            }
+        }
+        float halfArea() const
+        {
+            if (m_count == 0) return 0.0f;
+            float d0 = m_max[0] - m_min[0], d1 = m_max[1] - m_min[1], d2 = m_max[2] - m_min[2];
+            return d0 * d1 + d1 * d2 + d2 * d0;
+        }
+    };
+}
+
+BoundingVolumeHierarchy::Line::Line(const float start[3], const float direction[3])
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        m_start[i] = start[i];
+        m_invDir[i] = 1.0f / direction[i];//infinite for zero components, with the sign of the zero
+        m_nearMax[i] = (m_invDir[i] < 0.0f ? 1 : 0);
+    }
+}
+
+void BoundingVolumeHierarchy::build(const float* boxMins, const float* boxMaxes, const int64_t& numPrims, const int maxLeafSize)
+{
+    CaretAssert(maxLeafSize > 0);
+    m_nodes.clear();
+    m_primOrder.clear();
+    if (numPrims < 1) return;
+    if (numPrims >= numeric_limits<int32_t>::max() / 2)
+    {
+        throw CaretException("too many primitives for bounding volume hierarchy");
+    }
+    vector<float> centroids(numPrims * 3);
+    m_primOrder.resize(numPrims);
+    for (int64_t i = 0; i < numPrims; ++i)
+    {
+        m_primOrder[i] = (int32_t)i;
+        for (int j = 0; j < 3; ++j)
+        {
+            centroids[i * 3 + j] = (boxMins[i * 3 + j] + boxMaxes[i * 3 + j]) * 0.5f;
+        }
+    }
+    m_nodes.reserve(2 * numPrims);//a binary tree with at least one primitive per leaf can't have more nodes than this
+    Node root;
+    root.m_start = 0;
+    root.m_count = (int32_t)numPrims;
+    m_nodes.push_back(root);
+    vector<int32_t> toSplit(1, 0);
+    BinInfo bins[NUM_BINS], rightAccum[NUM_BINS];
+    while (!toSplit.empty())
+    {
+        int32_t nodeIndex = toSplit.back();
+        toSplit.pop_back();
+        int32_t start = m_nodes[nodeIndex].m_start, count = m_nodes[nodeIndex].m_count;
+        BinInfo nodeBox, centBox;
+        nodeBox.reset();
+        centBox.reset();
+        for (int32_t i = start; i < start + count; ++i)
+        {
+            int32_t prim = m_primOrder[i];
+            nodeBox.grow(boxMins + prim * 3, boxMaxes + prim * 3);
+            centBox.grow(centroids.data() + prim * 3, centroids.data() + prim * 3);
+        }
+        nodeBox.m_count = count;
+        for (int i = 0; i < 3; ++i)
+        {
+            m_nodes[nodeIndex].m_min[i] = nodeBox.m_min[i];
+            m_nodes[nodeIndex].m_max[i] = nodeBox.m_max[i];
+        }
+        if (count < 2) continue;
+        int bestAxis = -1, bestBin = -1;
+        float bestCost = numeric_limits<float>::max();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float extent = centBox.m_max[axis] - centBox.m_min[axis];
+            if (!(extent > 0.0f)) continue;
+            float scale = NUM_BINS / extent;
+            for (int b = 0; b < NUM_BINS; ++b) bins[b].reset();
+            for (int32_t i = start; i < start + count; ++i)
+            {
+                int32_t prim = m_primOrder[i];
+                int b = min(NUM_BINS - 1, (int)((centroids[prim * 3 + axis] - centBox.m_min[axis]) * scale));
+                ++bins[b].m_count;
+                bins[b].grow(boxMins + prim * 3, boxMaxes + prim * 3);
+            }
+            rightAccum[NUM_BINS - 1] = bins[NUM_BINS - 1];
+            for (int b = NUM_BINS - 2; b > 0; --b)
+            {
+                rightAccum[b] = rightAccum[b + 1];
+                rightAccum[b].grow(bins[b].m_min, bins[b].m_max);
+                rightAccum[b].m_count += bins[b].m_count;
+            }
+            BinInfo leftAccum;
+            leftAccum.reset();
+            for (int b = 0; b < NUM_BINS - 1; ++b)//split is after bin b
+            {
+                leftAccum.grow(bins[b].m_min, bins[b].m_max);
+                leftAccum.m_count += bins[b].m_count;
+                float cost = leftAccum.m_count * leftAccum.halfArea() + rightAccum[b + 1].m_count * rightAccum[b + 1].halfArea();
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+        float nodeArea = nodeBox.halfArea();
+        if (count <= maxLeafSize && (bestAxis == -1 || nodeArea <= 0.0f || 1.0f + bestCost / nodeArea >= count)) continue;//traversal step costs about the same as one primitive test
+        int32_t mid = start + count / 2;
+        if (bestAxis != -1)
+        {
+            float scale = NUM_BINS / (centBox.m_max[bestAxis] - centBox.m_min[bestAxis]), axisMin = centBox.m_min[bestAxis];
+            const float* centData = centroids.data();
+            int axis = bestAxis, splitBin = bestBin;
+            mid = (int32_t)(partition(m_primOrder.begin() + start, m_primOrder.begin() + start + count, [=](const int32_t& prim)
+                                      { return min(NUM_BINS - 1, (int)((centData[prim * 3 + axis] - axisMin) * scale)) <= splitBin; }) - m_primOrder.begin());
+        }
+        if (mid == start || mid == start + count)
+        {//all centroids coincide, or rounding put everything on one side, so split the range in half to keep leaves small
+            mid = start + count / 2;
+        }
+        int32_t firstChild = (int32_t)m_nodes.size();
+        Node child;
+        child.m_start = start;
+        child.m_count = mid - start;
+        m_nodes.push_back(child);
+        child.m_start = mid;
+        child.m_count = start + count - mid;
+        m_nodes.push_back(child);
+        m_nodes[nodeIndex].m_start = firstChild;
+        m_nodes[nodeIndex].m_count = 0;
+        toSplit.push_back(firstChild + 1);
+        toSplit.push_back(firstChild);
+    }
+}
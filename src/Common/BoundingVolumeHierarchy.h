@@ -0,0 +1,95 @@
+#ifndef __BOUNDING_VOLUME_HIERARCHY_H__
+#define __BOUNDING_VOLUME_HIERARCHY_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretAssert.h"
+
+#include "stdint.h"
+#include <vector>
+
+namespace caret {
+
+    ///flat binary tree of axis aligned boxes, built once from per-primitive boxes with a binned surface area heuristic
+    ///nodes and the primitive order are contiguous arrays, each primitive is in exactly one leaf, traversal is up to the user (see CaretPointLocator, SignedDistanceHelper)
+    class BoundingVolumeHierarchy
+    {
+    public:
+        ///start + t * direction, with the inverse direction and the sign of each component worked out once for testing against many boxes
+        struct Line
+        {
+            float m_start[3], m_invDir[3];
+            int m_nearMax[3];//1 when the direction component is negative, so the line enters through the maximum bound
+            Line(const float start[3], const float direction[3]);
+        };
+        struct Node
+        {
+            float m_min[3], m_max[3];
+            int32_t m_start;//leaf: first position in the primitive order, internal: index of first child, the second child is m_start + 1
+            int32_t m_count;//number of primitives in a leaf, 0 for internal nodes
+            bool isLeaf() const { return m_count > 0; }
+            ///box tests are written without branches on the coordinates so they vectorize
+            float distSquaredToPoint(const float point[3]) const
+            {
+                float ret = 0.0f;
+                for (int i = 0; i < 3; ++i)
+                {
+                    float below = m_min[i] - point[i], above = point[i] - m_max[i];
+                    float outside = (below > above ? below : above);
+                    outside = (outside > 0.0f ? outside : 0.0f);
+                    ret += outside * outside;
+                }
+                return ret;
+            }
+            ///whether the line hits the box for t in [tmin, tmax] - a zero direction component gives infinite slab distances, or NaN when the start
+            ///is exactly on a bound, which the comparisons ignore, so lines on a face count as hitting it
+            bool lineIntersects(const Line& line, const float& tmin, const float& tmax) const
+            {
+                const float* bounds[2] = { m_min, m_max };
+                float curlow = tmin, curhigh = tmax;
+                for (int i = 0; i < 3; ++i)
+                {
+                    float templow = (bounds[line.m_nearMax[i]][i] - line.m_start[i]) * line.m_invDir[i];
+                    float temphigh = (bounds[1 - line.m_nearMax[i]][i] - line.m_start[i]) * line.m_invDir[i];
+                    curlow = (templow > curlow ? templow : curlow);
+                    curhigh = (temphigh < curhigh ? temphigh : curhigh);
+                }
+                return curlow <= curhigh;
+            }
+        };
+        BoundingVolumeHierarchy() { }
+        ///boxes are 3 floats of minimum coordinates and 3 floats of maximum coordinates per primitive, in separate arrays
+        void build(const float* boxMins, const float* boxMaxes, const int64_t& numPrims, const int maxLeafSize = 4);
+        bool isEmpty() const { return m_nodes.empty(); }
+        ///root is node 0
+        const Node& getNode(const int32_t& index) const { CaretAssertVectorIndex(m_nodes, index); return m_nodes[index]; }
+        int32_t getNumberOfNodes() const { return (int32_t)m_nodes.size(); }
+        ///primitive indices in leaf order, leaves refer to ranges of this
+        const std::vector<int32_t>& getPrimitiveOrder() const { return m_primOrder; }
+    private:
+        std::vector<Node> m_nodes;
+        std::vector<int32_t> m_primOrder;
+        static const int NUM_BINS = 16;
+    };
+
+}
+
+#endif //__BOUNDING_VOLUME_HIERARCHY_H__
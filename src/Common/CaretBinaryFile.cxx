@@ -28,12 +28,19 @@
 #include "CaretAssert.h"
 #include "CaretBinaryFile.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "DataFileException.h"
 
 #include <QFile>
 #include "zlib.h"
 
+#ifndef CARET_OS_WINDOWS
+#include <cerrno>
+#include <unistd.h>
+#endif
+
 #include <algorithm>
+#include <cstring>
 
 using namespace caret;
 using namespace std;
@@ -53,16 +60,61 @@ namespace caret
         void seek(const int64_t& position);
         int64_t pos();
         int64_t size() { return -1; }
+        bool supportsRandomAccess() { return false; }//gzseek backwards starts over from the beginning
         void read(void* dataOut, const int64_t& count, int64_t* numRead);
         void write(const void* dataIn, const int64_t& count);
         ~ZFileImpl();
     };
     
     const int64_t ZFileImpl::CHUNK_SIZE = 1<<26;//64MiB, large enough for good performance, small enough for zlib, must convert to uint32
+    
+    //gzip written as independently deflated blocks (like pigz), so blocks can be compressed and decompressed in parallel
+    //the block boundaries are recorded in an extra field of an empty trailing gzip member, which other gzip readers ignore
+    //reading only uses this class when that index is present, other .gz files go through ZFileImpl
+    class BlockZFileImpl : public CaretBinaryFile::ImplInterface
+    {
+    public:
+        struct IndexEntry
+        {
+            int64_t m_uncompressed, m_compressed;//offsets where an independent block starts
+        };
+    private:
+        QFile m_file;
+        bool m_writing;
+        int64_t m_pos;//uncompressed position
+        std::vector<IndexEntry> m_index;//when reading, last entry is the end of the data
+        //writing state
+        std::vector<char> m_pending;//uncompressed data not yet compressed
+        uLong m_crc;
+        int64_t m_compressedPos;
+        //reading state
+        int64_t m_cachedSegment;//most recently inflated partial segment, so small sequential reads don't inflate it again
+        std::vector<char> m_cache;
+        void compressPending(const bool& final);
+        void inflateSegment(const int64_t& segment, const char* compressed, char* dataOut);
+        int64_t segmentSize(const int64_t& segment) const { return m_index[segment + 1].m_uncompressed - m_index[segment].m_uncompressed; }
+        static const int64_t BLOCK_SIZE;
+        static const char INDEX_MAGIC[8];
+    public:
+        BlockZFileImpl() { m_writing = false; m_pos = 0; m_crc = 0; m_compressedPos = 0; m_cachedSegment = -1; }
+        static bool hasIndex(const QString& filename);
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);
+        int64_t pos() { return m_pos; }
+        int64_t size();
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void write(const void* dataIn, const int64_t& count);
+        ~BlockZFileImpl();
+    };
+    
+    const int64_t BlockZFileImpl::BLOCK_SIZE = 1<<20;//1MiB of uncompressed data per block, large enough that not sharing a dictionary costs little
+    const char BlockZFileImpl::INDEX_MAGIC[8] = { 'W', 'B', 'G', 'Z', 'I', 'D', 'X', '1' };
 #endif //ZLIB_VERSION
 
     class QFileImpl : public CaretBinaryFile::ImplInterface
     {
+    protected:
         QFile m_file;
         const static int64_t CHUNK_SIZE;
     public:
@@ -73,15 +125,51 @@ namespace caret
         int64_t size() { return m_file.size(); }
         void read(void* dataOut, const int64_t& count, int64_t* numRead);
         void write(const void* dataIn, const int64_t& count);
+#ifndef CARET_OS_WINDOWS
+        bool supportsPositionalIO() { return m_file.handle() != -1; }
+        void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead);
+        void writeAt(const int64_t& position, const void* dataIn, const int64_t& count);
+#endif
+        void flush();
     };
     
     const int64_t QFileImpl::CHUNK_SIZE = 1<<30;//1GiB, QT4 apparently chokes at more than 2GiB via buffer.read using int32
+    
+    //read-only uncompressed access through a memory mapping, falls back to QFileImpl behavior if the mapping fails
+    class MMapFileImpl : public QFileImpl
+    {
+        uchar* m_map;
+        int64_t m_mapSize, m_mapPos;
+    public:
+        MMapFileImpl() { m_map = NULL; m_mapSize = 0; m_mapPos = 0; }
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);
+        int64_t pos();
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void write(const void* dataIn, const int64_t& count);
+        const char* getMemoryMap() { return (const char*)m_map; }
+        bool supportsPositionalIO() { return m_map != NULL || QFileImpl::supportsPositionalIO(); }
+        void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead);
+    };
 }
 
 CaretBinaryFile::ImplInterface::~ImplInterface()
 {
 }
 
+void CaretBinaryFile::ImplInterface::readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    seek(position);
+    read(dataOut, count, numRead);
+}
+
+void CaretBinaryFile::ImplInterface::writeAt(const int64_t& position, const void* dataIn, const int64_t& count)
+{
+    seek(position);
+    write(dataIn, count);
+}
+
 CaretBinaryFile::CaretBinaryFile(const QString& filename, const OpenMode& fileMode)
 {
     open(filename, fileMode);
@@ -118,12 +206,22 @@ void CaretBinaryFile::open(const QString& filename, const OpenMode& opmode)
     if (filename.endsWith(".gz"))
     {
 #ifdef ZLIB_VERSION
-        m_impl.grabNew(new ZFileImpl());
+        if (opmode == WRITE_TRUNCATE || (opmode == READ && BlockZFileImpl::hasIndex(filename)))
+        {
+            m_impl.grabNew(new BlockZFileImpl());
+        } else {
+            m_impl.grabNew(new ZFileImpl());
+        }
 #else //ZLIB_VERSION
         throw DataFileException("can't open .gz file '" + filename + "', compiled without zlib support");
 #endif //ZLIB_VERSION
     } else {
-        m_impl.grabNew(new QFileImpl());
+        if (opmode == READ && sizeof(void*) >= 8)//don't try to map large files into a 32-bit address space
+        {
+            m_impl.grabNew(new MMapFileImpl());
+        } else {
+            m_impl.grabNew(new QFileImpl());
+        }
     }
     m_impl->open(filename, opmode);
     m_curMode = opmode;
@@ -155,6 +253,12 @@ int64_t CaretBinaryFile::size()
     return m_impl->size();
 }
 
+const char* CaretBinaryFile::getMemoryMap()
+{
+    if (m_curMode == NONE) return NULL;
+    return m_impl->getMemoryMap();
+}
+
 void CaretBinaryFile::write(const void* dataIn, const int64_t& count)
 {
     CaretAssert(count >= 0);//not sure about allowing 0
@@ -162,6 +266,38 @@ void CaretBinaryFile::write(const void* dataIn, const int64_t& count)
     m_impl->write(dataIn, count);
 }
 
+bool CaretBinaryFile::supportsPositionalIO()
+{
+    if (m_curMode == NONE) return false;
+    return m_impl->supportsPositionalIO();
+}
+
+bool CaretBinaryFile::supportsRandomAccess()
+{
+    if (m_curMode == NONE) return false;
+    return m_impl->supportsRandomAccess();
+}
+
+void CaretBinaryFile::readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    CaretAssert(position >= 0 && count >= 0);
+    if (!getOpenForRead()) throw DataFileException("file is not open for reading");
+    m_impl->readAt(position, dataOut, count, numRead);
+}
+
+void CaretBinaryFile::writeAt(const int64_t& position, const void* dataIn, const int64_t& count)
+{
+    CaretAssert(position >= 0 && count >= 0);
+    if (!getOpenForWrite()) throw DataFileException("file is not open for writing");
+    m_impl->writeAt(position, dataIn, count);
+}
+
+void CaretBinaryFile::flush()
+{
+    if (m_curMode == NONE) return;
+    m_impl->flush();
+}
+
 #ifdef ZLIB_VERSION
 void ZFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
 {
@@ -280,6 +416,372 @@ ZFileImpl::~ZFileImpl()
         CaretLogSevere("caught unknown exception type while closing a compressed file");
     }
 }
+
+namespace
+{
+    void putLE(char* out, uint64_t value, const int& numBytes)
+    {
+        for (int i = 0; i < numBytes; ++i)
+        {
+            out[i] = (char)(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    uint64_t getLE(const char* in, const int& numBytes)
+    {
+        uint64_t ret = 0;
+        for (int i = numBytes - 1; i >= 0; --i)
+        {
+            ret = (ret << 8) | (unsigned char)in[i];
+        }
+        return ret;
+    }
+
+    //everything after the last deflate block: gzip header with FEXTRA, XLEN, subfield id and length, payload, empty deflate stream, crc and isize
+    //payload is index entries, then entry count, then magic - so it can be found by reading backwards from the end of the file
+    const int INDEX_TAIL_BYTES = 4 + 8 + 10;//count, magic, empty stream + crc + isize
+    const int INDEX_MAX_PAYLOAD = 65535 - 4;//XLEN is 16 bits, and includes the subfield header
+    
+    bool indexLess(const int64_t& position, const BlockZFileImpl::IndexEntry& entry)
+    {
+        return position < entry.m_uncompressed;
+    }
+}
+
+bool BlockZFileImpl::hasIndex(const QString& filename)
+{
+    QFile testFile(filename);
+    if (!testFile.open(QIODevice::ReadOnly)) return false;//let ZFileImpl generate the error
+    int64_t fileSize = testFile.size();
+    if (fileSize < 10 + 12 + INDEX_TAIL_BYTES) return false;
+    char tail[INDEX_TAIL_BYTES];
+    if (!testFile.seek(fileSize - INDEX_TAIL_BYTES) || testFile.read(tail, INDEX_TAIL_BYTES) != INDEX_TAIL_BYTES) return false;
+    return memcmp(tail + 4, INDEX_MAGIC, 8) == 0;
+}
+
+void BlockZFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    close();
+    m_fileName = filename;
+    m_file.setFileName(filename);
+    m_pos = 0;
+    m_index.clear();
+    m_cachedSegment = -1;
+    m_cache.clear();
+    if (opmode == CaretBinaryFile::WRITE_TRUNCATE)
+    {
+        QFile::remove(filename);//same as the other implementations, don't truncate through symlinks
+        if (!m_file.open(QIODevice::WriteOnly)) throw DataFileException("failed to open compressed file '" + filename + "', unable to create file");
+        m_writing = true;
+        const char header[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3 };//deflate, no flags, no mtime, unix
+        if (m_file.write(header, 10) != 10) throw DataFileException("failed to write to compressed file '" + filename + "'");
+        m_compressedPos = 10;
+        m_crc = crc32(0L, Z_NULL, 0);
+        m_pending.clear();
+        IndexEntry first = { 0, m_compressedPos };
+        m_index.push_back(first);
+        return;
+    }
+    if (opmode != CaretBinaryFile::READ) throw DataFileException("compressed file only supports READ and WRITE_TRUNCATE modes");
+    m_writing = false;
+    if (!m_file.open(QIODevice::ReadOnly)) throw DataFileException("failed to open compressed file '" + filename + "'");
+    int64_t fileSize = m_file.size();
+    char tail[INDEX_TAIL_BYTES];
+    if (fileSize < 10 + 12 + INDEX_TAIL_BYTES || !m_file.seek(fileSize - INDEX_TAIL_BYTES) || m_file.read(tail, INDEX_TAIL_BYTES) != INDEX_TAIL_BYTES)
+    {
+        throw DataFileException("failed to read block index of compressed file '" + filename + "'");
+    }
+    int64_t numEntries = getLE(tail, 4);
+    int64_t payloadSize = numEntries * 16 + 12;
+    if (numEntries < 2 || payloadSize > INDEX_MAX_PAYLOAD) throw DataFileException("invalid block index in compressed file '" + filename + "'");
+    int64_t memberStart = fileSize - 10 - payloadSize - 4 - 12;//payload, subfield header, gzip header + XLEN
+    std::vector<char> member(fileSize - memberStart);
+    if (memberStart < 10 || !m_file.seek(memberStart) || m_file.read(member.data(), member.size()) != (int64_t)member.size())
+    {
+        throw DataFileException("failed to read block index of compressed file '" + filename + "'");
+    }
+    if ((unsigned char)member[0] != 0x1f || (unsigned char)member[1] != 0x8b || member[3] != 4 ||
+        (int64_t)getLE(member.data() + 10, 2) != payloadSize + 4 || member[12] != 'W' || member[13] != 'B')
+    {
+        throw DataFileException("invalid block index in compressed file '" + filename + "'");
+    }
+    const char* payload = member.data() + 16;
+    m_index.resize(numEntries);
+    for (int64_t i = 0; i < numEntries; ++i)
+    {
+        m_index[i].m_uncompressed = getLE(payload + i * 16, 8);
+        m_index[i].m_compressed = getLE(payload + i * 16 + 8, 8);
+        if (i > 0 && (m_index[i].m_uncompressed < m_index[i - 1].m_uncompressed || m_index[i].m_compressed < m_index[i - 1].m_compressed))
+        {
+            throw DataFileException("invalid block index in compressed file '" + filename + "'");
+        }
+    }
+    if (m_index.back().m_compressed > memberStart) throw DataFileException("invalid block index in compressed file '" + filename + "'");
+}
+
+void BlockZFileImpl::compressPending(const bool& final)
+{
+    int64_t numBlocks = (int64_t)m_pending.size() / BLOCK_SIZE;
+    if (final && (numBlocks * BLOCK_SIZE < (int64_t)m_pending.size() || numBlocks == 0)) ++numBlocks;//last block may be partial or empty, it still needs to end the stream
+    if (numBlocks == 0) return;
+    std::vector<std::vector<unsigned char> > outBlocks(numBlocks);
+    std::vector<uLong> blockCrcs(numBlocks);
+    bool failed = false;
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t b = 0; b < numBlocks; ++b)
+    {
+        int64_t start = b * BLOCK_SIZE;
+        int64_t length = min(BLOCK_SIZE, (int64_t)m_pending.size() - start);
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+        if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)//raw deflate, we write the gzip wrapper ourselves
+        {
+            failed = true;
+            continue;
+        }
+        outBlocks[b].resize(deflateBound(&strm, length) + 16);//sync flush adds an empty stored block
+        strm.next_in = (Bytef*)(m_pending.data() + start);
+        strm.avail_in = length;
+        strm.next_out = outBlocks[b].data();
+        strm.avail_out = outBlocks[b].size();
+        bool lastBlock = (final && b == numBlocks - 1);
+        int ret = deflate(&strm, lastBlock ? Z_FINISH : Z_SYNC_FLUSH);//sync flush ends on a byte boundary, so the next block can start a fresh stream
+        if ((lastBlock && ret != Z_STREAM_END) || (!lastBlock && ret != Z_OK) || strm.avail_in != 0 || strm.avail_out == 0)
+        {
+            failed = true;
+        }
+        outBlocks[b].resize(outBlocks[b].size() - strm.avail_out);
+        deflateEnd(&strm);
+        blockCrcs[b] = crc32(0L, (const Bytef*)(m_pending.data() + start), length);
+    }
+    if (failed) throw DataFileException("failed to compress data for file '" + m_fileName + "'");
+    int64_t uncompressedPos = m_index.back().m_uncompressed;
+    for (int64_t b = 0; b < numBlocks; ++b)
+    {
+        int64_t length = min(BLOCK_SIZE, (int64_t)m_pending.size() - b * BLOCK_SIZE);
+        if (m_file.write((const char*)outBlocks[b].data(), outBlocks[b].size()) != (int64_t)outBlocks[b].size())
+        {
+            throw DataFileException("failed to write to compressed file '" + m_fileName + "'");
+        }
+        m_crc = crc32_combine(m_crc, blockCrcs[b], length);
+        m_compressedPos += outBlocks[b].size();
+        uncompressedPos += length;
+        IndexEntry next = { uncompressedPos, m_compressedPos };
+        m_index.push_back(next);//the entry after the last block marks the end of the data
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + min((int64_t)m_pending.size(), numBlocks * BLOCK_SIZE));
+}
+
+void BlockZFileImpl::write(const void* dataIn, const int64_t& count)
+{
+    if (!m_writing) throw DataFileException("file '" + m_fileName + "' is open read-only");
+    int numThreads = 1;
+#ifdef CARET_OMP
+    numThreads = omp_get_max_threads();
+#endif
+    const int64_t batchSize = BLOCK_SIZE * 2 * numThreads;//enough blocks to keep all threads busy
+    int64_t done = 0;
+    while (done < count)
+    {
+        int64_t toAdd = min(count - done, batchSize - (int64_t)m_pending.size());
+        m_pending.insert(m_pending.end(), ((const char*)dataIn) + done, ((const char*)dataIn) + done + toAdd);
+        done += toAdd;
+        if ((int64_t)m_pending.size() >= batchSize) compressPending(false);
+    }
+    m_pos += count;
+}
+
+void BlockZFileImpl::seek(const int64_t& position)
+{
+    if (m_writing)
+    {
+        if (position == m_pos) return;
+        if (position < m_pos) throw DataFileException("can't seek backwards while writing compressed file '" + m_fileName + "'");
+        std::vector<char> zeros(position - m_pos, 0);//same as gzseek when writing
+        write(zeros.data(), zeros.size());
+        return;
+    }
+    m_pos = position;//reading past the end is caught in read()
+}
+
+int64_t BlockZFileImpl::size()
+{
+    if (m_writing) return m_pos;
+    return m_index.back().m_uncompressed;
+}
+
+void BlockZFileImpl::inflateSegment(const int64_t& segment, const char* compressed, char* dataOut)
+{
+    int64_t outSize = segmentSize(segment);
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, -15) != Z_OK) throw DataFileException("failed to initialize decompression for file '" + m_fileName + "'");
+    strm.next_in = (Bytef*)compressed;
+    strm.avail_in = m_index[segment + 1].m_compressed - m_index[segment].m_compressed;
+    strm.next_out = (Bytef*)dataOut;
+    strm.avail_out = outSize;
+    int ret = inflate(&strm, Z_SYNC_FLUSH);//segments that don't end the stream have no final block, so don't expect Z_STREAM_END
+    int64_t produced = outSize - strm.avail_out;
+    inflateEnd(&strm);
+    if ((ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) || produced != outSize)
+    {
+        throw DataFileException("error while decompressing file '" + m_fileName + "'");
+    }
+}
+
+void BlockZFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (m_writing) throw DataFileException("file '" + m_fileName + "' is open write-only");
+    int64_t totalSize = m_index.back().m_uncompressed;
+    int64_t toRead = max((int64_t)0, min(count, totalSize - m_pos));
+    char* outBytes = (char*)dataOut;
+    int64_t done = 0;
+    int numThreads = 1;
+#ifdef CARET_OMP
+    numThreads = omp_get_max_threads();
+#endif
+    while (done < toRead)
+    {
+        int64_t curPos = m_pos + done;
+        int64_t firstSeg = (upper_bound(m_index.begin(), m_index.end(), curPos, indexLess) - m_index.begin()) - 1;
+        CaretAssert(firstSeg >= 0 && firstSeg < (int64_t)m_index.size() - 1);
+        if (firstSeg == m_cachedSegment)
+        {
+            int64_t offset = curPos - m_index[firstSeg].m_uncompressed;
+            int64_t numCopy = min(toRead - done, (int64_t)m_cache.size() - offset);
+            memcpy(outBytes + done, m_cache.data() + offset, numCopy);
+            done += numCopy;
+            continue;
+        }
+        int64_t endSeg = firstSeg;//exclusive, limit how much we decompress at once to bound the compressed buffer
+        while (endSeg < (int64_t)m_index.size() - 1 && m_index[endSeg].m_uncompressed < m_pos + toRead && endSeg - firstSeg < 4 * numThreads)
+        {
+            ++endSeg;
+        }
+        std::vector<char> compressed(m_index[endSeg].m_compressed - m_index[firstSeg].m_compressed);
+        if (!m_file.seek(m_index[firstSeg].m_compressed) || m_file.read(compressed.data(), compressed.size()) != (int64_t)compressed.size())
+        {
+            throw DataFileException("error while reading compressed file '" + m_fileName + "'");
+        }
+        int64_t lastSeg = endSeg - 1;
+        bool firstPartial = (m_index[firstSeg].m_uncompressed < curPos);
+        bool lastPartial = (m_index[endSeg].m_uncompressed > m_pos + toRead);
+        std::vector<char> firstScratch;
+        if (lastPartial) m_cache.resize(segmentSize(lastSeg));
+        if (firstPartial && !(lastPartial && lastSeg == firstSeg)) firstScratch.resize(segmentSize(firstSeg));
+        m_cachedSegment = -1;//in case of exception
+        AString errorMessage;
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t seg = firstSeg; seg < endSeg; ++seg)
+        {
+            char* segOut;
+            if (seg == lastSeg && lastPartial)
+            {
+                segOut = m_cache.data();//keep the end of the read around for the next sequential read
+            } else if (seg == firstSeg && firstPartial) {
+                segOut = firstScratch.data();
+            } else {
+                segOut = outBytes + done + (m_index[seg].m_uncompressed - curPos);//whole segment needed, inflate it in place
+            }
+            try
+            {
+                inflateSegment(seg, compressed.data() + (m_index[seg].m_compressed - m_index[firstSeg].m_compressed), segOut);
+            } catch (CaretException& e) {
+#pragma omp critical
+                {
+                    errorMessage = e.whatString();
+                }
+            }
+        }
+        if (errorMessage != "") throw DataFileException(errorMessage);
+        int64_t segEnd = min(m_index[endSeg].m_uncompressed, m_pos + toRead);
+        if (firstPartial)
+        {
+            const char* firstData = (lastPartial && lastSeg == firstSeg) ? m_cache.data() : firstScratch.data();
+            int64_t offset = curPos - m_index[firstSeg].m_uncompressed;
+            memcpy(outBytes + done, firstData + offset, min(segmentSize(firstSeg) - offset, segEnd - curPos));
+        }
+        if (lastPartial)
+        {
+            m_cachedSegment = lastSeg;
+            if (!(firstPartial && lastSeg == firstSeg))
+            {
+                memcpy(outBytes + done + (m_index[lastSeg].m_uncompressed - curPos), m_cache.data(), segEnd - m_index[lastSeg].m_uncompressed);
+            }
+        }
+        done += segEnd - curPos;
+    }
+    m_pos += toRead;
+    if (numRead == NULL)
+    {
+        if (toRead != count) throw DataFileException("premature end of file in compressed file '" + m_fileName + "'");
+    } else {
+        *numRead = toRead;
+    }
+}
+
+void BlockZFileImpl::close()
+{
+    if (!m_file.isOpen()) return;
+    if (m_writing)
+    {
+        m_writing = false;//so a failure here doesn't make the destructor try again
+        compressPending(true);
+        char trailer[8];
+        putLE(trailer, m_crc, 4);
+        putLE(trailer + 4, m_index.back().m_uncompressed & 0xFFFFFFFF, 4);//gzip stores size modulo 2^32
+        std::vector<IndexEntry> saveIndex = m_index;
+        while ((int64_t)saveIndex.size() * 16 + 12 > INDEX_MAX_PAYLOAD)
+        {//too many blocks for one extra field, keep every other boundary, and always the end
+            std::vector<IndexEntry> thinned;
+            for (size_t i = 0; i < saveIndex.size() - 1; i += 2) thinned.push_back(saveIndex[i]);
+            thinned.push_back(saveIndex.back());
+            saveIndex = thinned;
+        }
+        int64_t payloadSize = saveIndex.size() * 16 + 12;
+        std::vector<char> member(12 + 4 + payloadSize + 10, 0);
+        const char header[10] = { '\x1f', '\x8b', 8, 4, 0, 0, 0, 0, 0, 3 };//FEXTRA
+        memcpy(member.data(), header, 10);
+        putLE(member.data() + 10, payloadSize + 4, 2);
+        member[12] = 'W';
+        member[13] = 'B';
+        putLE(member.data() + 14, payloadSize, 2);
+        char* payload = member.data() + 16;
+        for (size_t i = 0; i < saveIndex.size(); ++i)
+        {
+            putLE(payload + i * 16, saveIndex[i].m_uncompressed, 8);
+            putLE(payload + i * 16 + 8, saveIndex[i].m_compressed, 8);
+        }
+        memcpy(payload + payloadSize - 8, INDEX_MAGIC, 8);//magic goes AFTER the count
+        putLE(payload + payloadSize - 12, saveIndex.size(), 4);
+        member[member.size() - 10] = 3;//empty final fixed-huffman block, followed by zero crc and size
+        if (m_file.write(trailer, 8) != 8 || m_file.write(member.data(), member.size()) != (int64_t)member.size() || !m_file.flush())
+        {
+            m_file.close();
+            throw DataFileException("failed to write to compressed file '" + m_fileName + "'");
+        }
+    }
+    m_file.close();
+    m_index.clear();
+    m_pending.clear();
+    m_cache.clear();
+    m_cachedSegment = -1;
+}
+
+BlockZFileImpl::~BlockZFileImpl()
+{
+    try//throwing from a destructor is a bad idea
+    {
+        close();
+    } catch (CaretException& e) {
+        CaretLogSevere(e.whatString());
+    } catch (exception& e) {
+        CaretLogSevere(e.what());
+    } catch (...) {
+        CaretLogSevere("caught unknown exception type while closing a compressed file");
+    }
+}
 #endif //ZLIB_VERSION
 
 void QFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
@@ -376,3 +878,141 @@ void QFileImpl::write(const void* dataIn, const int64_t& count)
                          + " bytes.");
     if (total != count) throw DataFileException(msg);
 }
+
+void QFileImpl::flush()
+{
+    if (!m_file.flush()) throw DataFileException("failed to flush file '" + m_fileName + "'");
+}
+
+#ifndef CARET_OS_WINDOWS
+void QFileImpl::readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead)
+{//pread doesn't use the file position, so concurrent calls don't interfere
+    int fd = m_file.handle();
+    int64_t total = 0;
+    bool error = false;
+    while (total < count)
+    {
+        int64_t maxToRead = min(count - total, CHUNK_SIZE);
+        ssize_t readret = pread(fd, ((char*)dataOut) + total, maxToRead, position + total);
+        if (readret < 0 && errno == EINTR) continue;
+        if (readret < 1)
+        {
+            error = (readret < 0);
+            break;
+        }
+        total += readret;
+    }
+    if (numRead == NULL)
+    {
+        if (total != count)
+        {
+            if (error) throw DataFileException("error while reading file '" + m_fileName + "'");
+            throw DataFileException("premature end of file in '" + m_fileName + "'");
+        }
+    } else {
+        *numRead = total;
+    }
+}
+
+void QFileImpl::writeAt(const int64_t& position, const void* dataIn, const int64_t& count)
+{
+    int fd = m_file.handle();
+    int64_t total = 0;
+    while (total < count)
+    {
+        int64_t maxToWrite = min(count - total, CHUNK_SIZE);
+        ssize_t writeret = pwrite(fd, ((const char*)dataIn) + total, maxToWrite, position + total);
+        if (writeret < 0 && errno == EINTR) continue;
+        if (writeret < 1) break;
+        total += writeret;
+    }
+    if (total != count)
+    {
+        throw DataFileException("failed to write file '" + m_fileName + "'.  Tried to write " + AString::number(count) +
+                                " bytes at position " + AString::number(position) + " but actually wrote " + AString::number(total) + " bytes.");
+    }
+}
+#endif
+
+void MMapFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    if (opmode != CaretBinaryFile::READ) throw DataFileException("memory mapped file only supports READ mode");
+    QFileImpl::open(filename, opmode);
+    m_mapPos = 0;
+    m_mapSize = m_file.size();
+    if (m_mapSize > 0)
+    {
+        m_map = m_file.map(0, m_mapSize);//if this fails, use the QFile reading functions instead
+        if (m_map == NULL) CaretLogFine("unable to memory map file '" + filename + "', using normal reads");
+    }
+}
+
+void MMapFileImpl::close()
+{
+    if (m_map != NULL)
+    {
+        m_file.unmap(m_map);
+        m_map = NULL;
+    }
+    m_mapSize = 0;
+    m_mapPos = 0;
+    QFileImpl::close();
+}
+
+void MMapFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (m_map == NULL)
+    {
+        QFileImpl::read(dataOut, count, numRead);
+        return;
+    }
+    int64_t total = min(count, m_mapSize - m_mapPos);
+    if (total < 0) total = 0;//seek past the end is allowed, reading there gets nothing
+    memcpy(dataOut, m_map + m_mapPos, total);
+    m_mapPos += total;
+    if (numRead == NULL)
+    {
+        if (total != count) throw DataFileException("premature end of file in '" + m_fileName + "'");
+    } else {
+        *numRead = total;
+    }
+}
+
+void MMapFileImpl::seek(const int64_t& position)
+{
+    if (m_map == NULL)
+    {
+        QFileImpl::seek(position);
+        return;
+    }
+    m_mapPos = position;
+}
+
+int64_t MMapFileImpl::pos()
+{
+    if (m_map == NULL) return QFileImpl::pos();
+    return m_mapPos;
+}
+
+void MMapFileImpl::readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (m_map == NULL)
+    {
+        QFileImpl::readAt(position, dataOut, count, numRead);
+        return;
+    }
+    int64_t total = min(count, m_mapSize - position);
+    if (total < 0) total = 0;
+    memcpy(dataOut, m_map + position, total);
+    if (numRead == NULL)
+    {
+        if (total != count) throw DataFileException("premature end of file in '" + m_fileName + "'");
+    } else {
+        *numRead = total;
+    }
+}
+
+void MMapFileImpl::write(const void*, const int64_t&)
+{
+    throw DataFileException("file '" + m_fileName + "' is open read-only");
+}
@@ -56,6 +56,14 @@ namespace caret {
         void read(void* dataOut, const int64_t& count, int64_t* numRead = NULL);//throw if numRead is NULL and (error or end of file reached early)
         void write(const void* dataIn, const int64_t& count);//failure to complete write is always an exception
         int64_t size();//may return -1 if size cannot be determined efficiently
+        const char* getMemoryMap();//returns NULL unless the file is open read-only, uncompressed, and the OS allowed mapping it
+        ///readAt and writeAt don't use or change the current position, and are safe to call from multiple threads when this returns true
+        bool supportsPositionalIO();
+        ///false when seeking backwards means decompressing again from the start (.gz files without a block index)
+        bool supportsRandomAccess();
+        void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead = NULL);//otherwise, they use seek and read/write, which must be serialized by the caller
+        void writeAt(const int64_t& position, const void* dataIn, const int64_t& count);
+        void flush();//push buffered writes to the OS before using writeAt
         class ImplInterface
         {
         protected:
@@ -69,6 +77,12 @@ namespace caret {
             virtual int64_t size() = 0;
             virtual void read(void* dataOut, const int64_t& count, int64_t* numRead) = 0;
             virtual void write(const void* dataIn, const int64_t& count) = 0;
+            virtual const char* getMemoryMap() { return NULL; }//only the mapped implementation overrides this
+            virtual bool supportsPositionalIO() { return false; }
+            virtual bool supportsRandomAccess() { return true; }
+            virtual void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead);//default is seek and read
+            virtual void writeAt(const int64_t& position, const void* dataIn, const int64_t& count);
+            virtual void flush() { }
             virtual ~ImplInterface();
         };
     private:
@@ -38,6 +38,7 @@ CaretMathExpression::CaretMathExpression(const AString& expression)
     {
         throw CaretException("extra characters on end of expression input: '" + m_input.mid(m_position) + "'");
     }
+    compileNode(m_root);//the last instruction holds the result
     CaretLogFiner("parsed '" + expression + "' as '" + toString() + "'");
 }
 
@@ -47,6 +48,108 @@ double CaretMathExpression::evaluate(const vector<float>& variableValues) const
     return m_root->eval(variableValues);
 }
 
+void CaretMathExpression::evaluateRow(float* dataOut, const vector<const float*>& variableRows, const int64_t& count) const
+{
+    CaretAssert(variableRows.size() == m_varNames.size());
+    CaretAssert(!m_program.empty());
+    const int BLOCK_SIZE = 256;//small enough that all registers for a typical expression stay in L1/L2
+    int numInstructions = (int)m_program.size();
+    vector<double> registers(numInstructions * BLOCK_SIZE);
+    for (int64_t blockStart = 0; blockStart < count; blockStart += BLOCK_SIZE)
+    {
+        int blockCount = (int)min((int64_t)BLOCK_SIZE, count - blockStart);
+        for (int inst = 0; inst < numInstructions; ++inst)
+        {
+            const Instruction& myInst = m_program[inst];
+            double* out = registers.data() + myInst.m_out * BLOCK_SIZE;
+            const double* a = NULL, *b = NULL, *c = NULL;
+            if (myInst.m_args[0] != -1) a = registers.data() + myInst.m_args[0] * BLOCK_SIZE;
+            if (myInst.m_args[1] != -1) b = registers.data() + myInst.m_args[1] * BLOCK_SIZE;
+            if (myInst.m_args[2] != -1) c = registers.data() + myInst.m_args[2] * BLOCK_SIZE;
+            switch (myInst.m_op)
+            {
+                case Instruction::LOADCONST:
+                    for (int i = 0; i < blockCount; ++i) out[i] = myInst.m_constVal;
+                    break;
+                case Instruction::LOADVAR:
+                {
+                    CaretAssertVectorIndex(variableRows, myInst.m_varIndex);
+                    const float* in = variableRows[myInst.m_varIndex] + blockStart;
+                    for (int i = 0; i < blockCount; ++i) out[i] = in[i];
+                    break;
+                }
+                case Instruction::OR://lazy evaluation doesn't matter without side effects, so evaluate both sides
+                    for (int i = 0; i < blockCount; ++i) out[i] = ((a[i] > 0.0 || b[i] > 0.0) ? 1.0 : 0.0);
+                    break;
+                case Instruction::AND:
+                    for (int i = 0; i < blockCount; ++i) out[i] = ((a[i] > 0.0 && b[i] > 0.0) ? 1.0 : 0.0);
+                    break;
+                case Instruction::EQUAL:
+                case Instruction::NOTEQUAL:
+                {
+                    double equalVal = (myInst.m_op == Instruction::EQUAL ? 1.0 : 0.0);
+                    for (int i = 0; i < blockCount; ++i)
+                    {
+                        float adjust = min(abs(a[i]), abs(b[i])) / 1000000;//same fudge factor as MathNode::eval
+                        bool equal = (a[i] >= b[i] - adjust) && (a[i] <= b[i] + adjust);
+                        out[i] = (equal ? equalVal : 1.0 - equalVal);
+                    }
+                    break;
+                }
+                case Instruction::GREATER:
+                    for (int i = 0; i < blockCount; ++i) out[i] = (a[i] > b[i] ? 1.0 : 0.0);
+                    break;
+                case Instruction::LESS:
+                    for (int i = 0; i < blockCount; ++i) out[i] = (a[i] < b[i] ? 1.0 : 0.0);
+                    break;
+                case Instruction::GREATEREQUAL:
+                    for (int i = 0; i < blockCount; ++i)
+                    {
+                        float adjust = min(abs(a[i]), abs(b[i])) / 1000000;
+                        out[i] = (a[i] >= b[i] - adjust ? 1.0 : 0.0);
+                    }
+                    break;
+                case Instruction::LESSEQUAL:
+                    for (int i = 0; i < blockCount; ++i)
+                    {
+                        float adjust = min(abs(a[i]), abs(b[i])) / 1000000;
+                        out[i] = (a[i] <= b[i] + adjust ? 1.0 : 0.0);
+                    }
+                    break;
+                case Instruction::ADD:
+                    for (int i = 0; i < blockCount; ++i) out[i] = a[i] + b[i];
+                    break;
+                case Instruction::SUBTRACT:
+                    for (int i = 0; i < blockCount; ++i) out[i] = a[i] - b[i];
+                    break;
+                case Instruction::MULTIPLY:
+                    for (int i = 0; i < blockCount; ++i) out[i] = a[i] * b[i];
+                    break;
+                case Instruction::DIVIDE:
+                    for (int i = 0; i < blockCount; ++i) out[i] = a[i] / b[i];
+                    break;
+                case Instruction::NOT:
+                    for (int i = 0; i < blockCount; ++i) out[i] = (a[i] > 0.0 ? 0.0 : 1.0);
+                    break;
+                case Instruction::NEGATE:
+                    for (int i = 0; i < blockCount; ++i) out[i] = -a[i];
+                    break;
+                case Instruction::POW:
+                    for (int i = 0; i < blockCount; ++i) out[i] = pow(a[i], b[i]);
+                    break;
+                case Instruction::FUNC:
+                    evalFunctionBlock(myInst.m_function, out, a, b, c, blockCount);
+                    break;
+            }
+        }
+        const double* result = registers.data() + m_program.back().m_out * BLOCK_SIZE;
+        for (int i = 0; i < blockCount; ++i)
+        {
+            dataOut[blockStart + i] = (float)result[i];
+        }
+    }
+}
+
 vector<AString> CaretMathExpression::getVarNames() const
 {
     vector<AString> ret(m_varNames.size());
@@ -396,6 +499,235 @@ double CaretMathExpression::MathNode::eval(const vector<float>& values) const
     return ret;
 }
 
+int CaretMathExpression::addInstruction(Instruction toAdd)
+{
+    toAdd.m_out = (int)m_program.size();//no register reuse, expressions are small
+    m_program.push_back(toAdd);
+    return toAdd.m_out;
+}
+
+int CaretMathExpression::compileNode(const MathNode* node)
+{//chains of same-precedence operators become a sequence of binary instructions, evaluated left to right like MathNode::eval
+    CaretAssert(node != NULL);
+    switch (node->m_type)
+    {
+        case MathNode::OR:
+        case MathNode::AND:
+        {
+            int end = (int)node->m_arguments.size();
+            CaretAssert(end > 1);
+            int ret = compileNode(node->m_arguments[0]);
+            for (int i = 1; i < end; ++i)
+            {
+                Instruction temp(node->m_type == MathNode::OR ? Instruction::OR : Instruction::AND);
+                temp.m_args[0] = ret;
+                temp.m_args[1] = compileNode(node->m_arguments[i]);
+                ret = addInstruction(temp);
+            }
+            return ret;
+        }
+        case MathNode::EQUAL:
+        case MathNode::GREATERLESS:
+        case MathNode::ADDSUB:
+        case MathNode::MULTDIV:
+        {
+            int end = (int)node->m_arguments.size();
+            CaretAssert(end > 1);
+            CaretAssert((int)node->m_invert.size() == end);
+            int ret = compileNode(node->m_arguments[0]);
+            for (int i = 1; i < end; ++i)
+            {
+                Instruction::OpCode myOp = Instruction::ADD;
+                switch (node->m_type)
+                {
+                    case MathNode::EQUAL:
+                        myOp = (node->m_invert[i] ? Instruction::NOTEQUAL : Instruction::EQUAL);
+                        break;
+                    case MathNode::GREATERLESS:
+                        CaretAssert((int)node->m_inclusive.size() == end);
+                        if (node->m_invert[i])
+                        {
+                            myOp = (node->m_inclusive[i] ? Instruction::LESSEQUAL : Instruction::LESS);
+                        } else {
+                            myOp = (node->m_inclusive[i] ? Instruction::GREATEREQUAL : Instruction::GREATER);
+                        }
+                        break;
+                    case MathNode::ADDSUB:
+                        myOp = (node->m_invert[i] ? Instruction::SUBTRACT : Instruction::ADD);
+                        break;
+                    case MathNode::MULTDIV:
+                        myOp = (node->m_invert[i] ? Instruction::DIVIDE : Instruction::MULTIPLY);
+                        break;
+                    default:
+                        CaretAssert(0);
+                }
+                Instruction temp(myOp);
+                temp.m_args[0] = ret;
+                temp.m_args[1] = compileNode(node->m_arguments[i]);
+                ret = addInstruction(temp);
+            }
+            return ret;
+        }
+        case MathNode::NOT:
+        case MathNode::NEGATE:
+        {
+            CaretAssert(node->m_arguments.size() == 1);
+            Instruction temp(node->m_type == MathNode::NOT ? Instruction::NOT : Instruction::NEGATE);
+            temp.m_args[0] = compileNode(node->m_arguments[0]);
+            return addInstruction(temp);
+        }
+        case MathNode::POW:
+        case MathNode::FUNC:
+        {
+            Instruction temp(node->m_type == MathNode::POW ? Instruction::POW : Instruction::FUNC);
+            temp.m_function = node->m_function;
+            int numArgs = (int)node->m_arguments.size();
+            CaretAssert(numArgs >= 1 && numArgs <= 3);
+            if (numArgs > 3) throw CaretException("parsing problem in CaretMathExpression");
+            for (int i = 0; i < numArgs; ++i)
+            {
+                temp.m_args[i] = compileNode(node->m_arguments[i]);
+            }
+            return addInstruction(temp);
+        }
+        case MathNode::VAR:
+        {
+            Instruction temp(Instruction::LOADVAR);
+            temp.m_varIndex = node->m_varIndex;
+            return addInstruction(temp);
+        }
+        case MathNode::CONST:
+        {
+            Instruction temp(Instruction::LOADCONST);
+            temp.m_constVal = node->m_constVal;
+            return addInstruction(temp);
+        }
+        case MathNode::INVALID:
+            break;
+    }
+    CaretAssertMessage(0, "parsing left INVALID MathNode");
+    throw CaretException("parsing problem in CaretMathExpression");
+}
+
+void CaretMathExpression::evalFunctionBlock(const MathFunctionEnum::Enum& function, double* out, const double* arg1, const double* arg2, const double* arg3, const int& count)
+{//same math as the FUNC case in MathNode::eval, one loop per function
+    switch (function)
+    {
+        case MathFunctionEnum::SIN:
+            for (int i = 0; i < count; ++i) out[i] = sin(arg1[i]);
+            break;
+        case MathFunctionEnum::COS:
+            for (int i = 0; i < count; ++i) out[i] = cos(arg1[i]);
+            break;
+        case MathFunctionEnum::TAN:
+            for (int i = 0; i < count; ++i) out[i] = tan(arg1[i]);
+            break;
+        case MathFunctionEnum::ASIN:
+            for (int i = 0; i < count; ++i) out[i] = asin(arg1[i]);
+            break;
+        case MathFunctionEnum::ACOS:
+            for (int i = 0; i < count; ++i) out[i] = acos(arg1[i]);
+            break;
+        case MathFunctionEnum::ATAN:
+            for (int i = 0; i < count; ++i) out[i] = atan(arg1[i]);
+            break;
+        case MathFunctionEnum::SINH:
+            for (int i = 0; i < count; ++i) out[i] = sinh(arg1[i]);
+            break;
+        case MathFunctionEnum::COSH:
+            for (int i = 0; i < count; ++i) out[i] = cosh(arg1[i]);
+            break;
+        case MathFunctionEnum::TANH:
+            for (int i = 0; i < count; ++i) out[i] = tanh(arg1[i]);
+            break;
+        case MathFunctionEnum::ASINH:
+            for (int i = 0; i < count; ++i)
+            {
+                double arg = arg1[i];
+                if (arg > 0)
+                {
+                    out[i] = log(arg + sqrt(arg * arg + 1));
+                } else {
+                    out[i] = -log(-arg + sqrt(arg * arg + 1));//special case negative for stability in large negatives
+                }
+            }
+            break;
+        case MathFunctionEnum::ACOSH:
+            for (int i = 0; i < count; ++i) out[i] = log(arg1[i] + sqrt(arg1[i] * arg1[i] - 1));
+            break;
+        case MathFunctionEnum::ATANH:
+            for (int i = 0; i < count; ++i) out[i] = 0.5 * log((1 + arg1[i]) / (1 - arg1[i]));
+            break;
+        case MathFunctionEnum::LN:
+            for (int i = 0; i < count; ++i) out[i] = log(arg1[i]);
+            break;
+        case MathFunctionEnum::EXP:
+            for (int i = 0; i < count; ++i) out[i] = exp(arg1[i]);
+            break;
+        case MathFunctionEnum::LOG:
+            for (int i = 0; i < count; ++i) out[i] = log10(arg1[i]);
+            break;
+        case MathFunctionEnum::LOG2:
+            for (int i = 0; i < count; ++i) out[i] = log2(arg1[i]);
+            break;
+        case MathFunctionEnum::SQRT:
+            for (int i = 0; i < count; ++i) out[i] = sqrt(arg1[i]);
+            break;
+        case MathFunctionEnum::ABS:
+            for (int i = 0; i < count; ++i) out[i] = abs(arg1[i]);
+            break;
+        case MathFunctionEnum::FLOOR:
+            for (int i = 0; i < count; ++i) out[i] = floor(arg1[i]);
+            break;
+        case MathFunctionEnum::ROUND:
+            for (int i = 0; i < count; ++i)
+            {
+                if (arg1[i] > 0.0)
+                {
+                    out[i] = floor(arg1[i] + 0.5);
+                } else {
+                    out[i] = ceil(arg1[i] - 0.5);
+                }
+            }
+            break;
+        case MathFunctionEnum::CEIL:
+            for (int i = 0; i < count; ++i) out[i] = ceil(arg1[i]);
+            break;
+        case MathFunctionEnum::ATAN2:
+            for (int i = 0; i < count; ++i) out[i] = atan2(arg1[i], arg2[i]);
+            break;
+        case MathFunctionEnum::MIN:
+            for (int i = 0; i < count; ++i) out[i] = (arg1[i] > arg2[i] ? arg2[i] : arg1[i]);
+            break;
+        case MathFunctionEnum::MAX:
+            for (int i = 0; i < count; ++i) out[i] = (arg1[i] < arg2[i] ? arg2[i] : arg1[i]);
+            break;
+        case MathFunctionEnum::MOD:
+            for (int i = 0; i < count; ++i)
+            {
+                if (arg2[i] == 0.0)
+                {
+                    out[i] = 0.0;
+                } else {
+                    out[i] = arg1[i] - arg2[i] * floor(arg1[i] / arg2[i]);
+                }
+            }
+            break;
+        case MathFunctionEnum::CLAMP:
+            for (int i = 0; i < count; ++i)
+            {
+                double temp = arg1[i];
+                if (temp < arg2[i]) temp = arg2[i];
+                if (temp > arg3[i]) temp = arg3[i];
+                out[i] = temp;
+            }
+            break;
+        case MathFunctionEnum::INVALID:
+            CaretAssertMessage(0, "MathNode is type FUNC but INVALID function");
+            throw CaretException("parsing problem in CaretMathExpression");
+    }
+}
+
 AString CaretMathExpression::MathNode::toString(const std::vector<AString>& varNames) const
 {
     AString ret = "";
@@ -28,6 +28,8 @@
 #include <map>
 #include <vector>
 
+#include <stdint.h>
+
 namespace caret {
 
 class CaretMathExpression
@@ -63,10 +65,49 @@ class CaretMathExpression
         double eval(const std::vector<float>& values) const;
         AString toString(const std::vector<AString>& varNames) const;
     };
+    struct Instruction
+    {//one step of the flattened expression, operating on a block of elements at a time
+        enum OpCode
+        {
+            LOADCONST,
+            LOADVAR,
+            OR,
+            AND,
+            EQUAL,
+            NOTEQUAL,
+            GREATER,
+            GREATEREQUAL,
+            LESS,
+            LESSEQUAL,
+            ADD,
+            SUBTRACT,
+            MULTIPLY,
+            DIVIDE,
+            NOT,
+            NEGATE,
+            POW,
+            FUNC
+        };
+        OpCode m_op;
+        MathFunctionEnum::Enum m_function;
+        double m_constVal;
+        int m_varIndex;
+        int m_out;
+        int m_args[3];
+        Instruction(const OpCode& op)
+        {
+            m_op = op; m_function = MathFunctionEnum::INVALID; m_constVal = 0.0; m_varIndex = -1;
+            m_out = -1; m_args[0] = -1; m_args[1] = -1; m_args[2] = -1;
+        }
+    };
     std::map<AString, int> m_varNames;
     AString m_input;
     int m_position, m_end;
     CaretPointer<MathNode> m_root;
+    std::vector<Instruction> m_program;//m_root compiled in evaluation order, each instruction writes its own register
+    int compileNode(const MathNode* node);//returns the register index holding the result
+    int addInstruction(Instruction toAdd);
+    static void evalFunctionBlock(const MathFunctionEnum::Enum& function, double* out, const double* arg1, const double* arg2, const double* arg3, const int& count);
     bool skipWhitespace();
     bool accept(const char& c);
     void expect(const char& c, const int& exprStart);
@@ -86,6 +127,8 @@ public:
     static bool getNamedConstant(const AString& name, double& valueOut);
     CaretMathExpression(const AString& expression);
     double evaluate(const std::vector<float>& variableValues) const;
+    ///evaluate on count elements at once, variableRows is indexed like getVarNames() and each must point to count values, thread safe
+    void evaluateRow(float* dataOut, const std::vector<const float*>& variableRows, const int64_t& count) const;
     std::vector<AString> getVarNames() const;
     AString toString() const;//the expression, with a lot of parentheses added
 };
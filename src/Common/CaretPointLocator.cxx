@@ -19,55 +19,42 @@
 /*LICENSE_END*/
 
 #include "CaretPointLocator.h"
-#include "CaretHeap.h"
+#include "CaretOMP.h"
+#include "MathFunctions.h"
 #include <cmath>
+#include <limits>
 
 using namespace caret;
 using namespace std;
 
-void CaretPointLocator::addPoint(Oct<LeafVector<Point> >* thisOct, const float point[3], const int64_t index, const int32_t pointSet)
+void CaretPointLocator::rebuildTree() const
 {
-    if (thisOct->m_leaf)
+    int64_t numPoints = (int64_t)m_points.size();
+    vector<float> coords(numPoints * 3);
+    for (int64_t i = 0; i < numPoints; ++i)
     {
-        thisOct->m_data.m_vector->push_back(Point(point, index, pointSet));
-        int curSize = (int)thisOct->m_data.m_vector->size();
-        if (curSize > NUM_POINTS_SPLIT)
-        {//test that not all points are the same, or that they have some minimum percentage spread, or...
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            Vector3D minBox = myVecRef[0].m_point, maxBox = myVecRef[0].m_point, tempvec;
-            tempvec[0] = thisOct->m_bounds[0][2] - thisOct->m_bounds[0][0];
-            tempvec[1] = thisOct->m_bounds[1][2] - thisOct->m_bounds[1][0];
-            tempvec[2] = thisOct->m_bounds[2][2] - thisOct->m_bounds[2][0];
-            float diagonal = tempvec.length();
-            bool safeToSplit = false;
-            for (int i = 1; i < curSize; ++i)
-            {//this will slow down if lots of stuff is continuously put in an Oct that is far too big - use random sampling?
-                if (myVecRef[i].m_point[0] < minBox[0]) minBox[0] = myVecRef[i].m_point[0];
-                if (myVecRef[i].m_point[1] < minBox[1]) minBox[1] = myVecRef[i].m_point[1];
-                if (myVecRef[i].m_point[2] < minBox[2]) minBox[2] = myVecRef[i].m_point[2];
-                if (myVecRef[i].m_point[0] > maxBox[0]) maxBox[0] = myVecRef[i].m_point[0];
-                if (myVecRef[i].m_point[1] > maxBox[1]) maxBox[1] = myVecRef[i].m_point[1];
-                if (myVecRef[i].m_point[2] > maxBox[2]) maxBox[2] = myVecRef[i].m_point[2];
-                tempvec = minBox - maxBox;
-                if (tempvec.length() > 0.01f * diagonal)//make sure points aren't all identical, would go to infinity recursively
-                {
-                    safeToSplit = true;
-                    break;
-                }
-            }
-            if (safeToSplit)
-            {
-                thisOct->makeChildren();
-                for (int i = 0; i < curSize; ++i)
-                {
-                    addPoint(thisOct->containingChild(myVecRef[i].m_point), myVecRef[i].m_point, myVecRef[i].m_index, myVecRef[i].m_mySet);
-                }
-                thisOct->m_data.freeData();
-            }
-        }
-    } else {
-        addPoint(thisOct->containingChild(point), point, index, pointSet);
+        coords[i * 3] = m_points[i].m_point[0];
+        coords[i * 3 + 1] = m_points[i].m_point[1];
+        coords[i * 3 + 2] = m_points[i].m_point[2];
     }
+    m_tree.build(coords.data(), coords.data(), numPoints, NUM_POINTS_LEAF);//points are boxes with no extent
+    const vector<int32_t>& order = m_tree.getPrimitiveOrder();
+    vector<Point> reordered;
+    reordered.reserve(numPoints);
+    for (int64_t i = 0; i < numPoints; ++i)
+    {
+        reordered.push_back(m_points[order[i]]);
+    }
+    m_points.swap(reordered);
+}
+
+void CaretPointLocator::ensureTree() const
+{//queries may run in parallel, so only one of them rebuilds
+    if (m_treeValid.load(std::memory_order_acquire)) return;
+    CaretMutexLocker locked(&m_modifyMutex);
+    if (m_treeValid.load(std::memory_order_relaxed)) return;
+    rebuildTree();
+    m_treeValid.store(true, std::memory_order_release);
 }
 
 int32_t CaretPointLocator::addPointSet(const float* coordsIn, const int64_t numCoords)
@@ -75,123 +62,93 @@ int32_t CaretPointLocator::addPointSet(const float* coordsIn, const int64_t numC
     CaretMutexLocker locked(&m_modifyMutex);
     int32_t setNum = newIndex();
     if (numCoords < 1) return setNum;
-    if (m_tree == NULL)
-    {
-        Vector3D minBox, maxBox;
-        minBox = maxBox = coordsIn;//hack - first triple
-        for (int64_t i = 1; i < numCoords; ++i)
-        {
-            int64_t i3 = i * 3;
-            if (coordsIn[i3] < minBox[0]) minBox[0] = coordsIn[i3];
-            if (coordsIn[i3 + 1] < minBox[1]) minBox[1] = coordsIn[i3 + 1];
-            if (coordsIn[i3 + 2] < minBox[2]) minBox[2] = coordsIn[i3 + 2];
-            if (coordsIn[i3] > maxBox[0]) maxBox[0] = coordsIn[i3];
-            if (coordsIn[i3 + 1] > maxBox[1]) maxBox[1] = coordsIn[i3 + 1];
-            if (coordsIn[i3 + 2] > maxBox[2]) maxBox[2] = coordsIn[i3 + 2];
-        }
-        m_tree = new Oct<LeafVector<Point> >(minBox, maxBox);
-    }
+    m_points.reserve(m_points.size() + numCoords);
     for (int64_t i = 0; i < numCoords; ++i)
     {
-        int64_t i3 = i * 3;
-        m_tree = m_tree->makeContains(coordsIn + i3);//make new root if needed
-        addPoint(m_tree, coordsIn + i3, i, setNum);//and add the point
+        m_points.push_back(Point(coordsIn + i * 3, i, setNum));
     }
+    m_treeValid.store(false, std::memory_order_release);//building from scratch gives a better tree than inserting, defer it so several sets cost one rebuild
     return setNum;
 }
 
 CaretPointLocator::CaretPointLocator(const float* coordsIn, const int64_t numCoords)
 {
     m_nextSetIndex = 1;//next set will be set #1
-    m_tree = NULL;
+    m_treeValid.store(true);
     if (numCoords >= 1)
     {
-        Vector3D minBox, maxBox;
-        minBox = maxBox = coordsIn;//hack - first triple
-        for (int64_t i = 1; i < numCoords; ++i)
-        {
-            int64_t i3 = i * 3;
-            if (coordsIn[i3] < minBox[0]) minBox[0] = coordsIn[i3];
-            if (coordsIn[i3 + 1] < minBox[1]) minBox[1] = coordsIn[i3 + 1];
-            if (coordsIn[i3 + 2] < minBox[2]) minBox[2] = coordsIn[i3 + 2];
-            if (coordsIn[i3] > maxBox[0]) maxBox[0] = coordsIn[i3];
-            if (coordsIn[i3 + 1] > maxBox[1]) maxBox[1] = coordsIn[i3 + 1];
-            if (coordsIn[i3 + 2] > maxBox[2]) maxBox[2] = coordsIn[i3 + 2];
-        }
-        m_tree = new Oct<LeafVector<Point> >(minBox, maxBox);
+        m_points.reserve(numCoords);
         for (int64_t i = 0; i < numCoords; ++i)
         {
-            int64_t i3 = i * 3;
-            addPoint(m_tree, coordsIn + i3, i, 0);//this is set #0
+            m_points.push_back(Point(coordsIn + i * 3, i, 0));//this is set #0
         }
+        rebuildTree();
     }
 }
 
-CaretPointLocator::CaretPointLocator(const float minBounds[3], const float maxBounds[3])
+CaretPointLocator::CaretPointLocator(const float[3], const float[3])
 {
     m_nextSetIndex = 0;
-    m_tree = new Oct<LeafVector<Point> >(minBounds, maxBounds);
+    m_treeValid.store(true);
 }
 
-int64_t CaretPointLocator::closestPoint(const float target[3], LocatorInfo* infoOut) const
+int64_t CaretPointLocator::findClosest(const float target[3], const float& maxDist2, const bool& limited) const
 {
-    if (m_tree == NULL) return -1;
-    CaretSimpleMinHeap<Oct<LeafVector<Point> >*, float> myHeap;
-    bool first = true;
-    float bestDist2 = -1.0f, bestDist = -1.0f, tempf, curDist = m_tree->distToPoint(target);
-    Vector3D bestPoint;
-    int64_t bestIndex = -1;
-    int32_t bestSet = -1;
-    myHeap.push(m_tree, curDist);
-    while (curDist < bestDist || first)
+    ensureTree();
+    if (m_tree.isEmpty()) return -1;
+    float bestDist2 = (limited ? maxDist2 : numeric_limits<float>::infinity());
+    int64_t bestPos = -1;
+    float rootDist2 = m_tree.getNode(0).distSquaredToPoint(target);
+    if (rootDist2 > bestDist2) return -1;
+    vector<pair<int32_t, float> > myStack;//depth first, nearer child on top, so the bound shrinks quickly
+    myStack.reserve(64);
+    myStack.push_back(make_pair(0, rootDist2));
+    while (!myStack.empty())
     {
-        Oct<LeafVector<Point> >* thisOct = myHeap.pop();
-        if (thisOct->m_leaf)
+        int32_t nodeIndex = myStack.back().first;
+        float nodeDist2 = myStack.back().second;
+        myStack.pop_back();
+        if (nodeDist2 > bestDist2 || (nodeDist2 == bestDist2 && bestPos != -1)) continue;//bound may have shrunk since the push
+        const BoundingVolumeHierarchy::Node& thisNode = m_tree.getNode(nodeIndex);
+        if (thisNode.isLeaf())
         {
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            int curSize = (int)myVecRef.size();
-            for (int i = 0; i < curSize; ++i)
+            int64_t end = thisNode.m_start + thisNode.m_count;
+            for (int64_t i = thisNode.m_start; i < end; ++i)
             {
-                tempf = MathFunctions::distanceSquared3D(myVecRef[i].m_point, target);
-                if (tempf < bestDist2 || first)
+                float tempf = MathFunctions::distanceSquared3D(&(m_points[i].m_point[0]), target);
+                if (tempf < bestDist2 || (bestPos == -1 && tempf <= bestDist2))
                 {
-                    first = false;
                     bestDist2 = tempf;
-                    bestPoint = myVecRef[i].m_point;
-                    bestSet = myVecRef[i].m_mySet;
-                    bestIndex = myVecRef[i].m_index;
+                    bestPos = i;
                 }
             }
-            bestDist = sqrt(bestDist2);
         } else {
-            for (int ii = 0; ii < 2; ++ii)
+            float dist1 = m_tree.getNode(thisNode.m_start).distSquaredToPoint(target);
+            float dist2 = m_tree.getNode(thisNode.m_start + 1).distSquaredToPoint(target);
+            if (dist1 < dist2)
             {
-                for (int ij = 0; ij < 2; ++ij)
-                {
-                    for (int ik = 0; ik < 2; ++ik)
-                    {
-                        tempf = thisOct->m_children[ii][ij][ik]->distToPoint(target);
-                        if (tempf < bestDist || first)
-                        {
-                            myHeap.push(thisOct->m_children[ii][ij][ik], tempf);
-                        }
-                    }
-                }
+                if (dist2 <= bestDist2) myStack.push_back(make_pair(thisNode.m_start + 1, dist2));
+                if (dist1 <= bestDist2) myStack.push_back(make_pair(thisNode.m_start, dist1));
+            } else {
+                if (dist1 <= bestDist2) myStack.push_back(make_pair(thisNode.m_start, dist1));
+                if (dist2 <= bestDist2) myStack.push_back(make_pair(thisNode.m_start + 1, dist2));
             }
         }
-        if (myHeap.isEmpty())
-        {
-            break;//allows us to use top() without violating an assertion
-        }
-        myHeap.top(&curDist);//get the key for the next item
     }
+    return bestPos;
+}
+
+int64_t CaretPointLocator::closestPoint(const float target[3], LocatorInfo* infoOut) const
+{
+    int64_t bestPos = findClosest(target, 0.0f, false);
+    if (bestPos == -1) return -1;
     if (infoOut != NULL)
     {
-        infoOut->whichSet = bestSet;
-        infoOut->coords = bestPoint;
-        infoOut->index = bestIndex;
+        infoOut->whichSet = m_points[bestPos].m_mySet;
+        infoOut->coords = m_points[bestPos].m_point;
+        infoOut->index = m_points[bestPos].m_index;
     }
-    return bestIndex;
+    return m_points[bestPos].m_index;
 }
 
 int64_t CaretPointLocator::closestPointLimited(const float target[3], const float& maxDist, LocatorInfo* infoOut) const
@@ -201,106 +158,63 @@ int64_t CaretPointLocator::closestPointLimited(const float target[3], const floa
         infoOut->whichSet = -1;
         infoOut->index = -1;
     }
-    if (m_tree == NULL) return -1;
-    float curDist2 = m_tree->distSquaredToPoint(target), maxDist2 = maxDist * maxDist;
-    if (curDist2 > maxDist2)
+    int64_t bestPos = findClosest(target, maxDist * maxDist, true);
+    if (bestPos == -1) return -1;
+    if (infoOut != NULL)
     {
-        return -1;
+        infoOut->whichSet = m_points[bestPos].m_mySet;
+        infoOut->coords = m_points[bestPos].m_point;
+        infoOut->index = m_points[bestPos].m_index;
     }
-    CaretSimpleMinHeap<Oct<LeafVector<Point> >*, float> myHeap;
-    bool first = true;
-    float bestDist2 = -1.0f, tempf;
-    Vector3D bestPoint;
-    int64_t bestIndex = -1;
-    int32_t bestSet = -1;
-    myHeap.push(m_tree, curDist2);
-    while (curDist2 < bestDist2 || first)
+    return m_points[bestPos].m_index;
+}
+
+void CaretPointLocator::closestPoints(const float* targetsIn, const int64_t& numTargets, int64_t* indicesOut, const float& maxDist, LocatorInfo* infoOut) const
+{
+    ensureTree();//rebuild before the threads start, rather than having them all wait on it
+#pragma omp CARET_PARFOR schedule(dynamic, 256)
+    for (int64_t i = 0; i < numTargets; ++i)
     {
-        Oct<LeafVector<Point> >* thisOct = myHeap.pop();
-        if (thisOct->m_leaf)
+        LocatorInfo* thisInfo = (infoOut == NULL ? NULL : infoOut + i);
+        if (maxDist < 0.0f)
         {
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            int curSize = (int)myVecRef.size();
-            for (int i = 0; i < curSize; ++i)
-            {
-                tempf = MathFunctions::distanceSquared3D(myVecRef[i].m_point, target);
-                if (tempf < bestDist2 || (first && tempf <= maxDist2))
-                {
-                    first = false;
-                    bestDist2 = tempf;
-                    bestPoint = myVecRef[i].m_point;
-                    bestSet = myVecRef[i].m_mySet;
-                    bestIndex = myVecRef[i].m_index;
-                }
-            }
+            indicesOut[i] = closestPoint(targetsIn + i * 3, thisInfo);
         } else {
-            for (int ii = 0; ii < 2; ++ii)
-            {
-                for (int ij = 0; ij < 2; ++ij)
-                {
-                    for (int ik = 0; ik < 2; ++ik)
-                    {
-                        tempf = thisOct->m_children[ii][ij][ik]->distSquaredToPoint(target);
-                        if (tempf < bestDist2 || (first && tempf <= maxDist2))
-                        {
-                            myHeap.push(thisOct->m_children[ii][ij][ik], tempf);
-                        }
-                    }
-                }
-            }
+            indicesOut[i] = closestPointLimited(targetsIn + i * 3, maxDist, thisInfo);
         }
-        if (myHeap.isEmpty())
-        {
-            break;//allows us to use top() without violating an assertion
-        }
-        myHeap.top(&curDist2);//get the key for the next item
     }
-    if (infoOut != NULL)
-    {
-        infoOut->whichSet = bestSet;
-        infoOut->coords = bestPoint;
-        infoOut->index = bestIndex;
-    }
-    return bestIndex;
 }
 
 vector<LocatorInfo> CaretPointLocator::pointsInRange(const float target[3], const float& maxDist) const
 {//each point occurs in only once in the tree, so we can use a vector
     vector<LocatorInfo> ret;
-    if (m_tree == NULL) return ret;
-    float curDist2 = m_tree->distSquaredToPoint(target), maxDist2 = maxDist * maxDist;
-    if (curDist2 > maxDist2) return ret;
-    vector<Oct<LeafVector<Point> >*> myStack;//since we don't need the points sorted by distance
-    myStack.push_back(m_tree);
+    ensureTree();
+    if (m_tree.isEmpty()) return ret;
+    float maxDist2 = maxDist * maxDist;
+    if (m_tree.getNode(0).distSquaredToPoint(target) > maxDist2) return ret;
+    vector<int32_t> myStack;//since we don't need the points sorted by distance
+    myStack.push_back(0);
     while (!myStack.empty())
     {
-        Oct<LeafVector<Point> >* thisOct = myStack.back();
+        const BoundingVolumeHierarchy::Node& thisNode = m_tree.getNode(myStack.back());
         myStack.pop_back();
-        if (thisOct->m_leaf)
+        if (thisNode.isLeaf())
         {
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            int curSize = (int)myVecRef.size();
-            for (int i = 0; i < curSize; ++i)
+            int64_t end = thisNode.m_start + thisNode.m_count;
+            for (int64_t i = thisNode.m_start; i < end; ++i)
             {
-                float tempf = MathFunctions::distanceSquared3D(myVecRef[i].m_point, target);
+                float tempf = MathFunctions::distanceSquared3D(&(m_points[i].m_point[0]), target);
                 if (tempf <= maxDist2)
                 {
-                    ret.push_back(LocatorInfo(myVecRef[i].m_index, myVecRef[i].m_mySet, myVecRef[i].m_point));
+                    ret.push_back(LocatorInfo(m_points[i].m_index, m_points[i].m_mySet, m_points[i].m_point));
                 }
             }
         } else {
-            for (int ii = 0; ii < 2; ++ii)
+            for (int32_t child = thisNode.m_start; child < thisNode.m_start + 2; ++child)
             {
-                for (int ij = 0; ij < 2; ++ij)
+                if (m_tree.getNode(child).distSquaredToPoint(target) <= maxDist2)
                 {
-                    for (int ik = 0; ik < 2; ++ik)
-                    {
-                        float tempf = thisOct->m_children[ii][ij][ik]->distSquaredToPoint(target);
-                        if (tempf <= maxDist2)
-                        {
-                            myStack.push_back(thisOct->m_children[ii][ij][ik]);
-                        }
-                    }
+                    myStack.push_back(child);
                 }
             }
         }
@@ -310,41 +224,33 @@ vector<LocatorInfo> CaretPointLocator::pointsInRange(const float target[3], cons
 
 bool CaretPointLocator::anyInRange(const float target[3], const float& maxDist) const
 {
-    if (m_tree == NULL) return false;
-    float curDist2 = m_tree->distSquaredToPoint(target), maxDist2 = maxDist * maxDist, tempf;
-    if (curDist2 > maxDist2) return false;
-    CaretSimpleMinHeap<Oct<LeafVector<Point> >*, float> myHeap;//closer octs are more likely to contain a close enough point
-    myHeap.push(m_tree, curDist2);
-    while (!myHeap.isEmpty())
+    ensureTree();
+    if (m_tree.isEmpty()) return false;
+    float maxDist2 = maxDist * maxDist;
+    if (m_tree.getNode(0).distSquaredToPoint(target) > maxDist2) return false;
+    vector<int32_t> myStack;
+    myStack.push_back(0);
+    while (!myStack.empty())
     {
-        Oct<LeafVector<Point> >* thisOct = myHeap.pop(&curDist2);
-        if (thisOct->m_leaf)
+        const BoundingVolumeHierarchy::Node& thisNode = m_tree.getNode(myStack.back());
+        myStack.pop_back();
+        if (thisNode.isLeaf())
         {
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            int curSize = (int)myVecRef.size();
-            for (int i = 0; i < curSize; ++i)
+            int64_t end = thisNode.m_start + thisNode.m_count;
+            for (int64_t i = thisNode.m_start; i < end; ++i)
             {
-                tempf = MathFunctions::distanceSquared3D(myVecRef[i].m_point, target);
-                if (tempf < maxDist2)
+                if (MathFunctions::distanceSquared3D(&(m_points[i].m_point[0]), target) < maxDist2)
                 {
                     return true;
                 }
             }
-        } else {
-            for (int ii = 0; ii < 2; ++ii)
-            {
-                for (int ij = 0; ij < 2; ++ij)
-                {
-                    for (int ik = 0; ik < 2; ++ik)
-                    {
-                        tempf = thisOct->m_children[ii][ij][ik]->distSquaredToPoint(target);
-                        if (tempf <= maxDist2)
-                        {
-                            myHeap.push(thisOct->m_children[ii][ij][ik], tempf);
-                        }
-                    }
-                }
-            }
+        } else {//closer boxes are more likely to contain a close enough point, so put the closer one on top
+            float dist1 = m_tree.getNode(thisNode.m_start).distSquaredToPoint(target);
+            float dist2 = m_tree.getNode(thisNode.m_start + 1).distSquaredToPoint(target);
+            int32_t nearChild = (dist1 < dist2 ? thisNode.m_start : thisNode.m_start + 1);
+            int32_t farChild = (dist1 < dist2 ? thisNode.m_start + 1 : thisNode.m_start);
+            if ((dist1 < dist2 ? dist2 : dist1) <= maxDist2) myStack.push_back(farChild);
+            if ((dist1 < dist2 ? dist1 : dist2) <= maxDist2) myStack.push_back(nearChild);
         }
     }
     return false;
@@ -366,48 +272,16 @@ void CaretPointLocator::removePointSet(int32_t whichSet)
 {
     CaretMutexLocker locked(&m_modifyMutex);
     m_unusedIndexes.push_back(whichSet);
-    removeSetHelper(m_tree, whichSet);
-}
-
-void CaretPointLocator::removeSetHelper(Oct<LeafVector<CaretPointLocator::Point> >* thisOct, int32_t thisSet)
-{
-    if (thisOct == NULL) return;
-    if (thisOct->m_leaf)
+    vector<Point> tempvec;
+    tempvec.reserve(m_points.size());
+    for (size_t i = 0; i < m_points.size(); ++i)
     {
-        vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-        int curSize = (int)myVecRef.size();
-        bool match = false;
-        for (int i = 0; i < curSize; ++i)//make sure something gets removed, so we don't have to do an allocation if it isn't needed
-        {
-            if (myVecRef[i].m_mySet == thisSet)
-            {
-                match = true;
-                break;
-            }
-        }
-        if (match)
-        {
-            vector<Point> tempvec;
-            tempvec.reserve(curSize - 1);//because at least one is getting removed
-            for (int i = 0; i < curSize; ++i)
-            {
-                if (myVecRef[i].m_mySet != thisSet)
-                {
-                    tempvec.push_back(myVecRef[i]);
-                }
-            }
-            myVecRef = tempvec;
-        }
-    } else {
-        for (int ii = 0; ii < 2; ++ii)
+        if (m_points[i].m_mySet != whichSet)
         {
-            for (int ij = 0; ij < 2; ++ij)
-            {
-                for (int ik = 0; ik < 2; ++ik)
-                {
-                    removeSetHelper(thisOct->m_children[ii][ij][ik], thisSet);
-                }
-            }
+            tempvec.push_back(m_points[i]);
         }
     }
+    if (tempvec.size() == m_points.size()) return;//nothing removed, tree is still valid
+    m_points.swap(tempvec);
+    m_treeValid.store(false, std::memory_order_release);
 }
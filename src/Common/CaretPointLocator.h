@@ -22,10 +22,11 @@
  */
 /*LICENSE_END*/
 
+#include "BoundingVolumeHierarchy.h"
 #include "CaretMutex.h"
-#include "OctTree.h"
 #include "Vector3D.h"
 
+#include <atomic>
 #include <set>
 #include <vector>
 
@@ -64,23 +65,27 @@ namespace caret {
                 m_mySet = mySet;
             }
         };
-        CaretMutex m_modifyMutex;//thread safety, don't let multiple threads modify the point sets at once
-        Oct<LeafVector<Point> >* m_tree;
+        mutable CaretMutex m_modifyMutex;//thread safety, don't let multiple threads modify the point sets or rebuild the tree at once
+        mutable std::vector<Point> m_points;//kept in the leaf order of m_tree, so leaves are contiguous
+        mutable BoundingVolumeHierarchy m_tree;
+        mutable std::atomic<bool> m_treeValid;//adding or removing point sets only marks the tree stale, the next query rebuilds it
         int32_t m_nextSetIndex;
         std::vector<int32_t> m_unusedIndexes;
-        void addPoint(Oct<LeafVector<Point> >* thisOct, const float point[3], const int64_t index, const int32_t pointSet);
         int32_t newIndex();
-        static const int NUM_POINTS_SPLIT = 100;
-        void removeSetHelper(Oct<LeafVector<Point> >* thisOct, const int32_t thisSet);
+        static const int NUM_POINTS_LEAF = 8;
+        void rebuildTree() const;
+        void ensureTree() const;
+        int64_t findClosest(const float target[3], const float& maxDist2, const bool& limited) const;//returns position in m_points
         CaretPointLocator();
     public:
-        ///make an empty point locator with given bounding box (bounding box can expand later, but may be less efficient
+        ///make an empty point locator, the bounds are no longer needed, the tree is rebuilt to fit the points when it is next queried
         CaretPointLocator(const float minBounds[3], const float maxBounds[3]);
         ///make a point locator with the bounding box of this point set, and use this point set as set #0
         CaretPointLocator(const float* coordsIn, const int64_t numCoords);
         ///convenience constructor for vectors
         CaretPointLocator(const std::vector<float> coordsIn) : CaretPointLocator(coordsIn.data(), coordsIn.size() / 3) { }
         ///add a point set, SAVE THE RETURN VALUE because it is how you identify which point set found points belong to
+        ///the tree over all point sets is rebuilt on the next query, so adding or removing several sets in a row costs one rebuild
         int32_t addPointSet(const float* coordsIn, const int64_t numCoords);
         int32_t addPointSet(const std::vector<float> coordsIn) { return addPointSet(coordsIn.data(), coordsIn.size() / 3); }
         ///remove a point set by its set number
@@ -90,6 +95,8 @@ namespace caret {
         int64_t closestPointLimited(const float target[3], const float& maxDist, LocatorInfo* infoOut = NULL) const;
         std::vector<LocatorInfo> pointsInRange(const float target[3], const float& maxDist) const;
         bool anyInRange(const float target[3], const float& maxDist) const;
+        ///closestPoint or closestPointLimited (when maxDist >= 0) for many targets, in parallel - infoOut, if given, must have numTargets elements
+        void closestPoints(const float* targetsIn, const int64_t& numTargets, int64_t* indicesOut, const float& maxDist = -1.0f, LocatorInfo* infoOut = NULL) const;
     };
 }
 
@@ -1115,6 +1115,35 @@ CaretPreferences::setDynamicConnectivityDefaultedOn(const bool defaultedOn)
                      defaultedOn);
 }
 
+/**
+ * @return How dense dynamic connectivity keeps the rows of its
+ * data-series file (integer value of
+ * CiftiConnectivityMatrixDenseDynamicFile::RowStorage).
+ */
+int32_t
+CaretPreferences::getDynamicConnectivityRowStorage() const
+{
+    return this->dynamicConnectivityRowStorage;
+}
+
+/**
+ * Set how dense dynamic connectivity keeps the rows of its data-series file.
+ *
+ * @param rowStorage
+ *     Integer value of CiftiConnectivityMatrixDenseDynamicFile::RowStorage.
+ */
+void
+CaretPreferences::setDynamicConnectivityRowStorage(const int32_t rowStorage)
+{
+    if (this->dynamicConnectivityRowStorage == rowStorage) {
+        return;
+    }
+    
+    this->dynamicConnectivityRowStorage = rowStorage;
+    this->setInteger(NAME_DYNAMIC_CONNECTIVITY_ROW_STORAGE,
+                     rowStorage);
+}
+
 
 /**
  * @return The image capture method.
@@ -1803,6 +1832,10 @@ CaretPreferences::readPreferences()
     this->dynamicConnectivityDefaultedOn = this->getBoolean(CaretPreferences::NAME_DYNAMIC_CONNECTIVITY_ON,
                                                             true);
     
+    /* default is CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_INT16 */
+    this->dynamicConnectivityRowStorage = this->getInteger(CaretPreferences::NAME_DYNAMIC_CONNECTIVITY_ROW_STORAGE,
+                                                           2);
+    
     this->remoteFileUserName = this->getString(NAME_REMOTE_FILE_USER_NAME);
     this->remoteFilePassword = this->getString(NAME_REMOTE_FILE_PASSWORD);
     this->remoteFileLoginSaved = this->getBoolean(NAME_REMOTE_FILE_LOGIN_SAVED,
@@ -206,6 +206,10 @@ namespace caret {
         
         void setDynamicConnectivityDefaultedOn(const bool defaultedOn);
         
+        int32_t getDynamicConnectivityRowStorage() const;
+        
+        void setDynamicConnectivityRowStorage(const int32_t rowStorage);
+        
         WuQMacroGroup* getMacros();
         
         const WuQMacroGroup* getMacros() const;
@@ -319,6 +323,8 @@ namespace caret {
         
         bool dynamicConnectivityDefaultedOn;
         
+        int32_t dynamicConnectivityRowStorage;
+        
         bool yokingDefaultedOn;
         
         bool dataToolTipsEnabled;
@@ -355,6 +361,7 @@ namespace caret {
         static const AString NAME_DEVELOP_MENU;
         static const AString NAME_DATA_TOOL_TIPS;
         static const AString NAME_DYNAMIC_CONNECTIVITY_ON;
+        static const AString NAME_DYNAMIC_CONNECTIVITY_ROW_STORAGE;
         static const AString NAME_IMAGE_CAPTURE_METHOD;
         static const AString NAME_LOGGING_LEVEL;
         static const AString NAME_MACROS;
@@ -400,6 +407,7 @@ namespace caret {
     const AString CaretPreferences::NAME_DEVELOP_MENU     = "developMenu";
     const AString CaretPreferences::NAME_DATA_TOOL_TIPS = "dataToolTips";
     const AString CaretPreferences::NAME_DYNAMIC_CONNECTIVITY_ON = "dynamicConnectivityDefaultedOn";
+    const AString CaretPreferences::NAME_DYNAMIC_CONNECTIVITY_ROW_STORAGE = "dynamicConnectivityRowStorage";
     const AString CaretPreferences::NAME_IMAGE_CAPTURE_METHOD = "imageCaptureMethod";
     const AString CaretPreferences::NAME_LOGGING_LEVEL     = "loggingLevel";
     const AString CaretPreferences::NAME_MACROS = "macros";
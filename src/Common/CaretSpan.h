@@ -0,0 +1,59 @@
+#ifndef __CARET_SPAN_H__
+#define __CARET_SPAN_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretAssert.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace caret
+{
+    ///read-only view of a contiguous range owned by something else, such as one vertex's section of a compressed sparse row array
+    ///does not own the memory, so don't keep it after the owner changes or is destroyed
+    template <typename T>
+    class CaretSpan
+    {
+        const T* m_data;
+        int64_t m_size;
+    public:
+        CaretSpan() : m_data(NULL), m_size(0) { }
+        CaretSpan(const T* data, const int64_t& size) : m_data(data), m_size(size) { }
+        CaretSpan(const std::vector<T>& source) : m_data(source.data()), m_size((int64_t)source.size()) { }
+        const T* data() const { return m_data; }
+        int64_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        const T* begin() const { return m_data; }
+        const T* end() const { return m_data + m_size; }
+        const T& front() const { CaretAssert(m_size > 0); return m_data[0]; }
+        const T& back() const { CaretAssert(m_size > 0); return m_data[m_size - 1]; }
+        const T& operator[](const int64_t& index) const
+        {
+            CaretAssertArrayIndex(m_data, m_size, index);
+            return m_data[index];
+        }
+        ///copy out, for code that needs to modify or keep the list
+        operator std::vector<T>() const { return std::vector<T>(m_data, m_data + m_size); }
+    };
+}
+
+#endif //__CARET_SPAN_H__
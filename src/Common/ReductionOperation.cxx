@@ -137,14 +137,15 @@ float ReductionOperation::reduce(const float* data, const int64_t& numElems, con
         }
         case ReductionEnum::MEDIAN:
         {
-            vector<float> dataCopy(numElems);
-            for (int64_t i = 0; i < numElems; ++i) dataCopy[i] = data[i];
-            sort(dataCopy.begin(), dataCopy.end());
+            vector<float> dataCopy(data, data + numElems);
+            nth_element(dataCopy.begin(), dataCopy.begin() + numElems / 2, dataCopy.end());//only the middle needs to be in place, not a full sort
+            float upper = dataCopy[numElems / 2];
             if ((numElems & 1) == 0)//if even, average middle two
             {
-                return (dataCopy[numElems / 2 - 1] + dataCopy[numElems / 2]) / 2.0f;
+                float lower = *max_element(dataCopy.begin(), dataCopy.begin() + numElems / 2);//everything before the nth element is no larger
+                return (lower + upper) / 2.0f;
             } else {
-                return dataCopy[numElems / 2];//otherwise, take the center
+                return upper;//otherwise, take the center
             }
         }
         case ReductionEnum::MODE:
@@ -28,19 +28,96 @@
 
 #include <QByteArray>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 using namespace caret;
 using namespace std;
 
-const char magic[] = "\0\0\0\0cst\0";
+namespace
+{
+    const char magic[] = "\0\0\0\0cst\0";//last byte is the format version
+    const int CURRENT_VERSION = 1;
+    
+    //version 1 layout: magic, dims, rows per block, file offsets of the row blocks (plus one for the xml), row blocks, xml
+    //a row block is a codec byte, then number of nonzeros and payload end offset for each row as little endian uint32,
+    //then the row payloads: varint index deltas, followed by the values in the block's codec
+    enum BlockCodec
+    {
+        CODEC_VARINT = 0,//zigzag varint
+        CODEC_FIBERS = 1//varint total count, then the 30 bits of fractions and distance in 4 bytes
+    };
+    const int64_t MAX_ROWS_PER_BLOCK = 64;
+    const int64_t MAX_BYTES_PER_ENTRY = 20;//two 10 byte varints
+    
+    void putVarint(uint64_t value, vector<char>& out)
+    {
+        while (value >= 128)
+        {
+            out.push_back((char)((value & 127) | 128));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+    
+    uint64_t getVarint(const char*& pos, const char* end)
+    {
+        uint64_t ret = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos >= end) throw DataFileException("row data is truncated in wbsparse file");
+            unsigned char byte = (unsigned char)*pos;
+            ++pos;
+            ret |= ((uint64_t)(byte & 127)) << shift;
+            if (byte < 128) return ret;
+        }
+        throw DataFileException("invalid varint found in wbsparse file");
+    }
+    
+    uint64_t zigzag(const int64_t& value)
+    {
+        return (((uint64_t)value) << 1) ^ (uint64_t)(value < 0 ? -1 : 0);
+    }
+    
+    int64_t unzigzag(const uint64_t& value)
+    {
+        return (int64_t)((value >> 1) ^ (0 - (value & 1)));
+    }
+    
+    void setUint32(const uint32_t& value, char* out)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            out[i] = (char)((value >> (8 * i)) & 255);
+        }
+    }
+    
+    uint32_t getUint32(const char* in)
+    {
+        uint32_t ret = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            ret |= ((uint32_t)(unsigned char)in[i]) << (8 * i);
+        }
+        return ret;
+    }
+}
 
 CaretSparseFile::CaretSparseFile(const AString& fileName)
 {
+    m_mappedData = NULL;
+    m_positional = false;
+    m_version = 0;
+    m_rowsPerBlock = 0;
     readFile(fileName);
 }
 
 void CaretSparseFile::readFile(const AString& filename)
 {
     m_file.close();
+    m_mappedData = NULL;
+    m_positional = false;
     if (filename.endsWith(".gz"))
     {
         throw DataFileException("wbsparse files cannot be read while compressed");
@@ -49,31 +126,65 @@ void CaretSparseFile::readFile(const AString& filename)
     FileInformation fileInfo(filename);//useful later for file size, but create it now to reduce the amount of time between file open and size check
     char buf[8];
     m_file.read(buf, 8);
-    for (int i = 0; i < 8; ++i)
+    for (int i = 0; i < 7; ++i)
     {
         if (buf[i] != magic[i]) throw DataFileException("file has the wrong magic string");
     }
+    m_version = (unsigned char)buf[7];
+    if (m_version > CURRENT_VERSION)
+    {
+        throw DataFileException("wbsparse file version " + AString::number(m_version) + " is not supported by this version of workbench");
+    }
     m_file.read(m_dims, 2 * sizeof(int64_t));
     if (ByteOrderEnum::isSystemBigEndian())
     {
         ByteSwapping::swapBytes(m_dims, 2);
     }
     if (m_dims[0] < 1 || m_dims[1] < 1) throw DataFileException("both dimensions must be positive");
-    m_indexArray.resize(m_dims[1] + 1);
-    vector<int64_t> lengthArray(m_dims[1]);
-    m_file.read(lengthArray.data(), m_dims[1] * sizeof(int64_t));
-    if (ByteOrderEnum::isSystemBigEndian())
-    {
-        ByteSwapping::swapBytes(lengthArray.data(), m_dims[1]);
-    }
-    m_indexArray[0] = 0;
-    for (int64_t i = 0; i < m_dims[1]; ++i)
+    int64_t xml_offset = 0;
+    if (m_version == 0)
     {
-        if (lengthArray[i] > m_dims[0] || lengthArray[i] < 0) throw DataFileException("impossible value found in length array");
-        m_indexArray[i + 1] = m_indexArray[i] + lengthArray[i];
+        m_indexArray.resize(m_dims[1] + 1);
+        vector<int64_t> lengthArray(m_dims[1]);
+        m_file.read(lengthArray.data(), m_dims[1] * sizeof(int64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(lengthArray.data(), m_dims[1]);
+        }
+        m_indexArray[0] = 0;
+        for (int64_t i = 0; i < m_dims[1]; ++i)
+        {
+            if (lengthArray[i] > m_dims[0] || lengthArray[i] < 0) throw DataFileException("impossible value found in length array");
+            m_indexArray[i + 1] = m_indexArray[i] + lengthArray[i];
+        }
+        m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
+        xml_offset = m_valuesOffset + m_indexArray[m_dims[1]] * 2 * sizeof(int64_t);
+    } else {
+        m_file.read(&m_rowsPerBlock, sizeof(int64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(&m_rowsPerBlock, 1);
+        }
+        if (m_rowsPerBlock < 1 || m_rowsPerBlock > MAX_ROWS_PER_BLOCK) throw DataFileException("impossible rows per block value in file");
+        int64_t numBlocks = (m_dims[1] + m_rowsPerBlock - 1) / m_rowsPerBlock;
+        m_indexArray.resize(numBlocks + 1);
+        m_file.read(m_indexArray.data(), (numBlocks + 1) * sizeof(uint64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(m_indexArray.data(), numBlocks + 1);
+        }
+        m_valuesOffset = 8 + 3 * sizeof(int64_t) + (numBlocks + 1) * sizeof(int64_t);
+        if (m_indexArray[0] != (uint64_t)m_valuesOffset) throw DataFileException("impossible value found in block offset array");
+        for (int64_t i = 0; i < numBlocks; ++i)
+        {
+            int64_t rowsInBlock = min(m_rowsPerBlock, m_dims[1] - i * m_rowsPerBlock);
+            if (m_indexArray[i + 1] < m_indexArray[i] + 1 + 8 * rowsInBlock || m_indexArray[i + 1] > (uint64_t)fileInfo.size())
+            {
+                throw DataFileException("impossible value found in block offset array");
+            }
+        }
+        xml_offset = m_indexArray[numBlocks];
     }
-    m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
-    int64_t xml_offset = m_valuesOffset + m_indexArray[m_dims[1]] * 2 * sizeof(int64_t);
     if (xml_offset >= fileInfo.size()) throw DataFileException("file is truncated");
     int64_t xml_length = fileInfo.size() - xml_offset;
     if (xml_length < 1) throw DataFileException("file is truncated");
@@ -94,91 +205,167 @@ void CaretSparseFile::readFile(const AString& filename)
     {
         throw DataFileException("cifti XML doesn't match dimensions of sparse file");
     }
+    m_positional = m_file.supportsPositionalIO();
+    m_mappedData = m_file.getMemoryMap();//NULL if the OS didn't allow mapping it
 }
 
 CaretSparseFile::~CaretSparseFile()
 {
 }
 
-void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
-{
-    CaretAssert(index >= 0 && index < m_dims[1]);
-    int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
-    int64_t numToRead = (end - start) * 2;
-    m_scratchArray.resize(numToRead);
-    m_file.seek(m_valuesOffset + start * sizeof(int64_t) * 2);
-    m_file.read(m_scratchArray.data(), numToRead * sizeof(int64_t));
-    if (ByteOrderEnum::isSystemBigEndian())
+const char* CaretSparseFile::getBytes(const int64_t& offset, const int64_t& count, vector<char>& scratch) const
+{//offsets are checked against the file size in readFile, so the mapping doesn't need a check here
+    if (m_mappedData != NULL) return m_mappedData + offset;
+    scratch.resize(count);
+    if (count == 0) return scratch.data();
+    if (m_positional)
     {
-        ByteSwapping::swapBytes(m_scratchArray.data(), numToRead);
+        m_file.readAt(offset, scratch.data(), count);
+    } else {
+        CaretMutexLocker locked(&m_mutex);
+        m_file.seek(offset);
+        m_file.read(scratch.data(), count);
     }
-    int64_t curIndex = 0;
-    for (int64_t i = 0; i < numToRead; i += 2)
+    return scratch.data();
+}
+
+void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut) const
+{
+    RowBuffer buffer;
+    getRow(index, rowOut, buffer);
+}
+
+void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut, RowBuffer& buffer) const
+{
+    getRowSparse(index, buffer.m_indices, buffer.m_values, buffer);
+    for (int64_t i = 0; i < m_dims[0]; ++i)
     {
-        int64_t index = m_scratchArray[i];
-        if (index < curIndex || index >= m_dims[0]) throw DataFileException("impossible index value found in file");
-        while (curIndex < index)
-        {
-            rowOut[curIndex] = 0;
-            ++curIndex;
-        }
-        ++curIndex;
-        rowOut[index] = m_scratchArray[i + 1];
+        rowOut[i] = 0;
     }
-    while (curIndex < m_dims[0])
+    size_t numNonzero = buffer.m_indices.size();
+    for (size_t i = 0; i < numNonzero; ++i)
     {
-        rowOut[curIndex] = 0;
-        ++curIndex;
+        rowOut[buffer.m_indices[i]] = buffer.m_values[i];
     }
 }
 
-void CaretSparseFile::getRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut)
+void CaretSparseFile::getRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut) const
+{
+    RowBuffer buffer;
+    getRowSparse(index, indicesOut, valuesOut, buffer);
+}
+
+void CaretSparseFile::getRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut, RowBuffer& buffer) const
 {
     CaretAssert(index >= 0 && index < m_dims[1]);
-    int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
-    int64_t numToRead = (end - start) * 2, numNonzero = end - start;
-    m_scratchArray.resize(numToRead);
-    m_file.seek(m_valuesOffset + start * sizeof(int64_t) * 2);
-    m_file.read(m_scratchArray.data(), numToRead * sizeof(int64_t));
-    if (ByteOrderEnum::isSystemBigEndian())
+    if (m_version != 0)
     {
-        ByteSwapping::swapBytes(m_scratchArray.data(), numToRead);
+        getRowSparseCompressed(index, indicesOut, valuesOut, buffer);
+        return;
     }
+    int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
+    int64_t numNonzero = end - start;
+    const char* data = getBytes(m_valuesOffset + start * sizeof(int64_t) * 2, numNonzero * sizeof(int64_t) * 2, buffer.m_bytes);
     indicesOut.resize(numNonzero);
     valuesOut.resize(numNonzero);
     int64_t lastIndex = -1;
     for (int64_t i = 0; i < numNonzero; ++i)
     {
-        indicesOut[i] = m_scratchArray[i * 2];
-        valuesOut[i] = m_scratchArray[i * 2 + 1];
+        memcpy(&(indicesOut[i]), data + i * 2 * sizeof(int64_t), sizeof(int64_t));//the mapping isn't necessarily aligned
+        memcpy(&(valuesOut[i]), data + (i * 2 + 1) * sizeof(int64_t), sizeof(int64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(&(indicesOut[i]), 1);
+            ByteSwapping::swapBytes(&(valuesOut[i]), 1);
+        }
         if (indicesOut[i] <= lastIndex || indicesOut[i] >= m_dims[0]) throw DataFileException("impossible index value found in file");
         lastIndex = indicesOut[i];
     }
 }
 
-void CaretSparseFile::getFibersRow(const int64_t& index, FiberFractions* rowOut)
+void CaretSparseFile::getRowSparseCompressed(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut, RowBuffer& buffer) const
 {
-    if (m_scratchRow.size() != (size_t)m_dims[0]) m_scratchRow.resize(m_dims[0]);
-    getRow(index, (int64_t*)m_scratchRow.data());
+    int64_t block = index / m_rowsPerBlock, rowInBlock = index % m_rowsPerBlock;
+    int64_t rowsInBlock = min(m_rowsPerBlock, m_dims[1] - block * m_rowsPerBlock);
+    int64_t blockStart = m_indexArray[block];
+    int64_t headerSize = 1 + 8 * rowsInBlock;
+    int64_t payloadSize = m_indexArray[block + 1] - blockStart - headerSize;
+    const char* header = getBytes(blockStart, headerSize, buffer.m_bytes);//only read the header, then the one row
+    int codec = (unsigned char)header[0];
+    int64_t numNonzero = getUint32(header + 1 + 8 * rowInBlock);
+    int64_t rowEnd = getUint32(header + 5 + 8 * rowInBlock);
+    int64_t rowStart = (rowInBlock == 0 ? 0 : getUint32(header + 5 + 8 * (rowInBlock - 1)));
+    if (codec > CODEC_FIBERS || numNonzero > m_dims[0] || rowStart > rowEnd || rowEnd > payloadSize)
+    {
+        throw DataFileException("impossible value found in row block header");
+    }
+    const char* pos = getBytes(blockStart + headerSize + rowStart, rowEnd - rowStart, buffer.m_bytes);
+    const char* end = pos + (rowEnd - rowStart);
+    indicesOut.resize(numNonzero);
+    valuesOut.resize(numNonzero);
+    int64_t curIndex = -1;
+    for (int64_t i = 0; i < numNonzero; ++i)
+    {
+        uint64_t delta = getVarint(pos, end);
+        if (delta >= (uint64_t)(m_dims[0] - 1 - curIndex)) throw DataFileException("impossible index value found in file");
+        curIndex += delta + 1;
+        indicesOut[i] = curIndex;
+    }
+    if (codec == CODEC_FIBERS)
+    {
+        for (int64_t i = 0; i < numNonzero; ++i)
+        {
+            uint64_t totalCount = getVarint(pos, end);
+            if (totalCount > numeric_limits<uint32_t>::max() || end - pos < 4) throw DataFileException("impossible fiber value found in file");
+            valuesOut[i] = (int64_t)((totalCount << 32) | getUint32(pos));
+            pos += 4;
+        }
+    } else {
+        for (int64_t i = 0; i < numNonzero; ++i)
+        {
+            valuesOut[i] = unzigzag(getVarint(pos, end));
+        }
+    }
+    if (pos != end) throw DataFileException("row data has the wrong length in file");
+}
+
+void CaretSparseFile::getFibersRow(const int64_t& index, FiberFractions* rowOut) const
+{
+    RowBuffer buffer;
+    getFibersRow(index, rowOut, buffer);
+}
+
+void CaretSparseFile::getFibersRow(const int64_t& index, FiberFractions* rowOut, RowBuffer& buffer) const
+{
+    getRowSparse(index, buffer.m_indices, buffer.m_values, buffer);
     for (int64_t i = 0; i < m_dims[0]; ++i)
     {
-        if (m_scratchRow[i] == 0)
+        rowOut[i].zero();
+    }
+    size_t numNonzero = buffer.m_indices.size();
+    for (size_t i = 0; i < numNonzero; ++i)
+    {
+        if (buffer.m_values[i] != 0)
         {
-            rowOut[i].zero();
-        } else {
-             decodeFibers(m_scratchRow[i], rowOut[i]);
+            decodeFibers(buffer.m_values[i], rowOut[buffer.m_indices[i]]);
         }
     }
 }
 
-void CaretSparseFile::getFibersRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<FiberFractions>& valuesOut)
+void CaretSparseFile::getFibersRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<FiberFractions>& valuesOut) const
+{
+    RowBuffer buffer;
+    getFibersRowSparse(index, indicesOut, valuesOut, buffer);
+}
+
+void CaretSparseFile::getFibersRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<FiberFractions>& valuesOut, RowBuffer& buffer) const
 {
-    getRowSparse(index, indicesOut, m_scratchSparseRow);
-    size_t numNonzero = m_scratchSparseRow.size();
+    getRowSparse(index, indicesOut, buffer.m_values, buffer);
+    size_t numNonzero = buffer.m_values.size();
     valuesOut.resize(numNonzero);
     for (size_t i = 0; i < numNonzero; ++i)
     {
-        decodeFibers(((uint64_t*)m_scratchSparseRow.data())[i], valuesOut[i]);
+        decodeFibers(buffer.m_values[i], valuesOut[i]);
     }
 }
 
@@ -206,13 +393,14 @@ void FiberFractions::zero()
     distance = 0.0f;
 }
 
-CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml)
+CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml, const bool& compressed)
 {
     if (!fileName.endsWith(".trajTEMP.wbsparse"))
     {//for now (and maybe forever), this format is single-purpose
         CaretLogWarning("sparse trajectory file '" + fileName + "' should be saved ending in .trajTEMP.wbsparse");
     }
     m_finished = false;
+    m_compressed = compressed;
     int64_t dimensions[2] = { xml.getDimensionLength(CiftiXML::ALONG_ROW), xml.getDimensionLength(CiftiXML::ALONG_COLUMN) };
     if (dimensions[0] < 1 || dimensions[1] < 1) throw DataFileException("both dimensions must be positive");
     m_xml = xml;
@@ -223,23 +411,58 @@ CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const Cift
         throw DataFileException("wbsparse files cannot be written compressed");
     }//because after we finish writing the data, we have to come back and write the lengths array
     m_file.open(fileName, CaretBinaryFile::WRITE_TRUNCATE);
-    m_file.write(magic, 8);
+    char fileMagic[8];
+    memcpy(fileMagic, magic, 8);
+    if (m_compressed) fileMagic[7] = CURRENT_VERSION;
+    m_file.write(fileMagic, 8);
     int64_t tempdims[2] = { m_dims[0], m_dims[1] };
     if (ByteOrderEnum::isSystemBigEndian())
     {
         ByteSwapping::swapBytes(tempdims, 2);
     }
     m_file.write(tempdims, 2 * sizeof(int64_t));
-    m_lengthArray.resize(m_dims[1], 0);//initialize the memory so that valgrind won't complain
-    m_file.write(m_lengthArray.data(), m_dims[1] * sizeof(uint64_t));//write it to get the file to the correct length
     m_nextRowIndex = 0;
-    m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
+    if (m_compressed)
+    {//keep blocks small enough that the offsets in a block header fit in 32 bits
+        m_rowsPerBlock = min(MAX_ROWS_PER_BLOCK, max((int64_t)1, (((int64_t)1) << 32) / (m_dims[0] * MAX_BYTES_PER_ENTRY)));
+        int64_t numBlocks = (m_dims[1] + m_rowsPerBlock - 1) / m_rowsPerBlock;
+        int64_t tempRows = m_rowsPerBlock;
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(&tempRows, 1);
+        }
+        m_file.write(&tempRows, sizeof(int64_t));
+        m_lengthArray.resize(numBlocks + 1, 0);
+        m_file.write(m_lengthArray.data(), (numBlocks + 1) * sizeof(uint64_t));
+        m_valuesOffset = 8 + 3 * sizeof(int64_t) + (numBlocks + 1) * sizeof(int64_t);
+        m_lengthArray[0] = m_valuesOffset;
+    } else {
+        m_rowsPerBlock = 0;
+        m_lengthArray.resize(m_dims[1], 0);//initialize the memory so that valgrind won't complain
+        m_file.write(m_lengthArray.data(), m_dims[1] * sizeof(uint64_t));//write it to get the file to the correct length
+        m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
+    }
 }
 
 void CaretSparseFileWriter::writeRow(const int64_t& index, const int64_t* row)
 {
     CaretAssert(index < m_dims[1]);
     CaretAssert(index >= m_nextRowIndex);
+    if (m_compressed)
+    {
+        m_scratchIndices.clear();
+        m_scratchArray.clear();
+        for (int64_t i = 0; i < m_dims[0]; ++i)
+        {
+            if (row[i] != 0)
+            {
+                m_scratchIndices.push_back(i);
+                m_scratchArray.push_back(row[i]);
+            }
+        }
+        writeRowSparse(index, m_scratchIndices, m_scratchArray);
+        return;
+    }
     while (m_nextRowIndex < index)
     {
         m_lengthArray[m_nextRowIndex] = 0;
@@ -271,6 +494,25 @@ void CaretSparseFileWriter::writeRowSparse(const int64_t& index, const vector<in
     CaretAssert(index < m_dims[1]);
     CaretAssert(index >= m_nextRowIndex);
     CaretAssert(indices.size() == values.size());
+    if (m_compressed)
+    {
+        while (m_nextRowIndex < index)
+        {
+            addRowToBlock(0);
+        }
+        size_t numNonzero = indices.size();//assume no zeros
+        int64_t lastIndex = -1;
+        for (size_t i = 0; i < numNonzero; ++i)
+        {
+            if (indices[i] <= lastIndex || indices[i] >= m_dims[0]) throw DataFileException("indices must be sorted when writing sparse rows");
+            lastIndex = indices[i];
+        }
+        m_blockIndices.insert(m_blockIndices.end(), indices.begin(), indices.end());
+        m_blockValues.insert(m_blockValues.end(), values.begin(), values.end());
+        addRowToBlock(numNonzero);
+        if (m_nextRowIndex == m_dims[1]) finish();
+        return;
+    }
     while (m_nextRowIndex < index)
     {
         m_lengthArray[m_nextRowIndex] = 0;
@@ -296,6 +538,66 @@ void CaretSparseFileWriter::writeRowSparse(const int64_t& index, const vector<in
     if (m_nextRowIndex == m_dims[1]) finish();
 }
 
+void CaretSparseFileWriter::addRowToBlock(const int64_t& numNonzero)
+{
+    m_blockRowLengths.push_back(numNonzero);
+    ++m_nextRowIndex;
+    if ((int64_t)m_blockRowLengths.size() == m_rowsPerBlock || m_nextRowIndex == m_dims[1]) writeBlock();
+}
+
+void CaretSparseFileWriter::writeBlock()
+{
+    int64_t numRows = (int64_t)m_blockRowLengths.size();
+    if (numRows == 0) return;
+    int codec = CODEC_FIBERS;
+    for (size_t i = 0; i < m_blockValues.size(); ++i)
+    {
+        if (((uint64_t)m_blockValues[i]) & (3u<<30))//not an encoded fiber value, see encodeFibers
+        {
+            codec = CODEC_VARINT;
+            break;
+        }
+    }
+    m_blockBytes.resize(1 + 8 * numRows);
+    m_blockBytes[0] = (char)codec;
+    const int64_t payloadStart = (int64_t)m_blockBytes.size();
+    int64_t entry = 0;
+    for (int64_t row = 0; row < numRows; ++row)
+    {
+        int64_t rowEntries = m_blockRowLengths[row], lastIndex = -1;
+        for (int64_t i = entry; i < entry + rowEntries; ++i)
+        {
+            putVarint(m_blockIndices[i] - lastIndex - 1, m_blockBytes);
+            lastIndex = m_blockIndices[i];
+        }
+        for (int64_t i = entry; i < entry + rowEntries; ++i)
+        {
+            if (codec == CODEC_FIBERS)
+            {
+                uint64_t coded = m_blockValues[i];
+                putVarint(coded >> 32, m_blockBytes);
+                size_t cur = m_blockBytes.size();
+                m_blockBytes.resize(cur + 4);
+                setUint32(coded & ((1LL<<32) - 1), m_blockBytes.data() + cur);
+            } else {
+                putVarint(zigzag(m_blockValues[i]), m_blockBytes);
+            }
+        }
+        entry += rowEntries;
+        int64_t rowEnd = (int64_t)m_blockBytes.size() - payloadStart;
+        if (rowEnd > numeric_limits<uint32_t>::max()) throw DataFileException("row block is too large for compressed wbsparse format");
+        setUint32(rowEntries, m_blockBytes.data() + 1 + 8 * row);
+        setUint32(rowEnd, m_blockBytes.data() + 5 + 8 * row);
+    }
+    m_file.write(m_blockBytes.data(), m_blockBytes.size());
+    int64_t block = (m_nextRowIndex - 1) / m_rowsPerBlock;
+    m_lengthArray[block + 1] = m_lengthArray[block] + m_blockBytes.size();
+    m_blockBytes.clear();
+    m_blockIndices.clear();
+    m_blockValues.clear();
+    m_blockRowLengths.clear();
+}
+
 void CaretSparseFileWriter::writeFibersRow(const int64_t& index, const FiberFractions* row)
 {
     if (m_scratchRow.size() != (size_t)m_dims[0]) m_scratchRow.resize(m_dims[0]);
@@ -326,14 +628,22 @@ void CaretSparseFileWriter::finish()
 {
     if (m_finished) return;
     m_finished = true;
-    while (m_nextRowIndex < m_dims[1])
+    if (m_compressed)
     {
-        m_lengthArray[m_nextRowIndex] = 0;
-        ++m_nextRowIndex;
+        while (m_nextRowIndex < m_dims[1])
+        {
+            addRowToBlock(0);
+        }
+    } else {
+        while (m_nextRowIndex < m_dims[1])
+        {
+            m_lengthArray[m_nextRowIndex] = 0;
+            ++m_nextRowIndex;
+        }
     }
     QByteArray myXMLBytes = m_xml.writeXMLToQByteArray();
     m_file.write(myXMLBytes.constData(), myXMLBytes.size());
-    m_file.seek(8 + 2 * sizeof(int64_t));
+    m_file.seek(8 + (m_compressed ? 3 : 2) * sizeof(int64_t));
     if (ByteOrderEnum::isSystemBigEndian())
     {
         ByteSwapping::swapBytes(m_lengthArray.data(), m_lengthArray.size());
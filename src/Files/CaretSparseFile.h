@@ -26,6 +26,7 @@
 
 #include "AString.h"
 #include "CaretBinaryFile.h"
+#include "CaretMutex.h"
 #include "CiftiXML.h"
 #include "DataFile.h"
 #include "DataFileException.h"
@@ -40,19 +41,34 @@ namespace caret {
         void zero();
     };
     
+    ///reads version 0 (raw index/value pairs) and version 1 (compressed row blocks) wbsparse files
+    ///all row functions are const and may be called from multiple threads, give each thread its own RowBuffer
     class CaretSparseFile /* : public DataFile */
     {
+    public:
+        ///scratch space for decoding rows, reuse it across calls to avoid allocation
+        struct RowBuffer
+        {
+            std::vector<char> m_bytes;
+            std::vector<int64_t> m_indices, m_values;
+        };
+    private:
         static void decodeFibers(const uint64_t& coded, FiberFractions& decoded);//takes a uint because right shift on signed is implementation dependent
-        CaretBinaryFile m_file;
-        int64_t m_dims[2], m_valuesOffset;
-        std::vector<uint64_t> m_indexArray, m_scratchRow;
-        std::vector<int64_t> m_scratchArray, m_scratchSparseRow;
+        const char* getBytes(const int64_t& offset, const int64_t& count, std::vector<char>& scratch) const;
+        void getRowSparseCompressed(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<int64_t>& valuesOut, RowBuffer& buffer) const;
+        mutable CaretBinaryFile m_file;
+        mutable CaretMutex m_mutex;//serializes seek and read when the file doesn't support positional reads
+        const char* m_mappedData;
+        bool m_positional;
+        int m_version;
+        int64_t m_dims[2], m_valuesOffset, m_rowsPerBlock;
+        std::vector<uint64_t> m_indexArray;//version 0: first pair of each row, version 1: file offset of each row block
         CaretSparseFile(const CaretSparseFile& rhs);
         CiftiXML m_xml;
     public:
-        const int64_t* getDimensions() { return m_dims; }
+        const int64_t* getDimensions() const { return m_dims; }
 
-        CaretSparseFile() {};
+        CaretSparseFile() { m_mappedData = NULL; m_positional = false; m_version = 0; m_rowsPerBlock = 0; m_valuesOffset = 0; m_dims[0] = 0; m_dims[1] = 0; }
         
         virtual void readFile(const AString& filename);
         
@@ -63,13 +79,19 @@ namespace caret {
         ///get a reference to the XML data
         const CiftiXML& getCiftiXML() const { return m_xml; }
         
-        void getRow(const int64_t& index, int64_t* rowOut);
+        int getVersion() const { return m_version; }
+        
+        void getRow(const int64_t& index, int64_t* rowOut) const;
+        void getRow(const int64_t& index, int64_t* rowOut, RowBuffer& buffer) const;
         
-        void getRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<int64_t>& valuesOut);
+        void getRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<int64_t>& valuesOut) const;
+        void getRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<int64_t>& valuesOut, RowBuffer& buffer) const;
 
-        void getFibersRow(const int64_t& index, FiberFractions* rowOut);
+        void getFibersRow(const int64_t& index, FiberFractions* rowOut) const;
+        void getFibersRow(const int64_t& index, FiberFractions* rowOut, RowBuffer& buffer) const;
         
-        void getFibersRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<FiberFractions>& valuesOut);
+        void getFibersRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<FiberFractions>& valuesOut) const;
+        void getFibersRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<FiberFractions>& valuesOut, RowBuffer& buffer) const;
 
         virtual ~CaretSparseFile();
     };
@@ -78,15 +100,20 @@ namespace caret {
     {
         static void encodeFibers(const FiberFractions& orig, uint64_t& coded);
         static uint32_t myclamp(const int& x);
+        void addRowToBlock(const int64_t& numNonzero);
+        void writeBlock();
         CaretBinaryFile m_file;
-        int64_t m_dims[2], m_valuesOffset, m_nextRowIndex;
-        bool m_finished;
-        std::vector<uint64_t> m_lengthArray, m_scratchRow;
-        std::vector<int64_t> m_scratchArray, m_scratchSparseRow;
+        int64_t m_dims[2], m_valuesOffset, m_nextRowIndex, m_rowsPerBlock;
+        bool m_finished, m_compressed;
+        std::vector<uint64_t> m_lengthArray, m_scratchRow;//for compressed, m_lengthArray holds the row block offsets
+        std::vector<int64_t> m_scratchArray, m_scratchSparseRow, m_scratchIndices;
+        std::vector<int64_t> m_blockIndices, m_blockValues, m_blockRowLengths;//rows of the current block, encoded when it is full
+        std::vector<char> m_blockBytes;
         CaretSparseFileWriter(const CaretSparseFileWriter& rhs);
         CiftiXML m_xml;
     public:
-        CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml);
+        ///compressed writes version 1, which older versions of workbench can't read
+        CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml, const bool& compressed = false);
         
         ~CaretSparseFileWriter();
         
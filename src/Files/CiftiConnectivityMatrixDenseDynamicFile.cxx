@@ -19,6 +19,7 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -46,6 +47,13 @@ using namespace caret;
  * Internally, the file format is the same as a data series file.  When
  * a row is requested, the row is correlated with all other rows
  * producing the connectivity from that row to all other rows.
+ *
+ * Unless the row storage is ROW_STORAGE_PARENT_FILE, every row is read
+ * once, demeaned and scaled to unit length, so that correlation with all
+ * other rows is a single matrix-vector product.  The integer row storage
+ * types reduce the memory used by the preloaded rows to one half or one
+ * quarter of float, with an error in correlation of about 1e-5 (16-bit)
+ * or 1e-3 (8-bit).
  */
 
 /**
@@ -60,9 +68,9 @@ m_parentDataSeriesFile(parentDataSeriesFile),
 m_parentDataSeriesCiftiFile(NULL),
 m_numberOfBrainordinates(-1),
 m_numberOfTimePoints(-1),
+m_rowStorage(s_defaultRowStorage),
 m_validDataFlag(false),
-m_enabledAsLayer(true),
-m_cacheDataFlag(false)
+m_enabledAsLayer(true)
 {
     CaretAssert(m_parentDataSeriesFile);
 
@@ -96,6 +104,29 @@ CiftiConnectivityMatrixDenseDynamicFile::getParentBrainordinateDataSeriesFile()
     return m_parentDataSeriesFile;
 }
 
+/**
+ * @return How rows are stored for computing correlation.
+ */
+CiftiConnectivityMatrixDenseDynamicFile::RowStorage
+CiftiConnectivityMatrixDenseDynamicFile::getRowStorage() const
+{
+    return m_rowStorage;
+}
+
+/**
+ * Set how rows are stored by dense dynamic files when their parent
+ * data-series file is read.  Does not affect files that have already
+ * been read.
+ *
+ * @param rowStorage
+ *     New row storage type.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::setDefaultRowStorage(const RowStorage rowStorage)
+{
+    s_defaultRowStorage = rowStorage;
+}
+
 /**
  * @return True if enabled as a layer.
  */
@@ -166,30 +197,27 @@ CiftiConnectivityMatrixDenseDynamicFile::updateAfterReading(const CiftiFile* cif
     m_numberOfTimePoints     = ciftiXML.getSeriesMap(CiftiXML::ALONG_ROW).getLength();
     
     m_rowData.clear();
+    m_normalizedFloatRows.clear();
+    m_normalizedInt16Rows.clear();
+    m_normalizedInt8Rows.clear();
+    m_normalizedRowScales.clear();
+    m_rowStorage = s_defaultRowStorage;
     
     if ((m_numberOfBrainordinates > 0)
         && (m_numberOfTimePoints > 0)) {
-        m_rowData.resize(m_numberOfBrainordinates);
-        
-        if (m_cacheDataFlag) {
+        if (m_rowStorage == ROW_STORAGE_PARENT_FILE) {
+            m_rowData.resize(m_numberOfBrainordinates);
+            preComputeRowMeanAndSumSquared();
+        }
+        else {
             /*
-             * Read all of the data.  Time-series type files are not
-             * too large and by caching the data, it eliminates
-             * numerous calls to read the data when correlation
-             * is performed.
-             *
-             * READ DATA FROM PARENT FILE
+             * Computing the row means already requires reading all
+             * of the data, so keep it in a form where correlation
+             * is only a dot product.
              */
-            for (int32_t i = 0; i < m_numberOfBrainordinates; i++) {
-                CaretAssertVectorIndex(m_rowData, i);
-                m_rowData[i].m_data.resize(m_numberOfTimePoints);
-                m_parentDataSeriesCiftiFile->getRow(&m_rowData[i].m_data[0],
-                                                    i);
-            }
+            loadNormalizedRows();
         }
         
-        preComputeRowMeanAndSumSquared();
-        
         m_validDataFlag = true;
     }
 }
@@ -268,6 +296,14 @@ CiftiConnectivityMatrixDenseDynamicFile::getProcessedDataForRow(float* dataOut,
         return;
     }
     
+    if (m_rowStorage != ROW_STORAGE_PARENT_FILE) {
+        std::vector<float> normalizedRow(m_numberOfTimePoints);
+        getNormalizedRow(index, &normalizedRow[0]);
+        correlateWithNormalizedRows(&normalizedRow[0], dataOut);
+        dataOut[index] = 1.0;
+        return;
+    }
+    
     std::vector<float> rowData(m_numberOfTimePoints);
     m_parentDataSeriesCiftiFile->getRow(&rowData[0], index);
     const float mean = m_rowData[index].m_mean;
@@ -316,6 +352,16 @@ CiftiConnectivityMatrixDenseDynamicFile::processRowAverageData(std::vector<float
         return;
     }
     
+    if (m_rowStorage != ROW_STORAGE_PARENT_FILE) {
+        std::vector<float> normalizedData(dataLength);
+        std::vector<float> processedRowAverageData(m_numberOfBrainordinates, 0.0);
+        if (normalizeData(&rowAverageDataInOut[0], dataLength, &normalizedData[0])) {
+            correlateWithNormalizedRows(&normalizedData[0], &processedRowAverageData[0]);
+        }
+        rowAverageDataInOut = processedRowAverageData;
+        return;
+    }
+    
     float mean = 0.0;
     float sumSquared = 0.0;
     computeDataMeanAndSumSquared(&rowAverageDataInOut[0],
@@ -363,24 +409,15 @@ CiftiConnectivityMatrixDenseDynamicFile::preComputeRowMeanAndSumSquared()
 
         CaretAssertVectorIndex(m_rowData, iRow);
         
-        if (m_cacheDataFlag) {
-            CaretAssertVectorIndex(m_rowData[iRow].m_data, (m_numberOfTimePoints - 1));
-            computeDataMeanAndSumSquared(&m_rowData[iRow].m_data[0],
-                                         m_numberOfTimePoints,
-                                         m_rowData[iRow].m_mean,
-                                         m_rowData[iRow].m_sqrt_ssxx);
-        }
-        else {
-            std::vector<float> data(m_numberOfTimePoints);
+        std::vector<float> data(m_numberOfTimePoints);
 #pragma omp critical
-            {//TSC: this can do disk access, which is not currently thread-safe
-                m_parentDataSeriesCiftiFile->getRow(&data[0], iRow);
-            }
-            computeDataMeanAndSumSquared(&data[0],
-                                         m_numberOfTimePoints,
-                                         m_rowData[iRow].m_mean,
-                                         m_rowData[iRow].m_sqrt_ssxx);
+        {//TSC: this can do disk access, which is not currently thread-safe
+            m_parentDataSeriesCiftiFile->getRow(&data[0], iRow);
         }
+        computeDataMeanAndSumSquared(&data[0],
+                                     m_numberOfTimePoints,
+                                     m_rowData[iRow].m_mean,
+                                     m_rowData[iRow].m_sqrt_ssxx);
         
 //        double sum = 0.0;
 //        double sumSquared = 0.0;
@@ -418,6 +455,223 @@ CiftiConnectivityMatrixDenseDynamicFile::preComputeRowMeanAndSumSquared()
     }
 }
 
+/**
+ * Read every row of the parent file, and store it demeaned and scaled
+ * to unit length, converted to the type given by the row storage.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::loadNormalizedRows()
+{
+    CaretAssert(m_numberOfBrainordinates > 0);
+    CaretAssert(m_numberOfTimePoints > 0);
+    CaretAssert(m_rowStorage != ROW_STORAGE_PARENT_FILE);
+    
+    const int64_t numberOfValues = static_cast<int64_t>(m_numberOfBrainordinates) * m_numberOfTimePoints;
+    switch (m_rowStorage) {
+        case ROW_STORAGE_PARENT_FILE:
+            break;
+        case ROW_STORAGE_NORMALIZED_FLOAT:
+            m_normalizedFloatRows.resize(numberOfValues);
+            break;
+        case ROW_STORAGE_NORMALIZED_INT16:
+            m_normalizedInt16Rows.resize(numberOfValues);
+            m_normalizedRowScales.resize(m_numberOfBrainordinates);
+            break;
+        case ROW_STORAGE_NORMALIZED_INT8:
+            m_normalizedInt8Rows.resize(numberOfValues);
+            m_normalizedRowScales.resize(m_numberOfBrainordinates);
+            break;
+    }
+    
+    const bool parallelRead = m_parentDataSeriesCiftiFile->hasParallelRowIO();
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int32_t iRow = 0; iRow < m_numberOfBrainordinates; iRow++) {
+        std::vector<float> data(m_numberOfTimePoints);
+        if (parallelRead) {
+            m_parentDataSeriesCiftiFile->getRow(&data[0], iRow);
+        }
+        else {
+#pragma omp critical
+            {//TSC: this can do disk access, which is not currently thread-safe
+                m_parentDataSeriesCiftiFile->getRow(&data[0], iRow);
+            }
+        }
+        const int64_t rowStart = static_cast<int64_t>(iRow) * m_numberOfTimePoints;
+        if (m_rowStorage == ROW_STORAGE_NORMALIZED_FLOAT) {
+            normalizeData(&data[0], m_numberOfTimePoints, &m_normalizedFloatRows[rowStart]);
+            continue;
+        }
+        
+        /*
+         * Scale so that the largest magnitude element uses the full integer range
+         */
+        normalizeData(&data[0], m_numberOfTimePoints, &data[0]);
+        float maxMagnitude = 0.0;
+        for (int32_t i = 0; i < m_numberOfTimePoints; i++) {
+            maxMagnitude = std::max(maxMagnitude, std::fabs(data[i]));
+        }
+        const float maxInteger = ((m_rowStorage == ROW_STORAGE_NORMALIZED_INT16) ? 32767.0 : 127.0);
+        const float scale = ((maxMagnitude > 0.0) ? (maxMagnitude / maxInteger) : 0.0);
+        m_normalizedRowScales[iRow] = scale;
+        for (int32_t i = 0; i < m_numberOfTimePoints; i++) {
+            const float value = ((scale > 0.0) ? std::floor(data[i] / scale + 0.5f) : 0.0f);
+            if (m_rowStorage == ROW_STORAGE_NORMALIZED_INT16) {
+                m_normalizedInt16Rows[rowStart + i] = static_cast<int16_t>(value);
+            }
+            else {
+                m_normalizedInt8Rows[rowStart + i] = static_cast<int8_t>(value);
+            }
+        }
+    }
+}
+
+/**
+ * Demean data and scale it to unit length.
+ *
+ * @param data
+ *     Data that is normalized.
+ * @param dataLength
+ *     Number of items in data.
+ * @param normalizedOut
+ *     Output with normalized data, may be the same as data.  Set to
+ *     zeros if the data is constant or contains non-finite values.
+ * @return
+ *     True if the data could be normalized.
+ */
+bool
+CiftiConnectivityMatrixDenseDynamicFile::normalizeData(const float* data,
+                                                       const int32_t dataLength,
+                                                       float* normalizedOut) const
+{
+    double sum = 0.0;
+    for (int32_t i = 0; i < dataLength; i++) {
+        sum += data[i];
+    }
+    const float mean = sum / dataLength;
+    
+    double sumSquared = 0.0;
+    for (int32_t i = 0; i < dataLength; i++) {
+        const float d = data[i] - mean;
+        normalizedOut[i] = d;
+        sumSquared += (d * d);
+    }
+    
+    const double length = std::sqrt(sumSquared);
+    if ((length > 0.0)
+        && std::isfinite(length)) {
+        const float invLength = 1.0 / length;
+        for (int32_t i = 0; i < dataLength; i++) {
+            normalizedOut[i] *= invLength;
+        }
+        return true;
+    }
+    
+    for (int32_t i = 0; i < dataLength; i++) {
+        normalizedOut[i] = 0.0;
+    }
+    return false;
+}
+
+/**
+ * Get a preloaded normalized row as floats.
+ *
+ * @param rowIndex
+ *     Index of the row.
+ * @param normalizedOut
+ *     Output with the normalized row.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::getNormalizedRow(const int32_t rowIndex,
+                                                          float* normalizedOut) const
+{
+    const int64_t rowStart = static_cast<int64_t>(rowIndex) * m_numberOfTimePoints;
+    switch (m_rowStorage) {
+        case ROW_STORAGE_PARENT_FILE:
+            CaretAssert(0);
+            break;
+        case ROW_STORAGE_NORMALIZED_FLOAT:
+            CaretAssertVectorIndex(m_normalizedFloatRows, rowStart + m_numberOfTimePoints - 1);
+            std::copy(m_normalizedFloatRows.begin() + rowStart,
+                      m_normalizedFloatRows.begin() + rowStart + m_numberOfTimePoints,
+                      normalizedOut);
+            break;
+        case ROW_STORAGE_NORMALIZED_INT16:
+        {
+            CaretAssertVectorIndex(m_normalizedInt16Rows, rowStart + m_numberOfTimePoints - 1);
+            const float scale = m_normalizedRowScales[rowIndex];
+            for (int32_t i = 0; i < m_numberOfTimePoints; i++) {
+                normalizedOut[i] = m_normalizedInt16Rows[rowStart + i] * scale;
+            }
+            break;
+        }
+        case ROW_STORAGE_NORMALIZED_INT8:
+        {
+            CaretAssertVectorIndex(m_normalizedInt8Rows, rowStart + m_numberOfTimePoints - 1);
+            const float scale = m_normalizedRowScales[rowIndex];
+            for (int32_t i = 0; i < m_numberOfTimePoints; i++) {
+                normalizedOut[i] = m_normalizedInt8Rows[rowStart + i] * scale;
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * Correlate normalized data with every preloaded row.  Since all
+ * of the rows are demeaned and unit length, the correlation is
+ * the dot product.
+ *
+ * @param normalizedData
+ *     Demeaned, unit length data with one element per time point.
+ * @param dataOut
+ *     Output with correlation to each row.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::correlateWithNormalizedRows(const float* normalizedData,
+                                                                     float* dataOut) const
+{
+    const int32_t numberOfPoints = m_numberOfTimePoints;
+    
+    /*
+     * TSC: hyperthreading means some cores end up "faster" than others, so "static" scheduling is generally not as fast
+     * there is almost no overhead to dynamic scheduling
+     */
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int32_t iRow = 0; iRow < m_numberOfBrainordinates; iRow++) {
+        const int64_t rowStart = static_cast<int64_t>(iRow) * numberOfPoints;
+        float coefficient = 0.0;
+        switch (m_rowStorage) {
+            case ROW_STORAGE_PARENT_FILE:
+                CaretAssert(0);
+                break;
+            case ROW_STORAGE_NORMALIZED_FLOAT:
+                coefficient = dsdot(normalizedData, &m_normalizedFloatRows[rowStart], numberOfPoints);
+                break;
+            case ROW_STORAGE_NORMALIZED_INT16:
+            {
+                const int16_t* row = &m_normalizedInt16Rows[rowStart];
+                float sum = 0.0;
+                for (int32_t i = 0; i < numberOfPoints; i++) {
+                    sum += normalizedData[i] * row[i];
+                }
+                coefficient = sum * m_normalizedRowScales[iRow];
+                break;
+            }
+            case ROW_STORAGE_NORMALIZED_INT8:
+            {
+                const int8_t* row = &m_normalizedInt8Rows[rowStart];
+                float sum = 0.0;
+                for (int32_t i = 0; i < numberOfPoints; i++) {
+                    sum += normalizedData[i] * row[i];
+                }
+                coefficient = sum * m_normalizedRowScales[iRow];
+                break;
+            }
+        }
+        dataOut[iRow] = coefficient;
+    }
+}
+
 /**
  * Compute data's mean and sum-squared
  *
@@ -488,14 +742,9 @@ CiftiConnectivityMatrixDenseDynamicFile::correlation(const std::vector<float>& d
     CaretAssertVectorIndex(m_rowData, otherRowIndex);
     const RowData& otherData = m_rowData[otherRowIndex];
     
-    if (m_cacheDataFlag) {
-        xySum = dsdot(&data[0], &otherData.m_data[0], numberOfPoints);
-    }
-    else {
-        std::vector<float> otherDataVector(m_numberOfTimePoints);
-        m_parentDataSeriesCiftiFile->getRow(&otherDataVector[0], otherRowIndex);
-        xySum = dsdot(&data[0], &otherDataVector[0], numberOfPoints);
-    }
+    std::vector<float> otherDataVector(m_numberOfTimePoints);
+    m_parentDataSeriesCiftiFile->getRow(&otherDataVector[0], otherRowIndex);
+    xySum = dsdot(&data[0], &otherDataVector[0], numberOfPoints);
     
     const double ssxy = xySum - (numFloat * mean * otherData.m_mean);
     
@@ -507,60 +756,6 @@ CiftiConnectivityMatrixDenseDynamicFile::correlation(const std::vector<float>& d
     return correlationCoefficient;
 }
 
-/**
- * Correlation from https://en.wikipedia.org/wiki/Pearson_product-moment_correlation_coefficient
- *
- * @param rowIndex
- *     Index of a row
- * @param otherRowIndex
- *     Index of another row
- * @param numberOfPoints
- *     Number of points int the two arrays
- * @return
- *     The correlation coefficient computed on the two arrays.
- */
-float
-CiftiConnectivityMatrixDenseDynamicFile::correlation(const int32_t rowIndex,
-                                                     const int32_t otherRowIndex,
-                                                     const int32_t numberOfPoints) const
-{
-    const double numFloat = numberOfPoints;
-    double xySum = 0.0;
-    
-    CaretAssertVectorIndex(m_rowData, rowIndex);
-    CaretAssertVectorIndex(m_rowData, otherRowIndex);
-    const RowData& data = m_rowData[rowIndex];
-    const RowData& otherData = m_rowData[otherRowIndex];
-    
-    if (m_cacheDataFlag) {
-        for (int i = 0; i < numberOfPoints; i++) {
-            CaretAssertVectorIndex(data.m_data, i);
-            CaretAssertVectorIndex(otherData.m_data, i);
-            xySum += data.m_data[i] * otherData.m_data[i];
-        }
-    }
-    else {
-        std::vector<float> dataVector(m_numberOfTimePoints);
-        std::vector<float> otherDataVector(m_numberOfTimePoints);
-        m_parentDataSeriesCiftiFile->getRow(&dataVector[0], rowIndex);
-        m_parentDataSeriesCiftiFile->getRow(&otherDataVector[0], otherRowIndex);
-        
-        for (int i = 0; i < numberOfPoints; i++) {
-            CaretAssertVectorIndex(dataVector, i);
-            CaretAssertVectorIndex(otherDataVector, i);
-            xySum += dataVector[i] * otherDataVector[i];
-        }
-    }
-    
-    const double ssxy = xySum - (numFloat * data.m_mean * otherData.m_mean);
-    
-    float correlationCoefficient = 0.0;
-    if ((data.m_sqrt_ssxx > 0.0)
-        && (otherData.m_sqrt_ssxx > 0.0)) {
-        correlationCoefficient = (ssxy / (data.m_sqrt_ssxx * otherData.m_sqrt_ssxx));
-    }
-    return correlationCoefficient;
-}
 /**
  * Save subclass data to the scene.
  *
@@ -31,6 +31,18 @@ namespace caret {
     class CiftiConnectivityMatrixDenseDynamicFile : public CiftiMappableConnectivityMatrixDataFile {
         
     public:
+        /** How the rows of the parent data-series are kept for computing correlation */
+        enum RowStorage {
+            /** Read rows from the parent file for every correlation */
+            ROW_STORAGE_PARENT_FILE,
+            /** Preload demeaned, unit-norm rows as floats */
+            ROW_STORAGE_NORMALIZED_FLOAT,
+            /** Preload demeaned, unit-norm rows as 16-bit integers with a per-row scale */
+            ROW_STORAGE_NORMALIZED_INT16,
+            /** Preload demeaned, unit-norm rows as 8-bit integers with a per-row scale */
+            ROW_STORAGE_NORMALIZED_INT8
+        };
+        
         CiftiConnectivityMatrixDenseDynamicFile(CiftiBrainordinateDataSeriesFile* parentDataSeriesFile);
         
         virtual ~CiftiConnectivityMatrixDenseDynamicFile();
@@ -49,6 +61,10 @@ namespace caret {
         
         const CiftiBrainordinateDataSeriesFile* getParentBrainordinateDataSeriesFile() const;
         
+        RowStorage getRowStorage() const;
+        
+        static void setDefaultRowStorage(const RowStorage rowStorage);
+        
     private:
         CiftiConnectivityMatrixDenseDynamicFile(const CiftiConnectivityMatrixDenseDynamicFile&);
 
@@ -78,15 +94,10 @@ namespace caret {
             
             ~RowData() { }
             
-            std::vector<float> m_data;
             float m_mean;
             float m_sqrt_ssxx;
         };
         
-        float correlation(const int32_t rowIndex,
-                          const int32_t otherRowIndex,
-                          const int32_t numberOfPoints) const;
-        
         float correlation(const std::vector<float>& data,
                           const float mean,
                           const float sumSquared,
@@ -95,6 +106,18 @@ namespace caret {
         
         void preComputeRowMeanAndSumSquared();
         
+        void loadNormalizedRows();
+        
+        bool normalizeData(const float* data,
+                           const int32_t dataLength,
+                           float* normalizedOut) const;
+        
+        void getNormalizedRow(const int32_t rowIndex,
+                              float* normalizedOut) const;
+        
+        void correlateWithNormalizedRows(const float* normalizedData,
+                                         float* dataOut) const;
+        
         void computeDataMeanAndSumSquared(const float* data,
                                           const int32_t dataLength,
                                           float& meanOut,
@@ -110,11 +133,23 @@ namespace caret {
         
         std::vector<RowData> m_rowData;
         
+        RowStorage m_rowStorage;
+        
+        /** Normalized rows, one after another, only the vector for m_rowStorage is used */
+        std::vector<float> m_normalizedFloatRows;
+        
+        std::vector<int16_t> m_normalizedInt16Rows;
+        
+        std::vector<int8_t> m_normalizedInt8Rows;
+        
+        /** Multiplier that converts an integer row back to unit norm */
+        std::vector<float> m_normalizedRowScales;
+        
         bool m_validDataFlag;
         
         bool m_enabledAsLayer;
         
-        const bool m_cacheDataFlag;
+        static RowStorage s_defaultRowStorage;
         
         CaretPointer<SceneClassAssistant> m_sceneAssistant;
         
@@ -124,6 +159,7 @@ namespace caret {
     
 #ifdef __CIFTI_CONNECTIVITY_MATRIX_DENSE_DYNAMIC_FILE_DECLARE__
     // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+    CiftiConnectivityMatrixDenseDynamicFile::RowStorage CiftiConnectivityMatrixDenseDynamicFile::s_defaultRowStorage = CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_INT16;
 #endif // __CIFTI_CONNECTIVITY_MATRIX_DENSE_DYNAMIC_FILE_DECLARE__
 
 } // namespace
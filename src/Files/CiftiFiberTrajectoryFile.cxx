@@ -19,6 +19,8 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
+#include <exception>
 #include <map>
 #include <set>
 
@@ -30,6 +32,7 @@
 
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CaretSparseFile.h"
 #include "CiftiFiberOrientationFile.h"
 #include "CiftiMappableDataFile.h"
@@ -1388,15 +1391,11 @@ CiftiFiberTrajectoryFile::loadRowsForAveraging(const std::vector<int64_t>& rowIn
     const CiftiXML& trajXML = m_sparseFile->getCiftiXML();
     const int64_t numberOfColumns = trajXML.getDimensionLength(CiftiXML::ALONG_ROW);
     
-    std::vector<FiberFractions> fiberFractionsForRowVector(numberOfColumns);
-    FiberFractions* fiberFractionsForRow = &fiberFractionsForRowVector[0];
-    
     const int64_t numberOfRowsToLoad = static_cast<int64_t>(rowIndices.size());
     if (numberOfRowsToLoad <= 0) {
         return false;
     }
     
-    const int32_t progressUpdateInterval = 1;
     EventProgressUpdate progressEvent(0,
                                       numberOfRowsToLoad,
                                       0,
@@ -1415,25 +1414,74 @@ CiftiFiberTrajectoryFile::loadRowsForAveraging(const std::vector<int64_t>& rowIn
     
     bool userCancelled = false;
     
-    for (int64_t iRow = 0; iRow < numberOfRowsToLoad; iRow++) {
-        const int64_t rowIndex = rowIndices[iRow];
+    /*
+     * Rows of a batch are read and decoded in parallel, then
+     * averaged in row order so the sums do not depend on threading.
+     */
+    const int64_t rowsPerBatch = 64;
+    std::vector<std::vector<int64_t> > batchFiberIndices(rowsPerBatch);
+    std::vector<std::vector<FiberFractions> > batchFiberFractions(rowsPerBatch);
+    FiberFractions zeroFiberFractions;
+    zeroFiberFractions.zero();
+    
+    for (int64_t batchStart = 0; batchStart < numberOfRowsToLoad; batchStart += rowsPerBatch) {
+        progressEvent.setProgress(batchStart,
+                                  "");
+        EventManager::get()->sendEvent(progressEvent.getPointer());
+        if (progressEvent.isCancelled()) {
+            userCancelled = true;
+            break;
+        }
         
-        if ((iRow % progressUpdateInterval) == 0) {
-            progressEvent.setProgress(iRow,
-                                      "");
-            EventManager::get()->sendEvent(progressEvent.getPointer());
-            if (progressEvent.isCancelled()) {
-                userCancelled = true;
-                break;
+        const int64_t batchEnd = std::min(batchStart + rowsPerBatch,
+                                          numberOfRowsToLoad);
+        /*
+         * No exception may leave the parallel region, so the first
+         * one is kept and rethrown after it.
+         */
+        std::exception_ptr firstException;
+#pragma omp CARET_PAR
+        {
+            CaretSparseFile::RowBuffer rowBuffer;
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int64_t iRow = batchStart; iRow < batchEnd; iRow++) {
+                try {
+                    m_sparseFile->getFibersRowSparse(rowIndices[iRow],
+                                                     batchFiberIndices[iRow - batchStart],
+                                                     batchFiberFractions[iRow - batchStart],
+                                                     rowBuffer);
+                }
+                catch (...) {
+#pragma omp critical
+                    {
+                        if ( ! firstException) {
+                            firstException = std::current_exception();
+                        }
+                    }
+                }
             }
         }
+        if (firstException) {
+            clearLoadedFiberOrientations();
+            std::rethrow_exception(firstException);
+        }
         
-        m_sparseFile->getFibersRow(rowIndex,
-                                   fiberFractionsForRow);
-        
-        for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
-            FiberOrientationTrajectory* fot = m_fiberOrientationTrajectories[iCol];
-            fot->addFiberFractionsForAveraging(fiberFractionsForRow[iCol]);
+        for (int64_t iRow = batchStart; iRow < batchEnd; iRow++) {
+            const std::vector<int64_t>& fiberIndices = batchFiberIndices[iRow - batchStart];
+            const std::vector<FiberFractions>& fiberFractions = batchFiberFractions[iRow - batchStart];
+            const int64_t numFibers = static_cast<int64_t>(fiberIndices.size());
+            int64_t iFiber = 0;
+            for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
+                FiberOrientationTrajectory* fot = m_fiberOrientationTrajectories[iCol];
+                if ((iFiber < numFibers)
+                    && (fiberIndices[iFiber] == iCol)) {
+                    fot->addFiberFractionsForAveraging(fiberFractions[iFiber]);
+                    iFiber++;
+                }
+                else {
+                    fot->addFiberFractionsForAveraging(zeroFiberFractions);
+                }
+            }
         }
     }
     
@@ -23,6 +23,7 @@
 #include "DataFileException.h"
 #include "FastStatistics.h"
 #include "GiftiDataArray.h"
+#include "GiftiException.h"
 #include "GiftiFile.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
@@ -153,12 +154,33 @@ GiftiTypeFile::readFile(const AString& filename)
     checkFileReadability(filename);
     
     this->setFileName(filename);
+    this->giftiFile->setDeferDataArrayReading(this->isDataArrayReadingDeferred());
     this->giftiFile->readFile(filename);
     this->validateDataArraysAfterReading();
     updateAfterFileDataChanges();
     this->clearModified();
 }
 
+/**
+ * Read any columns whose reading was deferred until first access.  Call
+ * this before accessing columns from inside a parallel region, so that
+ * errors are reported from this thread rather than terminating.
+ *
+ * @throws DataFileException
+ *    If there is an error reading the data.
+ */
+void
+GiftiTypeFile::readAllDeferredData() const
+{
+    try {
+        this->giftiFile->readAllDeferredDataArrays();
+    }
+    catch (const GiftiException& e) {
+        throw DataFileException(getFileName(),
+                                e.whatString());
+    }
+}
+
 /**
  * Write the file.
  *
@@ -56,6 +56,9 @@ namespace caret {
          */
         virtual void validateDataArraysAfterReading() = 0;
         
+        /** @return True if binary data arrays should be read when first accessed, instead of when the file is read */
+        virtual bool isDataArrayReadingDeferred() const { return false; }
+        
         void verifyDataArraysHaveSameNumberOfRows(const int32_t minimumSecondDimension,
                                                   const int32_t maximumSecondDimension) const;
 
@@ -72,6 +75,8 @@ namespace caret {
         
         virtual void writeFile(const AString& filename);
         
+        void readAllDeferredData() const;
+        
         virtual AString toString() const;
         
         virtual GiftiMetaData* getFileMetaData();
@@ -78,7 +78,6 @@ LabelFile::operator=(const LabelFile& sf)
  */
 LabelFile::~LabelFile()
 {
-    this->columnDataPointers.clear();
     delete m_classNameHierarchy;
 }
 
@@ -98,7 +97,6 @@ void
 LabelFile::clear()
 {
     GiftiTypeFile::clear();
-    this->columnDataPointers.clear();
     m_classNameHierarchy->clear();
 }
 
@@ -154,13 +152,12 @@ LabelFile::getGroupAndNameHierarchyModel() const
 void 
 LabelFile::validateDataArraysAfterReading()
 {
-    this->columnDataPointers.clear();
-
     this->initializeMembersLabelFile();
     
     this->verifyDataArraysHaveSameNumberOfRows(0, 0);
     
     bool haveWarned = false;
+    bool haveDeferredArrays = false;
     
     const int32_t numberOfDataArrays = this->giftiFile->getNumberOfDataArrays();
     for (int32_t i = 0; i < numberOfDataArrays; i++) {
@@ -174,19 +171,24 @@ LabelFile::validateDataArraysAfterReading()
                 haveWarned = true;
             }
         }
-        int32_t* tempPointer = thisArray->getDataPointerInt();
-        CaretAssert(tempPointer != NULL);
-        if (tempPointer == NULL) throw DataFileException(getFileName(),
-                                                         "failed to convert data array to int32.");//shouldn't happen, can probably be removed
-        this->columnDataPointers.push_back(tempPointer);
+        if (thisArray->isDataReadDeferred()) {
+            haveDeferredArrays = true;
+        }
     }
     
     validateKeysAndLabels();
     
-    m_classNameHierarchy->update(this,
-                                 true);
-    m_forceUpdateOfGroupAndNameHierarchy = false;
-    m_classNameHierarchy->setAllSelected(true);
+    /*
+     * The hierarchy needs the keys used in every map, so when maps
+     * are read on first access, leave it to be built when it is first
+     * requested (new items are selected by default).
+     */
+    if (haveDeferredArrays == false) {
+        m_classNameHierarchy->update(this,
+                                     true);
+        m_forceUpdateOfGroupAndNameHierarchy = false;
+        m_classNameHierarchy->setAllSelected(true);
+    }
     
     CaretLogFiner("CLASS/NAME Table for : "
                   + this->getFileNameNoPath()
@@ -373,11 +375,10 @@ int32_t
 LabelFile::getLabelKey(const int32_t nodeIndex,
                        const int32_t columnIndex) const
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
     CaretAssertMessage((nodeIndex >= 0) && (nodeIndex < this->getNumberOfNodes()), 
                        "Node Index out of range.");
     
-    return this->columnDataPointers[columnIndex][nodeIndex];
+    return this->getColumnDataPointer(columnIndex)[nodeIndex];
 }
 
 /**
@@ -395,10 +396,9 @@ LabelFile::setLabelKey(const int32_t nodeIndex,
                        const int32_t columnIndex,
                        const int32_t labelKey)
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
     CaretAssertMessage((nodeIndex >= 0) && (nodeIndex < this->getNumberOfNodes()), "Node Index out of range.");
     
-    this->columnDataPointers[columnIndex][nodeIndex] = labelKey;
+    this->getColumnDataPointer(columnIndex)[nodeIndex] = labelKey;
     this->setModified();
     m_forceUpdateOfGroupAndNameHierarchy = true;
 }
@@ -429,6 +429,19 @@ LabelFile::getNodeIndicesWithLabelKey(const int32_t columnIndex,
     }
 }
 
+/**
+ * @return Pointer to the keys in a column's GIFTI data array,
+ * reading the column if its reading was deferred.
+ *
+ * @param columnIndex
+ *     Column index.
+ */
+int32_t*
+LabelFile::getColumnDataPointer(const int32_t columnIndex) const
+{
+    return this->giftiFile->getDataArray(columnIndex)->getDataPointerInt();
+}
+
 /**
  * Get a pointer to the keys for a label file column.
  * @param columnIndex
@@ -439,14 +452,12 @@ LabelFile::getNodeIndicesWithLabelKey(const int32_t columnIndex,
 const int32_t* 
 LabelFile::getLabelKeyPointerForColumn(const int32_t columnIndex) const
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
-    return this->columnDataPointers[columnIndex];    
+    return this->getColumnDataPointer(columnIndex);
 }
 
 void LabelFile::setNumberOfNodesAndColumns(int32_t nodes, int32_t columns)
 {
     giftiFile->clearAndKeepMetadata();
-    columnDataPointers.clear();
 
     const int32_t unassignedKey = this->getLabelTable()->getUnassignedLabelKey();
     
@@ -455,7 +466,6 @@ void LabelFile::setNumberOfNodesAndColumns(int32_t nodes, int32_t columns)
     for (int32_t i = 0; i < columns; ++i)
     {
         giftiFile->addDataArray(new GiftiDataArray(NiftiIntentEnum::NIFTI_INTENT_LABEL, NiftiDataTypeEnum::NIFTI_TYPE_INT32, dimensions, GiftiEncodingEnum::GZIP_BASE64_BINARY));
-        columnDataPointers.push_back(giftiFile->getDataArray(i)->getDataPointerInt());
         int32_t* ptr = giftiFile->getDataArray(i)->getDataPointerInt();
         for (int32_t j = 0; j < nodes; j++) {
             ptr[j] = unassignedKey;
@@ -512,8 +522,6 @@ LabelFile::addMaps(const int32_t numberOfNodes,
                                                              dimensions, 
                                                              GiftiEncodingEnum::GZIP_BASE64_BINARY));
             const int32_t mapIndex = giftiFile->getNumberOfDataArrays() - 1;
-            this->columnDataPointers.push_back(giftiFile->getDataArray(mapIndex)->getDataPointerInt());
-            
             int32_t* ptr = giftiFile->getDataArray(mapIndex)->getDataPointerInt();
             for (int32_t j = 0; j < numberOfNodes; j++) {
                 ptr[j] = unassignedKey;
@@ -531,8 +539,7 @@ LabelFile::addMaps(const int32_t numberOfNodes,
 
 void LabelFile::setLabelKeysForColumn(const int32_t columnIndex, const int32_t* valuesIn)
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
-    int32_t* myColumn = columnDataPointers[columnIndex];
+    int32_t* myColumn = getColumnDataPointer(columnIndex);
     int numNodes = (int)getNumberOfNodes();
     for (int i = 0; i < numNodes; ++i)
     {
@@ -553,7 +560,7 @@ void LabelFile::setLabelKeysForColumn(const int32_t columnIndex, const int32_t*
 std::vector<int32_t>
 LabelFile::getUniqueLabelKeysUsedInMap(const int32_t mapIndex) const
 {
-    CaretAssertVectorIndex(this->columnDataPointers, mapIndex);
+    CaretAssert((mapIndex >= 0) && (mapIndex < this->getNumberOfMaps()));
     
     std::set<int32_t> uniqueKeys;
     const int32_t numNodes = getNumberOfNodes();
@@ -101,11 +101,13 @@ namespace caret {
         
         void initializeMembersLabelFile();
         
+        /** Label columns are read from the file when first accessed */
+        virtual bool isDataArrayReadingDeferred() const { return true; }
+        
     private:
         void validateKeysAndLabels() const;
         
-        /** Points to actual data in each Gifti Data Array */
-        std::vector<int32_t*> columnDataPointers;
+        int32_t* getColumnDataPointer(const int32_t columnIndex) const;
 
         /** Holds class and name hierarchy used for display selection */
         mutable GroupAndNameHierarchyModel* m_classNameHierarchy;
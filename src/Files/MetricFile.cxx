@@ -83,7 +83,6 @@ MetricFile::operator=(const MetricFile& sf)
  */
 MetricFile::~MetricFile()
 {
-    this->columnDataPointers.clear();
 }
 
 void MetricFile::writeFile(const AString& filename)
@@ -102,7 +101,6 @@ void
 MetricFile::clear()
 {
     GiftiTypeFile::clear();
-    this->columnDataPointers.clear();
 }
 
 /**
@@ -113,8 +111,6 @@ MetricFile::clear()
 void 
 MetricFile::validateDataArraysAfterReading()
 {
-    this->columnDataPointers.clear();
-
     this->initializeMembersMetricFile();
         
     this->verifyDataArraysHaveSameNumberOfRows(0, 0);
@@ -132,10 +128,8 @@ MetricFile::validateDataArraysAfterReading()
         }
         int numDims = gda->getNumberOfDimensions();
         std::vector<int64_t> dims = gda->getDimensions();
-        if (numDims == 1 || (numDims == 2 && dims[1] == 1))
+        if (!(numDims == 1 || (numDims == 2 && dims[1] == 1)))
         {
-            this->columnDataPointers.push_back(gda->getDataPointerFloat());
-        } else {
             if (numDims != 2)
             {
                 throw DataFileException(getFileName(),
@@ -164,7 +158,6 @@ MetricFile::validateDataArraysAfterReading()
                 }
                 newFile->addDataArray(tempArray);
                 newFile->setDataArrayName(indices[1], "#" + AString::number(indices[1] + 1));
-                columnDataPointers.push_back(tempArray->getDataPointerFloat());
             }
             delete giftiFile;//delete old 2D file
             giftiFile = newFile;//drop new 1D file in
@@ -249,11 +242,10 @@ float
 MetricFile::getValue(const int32_t nodeIndex,
                      const int32_t columnIndex) const
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
     CaretAssertMessage((nodeIndex >= 0) && (nodeIndex < this->getNumberOfNodes()), 
                        "Node Index out of range.");
     
-    return this->columnDataPointers[columnIndex][nodeIndex];
+    return this->getColumnDataPointer(columnIndex)[nodeIndex];
 }
 
 /**
@@ -271,30 +263,39 @@ MetricFile::setValue(const int32_t nodeIndex,
                      const int32_t columnIndex,
                      const float value)
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
     CaretAssertMessage((nodeIndex >= 0) && (nodeIndex < this->getNumberOfNodes()), "Node Index out of range.");
     
-    this->columnDataPointers[columnIndex][nodeIndex] = value;
+    this->getColumnDataPointer(columnIndex)[nodeIndex] = value;
     setModified();
 }
 
+/**
+ * @return Pointer to the data in a column's GIFTI data array,
+ * reading the column if its reading was deferred.
+ *
+ * @param columnIndex
+ *     Column index.
+ */
+float*
+MetricFile::getColumnDataPointer(const int32_t columnIndex) const
+{
+    return this->giftiFile->getDataArray(columnIndex)->getDataPointerFloat();
+}
+
 const float* 
 MetricFile::getValuePointerForColumn(const int32_t columnIndex) const
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
-    return this->columnDataPointers[columnIndex];
+    return this->getColumnDataPointer(columnIndex);
 }
 
 void MetricFile::setNumberOfNodesAndColumns(int32_t nodes, int32_t columns)
 {
     giftiFile->clearAndKeepMetadata();
-    columnDataPointers.clear();
     std::vector<int64_t> dimensions;
     dimensions.push_back(nodes);
     for (int32_t i = 0; i < columns; ++i)
     {
         giftiFile->addDataArray(new GiftiDataArray(NiftiIntentEnum::NIFTI_INTENT_NORMAL, NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32, dimensions, GiftiEncodingEnum::GZIP_BASE64_BINARY));
-        columnDataPointers.push_back(giftiFile->getDataArray(i)->getDataPointerFloat());
     }
     setModified();
 }
@@ -343,8 +344,6 @@ MetricFile::addMaps(const int32_t numberOfNodes,
                                                              NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32, 
                                                              dimensions, 
                                                              GiftiEncodingEnum::GZIP_BASE64_BINARY));
-            const int32_t mapIndex = giftiFile->getNumberOfDataArrays() - 1;
-            this->columnDataPointers.push_back(giftiFile->getDataArray(mapIndex)->getDataPointerFloat());
         }
     }
     else {
@@ -357,8 +356,7 @@ MetricFile::addMaps(const int32_t numberOfNodes,
 
 void MetricFile::setValuesForColumn(const int32_t columnIndex, const float* valuesIn)
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
-    float* myColumn = columnDataPointers[columnIndex];
+    float* myColumn = getColumnDataPointer(columnIndex);
     int numNodes = (int)getNumberOfNodes();
     for (int i = 0; i < numNodes; ++i)
     {
@@ -369,8 +367,7 @@ void MetricFile::setValuesForColumn(const int32_t columnIndex, const float* valu
 
 void MetricFile::initializeColumn(const int32_t columnIndex, const float& value)
 {
-    CaretAssertVectorIndex(this->columnDataPointers, columnIndex);
-    float* myColumn = columnDataPointers[columnIndex];
+    float* myColumn = getColumnDataPointer(columnIndex);
     int numNodes = (int)getNumberOfNodes();
     for (int i = 0; i < numNodes; ++i)
     {
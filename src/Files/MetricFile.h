@@ -117,9 +117,11 @@ namespace caret {
         virtual void restoreFileDataFromScene(const SceneAttributes* sceneAttributes,
                                               const SceneClass* sceneClass);
         
+        /** Metric columns are read from the file when first accessed */
+        virtual bool isDataArrayReadingDeferred() const { return true; }
+        
     private:
-        /** Points to actual data in each Gifti Data Array */
-        std::vector<float*> columnDataPointers;
+        float* getColumnDataPointer(const int32_t columnIndex) const;
 
         bool m_chartingEnabledForTab[BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS];
     };
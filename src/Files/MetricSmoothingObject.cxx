@@ -21,25 +21,162 @@
 #include "MetricSmoothingObject.h"
 
 #include "CaretAssert.h"
+#include "CaretBinaryFile.h"
 #include "CaretException.h"
+#include "CaretLogger.h"
 #include "SurfaceFile.h"
 #include "MetricFile.h"
 #include "GeodesicHelper.h"
 #include "TopologyHelper.h"
 #include "CaretOMP.h"
+#include "WeightsCacheFile.h"
+#include <QCryptographicHash>
+#include <QFile>
 #include <cmath>
 
 using namespace std;
 using namespace caret;
 
-MetricSmoothingObject::MetricSmoothingObject(const SurfaceFile* mySurf, const float& kernel, const MetricFile* myRoi, Method myMethod, const float* nodeAreas)
+namespace
+{
+    const char WEIGHTS_FILE_MAGIC[8] = { 'W', 'B', 'S', 'M', 'W', 'T', '0', '1' };
+}
+
+MetricSmoothingObject::MetricSmoothingObject(const SurfaceFile* mySurf, const float& kernel, const MetricFile* myRoi, Method myMethod, const float* nodeAreas,
+                                             const AString& weightsFileName)
 {
     CaretAssert(mySurf != NULL);
     if (myRoi != NULL && mySurf->getNumberOfNodes() != myRoi->getNumberOfNodes())
     {
         throw CaretException("roi number of nodes doesn't match the surface");
     }
+    if (weightsFileName == "")
+    {
+        precomputeWeights(mySurf, kernel, myRoi, myMethod, nodeAreas);
+        return;
+    }
+    AString key = computeWeightsKey(mySurf, kernel, myRoi, myMethod, nodeAreas);
+    if (readWeightsFile(weightsFileName, key, mySurf->getNumberOfNodes()))
+    {
+        return;
+    }
     precomputeWeights(mySurf, kernel, myRoi, myMethod, nodeAreas);
+    writeWeightsFile(weightsFileName, key);
+}
+
+AString MetricSmoothingObject::computeWeightsKey(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, Method myMethod, const float* nodeAreas)
+{//hash everything the weights depend on, so a stale weights file can't be picked up for different inputs
+    QCryptographicHash myHash(QCryptographicHash::Sha1);
+    int32_t numNodes = mySurf->getNumberOfNodes();
+    int32_t header[4] = { (int32_t)myMethod, numNodes, mySurf->getNumberOfTriangles(), 0 };
+    if (theRoi != NULL) header[3] |= 1;
+    if (nodeAreas != NULL) header[3] |= 2;//computed areas follow from the coordinates
+    WeightsCacheFile::addHashData(myHash, header, sizeof(header));
+    WeightsCacheFile::addHashData(myHash, &myKernel, sizeof(myKernel));
+    WeightsCacheFile::addHashData(myHash, mySurf->getCoordinateData(), sizeof(float) * 3 * (int64_t)numNodes);
+    for (int32_t j = 0; j < mySurf->getNumberOfTriangles(); ++j)
+    {
+        WeightsCacheFile::addHashData(myHash, mySurf->getTriangle(j), sizeof(int32_t) * 3);
+    }
+    if (theRoi != NULL)
+    {//weights only depend on where the roi is positive
+        const float* roiData = theRoi->getValuePointerForColumn(0);
+        vector<char> roiFlags(numNodes);
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            roiFlags[i] = (roiData[i] > 0.0f ? 1 : 0);
+        }
+        WeightsCacheFile::addHashData(myHash, roiFlags.data(), numNodes);
+    }
+    WeightsCacheFile::addHashData(myHash, nodeAreas, sizeof(float) * (int64_t)numNodes);
+    return AString(myHash.result().toHex());
+}
+
+bool MetricSmoothingObject::readWeightsFile(const AString& fileName, const AString& key, const int32_t& numNodes)
+{
+    if (!QFile::exists(fileName)) return false;
+    try
+    {//layout: cache header, number of nodes, total entries, then per-node counts, per-node weight sums, all node indices, all weights
+        CaretBinaryFile myFile(fileName);
+        bool headerOk = WeightsCacheFile::readHeader(myFile, WEIGHTS_FILE_MAGIC, key);
+        int64_t fileNodes, totalEntries;
+        myFile.read(&fileNodes, sizeof(fileNodes));
+        myFile.read(&totalEntries, sizeof(totalEntries));
+        if (!headerOk || fileNodes != numNodes || totalEntries < 0)
+        {
+            CaretLogInfo("smoothing weights file '" + fileName + "' does not match the current inputs, recomputing weights");
+            return false;
+        }
+        int64_t expectedSize = WeightsCacheFile::getHeaderSize(key) + 2 * sizeof(int64_t) + (int64_t)(sizeof(int32_t) + sizeof(float)) * (numNodes + totalEntries);
+        int64_t fileSize = myFile.size();//check the entry count against what is actually in the file before allocating anything from it
+        if (totalEntries > (int64_t)numNodes * numNodes || (fileSize >= 0 && fileSize != expectedSize))
+        {
+            CaretLogInfo("smoothing weights file '" + fileName + "' has the wrong size, recomputing weights");
+            return false;
+        }
+        vector<int32_t> counts(numNodes);
+        vector<float> sums(numNodes);
+        myFile.read(counts.data(), sizeof(int32_t) * numNodes);
+        myFile.read(sums.data(), sizeof(float) * numNodes);
+        int64_t countTotal = 0;
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            if (counts[i] < 0) throw CaretException("negative weight count");
+            countTotal += counts[i];
+        }
+        if (countTotal != totalEntries) throw CaretException("weight counts do not match total");
+        vector<WeightList> newLists(numNodes);
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            newLists[i].m_nodes.resize(counts[i]);
+            newLists[i].m_weightSum = sums[i];
+            if (counts[i] > 0) myFile.read(newLists[i].m_nodes.data(), sizeof(int32_t) * counts[i]);
+            for (int32_t j = 0; j < counts[i]; ++j)
+            {
+                if (newLists[i].m_nodes[j] < 0 || newLists[i].m_nodes[j] >= numNodes) throw CaretException("vertex index out of range");
+            }
+        }
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            newLists[i].m_weights.resize(counts[i]);
+            if (counts[i] > 0) myFile.read(newLists[i].m_weights.data(), sizeof(float) * counts[i]);
+        }
+        m_weightLists.swap(newLists);
+    } catch (CaretException& e) {
+        CaretLogWarning("failed to read smoothing weights file '" + fileName + "', recomputing weights: " + e.whatString());
+        return false;
+    }
+    return true;
+}
+
+void MetricSmoothingObject::writeWeightsFile(const AString& fileName, const AString& key) const
+{
+    int64_t numNodes = (int64_t)m_weightLists.size(), totalEntries = 0;
+    vector<int32_t> counts(numNodes);
+    vector<float> sums(numNodes);
+    for (int64_t i = 0; i < numNodes; ++i)
+    {
+        counts[i] = (int32_t)m_weightLists[i].m_nodes.size();
+        sums[i] = m_weightLists[i].m_weightSum;
+        totalEntries += counts[i];
+    }
+    WeightsCacheFile myFile(fileName, WEIGHTS_FILE_MAGIC, key);
+    myFile.write(&numNodes, sizeof(numNodes));
+    myFile.write(&totalEntries, sizeof(totalEntries));
+    myFile.write(counts.data(), sizeof(int32_t) * numNodes);
+    myFile.write(sums.data(), sizeof(float) * numNodes);
+    for (int64_t i = 0; i < numNodes; ++i)
+    {
+        myFile.write(m_weightLists[i].m_nodes.data(), sizeof(int32_t) * counts[i]);
+    }
+    for (int64_t i = 0; i < numNodes; ++i)
+    {
+        myFile.write(m_weightLists[i].m_weights.data(), sizeof(float) * counts[i]);
+    }
+    if (!myFile.finish(true))//the name is chosen by the user, so replace whatever was there
+    {
+        CaretLogWarning("failed to write smoothing weights file '" + fileName + "'");
+    }
 }
 
 void MetricSmoothingObject::smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* columnOut, const MetricFile* roi, const bool& fixZeros) const
@@ -374,7 +511,7 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussArea(const SurfaceFile* myS
         for (int32_t i = 0; i < numNodes; ++i)
         {
             myGeoHelp->getNodesToGeoDist(i, myGeoDist, tempList[i].m_nodes, distances, true);
-            const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
+            const CaretSpan<int32_t> tempneighbors = myTopoHelp->getNodeNeighbors(i);
             if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
             {
                 tempList[i].m_nodes = tempneighbors;
@@ -441,7 +578,7 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussArea(const SurfaceFile*
             if (myRoiColumn[i] > 0.0f)//we don't need to scatter from things outside the ROI
             {
                 myGeoHelp->getNodesToGeoDist(i, myGeoDist, nodes, distances, true);
-                const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
+                const CaretSpan<int32_t> tempneighbors = myTopoHelp->getNodeNeighbors(i);
                 if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
                 {
                     nodes = tempneighbors;
@@ -509,7 +646,7 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussEqual(const SurfaceFile* my
         for (int32_t i = 0; i < numNodes; ++i)
         {
             myGeoHelp->getNodesToGeoDist(i, myGeoDist, tempList[i].m_nodes, distances, true);
-            const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
+            const CaretSpan<int32_t> tempneighbors = myTopoHelp->getNodeNeighbors(i);
             if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
             {
                 tempList[i].m_nodes = tempneighbors;
@@ -576,7 +713,7 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussEqual(const SurfaceFile*
             if (myRoiColumn[i] > 0.0f)//we don't need to scatter from things outside the ROI
             {
                 myGeoHelp->getNodesToGeoDist(i, myGeoDist, nodes, distances, true);
-                const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
+                const CaretSpan<int32_t> tempneighbors = myTopoHelp->getNodeNeighbors(i);
                 if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
                 {
                     nodes = tempneighbors;
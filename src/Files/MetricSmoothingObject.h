@@ -29,6 +29,11 @@
 //
 //NOTE: for a static ROI, it is (sometimes much) more efficient to use it in the constructor, and provide no ROI (NULL) to the functions, using both an ROI in constructor and in method
 //      will result in the effective ROI being the logical AND of the two (intersection).
+//
+//NOTE: if a weights file name is given to the constructor, the precomputed weights are loaded from it when it was written for the same surface, kernel, method, ROI and areas,
+//      otherwise they are computed and written to it, so repeated smoothing runs can skip the precompute.  The file is in native byte order, it is a cache, not an interchange format.
+
+#include "AString.h"
 
 #include "stdint.h"
 #include "stddef.h"
@@ -48,7 +53,8 @@ namespace caret {
             GEO_GAUSS_EQUAL,
             GEO_GAUSS
         };
-        MetricSmoothingObject(const SurfaceFile* mySurf, const float& kernel, const MetricFile* myRoi = NULL, Method myMethod = GEO_GAUSS_AREA, const float* nodeAreas = NULL);
+        MetricSmoothingObject(const SurfaceFile* mySurf, const float& kernel, const MetricFile* myRoi = NULL, Method myMethod = GEO_GAUSS_AREA, const float* nodeAreas = NULL,
+                              const AString& weightsFileName = "");
         void smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* columnOut, const MetricFile* roi = NULL, const bool& fixZeros = false) const;
         void smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi = NULL, const int& whichRoiColumn = 0, const bool& fixZeros = false) const;
         void smoothMetric(const MetricFile* metricIn, MetricFile* metricOut, const MetricFile* roi = NULL, const bool& fixZeros = false) const;
@@ -69,6 +75,9 @@ namespace caret {
         void precomputeWeightsROIGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
         void precomputeWeightsGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
         void precomputeWeightsROIGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
+        static AString computeWeightsKey(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, Method myMethod, const float* nodeAreas);
+        bool readWeightsFile(const AString& fileName, const AString& key, const int32_t& numNodes);
+        void writeWeightsFile(const AString& fileName, const AString& key) const;
         MetricSmoothingObject();
     };
     
@@ -19,6 +19,7 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -38,6 +39,7 @@
 #include "GroupAndNameHierarchyItem.h"
 #include "Palette.h"
 #include "PaletteColorMapping.h"
+#include "PaletteScalarAndColor.h"
 #include "MathFunctions.h"
 
 using namespace caret;
@@ -197,6 +199,73 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
                              rgbaNegativeOne);
     const bool rgbaNegativeOneValid = (rgbaNegativeOne[3] > 0.0);
     
+    /*
+     * When there are many scalars and the output is bytes, look up
+     * the palette color from a table indexed by the quantized normalized
+     * value instead of searching the palette for every scalar.  The
+     * table's spacing is far below what is resolvable in a byte color
+     * and its end points are the exact -1.0 and 1.0 colors.  Small
+     * numbers of scalars are colored directly since building the table
+     * would take longer.  A palette that is not interpolated changes
+     * color in a step at each control point, and a quantized value near
+     * a step may land on the wrong side of it, so those palettes are
+     * always colored directly.  Interpolated palettes also have a step
+     * where a control point is "none", so values within one table
+     * entry of any control point are colored directly as well.
+     */
+    const int64_t lookupTableHalfSize = PALETTE_LOOKUP_TABLE_HALF_SIZE;
+    const int64_t lookupTableSize     = (lookupTableHalfSize * 2) + 1;
+    const bool useLookupTableFlag = ((colorDataType == COLOR_TYPE_UNSIGNED_BTYE)
+                                     && interpolateFlag
+                                     && (numberOfScalars > lookupTableSize));
+    std::vector<uint8_t> lookupTableRGBA;
+    std::vector<char> lookupNearControlPoint;
+    if (useLookupTableFlag) {
+        lookupTableRGBA.resize(lookupTableSize * 4);
+#pragma omp CARET_PARFOR
+        for (int64_t k = 0; k < lookupTableSize; k++) {
+            float rgba[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            if (k == 0) {
+                if (rgbaNegativeOneValid) {
+                    std::copy(rgbaNegativeOne, rgbaNegativeOne + 4, rgba);
+                }
+            }
+            else if (k == (lookupTableSize - 1)) {
+                if (rgbaPositiveOneValid) {
+                    std::copy(rgbaPositiveOne, rgbaPositiveOne + 4, rgba);
+                }
+            }
+            else {
+                const float normalValue = (static_cast<float>(k - lookupTableHalfSize)
+                                           / static_cast<float>(lookupTableHalfSize));
+                palette->getPaletteColor(normalValue,
+                                         true,
+                                         rgba);
+                if (rgba[3] <= 0.0f) {
+                    rgba[0] = 0.0f;
+                    rgba[1] = 0.0f;
+                    rgba[2] = 0.0f;
+                    rgba[3] = 0.0f;
+                }
+            }
+            const int64_t k4 = k * 4;
+            lookupTableRGBA[k4]   = rgba[0] * 255.0;
+            lookupTableRGBA[k4+1] = rgba[1] * 255.0;
+            lookupTableRGBA[k4+2] = rgba[2] * 255.0;
+            lookupTableRGBA[k4+3] = ((rgba[3] > 0.0f) ? (rgba[3] * 255.0) : 0);
+        }
+        lookupNearControlPoint.resize(lookupTableSize, 0);
+        const int32_t numControlPoints = palette->getNumberOfScalarsAndColors();
+        for (int32_t j = 0; j < numControlPoints; j++) {
+            const float position = (palette->getScalarAndColor(j)->getScalar() + 1.0f) * lookupTableHalfSize;
+            const int64_t firstEntry = std::max(static_cast<int64_t>(std::floor(position)) - 1, static_cast<int64_t>(0));
+            const int64_t lastEntry  = std::min(static_cast<int64_t>(std::ceil(position)) + 1, lookupTableSize - 1);
+            for (int64_t k = firstEntry; k <= lastEntry; k++) {
+                lookupNearControlPoint[k] = 1;
+            }
+        }
+    }
+    
     /*
      * Color all scalars.
      */
@@ -257,6 +326,82 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
             }
         }
         
+        /*
+         * Threshold Test
+         * Colors are still set when the threshold test fails, but
+         * alpha is set invalid unless a threshold failure color is used.
+         */
+        bool thresholdPassedFlag = false;
+        if (skipThresholdTesting) {
+            thresholdPassedFlag = true;
+        }
+        else if (showOutsideFlag) {
+            if (threshold > thresholdMaximum) {
+                thresholdPassedFlag = true;
+            }
+            else if (threshold < thresholdMinimum) {
+                thresholdPassedFlag = true;
+            }
+        }
+        else {
+            if ((threshold >= thresholdMinimum) &&
+                (threshold <= thresholdMaximum)) {
+                thresholdPassedFlag = true;
+            }
+        }
+        const float* thresholdFailureColor = NULL;
+        if (thresholdPassedFlag == false) {
+            if (showMappedThresholdFailuresInGreen) {
+                if (thresholdType == PaletteThresholdTypeEnum::THRESHOLD_TYPE_MAPPED) {
+                    if (threshold > 0.0f) {
+                        if ((threshold < thresholdMappedPositive) &&
+                            (threshold > thresholdMappedPositiveAverageArea)) {
+                            thresholdFailureColor = positiveThresholdGreenColor;
+                        }
+                    }
+                    else if (threshold < 0.0f) {
+                        if ((threshold > thresholdMappedNegative) &&
+                            (threshold < thresholdMappedNegativeAverageArea)) {
+                            thresholdFailureColor = negativeThresholdGreenColor;
+                        }
+                    }
+                }
+            }
+        }
+        
+        const float normalValue = normalizedValues[i];
+        
+        if (useLookupTableFlag) {
+            CaretAssertArrayIndex(rgbaUnsignedByte, numberOfScalars * 4, i*4+3);
+            int64_t lookupIndex = 0;
+            if (normalValue >= 1.0f) {
+                lookupIndex = lookupTableSize - 1;
+            }
+            else if (normalValue > -1.0f) {
+                lookupIndex = static_cast<int64_t>((normalValue + 1.0f) * lookupTableHalfSize + 0.5f);
+            }
+            CaretAssertVectorIndex(lookupNearControlPoint, lookupIndex);
+            if ( ! lookupNearControlPoint[lookupIndex]) {
+                if (thresholdFailureColor != NULL) {
+                    rgbaUnsignedByte[i4]   = thresholdFailureColor[0] * 255.0;
+                    rgbaUnsignedByte[i4+1] = thresholdFailureColor[1] * 255.0;
+                    rgbaUnsignedByte[i4+2] = thresholdFailureColor[2] * 255.0;
+                    rgbaUnsignedByte[i4+3] = thresholdFailureColor[3] * 255.0;
+                    continue;
+                }
+                CaretAssertVectorIndex(lookupTableRGBA, lookupIndex * 4 + 3);
+                const uint8_t* lookupRGBA = &lookupTableRGBA[lookupIndex * 4];
+                rgbaUnsignedByte[i4]   = lookupRGBA[0];
+                rgbaUnsignedByte[i4+1] = lookupRGBA[1];
+                rgbaUnsignedByte[i4+2] = lookupRGBA[2];
+                rgbaUnsignedByte[i4+3] = (thresholdPassedFlag ? lookupRGBA[3] : 0);
+                continue;
+            }
+            /*
+             * Near a control point, where the color may change in a step
+             */
+        }
+        
         /*
          * Temporary for rgba coloring now that past possible
          * continue statements
@@ -268,8 +413,6 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
              0.0
         };
         
-        const float normalValue = normalizedValues[i];
-        
         /*
          * RGBA colors have been mapped for extreme values
          */
@@ -305,52 +448,13 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
             }
         }
         
-        /*
-         * Threshold Test
-         * Threshold is done last so colors are still set
-         * but if threshold test fails, alpha is set invalid.
-         */
-        bool thresholdPassedFlag = false;
-        if (skipThresholdTesting) {
-            thresholdPassedFlag = true;
-        }
-        else if (showOutsideFlag) {
-            if (threshold > thresholdMaximum) {
-                thresholdPassedFlag = true;
-            }
-            else if (threshold < thresholdMinimum) {
-                thresholdPassedFlag = true;
-            }
-        }
-        else {
-            if ((threshold >= thresholdMinimum) &&
-                (threshold <= thresholdMaximum)) {
-                thresholdPassedFlag = true;
-            }
-        }
         if (thresholdPassedFlag == false) {
             rgbaOut[3] = 0.0;
-            if (showMappedThresholdFailuresInGreen) {
-                if (thresholdType == PaletteThresholdTypeEnum::THRESHOLD_TYPE_MAPPED) {
-                    if (threshold > 0.0f) {
-                        if ((threshold < thresholdMappedPositive) &&
-                            (threshold > thresholdMappedPositiveAverageArea)) {
-                            rgbaOut[0] = positiveThresholdGreenColor[0];
-                            rgbaOut[1] = positiveThresholdGreenColor[1];
-                            rgbaOut[2] = positiveThresholdGreenColor[2];
-                            rgbaOut[3] = positiveThresholdGreenColor[3];
-                        }
-                    }
-                    else if (threshold < 0.0f) {
-                        if ((threshold > thresholdMappedNegative) &&
-                            (threshold < thresholdMappedNegativeAverageArea)) {
-                            rgbaOut[0] = negativeThresholdGreenColor[0];
-                            rgbaOut[1] = negativeThresholdGreenColor[1];
-                            rgbaOut[2] = negativeThresholdGreenColor[2];
-                            rgbaOut[3] = negativeThresholdGreenColor[3];
-                        }
-                    }
-                }
+            if (thresholdFailureColor != NULL) {
+                rgbaOut[0] = thresholdFailureColor[0];
+                rgbaOut[1] = thresholdFailureColor[1];
+                rgbaOut[2] = thresholdFailureColor[2];
+                rgbaOut[3] = thresholdFailureColor[3];
             }
         }
 
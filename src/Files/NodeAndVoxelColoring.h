@@ -144,12 +144,16 @@ namespace caret {
         NodeAndVoxelColoring& operator=(const NodeAndVoxelColoring&);
 
         static const int32_t INVALID_TAB_INDEX;
+        
+        /** Number of palette lookup table entries on each side of zero */
+        static const int64_t PALETTE_LOOKUP_TABLE_HALF_SIZE;
     };
     
 #ifdef __NODE_AND_VOXEL_COLORING_DECLARE__
   // JWH 24 April 2015  const float NodeAndVoxelColoring::SMALL_POSITIVE =  0.00001;
   // JWH 24 April 2015  const float NodeAndVoxelColoring::SMALL_NEGATIVE = -0.00001;
     const int32_t NodeAndVoxelColoring::INVALID_TAB_INDEX = -1;
+    const int64_t NodeAndVoxelColoring::PALETTE_LOOKUP_TABLE_HALF_SIZE = 4096;
 #endif // __NODE_AND_VOXEL_COLORING_DECLARE__
 
 } // namespace
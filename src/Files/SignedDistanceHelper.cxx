@@ -45,129 +45,85 @@ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FO
 DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
-#include "BoundingBox.h"
-#include "CaretHeap.h"
 #include "SignedDistanceHelper.h"
+#include "CaretException.h"
+#include "CaretOMP.h"
+#include "MathFunctions.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
 #include <cmath>
+#include <limits>
 
 using namespace std;
 using namespace caret;
 
-float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding)
+float SignedDistanceHelper::closestTriangle(const float coord[3], ClosestPointInfo& bestInfo)
 {
-    CaretMutexLocker locked(&m_mutex);
-    CaretSimpleMinHeap<Oct<SignedDistanceHelperBase::TriVector>*, float> myHeap;
-    myHeap.push(m_base->m_indexRoot, m_base->m_indexRoot->distToPoint(coord));
-    ClosestPointInfo tempInfo, bestInfo;
-    float tempf = -1.0f, bestTriDist = -1.0f;
+    const BoundingVolumeHierarchy& myTree = m_base->m_tree;
+    ClosestPointInfo tempInfo;
+    float tempf = -1.0f, bestTriDist = -1.0f, bestTriDist2 = -1.0f;
     bool first = true;
-    int numChanged = 0;
-    while (!myHeap.isEmpty())
+    vector<pair<int32_t, float> > myStack;//depth first, nearer child on top so the bound shrinks quickly
+    myStack.reserve(64);
+    myStack.push_back(make_pair(0, myTree.getNode(0).distSquaredToPoint(coord)));
+    const vector<int32_t>& primOrder = myTree.getPrimitiveOrder();
+    while (!myStack.empty())
     {
-        Oct<SignedDistanceHelperBase::TriVector>* curOct = myHeap.pop(&tempf);
-        if (first || tempf < bestTriDist)
+        int32_t nodeIndex = myStack.back().first;
+        float nodeDist2 = myStack.back().second;
+        myStack.pop_back();
+        if (!first && nodeDist2 >= bestTriDist2) continue;
+        const BoundingVolumeHierarchy::Node& curNode = myTree.getNode(nodeIndex);
+        if (curNode.isLeaf())
         {
-            if (curOct->m_leaf)
+            int32_t end = curNode.m_start + curNode.m_count;
+            for (int32_t i = curNode.m_start; i < end; ++i)
             {
-                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                int numTris = (int)myVecRef.size();
-                for (int i = 0; i < numTris; ++i)
+                tempf = unsignedDistToTri(coord, primOrder[i], tempInfo);
+                if (first || tempf < bestTriDist)
                 {
-                    if (m_triMarked[myVecRef[i]] != 1)
-                    {
-                        m_triMarked[myVecRef[i]] = 1;
-                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                        tempf = unsignedDistToTri(coord, myVecRef[i], tempInfo);
-                        if (first || tempf < bestTriDist)
-                        {
-                            bestInfo = tempInfo;
-                            bestTriDist = tempf;
-                            first = false;
-                        }
-                    }
-                }
-            } else {
-                for (int ci = 0; ci < 2; ++ci)
-                {
-                    for (int cj = 0; cj < 2; ++cj)
-                    {
-                        for (int ck = 0; ck < 2; ++ck)
-                        {
-                            tempf = curOct->m_children[ci][cj][ck]->distToPoint(coord);
-                            if (first || tempf < bestTriDist)
-                            {
-                                myHeap.push(curOct->m_children[ci][cj][ck], tempf);
-                            }
-                        }
-                    }
+                    bestInfo = tempInfo;
+                    bestTriDist = tempf;
+                    bestTriDist2 = tempf * tempf;
+                    first = false;
                 }
             }
+        } else {
+            float dist1 = myTree.getNode(curNode.m_start).distSquaredToPoint(coord);
+            float dist2 = myTree.getNode(curNode.m_start + 1).distSquaredToPoint(coord);
+            int32_t nearChild = curNode.m_start, farChild = curNode.m_start + 1;
+            if (dist2 < dist1)
+            {
+                swap(nearChild, farChild);
+                swap(dist1, dist2);
+            }
+            if (first || dist2 < bestTriDist2) myStack.push_back(make_pair(farChild, dist2));
+            if (first || dist1 < bestTriDist2) myStack.push_back(make_pair(nearChild, dist1));
         }
     }
-    while (numChanged)
-    {
-        m_triMarked[m_triMarkChanged[--numChanged]] = 0;//need to do this before computeSign
-    }
+    return bestTriDist;
+}
+
+float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding)
+{
+    ClosestPointInfo bestInfo;
+    float bestTriDist = closestTriangle(coord, bestInfo);
     return bestTriDist * computeSign(coord, bestInfo, myWinding);
 }
 
-void SignedDistanceHelper::barycentricWeights(const float coord[3], BarycentricInfo& baryInfoOut)
+void SignedDistanceHelper::dist(const float* coordsIn, const int64_t& numCoords, float* distsOut, WindingLogic myWinding)
 {
-    CaretMutexLocker locked(&m_mutex);
-    CaretSimpleMinHeap<Oct<SignedDistanceHelperBase::TriVector>*, float> myHeap;
-    myHeap.push(m_base->m_indexRoot, m_base->m_indexRoot->distToPoint(coord));
-    ClosestPointInfo tempInfo, bestInfo;
-    float tempf = -1.0f, bestTriDist = -1.0f;
-    bool first = true;
-    int numChanged = 0;
-    while (!myHeap.isEmpty())
+#pragma omp CARET_PARFOR schedule(dynamic, 64)
+    for (int64_t i = 0; i < numCoords; ++i)
     {
-        Oct<SignedDistanceHelperBase::TriVector>* curOct = myHeap.pop(&tempf);
-        if (first || tempf < bestTriDist)
-        {
-            if (curOct->m_leaf)
-            {
-                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                int numTris = (int)myVecRef.size();
-                for (int i = 0; i < numTris; ++i)
-                {
-                    if (m_triMarked[myVecRef[i]] != 1)
-                    {
-                        m_triMarked[myVecRef[i]] = 1;
-                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                        tempf = unsignedDistToTri(coord, myVecRef[i], tempInfo);
-                        if (first || tempf < bestTriDist)
-                        {
-                            bestInfo = tempInfo;
-                            bestTriDist = tempf;
-                            first = false;
-                        }
-                    }
-                }
-            } else {
-                for (int ci = 0; ci < 2; ++ci)
-                {
-                    for (int cj = 0; cj < 2; ++cj)
-                    {
-                        for (int ck = 0; ck < 2; ++ck)
-                        {
-                            tempf = curOct->m_children[ci][cj][ck]->distToPoint(coord);
-                            if (first || tempf < bestTriDist)
-                            {
-                                myHeap.push(curOct->m_children[ci][cj][ck], tempf);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-    while (numChanged)
-    {
-        m_triMarked[m_triMarkChanged[--numChanged]] = 0;//clean up
+        distsOut[i] = dist(coordsIn + i * 3, myWinding);
     }
+}
+
+void SignedDistanceHelper::barycentricWeights(const float coord[3], BarycentricInfo& baryInfoOut)
+{
+    ClosestPointInfo bestInfo;
+    float bestTriDist = closestTriangle(coord, bestInfo);
     baryInfoOut.triangle = bestInfo.triangle;
     baryInfoOut.point = bestInfo.tempPoint;
     baryInfoOut.absDistance = bestTriDist;
@@ -252,68 +208,53 @@ int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper
         case NEGATIVE:
         case NONZERO:
             {
-                int numChanged = 0;
                 float positiveZ[3] = {0, 0, 1};
-                Vector3D point2 = point + positiveZ;
+                const BoundingVolumeHierarchy::Line upLine(coord, positiveZ);
                 int crossCount = 0;
-                vector<Oct<SignedDistanceHelperBase::TriVector>*> myStack;
-                myStack.push_back(m_base->m_indexRoot);
+                const BoundingVolumeHierarchy& myTree = m_base->m_tree;
+                const vector<int32_t>& primOrder = myTree.getPrimitiveOrder();
+                vector<int32_t> myStack;
+                myStack.push_back(0);
                 while (!myStack.empty())
                 {
-                    Oct<SignedDistanceHelperBase::TriVector>* curOct = myStack[myStack.size() - 1];
+                    const BoundingVolumeHierarchy::Node& curNode = myTree.getNode(myStack.back());
                     myStack.pop_back();
-                    if (curOct->m_leaf)
+                    if (curNode.isLeaf())
                     {
-                        vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                        int numTris = (int)myVecRef.size();
-                        for (int i = 0; i < numTris; ++i)
+                        int32_t end = curNode.m_start + curNode.m_count;
+                        for (int32_t i = curNode.m_start; i < end; ++i)
                         {
-                            if (m_triMarked[myVecRef[i]] != 1)
+                            const int32_t* myTileNodes = m_base->getTriangle(primOrder[i]);
+                            Vector3D verts[3];
+                            verts[0] = m_base->getCoordinate(myTileNodes[0]);
+                            verts[1] = m_base->getCoordinate(myTileNodes[1]);
+                            verts[2] = m_base->getCoordinate(myTileNodes[2]);
+                            Vector3D triNormal;
+                            MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
+                            float factor = triNormal[2];//equivalent to dot product with positiveZ
+                            if (factor != 0.0f)
                             {
-                                m_triMarked[myVecRef[i]] = 1;
-                                m_triMarkChanged[numChanged++] = myVecRef[i];
-                                const int32_t* myTileNodes = m_base->getTriangle(myVecRef[i]);
-                                Vector3D verts[3];
-                                verts[0] = m_base->getCoordinate(myTileNodes[0]);
-                                verts[1] = m_base->getCoordinate(myTileNodes[1]);
-                                verts[2] = m_base->getCoordinate(myTileNodes[2]);
-                                Vector3D triNormal;
-                                MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
-                                float factor = triNormal[2];//equivalent to dot product with positiveZ
-                                if (factor != 0.0f)
+                                if (triNormal.dot(verts[0] - point) / factor > 0.0f && pointInTri(verts, point, 0, 1))
                                 {
-                                    if (triNormal.dot(verts[0] - point) / factor > 0.0f && pointInTri(verts, point, 0, 1))
+                                    if (triNormal[2] < 0.0f)
                                     {
-                                        if (triNormal[2] < 0.0f)
-                                        {
-                                            ++crossCount;
-                                        } else {
-                                            --crossCount;
-                                        }
+                                        ++crossCount;
+                                    } else {
+                                        --crossCount;
                                     }
                                 }
                             }
                         }
                     } else {
-                        for (int ci = 0; ci < 2; ++ci)
+                        for (int32_t child = curNode.m_start; child < curNode.m_start + 2; ++child)
                         {
-                            for (int cj = 0; cj < 2; ++cj)
+                            if (myTree.getNode(child).lineIntersects(upLine, 0.0f, numeric_limits<float>::infinity()))
                             {
-                                for (int ck = 0; ck < 2; ++ck)
-                                {
-                                    if (curOct->m_children[ci][cj][ck]->rayIntersects(coord, point2))
-                                    {
-                                        myStack.push_back(curOct->m_children[ci][cj][ck]);
-                                    }
-                                }
+                                myStack.push_back(child);
                             }
                         }
                     }
                 }
-                while (numChanged)
-                {
-                    m_triMarked[m_triMarkChanged[--numChanged]] = 0;
-                }
                 switch (myWinding)
                 {
                     case EVEN_ODD:
@@ -339,8 +280,7 @@ int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper
                 case 0://node
                     {
                         int curSign = 0;
-                        int numChanged = 0;
-                        const vector<int>& myTiles = m_base->m_topoHelp->getNodeTiles(myInfo.node1);
+                        const CaretSpan<int32_t> myTiles = m_base->m_topoHelp->getNodeTiles(myInfo.node1);
                         bool first = true;
                         float bestNorm = 0;
                         Vector3D tempvec, tempvec2, bestCent;
@@ -382,78 +322,66 @@ int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper
                         {
                             midAxis = 2;
                         }
-                        vector<Oct<SignedDistanceHelperBase::TriVector>*> myStack;
-                        myStack.push_back(m_base->m_indexRoot);
+                        const BoundingVolumeHierarchy& myTree = m_base->m_tree;
+                        const vector<int32_t>& primOrder = myTree.getPrimitiveOrder();
+                        Vector3D segDirection = bestCent - point;//parameterize the segment to the range [0, 1]
+                        const BoundingVolumeHierarchy::Line segLine(coord, segDirection);
+                        vector<int32_t> myStack;
+                        myStack.push_back(0);
                         while (!myStack.empty())
                         {
-                            Oct<SignedDistanceHelperBase::TriVector>* curOct = myStack[myStack.size() - 1];
+                            const BoundingVolumeHierarchy::Node& curNode = myTree.getNode(myStack.back());
                             myStack.pop_back();
-                            if (curOct->m_leaf)
+                            if (curNode.isLeaf())
                             {
-                                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                                int numTris = (int)myVecRef.size();
-                                for (int i = 0; i < numTris; ++i)
+                                int32_t end = curNode.m_start + curNode.m_count;
+                                for (int32_t i = curNode.m_start; i < end; ++i)
                                 {
-                                    if (m_triMarked[myVecRef[i]] != 1)
+                                    const int32_t* myTileNodes = m_base->getTriangle(primOrder[i]);
+                                    Vector3D verts[3];
+                                    verts[0] = m_base->getCoordinate(myTileNodes[0]);
+                                    verts[1] = m_base->getCoordinate(myTileNodes[1]);
+                                    verts[2] = m_base->getCoordinate(myTileNodes[2]);
+                                    Vector3D triNormal;
+                                    MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
+                                    float factor = triNormal.dot(segNormal);
+                                    if (factor == 0.0f)
                                     {
-                                        m_triMarked[myVecRef[i]] = 1;
-                                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                                        const int32_t* myTileNodes = m_base->getTriangle(myVecRef[i]);
-                                        Vector3D verts[3];
-                                        verts[0] = m_base->getCoordinate(myTileNodes[0]);
-                                        verts[1] = m_base->getCoordinate(myTileNodes[1]);
-                                        verts[2] = m_base->getCoordinate(myTileNodes[2]);
-                                        Vector3D triNormal;
-                                        MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
-                                        float factor = triNormal.dot(segNormal);
-                                        if (factor == 0.0f)
-                                        {
-                                            continue;//skip triangles parallel to the line segment
-                                        }
-                                        float intersectDist = triNormal.dot(point - verts[0]) / factor;
-                                        if (intersectDist > 0.0f && intersectDist < bestDist)
+                                        continue;//skip triangles parallel to the line segment
+                                    }
+                                    float intersectDist = triNormal.dot(point - verts[0]) / factor;
+                                    if (intersectDist > 0.0f && intersectDist < bestDist)
+                                    {
+                                        Vector3D inPlane = point - intersectDist * segNormal;
+                                        if (pointInTri(verts, inPlane, majAxis, midAxis))
                                         {
-                                            Vector3D inPlane = point - intersectDist * segNormal;
-                                            if (pointInTri(verts, inPlane, majAxis, midAxis))
+                                            bestDist = intersectDist;
+                                            if (triNormal.dot(mySeg) > 0.0f)
                                             {
-                                                bestDist = intersectDist;
-                                                if (triNormal.dot(mySeg) > 0.0f)
-                                                {
-                                                    curSign = 1;
-                                                } else {
-                                                    curSign = -1;
-                                                }
+                                                curSign = 1;
+                                            } else {
+                                                curSign = -1;
                                             }
                                         }
                                     }
                                 }
                             } else {
-                                for (int ci = 0; ci < 2; ++ci)
+                                for (int32_t child = curNode.m_start; child < curNode.m_start + 2; ++child)
                                 {
-                                    for (int cj = 0; cj < 2; ++cj)
+                                    if (myTree.getNode(child).lineIntersects(segLine, 0.0f, 1.0f))
                                     {
-                                        for (int ck = 0; ck < 2; ++ck)
-                                        {
-                                            if (curOct->m_children[ci][cj][ck]->lineSegmentIntersects(coord, bestCent))
-                                            {
-                                                myStack.push_back(curOct->m_children[ci][cj][ck]);
-                                            }
-                                        }
+                                        myStack.push_back(child);
                                     }
                                 }
                             }
                         }
-                        while (numChanged)
-                        {
-                            m_triMarked[m_triMarkChanged[--numChanged]] = 0;
-                        }
                         return curSign;
                     }
                     break;
                 case 1://edge
                     {
                         const vector<TopologyEdgeInfo>& edgeInfo = m_base->m_topoHelp->getEdgeInfo();
-                        const vector<int>& edges = m_base->m_topoHelp->getNodeEdges(myInfo.node1);
+                        const CaretSpan<int32_t> edges = m_base->m_topoHelp->getNodeEdges(myInfo.node1);
                         int whichEdge = -1, numEdges = (int)edges.size();
                         for (int i = 0; i < numEdges; ++i)
                         {
@@ -713,24 +641,11 @@ float SignedDistanceHelper::unsignedDistToTri(const float coord[3], int32_t tria
 SignedDistanceHelper::SignedDistanceHelper(CaretPointer<SignedDistanceHelperBase> myBase)
 {
     m_base = myBase;
-    int32_t numTris = m_base->m_numTris;
-    m_triMarked = CaretArray<int>(numTris);
-    m_triMarkChanged = CaretArray<int>(numTris);
-    for (int32_t i = 0; i < numTris; ++i)
-    {
-        m_triMarked[i] = 0;
-    }
 }
 
 SignedDistanceHelperBase::SignedDistanceHelperBase(const SurfaceFile* mySurf)
 {
     m_topoHelp = mySurf->getTopologyHelper();
-    const float* myBB = mySurf->getBoundingBox()->getBounds();
-    Vector3D minCoord, maxCoord;
-    minCoord[0] = myBB[0]; maxCoord[0] = myBB[1];
-    minCoord[1] = myBB[2]; maxCoord[1] = myBB[3];
-    minCoord[2] = myBB[4]; maxCoord[2] = myBB[5];
-    m_indexRoot.grabNew(new Oct<TriVector>(minCoord, maxCoord));
     const float* myCoordData = mySurf->getCoordinateData();
     m_numNodes = mySurf->getNumberOfNodes();
     int32_t numNodes3 = m_numNodes * 3;
@@ -740,7 +655,12 @@ SignedDistanceHelperBase::SignedDistanceHelperBase(const SurfaceFile* mySurf)
         m_coordList[i] = myCoordData[i];
     }
     m_numTris = mySurf->getNumberOfTriangles();
+    if (m_numTris < 1)
+    {
+        throw CaretException("cannot compute distances to a surface with no triangles");
+    }
     m_triangleList.resize(m_numTris * 3);
+    vector<float> minCoords(m_numTris * 3), maxCoords(m_numTris * 3);
     for (int32_t i = 0; i < m_numTris; ++i)
     {
         int32_t i3 = i * 3;
@@ -748,106 +668,22 @@ SignedDistanceHelperBase::SignedDistanceHelperBase(const SurfaceFile* mySurf)
         m_triangleList[i3] = thisTri[0];
         m_triangleList[i3 + 1] = thisTri[1];
         m_triangleList[i3 + 2] = thisTri[2];
-        maxCoord = minCoord = myCoordData + thisTri[0] * 3;//set both to the coordinates of the first node in the triangle
-        for (int j = 1; j < 3; ++j)
+        for (int j = 0; j < 3; ++j)
         {
-            int32_t thisNode3 = thisTri[j] * 3;
-            if (myCoordData[thisNode3] < minCoord[0]) minCoord[0] = myCoordData[thisNode3];
-            if (myCoordData[thisNode3 + 1] < minCoord[1]) minCoord[1] = myCoordData[thisNode3 + 1];
-            if (myCoordData[thisNode3 + 2] < minCoord[2]) minCoord[2] = myCoordData[thisNode3 + 2];
-            if (myCoordData[thisNode3] > maxCoord[0]) maxCoord[0] = myCoordData[thisNode3];
-            if (myCoordData[thisNode3 + 1] > maxCoord[1]) maxCoord[1] = myCoordData[thisNode3 + 1];
-            if (myCoordData[thisNode3 + 2] > maxCoord[2]) maxCoord[2] = myCoordData[thisNode3 + 2];
+            minCoords[i3 + j] = myCoordData[thisTri[0] * 3 + j];
+            maxCoords[i3 + j] = minCoords[i3 + j];
         }
-        addTriangle(m_indexRoot, i, minCoord, maxCoord);//use bounding box for now as an easy test to capture any chance of the triangle intersecting the Oct
-    }
-}
-
-void SignedDistanceHelperBase::addTriangle(Oct<TriVector>* thisOct, int32_t triangle, float minCoord[3], float maxCoord[3])
-{
-    if (thisOct->m_leaf)
-    {
-        thisOct->m_data.m_triList->push_back(triangle);
-        int numTris = (int)thisOct->m_data.m_triList->size();
-        if (numTris >= NUM_TRIS_TO_TEST && numTris % NUM_TRIS_TEST_INCR == NUM_TRIS_TO_TEST % NUM_TRIS_TEST_INCR)//the second modulus should const out
+        for (int k = 1; k < 3; ++k)
         {
-            Vector3D tempMinCoord, tempMaxCoord;
-            const float* myCoordData = m_coordList.data();
-            int totalSize = 0;
-            int numSplit = 0;
-            for (int i = 0; i < numTris; ++i)//gather data on how it would end up splitting
+            int32_t thisNode3 = thisTri[k] * 3;
+            for (int j = 0; j < 3; ++j)
             {
-                const int32_t* tempTri = getTriangle((*(thisOct->m_data.m_triList))[i]);
-                tempMaxCoord = tempMinCoord = myCoordData + tempTri[0] * 3;//set both to the coordinates of the first node in the triangle
-                for (int j = 1; j < 3; ++j)
-                {
-                    int32_t thisNode3 = tempTri[j] * 3;
-                    if (myCoordData[thisNode3] < tempMinCoord[0]) tempMinCoord[0] = myCoordData[thisNode3];
-                    if (myCoordData[thisNode3 + 1] < tempMinCoord[1]) tempMinCoord[1] = myCoordData[thisNode3 + 1];
-                    if (myCoordData[thisNode3 + 2] < tempMinCoord[2]) tempMinCoord[2] = myCoordData[thisNode3 + 2];
-                    if (myCoordData[thisNode3] > tempMaxCoord[0]) tempMaxCoord[0] = myCoordData[thisNode3];
-                    if (myCoordData[thisNode3 + 1] > tempMaxCoord[1]) tempMaxCoord[1] = myCoordData[thisNode3 + 1];
-                    if (myCoordData[thisNode3 + 2] > tempMaxCoord[2]) tempMaxCoord[2] = myCoordData[thisNode3 + 2];
-                }
-                int minOct[3], maxOct[3];
-                thisOct->containingChild(tempMinCoord, minOct);
-                thisOct->containingChild(tempMaxCoord, maxOct);
-                int splitSize = 8;
-                if (minOct[0] == maxOct[0]) splitSize >>= 1;
-                if (minOct[1] == maxOct[1]) splitSize >>= 1;
-                if (minOct[2] == maxOct[2]) splitSize >>= 1;
-                totalSize += splitSize;
-                if (splitSize != 8) ++numSplit;
-            }
-            if (numSplit > 0 && totalSize < 3.0f * numTris)//don't split if all triangles end up in all child octs, and try to balance speedup with memory usage
-            {
-                thisOct->makeChildren();//do the split
-                for (int i = 0; i < numTris; ++i)//gather data on how it would end up splitting
-                {
-                    const int32_t* tempTri = getTriangle((*(thisOct->m_data.m_triList))[i]);
-                    tempMaxCoord = tempMinCoord = myCoordData + tempTri[0] * 3;//set both to the coordinates of the first node in the triangle
-                    for (int j = 1; j < 3; ++j)
-                    {
-                        int32_t thisNode3 = tempTri[j] * 3;
-                        if (myCoordData[thisNode3] < tempMinCoord[0]) tempMinCoord[0] = myCoordData[thisNode3];
-                        if (myCoordData[thisNode3 + 1] < tempMinCoord[1]) tempMinCoord[1] = myCoordData[thisNode3 + 1];
-                        if (myCoordData[thisNode3 + 2] < tempMinCoord[2]) tempMinCoord[2] = myCoordData[thisNode3 + 2];
-                        if (myCoordData[thisNode3] > tempMaxCoord[0]) tempMaxCoord[0] = myCoordData[thisNode3];
-                        if (myCoordData[thisNode3 + 1] > tempMaxCoord[1]) tempMaxCoord[1] = myCoordData[thisNode3 + 1];
-                        if (myCoordData[thisNode3 + 2] > tempMaxCoord[2]) tempMaxCoord[2] = myCoordData[thisNode3 + 2];
-                    }
-                    for (int ci = 0; ci < 2; ++ci)
-                    {
-                        for (int cj = 0; cj < 2; ++cj)
-                        {
-                            for (int ck = 0; ck < 2; ++ck)
-                            {
-                                if (thisOct->m_children[ci][cj][ck]->boundsOverlaps(tempMinCoord, tempMaxCoord))
-                                {
-                                    addTriangle(thisOct->m_children[ci][cj][ck], (*(thisOct->m_data.m_triList))[i], tempMinCoord, tempMaxCoord);
-                                }
-                            }
-                        }
-                    }
-                }
-                thisOct->m_data.freeData();//and free up some memory
-            }
-        }
-    } else {
-        for (int ci = 0; ci < 2; ++ci)
-        {
-            for (int cj = 0; cj < 2; ++cj)
-            {
-                for (int ck = 0; ck < 2; ++ck)
-                {
-                    if (thisOct->m_children[ci][cj][ck]->boundsOverlaps(minCoord, maxCoord))
-                    {
-                        addTriangle(thisOct->m_children[ci][cj][ck], triangle, minCoord, maxCoord);
-                    }
-                }
+                if (myCoordData[thisNode3 + j] < minCoords[i3 + j]) minCoords[i3 + j] = myCoordData[thisNode3 + j];
+                if (myCoordData[thisNode3 + j] > maxCoords[i3 + j]) maxCoords[i3 + j] = myCoordData[thisNode3 + j];
             }
         }
     }
+    m_tree.build(minCoords.data(), maxCoords.data(), m_numTris, NUM_TRIS_LEAF);
 }
 
 const float* SignedDistanceHelperBase::getCoordinate(const int32_t nodeIndex) const
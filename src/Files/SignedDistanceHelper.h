@@ -21,10 +21,9 @@
  */
 /*LICENSE_END*/
 
+#include "BoundingVolumeHierarchy.h"
 #include "Vector3D.h"
-#include "CaretMutex.h"
 #include "CaretPointer.h"
-#include "OctTree.h"
 #include <vector>
 
 namespace caret {
@@ -34,29 +33,13 @@ namespace caret {
     
     class SignedDistanceHelperBase
     {
-        struct TriVector
-        {//specifically so we can cleanly deallocate the vector from non-leaf nodes when they split
-            std::vector<int32_t>* m_triList;
-            TriVector() { m_triList = new std::vector<int32_t>(); }
-            ~TriVector() { freeData(); }
-            void freeData()
-            {
-                if (m_triList != NULL)
-                {
-                    delete m_triList;
-                    m_triList = NULL;
-                }
-            }
-        };
-        static const int NUM_TRIS_TO_TEST = 50;//test for whether to split leaf at this number
-        static const int NUM_TRIS_TEST_INCR = 50;//and again at further multiples of this
-        CaretPointer<Oct<TriVector> > m_indexRoot;
+        static const int NUM_TRIS_LEAF = 4;
+        BoundingVolumeHierarchy m_tree;//built on triangle bounding boxes, each triangle is in exactly one leaf
         int32_t m_numTris, m_numNodes;
         std::vector<float> m_coordList;//make a copy of what we need from SurfaceFile so that if the SurfaceFile gets destroyed, we don't crash
         std::vector<int32_t> m_triangleList;
         CaretPointer<TopologyHelper> m_topoHelp;
         SignedDistanceHelperBase();
-        void addTriangle(Oct<TriVector>* thisOct, int32_t triangle, float minCoord[3], float maxCoord[3]);
         const float* getCoordinate(const int32_t nodeIndex) const;//make these public? probably don't want them to be widely used, that is what SurfaceFile is for (but we don't want to store a SurfaceFile pointer)
         const int32_t* getTriangle(const int32_t tileIndex) const;
     public:
@@ -92,10 +75,7 @@ namespace caret {
             NORMALS
         };
     private:
-        CaretMutex m_mutex;
         CaretPointer<SignedDistanceHelperBase> m_base;
-        CaretArray<int> m_triMarked;
-        CaretArray<int> m_triMarkChanged;
         SignedDistanceHelper();
         struct ClosestPointInfo
         {
@@ -104,6 +84,7 @@ namespace caret {
             Vector3D tempPoint;
         };
         float unsignedDistToTri(const float coord[3], int32_t triangle, ClosestPointInfo& myInfo);
+        float closestTriangle(const float coord[3], ClosestPointInfo& bestInfo);//returns unsigned distance
         int computeSign(const float coord[3], ClosestPointInfo myInfo, WindingLogic myWinding);
         bool pointInTri(Vector3D verts[3], Vector3D inPlane, int majAxis, int midAxis);
     public:
@@ -112,6 +93,9 @@ namespace caret {
         ///return the signed distance value at the point
         float dist(const float coord[3], WindingLogic myWinding);
         
+        ///signed distance for many points, in parallel - the helper has no scratch state, so this is the same as calling dist() from multiple threads
+        void dist(const float* coordsIn, const int64_t& numCoords, float* distsOut, WindingLogic myWinding);
+        
         ///find the closest point ON the surface, and return information about it
         ///will never have negative barycentric weights, or a point outside the triangle
         void barycentricWeights(const float coordIn[3], BarycentricInfo& baryInfoOut);
@@ -527,6 +527,8 @@ SurfaceFile::initializeMembersSurfaceFile()
     m_geoHelperIndex = 0;
     m_topoHelperIndex = 0;
     m_normalsComputed = false;
+    m_geometryModificationCount = 0;
+    m_nodeColoringModificationCount = 0;
 }
 
 /**
@@ -598,6 +600,7 @@ SurfaceFile::computeNormals()
         return;
     }
     m_normalsComputed = true;
+    ++m_geometryModificationCount;
     int32_t numCoords = this->getNumberOfNodes();
     if (numCoords > 0) {
         this->normalVectors.resize(numCoords * 3);
@@ -668,7 +671,7 @@ std::vector<float> SurfaceFile::computeAverageNormals()
     {
         int i3 = i * 3;
         Vector3D accum;
-        const std::vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(i);
+        const CaretSpan<int32_t> neighbors = myTopoHelp->getNodeNeighbors(i);
         int numNeigh = (int)neighbors.size();
         for (int j = 0; j < numNeigh; ++j)
         {
@@ -879,6 +882,7 @@ CaretPointer<SignedDistanceHelper> SurfaceFile::getSignedDistanceHelper() const
 
 void SurfaceFile::invalidateHelpers()
 {
+    ++m_geometryModificationCount;
     if (m_geoBase != NULL)
     {
         CaretMutexLocker myLock(&m_geoHelperMutex);//make this function threadsafe
@@ -1018,6 +1022,9 @@ SurfaceFile::matchToAnatomicalSurface(const SurfaceFile* anatomicalSurfaceFile,
             std::copy_n(m_unmatchedCoordinates.begin(),
                         numXYZ,
                         this->coordinatePointer);
+            invalidateNormals();
+            invalidateHelpers();
+            computeNormals();
         }
         m_unmatchedCoordinates.clear();
     }
@@ -1201,6 +1208,8 @@ SurfaceFile::applyMatrix(const Matrix4x4& matrix)
         }
     }
     
+    invalidateNormals();
+    invalidateHelpers();//also bumps the geometry modification count, so the drawing buffers get the new coordinates
     computeNormals();
     
     setModified();
@@ -1549,12 +1558,33 @@ SurfaceFile::getNodesSpacingStatistics(FastStatistics& statsOut) const
 
 }
 
+/**
+ * @return A count that changes whenever the coordinates, triangles, or
+ * normal vectors of this surface change.
+ */
+int64_t
+SurfaceFile::getGeometryModificationCount() const
+{
+    return m_geometryModificationCount;
+}
+
+/**
+ * @return A count that changes whenever the node coloring for any
+ * browser tab is set or invalidated.
+ */
+int64_t
+SurfaceFile::getNodeColoringModificationCount() const
+{
+    return m_nodeColoringModificationCount;
+}
+
 /**
  * Invalidate surface coloring.
  */
 void
 SurfaceFile::invalidateNodeColoringForBrowserTabs()
 {
+    ++m_nodeColoringModificationCount;
     /*
      * Free memory since could have many tabs and many surfaces equals lots of memory
      */
@@ -1688,6 +1718,7 @@ SurfaceFile::setSurfaceNodeColoringRgbaForBrowserTab(const int32_t browserTabInd
                                             false);
     const int numberOfComponentsRGBA = this->getNumberOfNodes() * 4;
     std::vector<float>& rgba = this->surfaceNodeColoringForBrowserTabs[browserTabIndex];
+    ++m_nodeColoringModificationCount;
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
@@ -1735,6 +1766,7 @@ SurfaceFile::setSurfaceMontageNodeColoringRgbaForBrowserTab(const int32_t browse
                                                    false);
     const int numberOfComponentsRGBA = this->getNumberOfNodes() * 4;
     std::vector<float>& rgba = this->surfaceMontageNodeColoringForBrowserTabs[browserTabIndex];
+    ++m_nodeColoringModificationCount;
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
@@ -1782,6 +1814,7 @@ SurfaceFile::setWholeBrainNodeColoringRgbaForBrowserTab(const int32_t browserTab
                                                    false);
     const int numberOfComponentsRGBA = this->getNumberOfNodes() * 4;
     std::vector<float>& rgba = this->wholeBrainNodeColoringForBrowserTabs[browserTabIndex];
+    ++m_nodeColoringModificationCount;
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
@@ -1831,8 +1864,8 @@ bool SurfaceFile::hasNodeCorrespondence(const SurfaceFile& rhs) const
     CaretPointer<TopologyHelper> myHelp = getTopologyHelper(), rightHelp = rhs.getTopologyHelper();
     for (int i = 0; i < numNodes; ++i)
     {
-        const std::vector<int32_t>& myNeigh = myHelp->getNodeNeighbors(i);
-        const std::vector<int32_t>& rightNeigh = rightHelp->getNodeNeighbors(i);
+        const CaretSpan<int32_t> myNeigh = myHelp->getNodeNeighbors(i);
+        const CaretSpan<int32_t> rightNeigh = rightHelp->getNodeNeighbors(i);
         int mySize = (int)myNeigh.size();
         if (mySize != (int)rightNeigh.size()) return false;
         std::set<int32_t> myUsed;
@@ -186,6 +186,12 @@ namespace caret {
 
         void invalidateNormals();
         
+        ///changes whenever coordinates, triangles, or normal vectors change, for keeping copies such as OpenGL buffers current
+        int64_t getGeometryModificationCount() const;
+        
+        ///changes whenever node coloring for any tab is set or invalidated
+        int64_t getNodeColoringModificationCount() const;
+        
         void translateToCenterOfMass();
         
         void flipNormals();
@@ -273,6 +279,10 @@ namespace caret {
         
         bool m_normalsComputed;
         
+        int64_t m_geometryModificationCount;
+        
+        int64_t m_nodeColoringModificationCount;
+        
         bool m_skipSanityCheck;
 
         ///topology base for surface
@@ -26,13 +26,20 @@
 #include "SurfaceResamplingHelper.h"
 
 #include "CaretAssert.h"
+#include "CaretBinaryFile.h"
 #include "CaretException.h"
+#include "CaretLogger.h"
 #include "CaretOMP.h"
 #include "GeodesicHelper.h"
 #include "SignedDistanceHelper.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
 #include "Vector3D.h"
+#include "WeightsCacheFile.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
 
 #include <set>
 #include <map>
@@ -41,9 +48,19 @@ using namespace std;
 using namespace caret;
 
 SurfaceResamplingHelper::SurfaceResamplingHelper(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
-                                                 const float* currentAreas, const float* newAreas, const float* currentRoi)
+                                                 const float* currentAreas, const float* newAreas, const float* currentRoi, const AString& weightsCacheDir)
 {
     if (!checkSphere(currentSphere) || !checkSphere(newSphere)) throw CaretException("input surfaces to SurfaceResamplingHelper must be spheres");
+    AString cacheKey, cacheFileName;
+    if (!weightsCacheDir.isEmpty())
+    {
+        cacheKey = computeCacheKey(myMethod, currentSphere, newSphere, currentAreas, newAreas, currentRoi);
+        cacheFileName = QDir(weightsCacheDir).filePath(cacheKey + ".wbweights");
+        if (QFile::exists(cacheFileName) && readWeightsFile(cacheFileName, cacheKey, currentSphere->getNumberOfNodes(), newSphere->getNumberOfNodes()))
+        {
+            return;
+        }
+    }
     SurfaceFile currentSphereMod, newSphereMod;
     changeRadius(100.0f, currentSphere, &currentSphereMod);
     changeRadius(100.0f, newSphere, &newSphereMod);
@@ -58,6 +75,111 @@ SurfaceResamplingHelper::SurfaceResamplingHelper(const SurfaceResamplingMethodEn
             computeWeightsBarycentric(&currentSphereMod, &newSphereMod, currentRoi);
             break;
     }
+    if (!cacheFileName.isEmpty())
+    {
+        writeWeightsFile(cacheFileName, cacheKey);
+    }
+}
+
+namespace
+{
+    const char WEIGHTS_FILE_MAGIC[8] = { 'W', 'B', 'R', 'S', 'W', 'T', '0', '1' };
+}
+
+AString SurfaceResamplingHelper::computeCacheKey(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
+                                                 const float* currentAreas, const float* newAreas, const float* currentRoi)
+{//hash everything the weights depend on, so a stale cache file can't be picked up for different inputs
+    QCryptographicHash myHash(QCryptographicHash::Sha1);
+    int32_t header[6] = { (int32_t)myMethod, currentSphere->getNumberOfNodes(), currentSphere->getNumberOfTriangles(),
+                          newSphere->getNumberOfNodes(), newSphere->getNumberOfTriangles(), 0 };
+    if (currentAreas != NULL) header[5] |= 1;
+    if (newAreas != NULL) header[5] |= 2;
+    if (currentRoi != NULL) header[5] |= 4;
+    WeightsCacheFile::addHashData(myHash, header, sizeof(header));
+    const SurfaceFile* surfs[2] = { currentSphere, newSphere };
+    for (int i = 0; i < 2; ++i)
+    {
+        WeightsCacheFile::addHashData(myHash, surfs[i]->getCoordinateData(), sizeof(float) * 3 * (int64_t)surfs[i]->getNumberOfNodes());
+        for (int j = 0; j < surfs[i]->getNumberOfTriangles(); ++j)
+        {
+            WeightsCacheFile::addHashData(myHash, surfs[i]->getTriangle(j), sizeof(int32_t) * 3);
+        }
+    }
+    WeightsCacheFile::addHashData(myHash, currentAreas, sizeof(float) * (int64_t)currentSphere->getNumberOfNodes());
+    WeightsCacheFile::addHashData(myHash, newAreas, sizeof(float) * (int64_t)newSphere->getNumberOfNodes());
+    WeightsCacheFile::addHashData(myHash, currentRoi, sizeof(float) * (int64_t)currentSphere->getNumberOfNodes());
+    return AString(myHash.result().toHex());
+}
+
+bool SurfaceResamplingHelper::readWeightsFile(const AString& fileName, const AString& cacheKey, const int& numCurrentNodes, const int& numNewNodes)
+{//any problem with the file just means we compute the weights instead
+    try
+    {
+        CaretBinaryFile myFile(fileName);
+        bool headerOk = WeightsCacheFile::readHeader(myFile, WEIGHTS_FILE_MAGIC, cacheKey);
+        int64_t counts[2];
+        myFile.read(counts, sizeof(counts));
+        if (!headerOk || counts[0] != numNewNodes || counts[1] < 0)
+        {
+            CaretLogInfo("ignoring resampling weights file with mismatched header: " + fileName);
+            return false;
+        }
+        int64_t headerSize = WeightsCacheFile::getHeaderSize(cacheKey) + (int64_t)(sizeof(counts) + sizeof(int64_t) * (numNewNodes + 1));
+        int64_t fileSize = myFile.size();//check the element count against what is actually in the file before allocating anything from it
+        if (counts[1] > (int64_t)numNewNodes * numCurrentNodes || (fileSize >= 0 && fileSize != headerSize + (int64_t)sizeof(WeightElem) * counts[1]))
+        {
+            CaretLogInfo("ignoring resampling weights file with wrong size: " + fileName);
+            return false;
+        }
+        vector<int64_t> offsets(numNewNodes + 1);
+        myFile.read(offsets.data(), sizeof(int64_t) * offsets.size());
+        if (offsets[0] != 0 || offsets[numNewNodes] != counts[1]) return false;
+        for (int i = 0; i < numNewNodes; ++i)
+        {
+            if (offsets[i + 1] < offsets[i]) return false;
+        }
+        CaretArray<WeightElem> storage(counts[1]);
+        CaretArray<WeightElem*> weights(numNewNodes + 1);
+        if (counts[1] > 0) myFile.read(storage.getArray(), sizeof(WeightElem) * counts[1]);
+        for (int i = 0; i < numNewNodes; ++i)
+        {
+            weights[i] = storage + offsets[i];
+        }
+        weights[numNewNodes] = storage + counts[1];
+        for (int64_t i = 0; i < counts[1]; ++i)
+        {
+            if (storage[i].node < 0 || storage[i].node >= numCurrentNodes) return false;
+        }
+        m_storagechunk = storage;
+        m_weights = weights;
+        return true;
+    } catch (CaretException& e) {
+        CaretLogInfo("failed to read resampling weights file '" + fileName + "': " + e.whatString());
+    }
+    return false;
+}
+
+void SurfaceResamplingHelper::writeWeightsFile(const AString& fileName, const AString& cacheKey) const
+{
+    int numNewNodes = (int)m_weights.size() - 1;
+    int64_t numElems = m_weights[numNewNodes] - m_weights[0];
+    vector<int64_t> offsets(numNewNodes + 1);
+    for (int i = 0; i <= numNewNodes; ++i)
+    {
+        offsets[i] = m_weights[i] - m_weights[0];
+    }
+    int64_t counts[2] = { numNewNodes, numElems };
+    WeightsCacheFile cacheFile(fileName, WEIGHTS_FILE_MAGIC, cacheKey);
+    cacheFile.write(counts, sizeof(counts));
+    cacheFile.write(offsets.data(), sizeof(int64_t) * offsets.size());
+    if (numElems > 0)
+    {
+        cacheFile.write(m_weights[0], sizeof(WeightElem) * numElems);
+    }
+    if (!cacheFile.finish())//the file name is the key, so an existing file already has these weights
+    {
+        CaretLogWarning("failed to write resampling weights cache file '" + fileName + "'");
+    }
 }
 
 void SurfaceResamplingHelper::resampleNormal(const float* input, float* output, const float& invalidVal) const
@@ -259,7 +381,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
                 break;
             case BarycentricInfo::EDGE:
             {
-                const vector<int32_t>& cutEdges = cutTopoHelp->getNodeEdges(largestNode[i]);
+                const CaretSpan<int32_t> cutEdges = cutTopoHelp->getNodeEdges(largestNode[i]);
                 for (int j = 0; j < (int)cutEdges.size(); ++j)
                 {
                     const TopologyEdgeInfo& myInfo = cutEdgeInfo[cutEdges[j]];
@@ -299,7 +421,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
 #pragma omp CARET_FOR schedule(dynamic)
         for (int32_t i = 0; i < newNodes; ++i)
         {
-            const vector<int32_t>& neighbors = newTopoHelp->getNodeNeighbors(i);
+            const CaretSpan<int32_t> neighbors = newTopoHelp->getNodeNeighbors(i);
             if (isOnEdge[i])
             {
                 bool hasInteriorNeighbor = false;
@@ -321,7 +443,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
                         cutGeoHelp->getPathToNode(largestNode[i], largestNode[neighbors[j]], cutPath, cutPathDists);
                         if (cutPathDists.size() == 0 || cutPathDists.back() > 2.0f * closedPathDists.back())//maybe this cutoff should be tunable
                         {
-                            const vector<int32_t>& myTiles = newTopoHelp->getNodeTiles(i);//find tiles on new mesh that share this edge, remove them
+                            const CaretSpan<int32_t> myTiles = newTopoHelp->getNodeTiles(i);//find tiles on new mesh that share this edge, remove them
                             for (int k = 0; k < (int)myTiles.size(); ++k)
                             {
                                 const int32_t* thisTile = newSphere->getTriangle(myTiles[k]);
@@ -334,7 +456,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
                     }
                 } else {
                     nodeDisconnect[i] = 1;//disconnect it completely if it has no interior neighbors
-                    const vector<int32_t>& nodeTiles = newTopoHelp->getNodeTiles(i);
+                    const CaretSpan<int32_t> nodeTiles = newTopoHelp->getNodeTiles(i);
                     for (int j = 0; j < (int)nodeTiles.size(); ++j)
                     {
                         triRemove[nodeTiles[j]] = 1;
@@ -349,7 +471,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
                     cutGeoHelp->getPathToNode(largestNode[i], largestNode[neighbors[j]], cutPath, cutPathDists);//note: path length of zero means no connection
                     if (cutPathDists.size() == 0 || cutPathDists.back() > 2.0f * closedPathDists.back())//maybe this cutoff should be tunable
                     {
-                        const vector<int32_t>& myTiles = newTopoHelp->getNodeTiles(i);//find tiles on new mesh that share this edge, remove them
+                        const CaretSpan<int32_t> myTiles = newTopoHelp->getNodeTiles(i);//find tiles on new mesh that share this edge, remove them
                         for (int k = 0; k < (int)myTiles.size(); ++k)
                         {
                             const int32_t* thisTile = newSphere->getTriangle(myTiles[k]);
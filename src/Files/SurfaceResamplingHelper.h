@@ -21,6 +21,7 @@
  */
 /*LICENSE_END*/
 
+#include "AString.h"
 #include "CaretPointer.h"
 #include "SurfaceResamplingMethodEnum.h"
 
@@ -48,10 +49,15 @@ namespace caret {
         void computeWeightsBarycentric(const SurfaceFile* currentSphere, const SurfaceFile* newSphere, const float* currentRoi);
         static void makeBarycentricWeights(const SurfaceFile* from, const SurfaceFile* to, std::vector<std::map<int, float> >& weights, const float* currentRoi);
         void compactWeights(const std::vector<std::map<int, float> >& weights);
+        static AString computeCacheKey(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
+                                       const float* currentAreas, const float* newAreas, const float* currentRoi);
+        bool readWeightsFile(const AString& fileName, const AString& cacheKey, const int& numCurrentNodes, const int& numNewNodes);
+        void writeWeightsFile(const AString& fileName, const AString& cacheKey) const;
     public:
         SurfaceResamplingHelper() { }
+        ///if weightsCacheDir is not empty, weights are looked up in (and otherwise saved to) a file in that directory named by a hash of the inputs
         SurfaceResamplingHelper(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
-                                const float* currentAreas = NULL, const float* newAreas = NULL, const float* currentRoi = NULL);
+                                const float* currentAreas = NULL, const float* newAreas = NULL, const float* currentRoi = NULL, const AString& weightsCacheDir = "");
         ///resample real-valued data by means of weights
         void resampleNormal(const float* input, float* output, const float& invalidVal = 0.0f) const;
         ///resample 3D coordinate data by means of weights
@@ -30,60 +30,75 @@ TopologyHelperBase::TopologyHelperBase(const SurfaceFile* surfIn, bool sortFlag)
 {
     m_numNodes = surfIn->getNumberOfNodes();
     m_numTris = surfIn->getNumberOfTriangles();
-    m_nodeInfo.resize(m_numNodes);
     m_boundaryCount.resize(m_numNodes);
     m_tileInfo.resize(m_numTris);
     vector<TopologyEdgeInfo> tempEdgeInfo;
     tempEdgeInfo.reserve(m_numTris * 3);//worst case, to prevent reallocs, we will copy it over later to the exact right size
+    m_tileOffsets.resize(m_numNodes + 1, 0);
+    for (int32_t i = 0; i < m_numTris; ++i)//count tiles per node first, so everything can go into flat arrays instead of a vector per node
+    {
+        const int32_t* thisTri = surfIn->getTriangle(i);
+        ++m_tileOffsets[thisTri[0] + 1];
+        ++m_tileOffsets[thisTri[1] + 1];
+        ++m_tileOffsets[thisTri[2] + 1];
+    }
+    m_maxTiles = 0;
     for (int32_t i = 0; i < m_numNodes; ++i)
-    {//preallocate what should be enough size for most nodes on most surfaces, including freesurfer
-        m_nodeInfo[i].m_edges.reserve(8);
-        m_nodeInfo[i].m_neighbors.reserve(8);
-        m_nodeInfo[i].m_tiles.reserve(8);
-        m_nodeInfo[i].m_whichVertex.reserve(8);
+    {
+        if (m_tileOffsets[i + 1] > m_maxTiles) m_maxTiles = (int32_t)m_tileOffsets[i + 1];
+        m_tileOffsets[i + 1] += m_tileOffsets[i];
     }
+    m_tiles.resize(m_tileOffsets[m_numNodes]);
+    m_whichVertex.resize(m_tileOffsets[m_numNodes]);
+    vector<int64_t> tileFill(m_tileOffsets.begin(), m_tileOffsets.end() - 1);
     for (int32_t i = 0; i < m_numTris; ++i)
     {
         const int32_t* thisTri = surfIn->getTriangle(i);
-        m_nodeInfo[thisTri[0]].addTileInfo(i, 0);
-        m_nodeInfo[thisTri[1]].addTileInfo(i, 1);
-        m_nodeInfo[thisTri[2]].addTileInfo(i, 2);
+        for (int k = 0; k < 3; ++k)
+        {
+            int64_t& fillPos = tileFill[thisTri[k]];
+            m_tiles[fillPos] = i;
+            m_whichVertex[fillPos] = k;
+            ++fillPos;
+        }
     }//node tiles complete, now we can sweep over nodes instead of triangles, making it easier to build node info
+    //each tile can add at most 2 neighbors to a node, so reserve that many slots per node while building, then compact
+    m_neighborOffsets.resize(m_numNodes + 1);
+    for (int32_t i = 0; i <= m_numNodes; ++i)
+    {
+        m_neighborOffsets[i] = 2 * m_tileOffsets[i];
+    }
+    m_neighbors.resize(m_neighborOffsets[m_numNodes]);
+    m_edges.resize(m_neighborOffsets[m_numNodes]);
+    vector<int32_t> neighCounts(m_numNodes, 0);
     m_maxNeigh = -1;
-    m_maxTiles = -1;
     CaretArray<int32_t> scratch(m_numNodes, -1);//mark array for added neighbors
     for (int32_t i = 0; i < m_numNodes; ++i)
     {
-        vector<int32_t>& tileList = m_nodeInfo[i].m_tiles;
-        vector<int32_t>& vertexList = m_nodeInfo[i].m_whichVertex;
-        int neighTiles = (int)tileList.size();
-        if (neighTiles > m_maxTiles)
-        {
-            m_maxTiles = neighTiles;
-        }
-        for (int j = 0; j < neighTiles; ++j)
+        int64_t tileStart = m_tileOffsets[i], tileEnd = m_tileOffsets[i + 1];
+        for (int64_t j = tileStart; j < tileEnd; ++j)
         {
-            int32_t myTile = tileList[j];
+            int32_t myTile = m_tiles[j];
             const int32_t* thisTri = surfIn->getTriangle(myTile);
-            int32_t myVert = vertexList[j];
+            int32_t myVert = m_whichVertex[j];
             switch (myVert)
             {
                 case 0:
-                    if (thisTri[1] > i) processTileNeighbor(tempEdgeInfo, scratch, i, thisTri[1], thisTri[2], myTile, 0, false);//boolean signifies if root, neighbor is same ordering as the cycle of tile nodes
-                    if (thisTri[2] > i) processTileNeighbor(tempEdgeInfo, scratch, i, thisTri[2], thisTri[1], myTile, 2, true);
+                    if (thisTri[1] > i) processTileNeighbor(tempEdgeInfo, scratch, neighCounts, i, thisTri[1], thisTri[2], myTile, 0, false);//boolean signifies if root, neighbor is same ordering as the cycle of tile nodes
+                    if (thisTri[2] > i) processTileNeighbor(tempEdgeInfo, scratch, neighCounts, i, thisTri[2], thisTri[1], myTile, 2, true);
                     break;//the if statement is a trick: processTileNeighbor adds neighbor to both nodes, so by checking that root is less, it does every edge exactly once
                 case 1://this allows edge info building in a linear pass
-                    if (thisTri[2] > i) processTileNeighbor(tempEdgeInfo, scratch, i, thisTri[2], thisTri[0], myTile, 1, false);
-                    if (thisTri[0] > i) processTileNeighbor(tempEdgeInfo, scratch, i, thisTri[0], thisTri[2], myTile, 0, true);
+                    if (thisTri[2] > i) processTileNeighbor(tempEdgeInfo, scratch, neighCounts, i, thisTri[2], thisTri[0], myTile, 1, false);
+                    if (thisTri[0] > i) processTileNeighbor(tempEdgeInfo, scratch, neighCounts, i, thisTri[0], thisTri[2], myTile, 0, true);
                     break;
                 case 2:
-                    if (thisTri[0] > i) processTileNeighbor(tempEdgeInfo, scratch, i, thisTri[0], thisTri[1], myTile, 2, false);
-                    if (thisTri[1] > i) processTileNeighbor(tempEdgeInfo, scratch, i, thisTri[1], thisTri[0], myTile, 1, true);
+                    if (thisTri[0] > i) processTileNeighbor(tempEdgeInfo, scratch, neighCounts, i, thisTri[0], thisTri[1], myTile, 2, false);
+                    if (thisTri[1] > i) processTileNeighbor(tempEdgeInfo, scratch, neighCounts, i, thisTri[1], thisTri[0], myTile, 1, true);
             }
         }
-        vector<int32_t>& myNeighList = m_nodeInfo[i].m_neighbors;
-        vector<int32_t>& myEdgeList = m_nodeInfo[i].m_edges;
-        int numNeigh = (int)myNeighList.size();
+        const int32_t* myNeighList = m_neighbors.data() + m_neighborOffsets[i];
+        const int32_t* myEdgeList = m_edges.data() + m_neighborOffsets[i];
+        int numNeigh = neighCounts[i];
         if (numNeigh > m_maxNeigh)
         {
             m_maxNeigh = numNeigh;
@@ -95,13 +110,30 @@ TopologyHelperBase::TopologyHelperBase(const SurfaceFile* surfIn, bool sortFlag)
             scratch[myNeighList[j]] = -1;//NOTE: -1 as sentinel because 0 is a valid edge number
         }
     }//neighbor, edge and tile info done
+    int64_t compacted = 0;//slide each node's neighbors left to remove the unused slots, destination is never past the source
+    for (int32_t i = 0; i < m_numNodes; ++i)
+    {
+        int64_t start = m_neighborOffsets[i];
+        m_neighborOffsets[i] = compacted;
+        for (int32_t j = 0; j < neighCounts[i]; ++j)
+        {
+            m_neighbors[compacted] = m_neighbors[start + j];
+            m_edges[compacted] = m_edges[start + j];
+            ++compacted;
+        }
+    }
+    m_neighborOffsets[m_numNodes] = compacted;
+    m_neighbors.resize(compacted);
+    m_edges.resize(compacted);
+    vector<int32_t>(m_neighbors).swap(m_neighbors);//release the extra capacity
+    vector<int32_t>(m_edges).swap(m_edges);
     m_edgeInfo = tempEdgeInfo;//copy edge info into member to get allocation correct
     CaretArray<int32_t> scratch2(m_numTris, -1);
     if (sortFlag)
     {
         for (int32_t i = 0; i < m_numNodes; ++i)
         {
-            sortNeighbors(surfIn, i, scratch, scratch2);//not a member function of node info object because I need m_edgeInfo and m_nodeInfo
+            sortNeighbors(surfIn, i, scratch, scratch2);//not a member function of node info object because I need m_edgeInfo and the node arrays
         }
         m_neighborsSorted = true;
     } else {
@@ -112,15 +144,23 @@ TopologyHelperBase::TopologyHelperBase(const SurfaceFile* surfIn, bool sortFlag)
 //1) check mark array
 //      a) if marked, find edge, add triangle to edge
 //      b) if unmarked, make edge from triangle, add neighbor, add reverse neighbor
-void TopologyHelperBase::processTileNeighbor(vector<TopologyEdgeInfo>& tempEdgeInfo, CaretArray<int32_t>& scratch, const int32_t& root, const int32_t& neighbor, const int32_t& thirdNode, const int32_t& tile, const int32_t& tileEdge, const bool& reversed)
+void TopologyHelperBase::processTileNeighbor(vector<TopologyEdgeInfo>& tempEdgeInfo, CaretArray<int32_t>& scratch, vector<int32_t>& neighCounts, const int32_t& root, const int32_t& neighbor, const int32_t& thirdNode, const int32_t& tile, const int32_t& tileEdge, const bool& reversed)
 {
     if (scratch[neighbor] == -1)
     {
         TopologyEdgeInfo tempInfo(root, neighbor, thirdNode, tile, tileEdge, reversed);
         int32_t myEdge = (int32_t)tempEdgeInfo.size();
         tempEdgeInfo.push_back(tempInfo);
-        m_nodeInfo[root].addNeighborInfo(neighbor, myEdge);
-        m_nodeInfo[neighbor].addNeighborInfo(root, myEdge);
+        int64_t rootPos = m_neighborOffsets[root] + neighCounts[root];
+        CaretAssert(rootPos < m_neighborOffsets[root + 1]);
+        m_neighbors[rootPos] = neighbor;
+        m_edges[rootPos] = myEdge;
+        ++neighCounts[root];
+        int64_t neighPos = m_neighborOffsets[neighbor] + neighCounts[neighbor];
+        CaretAssert(neighPos < m_neighborOffsets[neighbor + 1]);
+        m_neighbors[neighPos] = root;
+        m_edges[neighPos] = myEdge;
+        ++neighCounts[neighbor];
         scratch[neighbor] = myEdge;//use mark array both as "have this neighbor" AND "this is this neighbor's edge"
         m_tileInfo[tile].edges[tileEdge].edge = myEdge;
     } else {
@@ -132,12 +172,16 @@ void TopologyHelperBase::processTileNeighbor(vector<TopologyEdgeInfo>& tempEdgeI
 
 void TopologyHelperBase::sortNeighbors(const SurfaceFile* mySurf, const int32_t& node, CaretArray<int32_t>& nodeScratch, CaretArray<int32_t>& tileScratch)
 {
-    TopologyHelperBase::NodeInfo& myNodeInfo = m_nodeInfo[node];
-    if (myNodeInfo.m_neighbors.size() == 0) return;
-    int firstIndex = 0, numNeigh = (int)myNodeInfo.m_neighbors.size();
+    int32_t* myNeighbors = m_neighbors.data() + m_neighborOffsets[node];
+    int32_t* myEdges = m_edges.data() + m_neighborOffsets[node];
+    int32_t* myTiles = m_tiles.data() + m_tileOffsets[node];
+    int32_t* myWhichVertex = m_whichVertex.data() + m_tileOffsets[node];
+    int numNeigh = (int)(m_neighborOffsets[node + 1] - m_neighborOffsets[node]);
+    if (numNeigh == 0) return;
+    int firstIndex = 0;
     for (int i = 0; i < numNeigh; ++i)
     {
-        int32_t thisEdge = myNodeInfo.m_edges[i];
+        int32_t thisEdge = myEdges[i];
         if (m_edgeInfo[thisEdge].numTiles == 1)//there cannot be edge info with zero tiles, we are looking for the edge of a cut
         {
             firstIndex = i;
@@ -149,12 +193,12 @@ void TopologyHelperBase::sortNeighbors(const SurfaceFile* mySurf, const int32_t&
     }
     vector<int32_t> tempNeigh;
     vector<int32_t> tempEdges, tempTiles;//why not sort everything? verts get regenerated in place
-    int numTiles = myNodeInfo.m_tiles.size();
+    int numTiles = (int)(m_tileOffsets[node + 1] - m_tileOffsets[node]);
     tempNeigh.reserve(numNeigh);
     tempEdges.reserve(numNeigh);
     tempTiles.reserve(numTiles);
-    int32_t nextNode = myNodeInfo.m_neighbors[firstIndex];
-    int32_t nextEdge = myNodeInfo.m_edges[firstIndex];
+    int32_t nextNode = myNeighbors[firstIndex];
+    int32_t nextEdge = myEdges[firstIndex];
     int32_t nextTile;
     bool foundNext = true;
     int tileToUse = 0;
@@ -206,45 +250,52 @@ void TopologyHelperBase::sortNeighbors(const SurfaceFile* mySurf, const int32_t&
     } while (foundNext);
     for (int i = 0; i < numNeigh; ++i)//clean up scratch array, find any neighbors that are gap-separated or on third+ tile of an edge
     {
-        if (nodeScratch[myNodeInfo.m_neighbors[i]] == 0)
+        if (nodeScratch[myNeighbors[i]] == 0)
         {
-            nodeScratch[myNodeInfo.m_neighbors[i]] = -1;
+            nodeScratch[myNeighbors[i]] = -1;
         } else {
-            tempNeigh.push_back(myNodeInfo.m_neighbors[i]);
-            tempEdges.push_back(myNodeInfo.m_edges[i]);
+            tempNeigh.push_back(myNeighbors[i]);
+            tempEdges.push_back(myEdges[i]);
         }
     }
-    CaretAssert(tempNeigh.size() == myNodeInfo.m_neighbors.size());//check against original size
-    CaretAssert(tempEdges.size() == myNodeInfo.m_edges.size());
-    myNodeInfo.m_neighbors = tempNeigh;//copy over
-    myNodeInfo.m_edges = tempEdges;
+    CaretAssert((int)tempNeigh.size() == numNeigh);//check against original size
+    CaretAssert((int)tempEdges.size() == numNeigh);
+    for (int i = 0; i < numNeigh; ++i)//copy over
+    {
+        myNeighbors[i] = tempNeigh[i];
+        myEdges[i] = tempEdges[i];
+    }
     for (int i = 0; i < numTiles; ++i)//and find similar tiles
     {
-        if (tileScratch[myNodeInfo.m_tiles[i]] == 0)
+        if (tileScratch[myTiles[i]] == 0)
         {
-            tileScratch[myNodeInfo.m_tiles[i]] = -1;
+            tileScratch[myTiles[i]] = -1;
         } else {
-            tempTiles.push_back(myNodeInfo.m_tiles[i]);
+            tempTiles.push_back(myTiles[i]);
         }
     }
-    CaretAssert(tempTiles.size() == myNodeInfo.m_tiles.size());
-    myNodeInfo.m_tiles = tempTiles;
+    CaretAssert((int)tempTiles.size() == numTiles);
+    for (int i = 0; i < numTiles; ++i)
+    {
+        myTiles[i] = tempTiles[i];
+    }
     for (int i = 0; i < numTiles; ++i)//finally, regenerate verts
     {
-        const int32_t* myTri = mySurf->getTriangle(myNodeInfo.m_tiles[i]);
+        const int32_t* myTri = mySurf->getTriangle(myTiles[i]);
         if (myTri[0] == node)
         {
-            myNodeInfo.m_whichVertex[i] = 0;
+            myWhichVertex[i] = 0;
         } else if (myTri[1] == node) {
-            myNodeInfo.m_whichVertex[i] = 1;
+            myWhichVertex[i] = 1;
         } else {
-            myNodeInfo.m_whichVertex[i] = 2;
+            myWhichVertex[i] = 2;
         }
     }
 }
 
-TopologyHelper::TopologyHelper(CaretPointer<TopologyHelperBase> myBase) : m_base(myBase), m_nodeInfo(myBase->m_nodeInfo), m_edgeInfo(myBase->m_edgeInfo),
-                                                                                    m_tileInfo(myBase->m_tileInfo), m_boundaryCount(myBase->m_boundaryCount)
+TopologyHelper::TopologyHelper(CaretPointer<TopologyHelperBase> myBase) : m_base(myBase), m_neighborOffsets(myBase->m_neighborOffsets), m_neighbors(myBase->m_neighbors),
+                                                                                    m_edges(myBase->m_edges), m_tileOffsets(myBase->m_tileOffsets), m_tiles(myBase->m_tiles),
+                                                                                    m_edgeInfo(myBase->m_edgeInfo), m_tileInfo(myBase->m_tileInfo), m_boundaryCount(myBase->m_boundaryCount)
 {//pointer is by-value so that it makes a private copy that can't be pointed elsewhere during this constructor
     m_maxNeigh = m_base->m_maxNeigh;
     m_neighborsSorted = m_base->m_neighborsSorted;
@@ -263,46 +314,46 @@ int32_t TopologyHelper::getMaximumNumberOfNeighbors() const
 
 bool TopologyHelper::getNodeHasNeighbors(const int32_t nodeNum) const
 {
-    CaretAssertVectorIndex(m_nodeInfo, nodeNum);
-    return m_nodeInfo[nodeNum].m_neighbors.size() != 0;
+    CaretAssert(nodeNum >= 0 && nodeNum < m_numNodes);
+    return m_neighborOffsets[nodeNum + 1] != m_neighborOffsets[nodeNum];
 }
 
-const vector<int32_t>& TopologyHelper::getNodeNeighbors(const int32_t nodeNum) const
+CaretSpan<int32_t> TopologyHelper::getNodeNeighbors(const int32_t nodeNum) const
 {
-    CaretAssertVectorIndex(m_nodeInfo, nodeNum);
-    return m_nodeInfo[nodeNum].m_neighbors;
+    CaretAssert(nodeNum >= 0 && nodeNum < m_numNodes);
+    return CaretSpan<int32_t>(m_neighbors.data() + m_neighborOffsets[nodeNum], m_neighborOffsets[nodeNum + 1] - m_neighborOffsets[nodeNum]);
 }
 
 const int32_t* TopologyHelper::getNodeNeighbors(const int32_t nodeNum, int32_t& numNeighborsOut) const
 {
-    CaretAssertVectorIndex(m_nodeInfo, nodeNum);
-    numNeighborsOut = (int32_t)m_nodeInfo[nodeNum].m_neighbors.size();
-    return m_nodeInfo[nodeNum].m_neighbors.data();
+    CaretAssert(nodeNum >= 0 && nodeNum < m_numNodes);
+    numNeighborsOut = (int32_t)(m_neighborOffsets[nodeNum + 1] - m_neighborOffsets[nodeNum]);
+    return m_neighbors.data() + m_neighborOffsets[nodeNum];
 }
 
 int32_t TopologyHelper::getNodeNumberOfNeighbors(const int32_t nodeNum) const
 {
-    CaretAssertVectorIndex(m_nodeInfo, nodeNum);
-    return m_nodeInfo[nodeNum].m_neighbors.size();
+    CaretAssert(nodeNum >= 0 && nodeNum < m_numNodes);
+    return (int32_t)(m_neighborOffsets[nodeNum + 1] - m_neighborOffsets[nodeNum]);
 }
 
-const vector<int32_t>& TopologyHelper::getNodeTiles(const int32_t nodeNum) const
+CaretSpan<int32_t> TopologyHelper::getNodeTiles(const int32_t nodeNum) const
 {
-    CaretAssertVectorIndex(m_nodeInfo, nodeNum);
-    return m_nodeInfo[nodeNum].m_tiles;
+    CaretAssert(nodeNum >= 0 && nodeNum < m_numNodes);
+    return CaretSpan<int32_t>(m_tiles.data() + m_tileOffsets[nodeNum], m_tileOffsets[nodeNum + 1] - m_tileOffsets[nodeNum]);
 }
 
 const int32_t* TopologyHelper::getNodeTiles(const int32_t nodeNum, int32_t& numTilesOut) const
 {
-    CaretAssertVectorIndex(m_nodeInfo, nodeNum);
-    numTilesOut = (int32_t)m_nodeInfo[nodeNum].m_tiles.size();
-    return m_nodeInfo[nodeNum].m_tiles.data();
+    CaretAssert(nodeNum >= 0 && nodeNum < m_numNodes);
+    numTilesOut = (int32_t)(m_tileOffsets[nodeNum + 1] - m_tileOffsets[nodeNum]);
+    return m_tiles.data() + m_tileOffsets[nodeNum];
 }
 
-const vector<int32_t>& TopologyHelper::getNodeEdges(const int32_t nodeNum) const
+CaretSpan<int32_t> TopologyHelper::getNodeEdges(const int32_t nodeNum) const
 {
-    CaretAssertVectorIndex(m_nodeInfo, nodeNum);
-    return m_nodeInfo[nodeNum].m_edges;
+    CaretAssert(nodeNum >= 0 && nodeNum < m_numNodes);
+    return CaretSpan<int32_t>(m_edges.data() + m_neighborOffsets[nodeNum], m_neighborOffsets[nodeNum + 1] - m_neighborOffsets[nodeNum]);
 }
 
 void TopologyHelper::checkArrays() const
@@ -336,11 +387,10 @@ void TopologyHelper::getNodeNeighborsToDepth(const int32_t nodeNum, const int32_
     {
         for (int32_t i = 0; i < curNum; ++i)
         {
-            const vector<int32_t>& nodeNeighbors = m_nodeInfo[(*curlist)[i]].m_neighbors;
-            int numNeigh = (int)nodeNeighbors.size();
-            for (int j = 0; j < numNeigh; ++j)
+            int64_t neighEnd = m_neighborOffsets[(*curlist)[i] + 1];
+            for (int64_t j = m_neighborOffsets[(*curlist)[i]]; j < neighEnd; ++j)
             {
-                int32_t thisNode = nodeNeighbors[j];
+                int32_t thisNode = m_neighbors[j];
                 if (m_markNodes[thisNode] == 0)
                 {
                     m_markNodes[thisNode] = 1;
@@ -34,6 +34,7 @@
 #include "ElapsedTimer.h"
 #include "EventManager.h"
 #include "GiftiLabel.h"
+#include "GraphicsOpenGLVolumeTexture.h"
 #include "GroupAndNameHierarchyModel.h"
 #include "FastStatistics.h"
 #include "Histogram.h"
@@ -54,6 +55,52 @@ using namespace std;
 
 const float VolumeFile::INVALID_INTERP_VALUE = 0.0f;//we may want NaN or something more obvious
 bool VolumeFile::s_voxelColoringEnabled = true;
+bool VolumeFile::s_lazyFrameLoadingEnabled = true;
+
+namespace
+{
+    //reads individual frames of a volume file that was opened without reading its data
+    class NiftiFrameSource : public VolumeBase::FrameSource
+    {
+        CaretPointer<NiftiIO> m_io;
+        vector<int64_t> m_extraDims;
+        int m_fullDims;
+    public:
+        NiftiFrameSource(CaretPointer<NiftiIO> io, const vector<int64_t>& extraDims, const int& fullDims)
+        {
+            m_io = io;
+            m_extraDims = extraDims;
+            m_fullDims = fullDims;
+        }
+        
+        void loadFrame(float* frameOut, const int64_t& brickIndex, const int64_t& component)
+        {
+            CaretAssert(component == 0);//multi-component volumes aren't read lazily
+            vector<int64_t> extraInds(m_extraDims.size());
+            int64_t remaining = brickIndex;
+            for (int i = 0; i < (int)m_extraDims.size(); ++i)//same order as getBrickIndexFromNonSpatialIndexes
+            {
+                extraInds[i] = remaining % m_extraDims[i];
+                remaining /= m_extraDims[i];
+            }
+            m_io->readData(frameOut, m_fullDims, extraInds);
+        }
+    };
+}
+
+/**
+ * Static method that controls whether volumes with more than one frame
+ * have their data read when the file is read, or as each frame is
+ * first used.  The file is kept open in the latter case.
+ *
+ * @param enabled
+ *    New status for lazy loading.
+ */
+void
+VolumeFile::setLazyFrameLoading(const bool enabled)
+{
+    s_lazyFrameLoadingEnabled = enabled;
+}
 
 /**
  * Static method that sets the status of voxel coloring.  Coloring may take
@@ -101,9 +148,16 @@ VolumeFile::VolumeFile(const vector<int64_t>& dimensionsIn, const vector<vector<
 
 void VolumeFile::reinitialize(const vector<int64_t>& dimensionsIn, const vector<vector<float> >& indexToSpace, const int64_t numComponents,
                               SubvolumeAttributes::VolumeType whatType, const AbstractHeader* templateHeader)
+{
+    reinitialize(dimensionsIn, indexToSpace, numComponents, CaretPointer<VolumeBase::FrameSource>(), whatType, templateHeader);
+}
+
+void VolumeFile::reinitialize(const vector<int64_t>& dimensionsIn, const vector<vector<float> >& indexToSpace, const int64_t numComponents,
+                              CaretPointer<VolumeBase::FrameSource> frameSource,
+                              SubvolumeAttributes::VolumeType whatType, const AbstractHeader* templateHeader)
 {
     clear();
-    VolumeBase::reinitialize(dimensionsIn, indexToSpace, numComponents);
+    VolumeBase::reinitialize(dimensionsIn, indexToSpace, numComponents, frameSource);
     if (templateHeader != NULL) m_header.grabNew(templateHeader->clone());
     validateMembers();
     setType(whatType);
@@ -224,7 +278,8 @@ void VolumeFile::readFile(const AString& filename)
             fileToRead = filename;
         }
         checkFileReadability(fileToRead);
-        NiftiIO myIO;//begin nifti specific code - should this go somewhere else?
+        CaretPointer<NiftiIO> myIOPointer(new NiftiIO());//begin nifti specific code - should this go somewhere else?
+        NiftiIO& myIO = *myIOPointer;//pointer so that a frame source can keep it open
         myIO.openRead(fileToRead);
         const NiftiHeader& inHeader = myIO.getHeader();
         for (int i = 0; i < (int)inHeader.m_extensions.size(); ++i)
@@ -256,10 +311,26 @@ void VolumeFile::readFile(const AString& filename)
                 throw DataFileException(filename, "volume FOV is 1x1x1 voxel, with over 10,000 frames, which suggests a broken cifti file (no header extension)");
             }
         }//this check is also done in reinitialize(), but we don't want to call getSForm before this check when reading a file
-        reinitialize(myDims, inHeader.getSForm(), numComponents);
-        setFileName(filename);  // must be done after reinitialize() since it calls clear() which clears the name of the file
         int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
-        if (numComponents != 1)
+        int64_t numFrames = 1;
+        for (int i = 0; i < (int)extraDims.size(); ++i)
+        {
+            numFrames *= extraDims[i];
+        }
+        //the temporary copy of a network file goes away at the end of this block, and separating components would require reading the whole brick anyway
+        //plain .gz files are read eagerly, parallel loops request frames out of order, and each backward seek decompresses from the start
+        bool lazy = s_lazyFrameLoadingEnabled && numFrames > 1 && numComponents == 1 && fileToRead == filename && myIO.hasRandomAccess();
+        if (lazy)
+        {
+            CaretPointer<VolumeBase::FrameSource> mySource(new NiftiFrameSource(myIOPointer, extraDims, fullDims));
+            reinitialize(myDims, inHeader.getSForm(), numComponents, mySource, SubvolumeAttributes::ANATOMY, NULL);
+        } else {
+            reinitialize(myDims, inHeader.getSForm(), numComponents);
+        }
+        setFileName(filename);  // must be done after reinitialize() since it calls clear() which clears the name of the file
+        if (lazy)
+        {//nothing to read now
+        } else if (numComponents != 1)
         {
             vector<float> tempFrame(frameSize), readBuffer(frameSize * numComponents);
             for (MultiDimIterator<int64_t> myiter(extraDims); !myiter.atEnd(); ++myiter)
@@ -333,6 +404,7 @@ VolumeFile::writeFile(const AString& filename)
         throw DataFileException(filename,
                                 "writing multi-component volumes is not currently supported");//its a hassle, and uncommon, and there is only one 3-component type, restricted to 0-255
     }
+    loadAllFrames();//we may be about to overwrite the file the frames come from
     updateCaretExtension();
     
     NiftiHeader outHeader;//begin nifti-specific code
@@ -1217,6 +1289,11 @@ VolumeFile::getFileData(std::vector<float>& dataOut) const
     int64_t dataOffset = 0;
     
     for (int iMap = 0; iMap < numMaps; iMap++) {
+        if (dimComp == 1) {
+            copyFrame(dataOut.data() + dataOffset, iMap);//doesn't make a lazily loaded volume keep every frame
+            dataOffset += mapSize;
+            continue;
+        }
         const float* mapData = getFrame(iMap);
         
         for (int64_t i = 0; i < mapSize; i++) {
@@ -1737,6 +1814,51 @@ VolumeFile::clearVoxelColoringForMap(const int64_t mapIndex)
     }
 }
 
+/**
+ * Get the RGBA coloring of all voxels in a map (no label display filtering).
+ *
+ * @param mapIndex
+ *    Index of map.
+ * @return
+ *    Four components per voxel, or NULL if coloring is not enabled.
+ */
+const uint8_t*
+VolumeFile::getVoxelColorsForMap(const int32_t mapIndex) const
+{
+    if (m_voxelColorizer == NULL) {
+        return NULL;
+    }
+    return m_voxelColorizer->getVoxelColorsForMap(mapIndex);
+}
+
+/**
+ * @return A value that changes whenever the coloring of the given
+ * map changes, or -1 if coloring is not enabled.
+ *
+ * @param mapIndex
+ *    Index of map.
+ */
+int64_t
+VolumeFile::getVoxelColorsModificationStampForMap(const int32_t mapIndex) const
+{
+    if (m_voxelColorizer == NULL) {
+        return -1;
+    }
+    return m_voxelColorizer->getVoxelColorsModificationStampForMap(mapIndex);
+}
+
+/**
+ * @return The OpenGL texture used for drawing slices of this volume.
+ */
+GraphicsOpenGLVolumeTexture*
+VolumeFile::getOpenGLVolumeTexture() const
+{
+    if (m_openGLVolumeTexture == NULL) {
+        m_openGLVolumeTexture.grabNew(new GraphicsOpenGLVolumeTexture());
+    }
+    return m_openGLVolumeTexture;
+}
+
 /**
  * Get the minimum and maximum values from ALL maps in this file.
  * Note that not all files (due to size of file) are able to provide
@@ -1780,14 +1902,20 @@ VolumeFile::getDataRangeFromAllMaps(float& dataRangeMinimumOut,
     m_dataRangeMinimum = std::numeric_limits<float>::max();
     
     const int64_t* dimensions = getDimensionsPtr();
-    int64_t m_dataSize = dimensions[0] * dimensions[1] * dimensions[2] * dimensions[3] * dimensions[4];
-    const float* data = getFrame();//HACK: use first frame knowing all data is contiguous after it
-    for (int64_t i = 0; i < m_dataSize; i++) {
-        if (data[i] > m_dataRangeMaximum) {
-            m_dataRangeMaximum = data[i];
-        }
-        if (data[i] < m_dataRangeMinimum) {
-            m_dataRangeMinimum = data[i];
+    const int64_t frameSize = dimensions[0] * dimensions[1] * dimensions[2];
+    vector<float> frameData(frameSize);
+    for (int64_t c = 0; c < dimensions[4]; c++) {
+        for (int64_t b = 0; b < dimensions[3]; b++) {
+            copyFrame(frameData.data(), b, c);//doesn't make a lazily loaded volume keep every frame
+            const float* data = frameData.data();
+            for (int64_t i = 0; i < frameSize; i++) {
+                if (data[i] > m_dataRangeMaximum) {
+                    m_dataRangeMaximum = data[i];
+                }
+                if (data[i] < m_dataRangeMinimum) {
+                    m_dataRangeMinimum = data[i];
+                }
+            }
         }
     }
     
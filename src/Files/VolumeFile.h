@@ -36,6 +36,7 @@
 
 namespace caret {
     
+    class GraphicsOpenGLVolumeTexture;
     class GroupAndNameHierarchyModel;
     class VolumeFileEditorDelegate;
     class VolumeFileVoxelColorizer;
@@ -53,6 +54,11 @@ namespace caret {
         
         void validateMembers();//called to ensure extension agrees with number of subvolumes
         
+        ///common code for the public reinitialize, frameSource may be NULL
+        void reinitialize(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents,
+                          CaretPointer<VolumeBase::FrameSource> frameSource,
+                          SubvolumeAttributes::VolumeType whatType, const AbstractHeader* templateHeader);
+        
         void updateCaretExtension();//called before writing a file, erases all existing caret extensions from m_extensions, and rebuilds one from m_caretVolExt
         
         void checkStatisticsValid();
@@ -96,6 +102,9 @@ namespace caret {
         /** Performs coloring of voxels.  Will be NULL if coloring is disabled. */
         CaretPointer<VolumeFileVoxelColorizer> m_voxelColorizer;
         
+        /** Voxel coloring as an OpenGL texture for slice drawing, created when first drawn. */
+        mutable CaretPointer<GraphicsOpenGLVolumeTexture> m_openGLVolumeTexture;
+        
         /** True if the volume is a single slice, needed by interpolateValue() methods */
         bool m_singleSliceFlag;
         
@@ -146,6 +155,11 @@ namespace caret {
         
         static void setVoxelColoringEnabled(const bool enabled);
         
+        /** Multi-frame volumes are read one frame at a time, on first access, unless they are .gz files without a block index */
+        static bool s_lazyFrameLoadingEnabled;
+        
+        static void setLazyFrameLoading(const bool enabled);
+        
         VolumeFile();
         VolumeFile(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1,
                    SubvolumeAttributes::VolumeType whatType = SubvolumeAttributes::ANATOMY, const AbstractHeader* templateHeader = NULL);
@@ -338,6 +352,12 @@ namespace caret {
         
         void clearVoxelColoringForMap(const int64_t mapIndex);
         
+        const uint8_t* getVoxelColorsForMap(const int32_t mapIndex) const;
+        
+        int64_t getVoxelColorsModificationStampForMap(const int32_t mapIndex) const;
+        
+        GraphicsOpenGLVolumeTexture* getOpenGLVolumeTexture() const;
+        
         virtual bool getDataRangeFromAllMaps(float& dataRangeMinimumOut,
                                              float& dataRangeMaximumOut) const;
         
@@ -68,6 +68,7 @@ VolumeFileVoxelColorizer::VolumeFileVoxelColorizer(VolumeFile* volumeFile)
     for (int64_t i = 0; i < m_mapCount; i++) {
         m_mapRGBA.push_back(new uint8_t[m_mapRGBACount]);
         m_mapColoringValid.push_back(false);
+        m_mapModificationStamp.push_back(++s_modificationStampCounter);
     }
 }
 
@@ -239,6 +240,8 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
             break;
     }
     
+    m_mapModificationStamp[mapIndex] = ++s_modificationStampCounter;
+    
     CaretLogFine("Time to color map named \""
                    + m_volumeFile->getMapName(mapIndex)
                    + " in volume file "
@@ -731,5 +734,39 @@ VolumeFileVoxelColorizer::clearVoxelColoringForMap(const int64_t mapIndex)
     
     CaretAssertVectorIndex(m_mapColoringValid, mapIndex);
     m_mapColoringValid[mapIndex] = false;
+    m_mapModificationStamp[mapIndex] = ++s_modificationStampCounter;
+}
+
+/**
+ * Get the RGBA coloring for all voxels in a map, without any label
+ * display group filtering, ordered with the first index fastest.
+ *
+ * @param mapIndex
+ *    Index of map.
+ * @return
+ *    Pointer to the map's RGBA, four per voxel.
+ */
+const uint8_t*
+VolumeFileVoxelColorizer::getVoxelColorsForMap(const int32_t mapIndex) const
+{
+    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+    return m_mapRGBA[mapIndex];
+}
+
+/**
+ * Get a value that changes whenever the map's RGBA is modified.  The
+ * values are unique across all colorizers so that they may be used to
+ * detect when a copy of the coloring (such as a texture) is out of date.
+ *
+ * @param mapIndex
+ *    Index of map.
+ * @return
+ *    The modification stamp.
+ */
+int64_t
+VolumeFileVoxelColorizer::getVoxelColorsModificationStampForMap(const int32_t mapIndex) const
+{
+    CaretAssertVectorIndex(m_mapModificationStamp, mapIndex);
+    return m_mapModificationStamp[mapIndex];
 }
 
@@ -22,6 +22,8 @@
 /*LICENSE_END*/
 
 
+#include <atomic>
+
 #include "CaretObject.h"
 #include "DisplayGroupEnum.h"
 #include "VolumeSliceViewPlaneEnum.h"
@@ -78,6 +80,10 @@ namespace caret {
         
         void invalidateColoring();
         
+        const uint8_t* getVoxelColorsForMap(const int32_t mapIndex) const;
+        
+        int64_t getVoxelColorsModificationStampForMap(const int32_t mapIndex) const;
+        
     private:
         VolumeFileVoxelColorizer(const VolumeFileVoxelColorizer&);
 
@@ -116,10 +122,15 @@ namespace caret {
         
         std::vector<bool> m_mapColoringValid;
         std::vector<uint8_t*> m_mapRGBA;
+        
+        /** Changes each time a map's RGBA is modified, unique across all colorizers */
+        std::vector<int64_t> m_mapModificationStamp;
+        
+        static std::atomic<int64_t> s_modificationStampCounter;
     };
     
 #ifdef __VOLUME_FILE_VOXEL_COLORIZER_DECLARE__
-    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+    std::atomic<int64_t> VolumeFileVoxelColorizer::s_modificationStampCounter(0);
 #endif // __VOLUME_FILE_VOXEL_COLORIZER_DECLARE__
 
 } // namespace
@@ -0,0 +1,106 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "WeightsCacheFile.h"
+
+#include "CaretBinaryFile.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+
+#include <cstring>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int32_t WEIGHTS_FILE_BYTE_ORDER = 0x01020304;//written natively, so a file from a machine with other endianness just gets recomputed
+}
+
+void WeightsCacheFile::addHashData(QCryptographicHash& myHash, const void* data, const int64_t& bytes)
+{
+    if (data != NULL) myHash.addData((const char*)data, bytes);
+}
+
+int64_t WeightsCacheFile::getHeaderSize(const AString& cacheKey)
+{
+    return 8 + sizeof(WEIGHTS_FILE_BYTE_ORDER) + cacheKey.toLatin1().size();
+}
+
+bool WeightsCacheFile::readHeader(CaretBinaryFile& myFile, const char magic[8], const AString& cacheKey)
+{
+    char fileMagic[8];
+    int32_t byteOrder;
+    QByteArray keyBytes = cacheKey.toLatin1();
+    vector<char> fileKey(keyBytes.size());
+    myFile.read(fileMagic, sizeof(fileMagic));
+    myFile.read(&byteOrder, sizeof(byteOrder));
+    myFile.read(fileKey.data(), fileKey.size());
+    return memcmp(fileMagic, magic, sizeof(fileMagic)) == 0 && byteOrder == WEIGHTS_FILE_BYTE_ORDER &&
+           memcmp(fileKey.data(), keyBytes.constData(), fileKey.size()) == 0;
+}
+
+WeightsCacheFile::WeightsCacheFile(const AString& fileName, const char magic[8], const AString& cacheKey) : m_tempFile(fileName + ".XXXXXX")
+{
+    m_fileName = fileName;
+    m_tempFile.setAutoRemove(false);//removed by hand after the rename attempt
+    m_ok = m_tempFile.open();
+    write(magic, 8);
+    write(&WEIGHTS_FILE_BYTE_ORDER, sizeof(WEIGHTS_FILE_BYTE_ORDER));
+    QByteArray keyBytes = cacheKey.toLatin1();
+    write(keyBytes.constData(), keyBytes.size());
+}
+
+void WeightsCacheFile::write(const void* data, const int64_t& bytes)
+{
+    if (m_ok && bytes > 0)
+    {
+        m_ok = (m_tempFile.write((const char*)data, bytes) == bytes);
+    }
+}
+
+bool WeightsCacheFile::finish(const bool& replaceExisting)
+{
+    if (!m_tempFile.isOpen()) return false;
+    AString tempName = m_tempFile.fileName();
+    m_tempFile.close();
+    if (m_ok && replaceExisting && QFile::exists(m_fileName))
+    {
+        QFile::remove(m_fileName);
+    }
+    if (m_ok && !QFile::rename(tempName, m_fileName))
+    {
+        m_ok = QFile::exists(m_fileName);//rename won't overwrite, so failure is fine if another process already wrote the same weights
+    }
+    if (QFile::exists(tempName)) QFile::remove(tempName);
+    return m_ok;
+}
+
+WeightsCacheFile::~WeightsCacheFile()
+{
+    if (m_tempFile.isOpen())
+    {//never finished, don't leave the partial file behind
+        AString tempName = m_tempFile.fileName();
+        m_tempFile.close();
+        QFile::remove(tempName);
+    }
+}
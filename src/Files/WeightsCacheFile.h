@@ -0,0 +1,68 @@
+#ifndef __WEIGHTS_CACHE_FILE_H__
+#define __WEIGHTS_CACHE_FILE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+
+#include <QTemporaryFile>
+
+#include "stdint.h"
+
+class QCryptographicHash;
+
+namespace caret {
+    
+    class CaretBinaryFile;
+    
+    ///cache file of precomputed weights: an 8 byte magic, a native byte order mark and the SHA-1 key of the inputs, followed by the caller's data
+    ///the file is written under a temporary name and renamed, so processes sharing a cache never see a partial file - failure only costs the cache
+    class WeightsCacheFile
+    {
+        QTemporaryFile m_tempFile;
+        AString m_fileName;
+        bool m_ok;
+        WeightsCacheFile(const WeightsCacheFile&);
+        WeightsCacheFile& operator=(const WeightsCacheFile&);
+    public:
+        ///add data to a key, NULL data adds nothing (so record whether optional inputs exist separately)
+        static void addHashData(QCryptographicHash& myHash, const void* data, const int64_t& bytes);
+        
+        ///size of the header written for a key, to check the expected file size against
+        static int64_t getHeaderSize(const AString& cacheKey);
+        
+        ///read the header from the start of the file, false if it was written for other inputs or on a machine with other endianness
+        static bool readHeader(CaretBinaryFile& myFile, const char magic[8], const AString& cacheKey);
+        
+        ///create the temporary file and write the header
+        WeightsCacheFile(const AString& fileName, const char magic[8], const AString& cacheKey);
+        
+        void write(const void* data, const int64_t& bytes);
+        
+        ///close and rename into place, false if anything failed - without replaceExisting, an existing file is assumed to be the same weights written by another process
+        bool finish(const bool& replaceExisting = false);
+        
+        ~WeightsCacheFile();
+    };
+    
+}
+
+#endif //__WEIGHTS_CACHE_FILE_H__
@@ -38,6 +38,12 @@ AbstractHeader::~AbstractHeader()
 }
 
 void VolumeBase::reinitialize(const vector<int64_t>& dimensionsIn, const vector<vector<float> >& indexToSpace, const int64_t numComponents)
+{
+    reinitialize(dimensionsIn, indexToSpace, numComponents, CaretPointer<FrameSource>());
+}
+
+void VolumeBase::reinitialize(const vector<int64_t>& dimensionsIn, const vector<vector<float> >& indexToSpace, const int64_t numComponents,
+                              CaretPointer<FrameSource> frameSource)
 {
     CaretAssert(numComponents > 0);
     clear();
@@ -64,7 +70,12 @@ void VolumeBase::reinitialize(const vector<int64_t>& dimensionsIn, const vector<
         throw DataFileException("this file doesn't appear to be a volume file");
     }
     storeDims[4] = numComponents;
-    m_storage.reinitialize(storeDims);
+    if (frameSource != NULL)
+    {
+        m_storage.reinitialize(storeDims, frameSource);
+    } else {
+        m_storage.reinitialize(storeDims);
+    }
 }
 
 void VolumeBase::addSubvolumes(const int64_t& numToAdd)
@@ -347,6 +358,10 @@ VolumeBase::isEmpty() const
     return (getDimensionsPtr()[0] <= 0);
 }
 
+VolumeBase::FrameSource::~FrameSource()
+{
+}
+
 VolumeBase::VolumeStorage::VolumeStorage()
 {
     for (int i = 0; i < 5; ++i)
@@ -354,9 +369,16 @@ VolumeBase::VolumeStorage::VolumeStorage()
         m_dimensions[i] = 0;
         m_mult[i] = 0;
     }
+    m_lazy.store(false);
 }
 
 void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5])
+{
+    setDimensions(dims);
+    m_data.resize(m_mult[4]);
+}
+
+void VolumeBase::VolumeStorage::setDimensions(int64_t dims[5])
 {
     for (int i = 0; i < 5; ++i)
     {
@@ -369,21 +391,118 @@ void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5])
     {
         m_mult[i] = m_mult[i - 1] * m_dimensions[i];
     }
-    m_data.resize(m_mult[4]);
+    dropLazy();
+}
+
+void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5], CaretPointer<FrameSource> frameSource)
+{
+    CaretAssert(frameSource != NULL);
+    setDimensions(dims);
+    vector<float>().swap(m_data);//actually release any previous memory
+    int64_t numFrames = m_dimensions[3] * m_dimensions[4];
+    m_frameSource = frameSource;
+    m_lazyFrames.resize(numFrames);
+    vector<std::atomic<float*> > newPointers(numFrames);
+    m_lazyPointers.swap(newPointers);
+    for (int64_t i = 0; i < numFrames; ++i)
+    {
+        m_lazyPointers[i].store(NULL, std::memory_order_relaxed);
+    }
+    m_lazy.store(true, std::memory_order_release);
+}
+
+void VolumeBase::VolumeStorage::dropLazy()
+{
+    m_lazy.store(false, std::memory_order_release);
+    m_frameSource.grabNew(NULL);
+    m_lazyFrames.clear();
+    m_lazyPointers.clear();
+}
+
+const float* VolumeBase::VolumeStorage::loadLazyFrame(const int64_t& frameIndex) const
+{//frames are never released until the whole volume leaves lazy mode, so the returned pointer can be used without the lock
+    CaretMutexLocker locked(&m_lazyMutex);
+    float* ret = m_lazyPointers[frameIndex].load(std::memory_order_relaxed);//another thread may have loaded it while we waited
+    if (ret == NULL)
+    {
+        vector<float>& frame = m_lazyFrames[frameIndex];
+        frame.resize(m_mult[2]);
+        m_frameSource->loadFrame(frame.data(), frameIndex % m_dimensions[3], frameIndex / m_dimensions[3]);
+        ret = frame.data();
+        m_lazyPointers[frameIndex].store(ret, std::memory_order_release);
+    }
+    return ret;
+}
+
+void VolumeBase::VolumeStorage::copyFrame(float* frameOut, const int64_t& brickIndex, const int64_t& component) const
+{
+    const float* source = NULL;
+    if (m_lazy.load(std::memory_order_acquire))
+    {
+        int64_t frameIndex = brickIndex + m_dimensions[3] * component;
+        source = m_lazyPointers[frameIndex].load(std::memory_order_acquire);
+        if (source == NULL)
+        {
+            CaretMutexLocker locked(&m_lazyMutex);//the frame source isn't necessarily thread safe
+            source = m_lazyPointers[frameIndex].load(std::memory_order_relaxed);
+            if (source == NULL)
+            {
+                m_frameSource->loadFrame(frameOut, brickIndex, component);
+                return;
+            }
+        }
+    } else {
+        source = m_data.data() + brickIndex * m_mult[2] + component * m_mult[3];
+    }
+    for (int64_t i = 0; i < m_mult[2]; ++i)
+    {
+        frameOut[i] = source[i];
+    }
+}
+
+void VolumeBase::VolumeStorage::makeResident()
+{//can be reached from parallel setValue calls, so only the first caller converts
+    CaretMutexLocker locked(&m_lazyMutex);
+    if (!m_lazy.load(std::memory_order_relaxed)) return;
+    CaretAssert(m_frameSource != NULL);
+    vector<float> newData(m_mult[4]);
+    int64_t numFrames = m_dimensions[3] * m_dimensions[4];
+    for (int64_t f = 0; f < numFrames; ++f)
+    {//frame index is brick + dims[3] * component, so frames are already in m_data order
+        float* dest = newData.data() + f * m_mult[2];
+        const float* loaded = m_lazyPointers[f].load(std::memory_order_acquire);
+        if (loaded != NULL)
+        {
+            for (int64_t i = 0; i < m_mult[2]; ++i)
+            {
+                dest[i] = loaded[i];
+            }
+        } else {
+            m_frameSource->loadFrame(dest, f % m_dimensions[3], f / m_dimensions[3]);
+        }
+    }
+    m_data.swap(newData);
+    dropLazy();//releases m_lazy, so other threads only use m_data after the swap
 }
 
 VolumeBase::VolumeStorage::VolumeStorage(int64_t dims[5])
 {
+    m_lazy.store(false);
     reinitialize(dims);
 }
 
 const float* VolumeBase::VolumeStorage::getFrame(const int64_t brickIndex, const int64_t component) const
 {
+    if (m_lazy.load(std::memory_order_relaxed))
+    {
+        return getLazyFrame(brickIndex, component);
+    }
     return m_data.data() + brickIndex * m_mult[2] + component * m_mult[3];//NOTE: do not use [4]
 }
 
 void VolumeBase::VolumeStorage::setFrame(const float* frameIn, const int64_t brickIndex, const int64_t component)
 {
+    if (m_lazy.load(std::memory_order_acquire)) makeResident();
     int64_t start = brickIndex * m_mult[2] + component * m_mult[3];
     for (int64_t i = 0; i < m_mult[2]; ++i)
     {
@@ -393,6 +512,11 @@ void VolumeBase::VolumeStorage::setFrame(const float* frameIn, const int64_t bri
 
 void VolumeBase::VolumeStorage::setValueAllVoxels(const float value)
 {
+    if (m_lazy.load(std::memory_order_relaxed))
+    {//no need to read anything
+        dropLazy();
+        m_data.resize(m_mult[4]);
+    }
     for (int64_t i = 0; i < m_mult[4]; ++i)
     {
         m_data[i] = value;
@@ -407,6 +531,14 @@ void VolumeBase::VolumeStorage::swap(VolumeStorage& rhs)
         std::swap(m_dimensions[i], rhs.m_dimensions[i]);
         std::swap(m_mult[i], rhs.m_mult[i]);
     }
+    CaretPointer<FrameSource> tempSource = m_frameSource;
+    m_frameSource = rhs.m_frameSource;
+    rhs.m_frameSource = tempSource;
+    bool tempLazy = m_lazy.load();
+    m_lazy.store(rhs.m_lazy.load());
+    rhs.m_lazy.store(tempLazy);
+    m_lazyFrames.swap(rhs.m_lazyFrames);
+    m_lazyPointers.swap(rhs.m_lazyPointers);
 }
 
 void VolumeBase::VolumeStorage::getDimensions(vector<int64_t>& dimOut) const
@@ -437,6 +569,7 @@ vector<int64_t> VolumeBase::VolumeStorage::getDimensions() const
 void VolumeBase::VolumeStorage::clear()
 {
     m_data.clear();
+    dropLazy();
     for (int i = 0; i < 5; ++i)
     {
         m_dimensions[i] = 0;
@@ -23,8 +23,10 @@
 /*LICENSE_END*/
 
 #include "stdint.h"
+#include <atomic>
 #include <vector>
 #include "CaretAssert.h"
+#include "CaretMutex.h"
 #include "CaretPointer.h"
 #include "VolumeMappableInterface.h"
 #include "VolumeSpace.h"
@@ -46,18 +48,54 @@ namespace caret {
     
     class VolumeBase : public VolumeMappableInterface
     {
+    public:
+        ///reads frames on demand, for volumes whose data is not loaded up front
+        class FrameSource
+        {
+        public:
+            ///fill frameOut (dims[0] * dims[1] * dims[2] floats) with the requested frame
+            virtual void loadFrame(float* frameOut, const int64_t& brickIndex, const int64_t& component) = 0;
+            virtual ~FrameSource();
+        };
+    private:
         class VolumeStorage
         {
             std::vector<float> m_data;
             int64_t m_dimensions[5];//store internally as 4d+component
             int64_t m_mult[5];//precalculated multipliers for getIndex/getValue/setValue - NOTE: [0] is for index[1], [4] is the entire size of the data
+            
+            //lazy mode: m_data is empty, frames are read from m_frameSource on first access, indexed by brick + dims[3] * component
+            //loaded frames are never released while in lazy mode, so pointers from getFrame stay valid until the volume is modified
+            std::atomic<bool> m_lazy;//checked instead of m_frameSource, so that parallel setValue calls can race to makeResident safely
+            CaretPointer<FrameSource> m_frameSource;
+            mutable std::vector<std::vector<float> > m_lazyFrames;
+            mutable std::vector<std::atomic<float*> > m_lazyPointers;//NULL until loaded, lets getValue skip the lock
+            mutable CaretMutex m_lazyMutex;
+            
+            const float* loadLazyFrame(const int64_t& frameIndex) const;
+            void dropLazy();
+            void setDimensions(int64_t dims[5]);
+            inline const float* getLazyFrame(const int64_t& brickIndex, const int64_t& component) const
+            {
+                const float* ret = m_lazyPointers[brickIndex + m_dimensions[3] * component].load(std::memory_order_acquire);
+                if (ret != NULL) return ret;
+                return loadLazyFrame(brickIndex + m_dimensions[3] * component);
+            }
+            
             VolumeStorage(const VolumeStorage& rhs);//deny copy, assignment for now
             VolumeStorage& operator=(const VolumeStorage& rhs);
         public:
             VolumeStorage();
             VolumeStorage(int64_t dims[5]);
             void reinitialize(int64_t dims[5]);
+            ///don't allocate the data, read frames from frameSource when they are first used
+            void reinitialize(int64_t dims[5], CaretPointer<FrameSource> frameSource);
             void clear();
+            bool isLazy() const { return m_lazy.load(std::memory_order_acquire); }
+            ///read all remaining frames into m_data and stop using the frame source, done automatically before any modification
+            void makeResident();
+            ///copy a frame out without keeping it resident if it hasn't been loaded yet
+            void copyFrame(float* frameOut, const int64_t& brickIndex, const int64_t& component) const;
             
             virtual void getDimensions(std::vector<int64_t>& dimOut) const;//NOTE: always returns a vector of 5 elements
             virtual void getDimensions(int64_t& dimOut1, int64_t& dimOut2, int64_t& dimOut3, int64_t& dimTimeOut, int64_t& numComponents) const;
@@ -73,6 +111,7 @@ namespace caret {
             inline const float& getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component) const
             {
                 CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, brickIndex, component));//assert so release version isn't slowed by checking
+                if (m_lazy.load(std::memory_order_relaxed)) return getLazyFrame(brickIndex, component)[indexIn1 + m_mult[0] * indexIn2 + m_mult[1] * indexIn3];
                 return m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)];
             }
             inline const float& getValue(const int64_t indexIn[3], const int64_t brickIndex, const int64_t component) const
@@ -110,6 +149,7 @@ namespace caret {
             inline void setValue(const float& valueIn, const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component)
             {
                 CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, brickIndex, component));//assert so release version isn't slowed by checking
+                if (m_lazy.load(std::memory_order_acquire)) makeResident();
                 m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)] = valueIn;
             }
             inline void setValue(const float& valueIn, const int64_t indexIn[3], const int64_t brickIndex, const int64_t component)
@@ -120,7 +160,7 @@ namespace caret {
             /// set every voxel to the given value
             void setValueAllVoxels(const float value);
             
-            ///get a frame (const)
+            ///get a frame (const), the pointer is invalidated by any modification of the volume
             const float* getFrame(const int64_t brickIndex = 0, const int64_t component = 0) const;
             
             ///set a frame
@@ -137,6 +177,9 @@ namespace caret {
         VolumeBase(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1);
         ///recreates the volume file storage with new size and spacing
         void reinitialize(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1);
+        ///same, but frames are read from frameSource on first access instead of being allocated, see VolumeStorage
+        void reinitialize(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents,
+                          CaretPointer<FrameSource> frameSource);
         
         void addSubvolumes(const int64_t& numToAdd);
         
@@ -163,6 +206,15 @@ namespace caret {
             return m_storage.getNumberOfComponents();
         }
         
+        ///whether frames are still being read from the file on first access
+        bool isLazyLoaded() const { return m_storage.isLazy(); }
+        
+        ///finish reading a lazily loaded volume, so the file is no longer needed
+        void loadAllFrames() { if (m_storage.isLazy()) m_storage.makeResident(); }
+        
+        ///copy a frame into frameOut, for a lazily loaded volume this doesn't keep an unloaded frame in memory
+        void copyFrame(float* frameOut, const int64_t brickIndex = 0, const int64_t component = 0) const { m_storage.copyFrame(frameOut, brickIndex, component); }
+        
         ///translates extraspatial indices into a (flat) brick index
         int64_t getBrickIndexFromNonSpatialIndexes(const std::vector<int64_t>& extraInds) const;
         
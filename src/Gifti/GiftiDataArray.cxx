@@ -149,6 +149,8 @@ GiftiDataArray::operator=(const GiftiDataArray& nda)
 void 
 GiftiDataArray::copyHelperGiftiDataArray(const GiftiDataArray& nda)
 {
+    nda.ensureDataRead();
+    dropDeferredRead();
     this->paletteColorMapping = NULL;
     if (nda.paletteColorMapping != NULL) {
         this->paletteColorMapping = new PaletteColorMapping(*nda.paletteColorMapping);
@@ -248,6 +250,7 @@ GiftiDataArray::getDataTypeAppropriateForIntent(const NiftiIntentEnum::Enum inte
 void 
 GiftiDataArray::addRows(const int32_t numRowsToAdd)
 {
+   ensureDataRead();
    dimensions[0] += numRowsToAdd;
    allocateData();
 }
@@ -258,6 +261,7 @@ GiftiDataArray::addRows(const int32_t numRowsToAdd)
 void 
 GiftiDataArray::deleteRows(const std::vector<int32_t>& rowsToDeleteIn)
 {
+   ensureDataRead();
    if (rowsToDeleteIn.empty()) {
       return;
    }
@@ -300,6 +304,7 @@ GiftiDataArray::deleteRows(const std::vector<int32_t>& rowsToDeleteIn)
 void 
 GiftiDataArray::setDimensions(const std::vector<int64_t> dimensionsIn)
 {
+   ensureDataRead();
    dimensions = dimensionsIn;
    if (dimensions.size() == 1) {
       dimensions.push_back(1);
@@ -400,6 +405,7 @@ GiftiDataArray::updateDataPointers()
 void 
 GiftiDataArray::clear()
 {
+   dropDeferredRead();
    arraySubscriptingOrder = GiftiArrayIndexingOrderEnum::ROW_MAJOR_ORDER;
    encoding = GiftiEncodingEnum::ASCII;
    dataType = NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32;
@@ -558,6 +564,7 @@ GiftiDataArray::remapIntValues(const std::vector<int32_t>& remappingTable)
  */
 void 
 GiftiDataArray::transferLabelIndices(const std::map<int32_t,int32_t>& indexConverter) {
+    ensureDataRead();
     if (this->getDataType() == NiftiDataTypeEnum::NIFTI_TYPE_INT32) {
         int64_t num = this->getTotalNumberOfElements();
         for (int i = 0; i < num; i++) {
@@ -575,11 +582,12 @@ GiftiDataArray::transferLabelIndices(const std::map<int32_t,int32_t>& indexConve
 }
 
 /**
- * read a GIFTI data array from text.
- * Data array should already be initialized and allocated.
+ * read a GIFTI data array from the raw bytes of the Data element text.
+ * Data is decoded directly into this array's storage.  Only this
+ * array is modified, so different arrays may be read concurrently.
  */
 void 
-GiftiDataArray::readFromText(const AString text,
+GiftiDataArray::readFromText(const std::string& text,
                              const GiftiEndianEnum::Enum dataEndianForReading,
                              const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
                              const NiftiDataTypeEnum::Enum dataTypeForReading,
@@ -589,6 +597,7 @@ GiftiDataArray::readFromText(const AString text,
                              const int64_t externalFileOffsetForReading,
                              const bool isReadOnlyMetaData)
 {
+   dropDeferredRead();
    const NiftiDataTypeEnum::Enum requiredDataType = dataType;
    dataType = dataTypeForReading;
    encoding = encodingForReading;
@@ -613,7 +622,7 @@ GiftiDataArray::readFromText(const AString text,
       switch (encoding) {
           case GiftiEncodingEnum::ASCII:
             {
-                std::istringstream stream(text.toStdString());
+                std::istringstream stream(text);
                 
                switch (dataType) {
                   case NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32:
@@ -656,7 +665,7 @@ GiftiDataArray::readFromText(const AString text,
                // Decode the Base64 data using VTK's algorithm
                //
                const uint64_t numDecoded =
-                     Base64::decode((const unsigned char*)(text.toStdString().c_str()),
+                     Base64::decode((const unsigned char*)(text.c_str()),
                                                 data.size(),
                                                 &data[0]);
                if (numDecoded != data.size()) {
@@ -680,12 +689,14 @@ GiftiDataArray::readFromText(const AString text,
                //
                // Decode the Base64 data using VTK's algorithm
                //
-               unsigned char* dataBuffer = new unsigned char[data.size()];
-               //const char* textChars = text.toLatin1().constData();
+               //
+               // Compressed size is not known, but can't exceed 3/4 of the text
+               //
+               std::vector<unsigned char> dataBuffer((text.size() / 4) * 3 + 3);
                const uint64_t numDecoded =
-                     Base64::decode((unsigned char*)text.toStdString().c_str(),
-                                                data.size(),
-                                                dataBuffer);
+                     Base64::decode((const unsigned char*)text.c_str(),
+                                                (text.size() / 4) * 3,
+                                                &dataBuffer[0]);
                if (numDecoded == 0) {
                    std::ostringstream str;
                    str << "Decoding of GZip Base64 Binary data failed."
@@ -696,11 +707,11 @@ GiftiDataArray::readFromText(const AString text,
                
                
                //
-               // Uncompress the data using VTK's algorithm
+               // Uncompress directly into the array storage
                // 
                 DataCompressZLib compressor;
                 const uint64_t uncompressedDataLength = 
-                                   compressor.uncompressData(dataBuffer,
+                                   compressor.uncompressData(&dataBuffer[0],
                                                           numDecoded,
                                                           (unsigned char*)&data[0],
                                                           data.size());
@@ -712,10 +723,6 @@ GiftiDataArray::readFromText(const AString text,
                   throw GiftiException(AString::fromStdString(str.str()));
                }
                
-               //
-               // Free memory
-               //
-               delete[] dataBuffer;
                
                //
                // Is byte swapping needed ? 
@@ -817,6 +824,144 @@ GiftiDataArray::readFromText(const AString text,
    setModified();
 }
 
+/**
+ * Keep the raw text of a Data element, to be read the first time the
+ * data is accessed.  The dimensions and data type are set immediately,
+ * so the array can be described without reading it.
+ *
+ * @param textInOut
+ *    Raw text of the Data element, swapped out (left empty).
+ * Other parameters are as for readFromText().
+ */
+void
+GiftiDataArray::setDeferredRead(std::string& textInOut,
+                                const GiftiEndianEnum::Enum dataEndianForReading,
+                                const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
+                                const NiftiDataTypeEnum::Enum dataTypeForReading,
+                                const std::vector<int64_t>& dimensionsForReading,
+                                const GiftiEncodingEnum::Enum encodingForReading,
+                                const AString& externalFileNameForReading,
+                                const int64_t externalFileOffsetForReading)
+{
+    if (dimensionsForReading.size() == 0) {
+        throw GiftiException("Data array has no dimensions.");
+    }
+    dropDeferredRead();
+    CaretPointer<DeferredRead> deferred(new DeferredRead());
+    deferred->text.swap(textInOut);
+    deferred->endian = dataEndianForReading;
+    deferred->arraySubscriptingOrder = arraySubscriptingOrderForReading;
+    deferred->dataType = dataTypeForReading;
+    deferred->dimensions = dimensionsForReading;
+    deferred->encoding = encodingForReading;
+    deferred->externalFileName = externalFileNameForReading;
+    deferred->externalFileOffset = externalFileOffsetForReading;
+    
+    /*
+     * Describe the array as it will be after reading: readFromText()
+     * converts to the current data type (except for pointsets), swaps
+     * binary data to the system byte order, and transposes to row major
+     * order.  readDeferredData() must only fill in the data, since these
+     * members are read by other threads without the lock.
+     */
+    if (intent == NiftiIntentEnum::NIFTI_INTENT_POINTSET) {
+        dataType = dataTypeForReading;
+    }
+    dimensions = dimensionsForReading;
+    if (dimensions.size() == 1) {
+        dimensions.push_back(1);
+    }
+    encoding = encodingForReading;
+    if (encodingForReading == GiftiEncodingEnum::ASCII) {
+        endian = dataEndianForReading;
+    } else {
+        endian = getSystemEndian();
+    }
+    arraySubscriptingOrder = GiftiArrayIndexingOrderEnum::ROW_MAJOR_ORDER;
+    data.clear();
+    updateDataPointers();
+    switch (dataType) {
+        case NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32:
+            dataTypeSize = sizeof(float);
+            break;
+        case NiftiDataTypeEnum::NIFTI_TYPE_INT32:
+            dataTypeSize = sizeof(int32_t);
+            break;
+        case NiftiDataTypeEnum::NIFTI_TYPE_UINT8:
+            dataTypeSize = sizeof(uint8_t);
+            break;
+        default:
+            throw GiftiException("DataType " + NiftiDataTypeEnum::toName(dataType) + " not supported in GIFTI");
+    }
+    m_deferredRead = deferred;
+    m_dataReadDeferred.store(true, std::memory_order_release);
+}
+
+/**
+ * Read the data kept by setDeferredRead().  Safe to call from several
+ * threads, the first caller reads and the others wait for it.
+ */
+void
+GiftiDataArray::readDeferredData() const
+{
+    CaretMutexLocker locked(&m_deferredReadMutex);
+    if (m_dataReadDeferred.load(std::memory_order_relaxed) == false) {
+        return;//another thread read it while we waited
+    }
+    CaretAssert(m_deferredRead != NULL);
+    const DeferredRead& deferred = *m_deferredRead;
+    
+    /*
+     * Read into a separate array, since reading uses methods that would
+     * otherwise try to read the deferred data again.
+     */
+    GiftiDataArray tempArray(intent);
+    tempArray.dataType = dataType;
+    tempArray.readFromText(deferred.text,
+                           deferred.endian,
+                           deferred.arraySubscriptingOrder,
+                           deferred.dataType,
+                           deferred.dimensions,
+                           deferred.encoding,
+                           deferred.externalFileName,
+                           deferred.externalFileOffset,
+                           false);
+    
+    /*
+     * setDeferredRead() already described the array as it is now, so
+     * only the data changes.
+     */
+    CaretAssert(tempArray.dataType == dataType);
+    CaretAssert(tempArray.dataTypeSize == dataTypeSize);
+    CaretAssert(tempArray.dimensions == dimensions);
+    CaretAssert(tempArray.endian == endian);
+    CaretAssert(tempArray.arraySubscriptingOrder == arraySubscriptingOrder);
+    
+    /*
+     * Logically const: the content of the array is the same, only
+     * the time at which it is decoded differs.
+     */
+    GiftiDataArray* self = const_cast<GiftiDataArray*>(this);
+    self->data.swap(tempArray.data);
+    self->updateDataPointers();
+    self->m_deferredRead.grabNew(NULL);
+    m_dataReadDeferred.store(false, std::memory_order_release);
+}
+
+/**
+ * Drop the deferred data without reading it, used when the array
+ * is cleared or replaced.
+ */
+void
+GiftiDataArray::dropDeferredRead()
+{
+    if (m_dataReadDeferred.load(std::memory_order_acquire)) {
+        CaretMutexLocker locked(&m_deferredReadMutex);
+        m_deferredRead.grabNew(NULL);
+        m_dataReadDeferred.store(false, std::memory_order_release);
+    }
+}
+
 /**
  * convert array indexing order of data.
  */
@@ -1015,6 +1160,7 @@ GiftiDataArray::writeAsXML(std::ostream& stream,
                            GiftiEncodingEnum::Enum encodingForWriting) 
                                                
 {
+    ensureDataRead();
     this->encoding = encodingForWriting;
     
     //
@@ -1265,6 +1411,7 @@ GiftiDataArray::writeAsXML(std::ostream& stream,
 void 
 GiftiDataArray::convertToDataType(const NiftiDataTypeEnum::Enum newDataType)
 {
+   ensureDataRead();
    if (newDataType != dataType) {      
       //
       // make a copy of myself
@@ -1433,6 +1580,7 @@ GiftiDataArray::isModified() const
 void 
 GiftiDataArray::getMinMaxValues(int& minValue, int& maxValue) const
 {
+   ensureDataRead();
    if (minMaxIntValuesValid == false) {
       minValueInt = std::numeric_limits<int32_t>::max();
       minValueInt = std::numeric_limits<int32_t>::min();
@@ -1460,6 +1608,7 @@ void
 GiftiDataArray::getMinMaxValuesFloat(float& minValue,
                           float& maxValue) const
 {
+    ensureDataRead();
     if (minMaxFloatValuesValid == false) {
         minValueFloat =  std::numeric_limits<float>::max();
         maxValueFloat = -std::numeric_limits<float>::max();
@@ -1482,6 +1631,7 @@ GiftiDataArray::getMinMaxValuesFloat(float& minValue,
 void 
 GiftiDataArray::zeroize()
 {
+   ensureDataRead();
    if (data.empty() == false) {
       std::fill(data.begin(), data.end(), 0);
    }
@@ -1523,6 +1673,7 @@ GiftiDataArray::getDataOffset(const int32_t indices[]) const
 float 
 GiftiDataArray::getDataFloat32(const int32_t indices[]) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    return dataPointerFloat[offset];
 }
@@ -1533,6 +1684,7 @@ GiftiDataArray::getDataFloat32(const int32_t indices[]) const
 const float* 
 GiftiDataArray::getDataFloat32Pointer(const int32_t indices[]) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    return &dataPointerFloat[offset];
 }
@@ -1543,6 +1695,7 @@ GiftiDataArray::getDataFloat32Pointer(const int32_t indices[]) const
 int32_t 
 GiftiDataArray::getDataInt32(const int32_t indices[]) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    return dataPointerInt[offset];
 }
@@ -1553,6 +1706,7 @@ GiftiDataArray::getDataInt32(const int32_t indices[]) const
 const int32_t* 
 GiftiDataArray::getDataInt32Pointer(const int32_t indices[]) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    return &dataPointerInt[offset];
 }
@@ -1563,6 +1717,7 @@ GiftiDataArray::getDataInt32Pointer(const int32_t indices[]) const
 uint8_t 
 GiftiDataArray::getDataUInt8(const int32_t indices[]) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    return dataPointerUByte[offset];
 }
@@ -1573,6 +1728,7 @@ GiftiDataArray::getDataUInt8(const int32_t indices[]) const
 const uint8_t*
 GiftiDataArray::getDataUInt8Pointer(const int32_t indices[]) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    return &dataPointerUByte[offset];
 }
@@ -1583,6 +1739,7 @@ GiftiDataArray::getDataUInt8Pointer(const int32_t indices[]) const
 void 
 GiftiDataArray::setDataFloat32(const int32_t indices[], const float dataValue) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    dataPointerFloat[offset] = dataValue;
 }
@@ -1593,6 +1750,7 @@ GiftiDataArray::setDataFloat32(const int32_t indices[], const float dataValue) c
 void 
 GiftiDataArray::setDataInt32(const int32_t indices[], const int32_t dataValue) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    dataPointerInt[offset] = dataValue;
 }
@@ -1603,6 +1761,7 @@ GiftiDataArray::setDataInt32(const int32_t indices[], const int32_t dataValue) c
 void 
 GiftiDataArray::setDataUInt8(const int32_t indices[], const uint8_t dataValue) const
 {
+   ensureDataRead();
    const int64_t offset = getDataOffset(indices);
    dataPointerUByte[offset] = dataValue;
 }      
@@ -1702,6 +1861,7 @@ GiftiDataArray::getPaletteColorMapping() const
 const DescriptiveStatistics* 
 GiftiDataArray::getDescriptiveStatistics() const
 {
+    ensureDataRead();
     if (this->getDataType() == NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32) {
         if (this->descriptiveStatistics == NULL) {
             this->descriptiveStatistics = new DescriptiveStatistics();
@@ -1714,6 +1874,7 @@ GiftiDataArray::getDescriptiveStatistics() const
 
 const FastStatistics* GiftiDataArray::getFastStatistics() const
 {
+    ensureDataRead();
     if (this->getDataType() == NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32) {
         if (m_fastStatistics == NULL) {
             m_fastStatistics.grabNew(new FastStatistics());
@@ -1725,6 +1886,7 @@ const FastStatistics* GiftiDataArray::getFastStatistics() const
 
 const Histogram* GiftiDataArray::getHistogram(const int32_t numberOfBuckets) const
 {
+    ensureDataRead();
     if (this->getDataType() == NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32) {
         bool updateHistogramFlag = false;
         if (m_histogram == NULL) {
@@ -1765,6 +1927,7 @@ GiftiDataArray::getDescriptiveStatistics(const float mostPositiveValueInclusive,
                                                       const float mostNegativeValueInclusive,
                                                       const bool includeZeroValues) const
 {
+    ensureDataRead();
     if (this->getDataType() == NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32) {
         if (this->descriptiveStatisticsLimitedValues == NULL) {
             this->descriptiveStatisticsLimitedValues = new DescriptiveStatistics();
@@ -1787,6 +1950,7 @@ const Histogram* GiftiDataArray::getHistogram(const int32_t numberOfBuckets,
                                               const float mostNegativeValueInclusive,
                                               const bool includeZeroValues) const
 {
+    ensureDataRead();
     if (this->getDataType() == NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32) {
         bool updateHistogramFlag = false;
         if (m_histogramLimitedValues == NULL)
@@ -22,6 +22,7 @@
  */
 /*LICENSE_END*/
 
+#include <atomic>
 #include <map>
 #include <ostream>
 #include <AString.h>
@@ -29,6 +30,7 @@
 
 #include <stdint.h>
 
+#include "CaretMutex.h"
 #include "CaretObject.h"
 #include "CaretPointer.h"
 #include "DescriptiveStatistics.h"
@@ -94,8 +96,8 @@ namespace caret {
         /// get the dimensions
         std::vector<int64_t> getDimensions() const { return dimensions; }
         
-        /// current size of the data (in bytes)
-        int64_t getDataSizeInBytes() const { return data.size(); }
+        /// current size of the data (in bytes), including data that has not been read yet
+        int64_t getDataSizeInBytes() const { return (isDataReadDeferred() ? getTotalNumberOfElements() * dataTypeSize : data.size()); }
         
         /// get a dimension
         int32_t getDimension(const int32_t dimIndex) const { return dimensions[dimIndex]; }
@@ -112,8 +114,8 @@ namespace caret {
         // get data offset 
         //int64_t getDataOffset(const int64_t nodeNum, const int64_t componentNum) const;//TSC: implementation was wrong, commenting out for now
         
-        // read a data array from text
-        void readFromText(const AString text,
+        // read a data array from the raw (undecoded) text of the Data element
+        void readFromText(const std::string& text,
                           const GiftiEndianEnum::Enum dataEndianForReading,
                           const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
                           const NiftiDataTypeEnum::Enum dataTypeForReading,
@@ -123,6 +125,22 @@ namespace caret {
                           const int64_t externalFileOffsetForReading,
                           const bool isReadOnlyMetaData);
         
+        // keep the raw text of the Data element and read it when the data is first accessed
+        void setDeferredRead(std::string& textInOut,
+                             const GiftiEndianEnum::Enum dataEndianForReading,
+                             const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
+                             const NiftiDataTypeEnum::Enum dataTypeForReading,
+                             const std::vector<int64_t>& dimensionsForReading,
+                             const GiftiEncodingEnum::Enum encodingForReading,
+                             const AString& externalFileNameForReading,
+                             const int64_t externalFileOffsetForReading);
+        
+        /// true if the data has not been read yet (see setDeferredRead)
+        bool isDataReadDeferred() const { return m_dataReadDeferred.load(std::memory_order_acquire); }
+        
+        /// read deferred data now, if there is any
+        void ensureDataRead() const { if (m_dataReadDeferred.load(std::memory_order_acquire)) readDeferredData(); }
+        
         // write the data as XML
         void writeAsXML(std::ostream& stream, 
                         std::ostream* externalBinaryOutputStream,
@@ -208,22 +226,22 @@ namespace caret {
         void setArraySubscriptingOrder(const GiftiArrayIndexingOrderEnum::Enum aso) { arraySubscriptingOrder = aso; }
         
         /// get pointer for floating point data (valid only if data type is FLOAT)
-        float* getDataPointerFloat() { return dataPointerFloat; }
+        float* getDataPointerFloat() { ensureDataRead(); return dataPointerFloat; }
         
         /// get pointer for floating point data (const method) (valid only if data type is FLOAT)
-        const float* getDataPointerFloat() const { return dataPointerFloat; }
+        const float* getDataPointerFloat() const { ensureDataRead(); return dataPointerFloat; }
         
         /// get pointer for integer data (valid only if data type is INT)
-        int32_t* getDataPointerInt() { return dataPointerInt; }
+        int32_t* getDataPointerInt() { ensureDataRead(); return dataPointerInt; }
         
         /// get pointer for integer data (const method) (valid only if data type is INT)
-        const int32_t* getDataPointerInt() const { return dataPointerInt; }
+        const int32_t* getDataPointerInt() const { ensureDataRead(); return dataPointerInt; }
         
         /// get pointer for unsigned byte data (valid only if data type is UBYTE)
-        uint8_t* getDataPointerUByte() { return dataPointerUByte; }
+        uint8_t* getDataPointerUByte() { ensureDataRead(); return dataPointerUByte; }
         
         /// get pointer for unsigned byte data (const method) (valid only if data type is UBYTE)
-        const uint8_t* getDataPointerUByte() const { return dataPointerUByte; }
+        const uint8_t* getDataPointerUByte() const { ensureDataRead(); return dataPointerUByte; }
         
         // set all elements of array to zero
         void zeroize();
@@ -425,6 +443,32 @@ namespace caret {
         mutable DescriptiveStatistics* descriptiveStatisticsLimitedValues;
         
         
+        /// raw text and attributes of a Data element that has not been read yet
+        struct DeferredRead {
+            std::string text;
+            GiftiEndianEnum::Enum endian;
+            GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrder;
+            NiftiDataTypeEnum::Enum dataType;
+            std::vector<int64_t> dimensions;
+            GiftiEncodingEnum::Enum encoding;
+            AString externalFileName;
+            int64_t externalFileOffset;
+        };
+        
+        // read the deferred data
+        void readDeferredData() const;
+        
+        // drop the deferred data without reading it
+        void dropDeferredRead();
+        
+        /// deferred data, NULL once read (DO NOT COPY)
+        CaretPointer<DeferredRead> m_deferredRead;
+        
+        /// lets the data pointer getters skip the lock once the data is read
+        mutable std::atomic<bool> m_dataReadDeferred { false };
+        
+        mutable CaretMutex m_deferredReadMutex;
+        
         bool modifiedFlag; // DO NOT COPY
         // ***** BE SURE TO UPDATE copyHelper() if elements are added ******
         
@@ -18,12 +18,14 @@
  */
 /*LICENSE_END*/
 
+#include <exception>
 #include <memory>
 #include <set>
 #include <sstream>
 
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "DataFileException.h"
 #include "FileInformation.h"
 #include "GiftiEncodingEnum.h"
@@ -58,6 +60,7 @@ GiftiFile::GiftiFile(const AString& descriptiveName,
     this->defaultExtension = defaultExtension;
    numberOfNodesForSparseNodeIndexFile = 0;
     this->encodingForWriting = GiftiFile::defaultEncodingForWriting;
+    this->deferDataArrayReading = false;
 }
 
 /**
@@ -73,6 +76,7 @@ GiftiFile::GiftiFile()
     numberOfNodesForSparseNodeIndexFile = 0;
     this->defaultExtension = ".gii";
     this->encodingForWriting = GiftiFile::defaultEncodingForWriting;
+    this->deferDataArrayReading = false;
 }
 
 /**
@@ -120,6 +124,7 @@ GiftiFile::copyHelperGiftiFile(const GiftiFile& nndf)
       addDataArray(new GiftiDataArray(*nndf.dataArrays[i]));
    }
     this->encodingForWriting = nndf.encodingForWriting;
+    this->deferDataArrayReading = nndf.deferDataArrayReading;
 }
       
 /**
@@ -887,6 +892,45 @@ GiftiFile::readFile(const AString& filename)
     }
 }
 
+/**
+ * Read the data of any data arrays whose reading was deferred
+ * (see setDeferDataArrayReading()), in parallel.
+ */
+void
+GiftiFile::readAllDeferredDataArrays() const
+{
+    const int32_t numArrays = getNumberOfDataArrays();
+    bool haveError = false;
+    AString errorText;
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int32_t i = 0; i < numArrays; i++) {
+        try {
+            dataArrays[i]->ensureDataRead();
+        }
+        catch (const CaretException& e) {
+#pragma omp critical
+            {
+                if (!haveError) {
+                    haveError = true;
+                    errorText = e.whatString();
+                }
+            }
+        }
+        catch (const std::exception& e) {
+#pragma omp critical
+            {
+                if (!haveError) {
+                    haveError = true;
+                    errorText = e.what();
+                }
+            }
+        }
+    }
+    if (haveError) {
+        throw GiftiException(errorText);
+    }
+}
+
 /**
  * write the file. 
  */
@@ -894,6 +938,11 @@ void
 GiftiFile::writeFile(const AString& filename)
 {
     try {
+        /*
+         * May be overwriting the file that deferred arrays come from
+         */
+        readAllDeferredDataArrays();
+        
         this->setFileName(filename);
         
         QFile::remove(filename);
@@ -186,6 +186,15 @@ class GiftiFile : public DataFile {
     
     bool getReadMetaDataOnlyFlag() const { return false; }
     
+    /// read binary data arrays only when their data is first accessed
+    bool getDeferDataArrayReading() const { return this->deferDataArrayReading; }
+    
+    /// set reading of binary data arrays to happen when their data is first accessed
+    void setDeferDataArrayReading(const bool deferReading) { this->deferDataArrayReading = deferReading; }
+    
+    // read the data of all deferred data arrays now
+    void readAllDeferredDataArrays() const;
+    
     /** @return The encoding used to write the file. */
     GiftiEncodingEnum::Enum getEncodingForWriting() const { return this->encodingForWriting; }
     
@@ -239,6 +248,9 @@ class GiftiFile : public DataFile {
       /// number of nodes in sparse node index files (NIFTI_INTENT_NODE_INDEX array)
       int32_t numberOfNodesForSparseNodeIndexFile;
       
+    /// defer reading of binary data arrays until first access
+    bool deferDataArrayReading;
+    
     /** The default encoding for writing a GIFTI file. */
     static GiftiEncodingEnum::Enum defaultEncodingForWriting;
     
@@ -20,7 +20,9 @@
 
 #include <sstream>
 
+#include "CaretException.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "FileInformation.h"
 #include "GiftiEndianEnum.h"
 #include "GiftiLabel.h"
@@ -45,6 +47,7 @@ GiftiFileSaxReader::GiftiFileSaxReader(GiftiFile* giftiFileIn)
    this->state = STATE_NONE;
    this->stateStack.push(this->state);
    this->elementText = "";
+   this->pendingArrayBytes = 0;
    this->dataArray.grabNew(NULL);
    this->labelTable = NULL;
     this->labelTableSaxReader = NULL;
@@ -214,6 +217,7 @@ GiftiFileSaxReader::startElement(const AString& namespaceURI,
    stateStack.push(previousState);
    
    elementText = "";
+   dataText.clear();
 }
 
 /**
@@ -507,7 +511,12 @@ GiftiFileSaxReader::createDataArray(const XmlAttributes& attributes)
 }
 
 /**
- * process the array data into numbers.
+ * queue the array data for decoding.  Decoding base64/zlib text is the
+ * bulk of the time for reading a GIFTI file, so arrays are decoded in
+ * parallel batches, limited in number and size so that the text of
+ * only a few arrays is held at once.  When the file defers reading,
+ * binary arrays instead keep their text (external binary arrays keep
+ * only the file offset) and are decoded on first access.
  */
 void 
 GiftiFileSaxReader::processArrayData()
@@ -515,19 +524,96 @@ GiftiFileSaxReader::processArrayData()
     this->dataArrayDataHasBeenRead = true;
 
     CaretAssert(dataArray);
-    try {
-        dataArray->readFromText(elementText,
-                                this->endianForReadingArrayData,
-                                arraySubscriptingOrderForReadingArrayData,
-                                dataTypeForReadingArrayData,
-                                dimensionsForReadingArrayData,
-                                encodingForReadingArrayData,
-                                externalFileNameForReadingData,
-                                externalFileOffsetForReadingData,
-                                this->giftiFile->getReadMetaDataOnlyFlag());
+    if (this->giftiFile->getDeferDataArrayReading()
+        && (encodingForReadingArrayData != GiftiEncodingEnum::ASCII)
+        && (this->giftiFile->getReadMetaDataOnlyFlag() == false)) {
+        try {
+            dataArray->setDeferredRead(dataText,
+                                       endianForReadingArrayData,
+                                       arraySubscriptingOrderForReadingArrayData,
+                                       dataTypeForReadingArrayData,
+                                       dimensionsForReadingArrayData,
+                                       encodingForReadingArrayData,
+                                       externalFileNameForReadingData,
+                                       externalFileOffsetForReadingData);
+        }
+        catch (const GiftiException& e) {
+            throw XmlSaxParserException(e.whatString());
+        }
+        return;
     }
-    catch (const GiftiException& e) {
-        throw XmlSaxParserException(e.whatString());
+
+    pendingArrays.push_back(PendingArrayData());
+    PendingArrayData& pending = pendingArrays.back();
+    pending.dataArray = dataArray;
+    pending.text.swap(dataText);
+    pending.endian = endianForReadingArrayData;
+    pending.arraySubscriptingOrder = arraySubscriptingOrderForReadingArrayData;
+    pending.dataType = dataTypeForReadingArrayData;
+    pending.dimensions = dimensionsForReadingArrayData;
+    pending.encoding = encodingForReadingArrayData;
+    pending.externalFileName = externalFileNameForReadingData;
+    pending.externalFileOffset = externalFileOffsetForReadingData;
+    pendingArrayBytes += pending.text.size();
+    
+    int maxPending = 1;
+#ifdef CARET_OMP
+    maxPending = omp_get_max_threads();
+#endif
+    const int64_t maxPendingBytes = ((int64_t)1) << 28;
+    if ((int)pendingArrays.size() >= maxPending || pendingArrayBytes >= maxPendingBytes) {
+        decodePendingArrays();
+    }
+}
+
+/**
+ * decode the queued array data, in parallel.
+ */
+void
+GiftiFileSaxReader::decodePendingArrays()
+{
+    const int64_t numPending = (int64_t)pendingArrays.size();
+    const bool metaDataOnly = this->giftiFile->getReadMetaDataOnlyFlag();
+    bool haveError = false;
+    AString errorText;
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numPending; ++i) {
+        PendingArrayData& pending = pendingArrays[i];
+        try {
+            pending.dataArray->readFromText(pending.text,
+                                            pending.endian,
+                                            pending.arraySubscriptingOrder,
+                                            pending.dataType,
+                                            pending.dimensions,
+                                            pending.encoding,
+                                            pending.externalFileName,
+                                            pending.externalFileOffset,
+                                            metaDataOnly);
+        }
+        catch (const CaretException& e) {
+#pragma omp critical
+            {
+                if (!haveError) {
+                    haveError = true;
+                    errorText = e.whatString();
+                }
+            }
+        }
+        catch (const std::exception& e) {
+#pragma omp critical
+            {
+                if (!haveError) {
+                    haveError = true;
+                    errorText = e.what();
+                }
+            }
+        }
+        std::string().swap(pending.text);//release the text as soon as possible
+    }
+    pendingArrays.clear();
+    pendingArrayBytes = 0;
+    if (haveError) {
+        throw XmlSaxParserException(errorText);
     }
 }
 
@@ -542,6 +628,9 @@ GiftiFileSaxReader::characters(const char* ch)
     }
     else if (this->labelTableSaxReader != NULL) {
         this->labelTableSaxReader->characters(ch);
+    }
+     else if (this->state == STATE_DATA_ARRAY_DATA) {
+        dataText += ch;
     }
     else {
         elementText += ch;
@@ -594,5 +683,6 @@ GiftiFileSaxReader::startDocument()
 void 
 GiftiFileSaxReader::endDocument()
 {
+    decodePendingArrays();
 }
 
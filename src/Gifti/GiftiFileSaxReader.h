@@ -23,6 +23,8 @@
 /*LICENSE_END*/
 
 #include <stack>
+#include <string>
+#include <vector>
 #include <AString.h>
 #include <stdint.h>
 
@@ -100,9 +102,25 @@ namespace caret {
             STATE_DATA_ARRAY_MATRIX_DATA
         };
         
-        // process the array data into numbers
+        /// data array whose text has been read but not yet decoded
+        struct PendingArrayData {
+            GiftiDataArray* dataArray;
+            std::string text;
+            GiftiEndianEnum::Enum endian;
+            GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrder;
+            NiftiDataTypeEnum::Enum dataType;
+            std::vector<int64_t> dimensions;
+            GiftiEncodingEnum::Enum encoding;
+            AString externalFileName;
+            int64_t externalFileOffset;
+        };
+        
+        // queue the array data for decoding
         void processArrayData();
         
+        // decode the queued array data, in parallel
+        void decodePendingArrays();
+        
         // create a data array
         void createDataArray(const XmlAttributes& attributes);
         
@@ -121,6 +139,15 @@ namespace caret {
         /// element text
         AString elementText;
         
+        /// raw text of the DataArray Data element, kept out of elementText to avoid UTF-16 conversion
+        std::string dataText;
+        
+        /// data arrays waiting to be decoded
+        std::vector<PendingArrayData> pendingArrays;
+        
+        /// total text size of the data arrays waiting to be decoded
+        int64_t pendingArrayBytes;
+        
         /// GIFTI data array being read
         CaretPointer<GiftiDataArray> dataArray;
         
@@ -0,0 +1,221 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __GRAPHICS_OPEN_G_L_VOLUME_TEXTURE_DECLARE__
+#include "GraphicsOpenGLVolumeTexture.h"
+#undef __GRAPHICS_OPEN_G_L_VOLUME_TEXTURE_DECLARE__
+
+#include <vector>
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "EventGraphicsOpenGLCreateTextureName.h"
+#include "EventManager.h"
+#include "GraphicsOpenGLError.h"
+#include "GraphicsOpenGLTextureName.h"
+#include "GraphicsUtilitiesOpenGL.h"
+
+using namespace caret;
+
+
+    
+/**
+ * \class caret::GraphicsOpenGLVolumeTexture 
+ * \brief A map's voxel coloring loaded into an OpenGL 3D texture.
+ * \ingroup Graphics
+ *
+ * Slices through the volume may then be drawn as single textured
+ * polygons instead of a polygon for every voxel.  The texture is
+ * reloaded only when the coloring's modification stamp changes.
+ */
+
+/**
+ * Constructor.
+ */
+GraphicsOpenGLVolumeTexture::GraphicsOpenGLVolumeTexture()
+: CaretObject()
+{
+    
+}
+
+/**
+ * Destructor.
+ */
+GraphicsOpenGLVolumeTexture::~GraphicsOpenGLVolumeTexture()
+{
+    deleteTexture();
+}
+
+/**
+ * Delete the texture.  The texture name is deleted later in the
+ * OpenGL context in which it was created.
+ */
+void
+GraphicsOpenGLVolumeTexture::deleteTexture()
+{
+    m_textureName.reset();
+    m_openglContextPointer = NULL;
+    m_mapIndex = -1;
+    m_modificationStamp = -1;
+}
+
+/**
+ * Is the texture loaded with the given coloring?
+ *
+ * @param openglContextPointer
+ *     Context sharing group of the current OpenGL context.
+ * @param mapIndex
+ *     Index of the map.
+ * @param modificationStamp
+ *     Modification stamp of the map's coloring.
+ * @return
+ *     True if the texture contains the coloring.
+ */
+bool
+GraphicsOpenGLVolumeTexture::isValid(void* openglContextPointer,
+                                     const int32_t mapIndex,
+                                     const int64_t modificationStamp) const
+{
+    return ((m_textureName != NULL)
+            && (m_openglContextPointer == openglContextPointer)
+            && (m_mapIndex == mapIndex)
+            && (m_modificationStamp == modificationStamp));
+}
+
+/**
+ * Load voxel coloring into the texture.  A voxel with an alpha greater
+ * than zero is loaded as opaque so that the drawing opacity is set by
+ * the current color, as when voxels are drawn individually.
+ *
+ * @param openglContextPointer
+ *     Context sharing group of the current OpenGL context.
+ * @param voxelRGBA
+ *     RGBA for each voxel, first index fastest.
+ * @param dimensions
+ *     Dimensions of the volume.
+ * @param mapIndex
+ *     Index of the map.
+ * @param modificationStamp
+ *     Modification stamp of the map's coloring.
+ * @return
+ *     True if the texture was loaded, false if it is too large for OpenGL.
+ */
+bool
+GraphicsOpenGLVolumeTexture::loadTexture(void* openglContextPointer,
+                                         const uint8_t* voxelRGBA,
+                                         const int64_t dimensions[3],
+                                         const int32_t mapIndex,
+                                         const int64_t modificationStamp)
+{
+    CaretAssert(voxelRGBA);
+    
+    if (openglContextPointer != m_openglContextPointer) {
+        deleteTexture();
+    }
+    
+    GLint maximumSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maximumSize);
+    for (int32_t i = 0; i < 3; i++) {
+        if ((dimensions[i] <= 0)
+            || (dimensions[i] > maximumSize)) {
+            deleteTexture();
+            return false;
+        }
+    }
+    
+    const int64_t numberOfComponents = dimensions[0] * dimensions[1] * dimensions[2] * 4;
+    std::vector<uint8_t> textureRGBA(numberOfComponents);
+#pragma omp CARET_PARFOR
+    for (int64_t i = 0; i < numberOfComponents; i += 4) {
+        textureRGBA[i]     = voxelRGBA[i];
+        textureRGBA[i + 1] = voxelRGBA[i + 1];
+        textureRGBA[i + 2] = voxelRGBA[i + 2];
+        textureRGBA[i + 3] = ((voxelRGBA[i + 3] > 0) ? 255 : 0);
+    }
+    
+    if (m_textureName == NULL) {
+        EventGraphicsOpenGLCreateTextureName createEvent;
+        EventManager::get()->sendEvent(createEvent.getPointer());
+        m_textureName.reset(createEvent.getOpenGLTextureName());
+        if (m_textureName == NULL) {
+            deleteTexture();
+            return false;
+        }
+    }
+    
+    GraphicsUtilitiesOpenGL::resetOpenGLError();
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_3D, m_textureName->getTextureName());
+    
+    /*
+     * Nearest so that voxels appear as blocks, and a transparent border
+     * so that slices do not smear the edge voxels.
+     */
+    const GLfloat borderColor[4] = { 0.0, 0.0, 0.0, 0.0 };
+    glTexParameterfv(GL_TEXTURE_3D, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    
+    glTexImage3D(GL_TEXTURE_3D,
+                 0,
+                 GL_RGBA8,
+                 dimensions[0],
+                 dimensions[1],
+                 dimensions[2],
+                 0,
+                 GL_RGBA,
+                 GL_UNSIGNED_BYTE,
+                 &textureRGBA[0]);
+    
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glPopClientAttrib();
+    
+    std::unique_ptr<GraphicsOpenGLError> errorInfo = GraphicsUtilitiesOpenGL::getOpenGLError("Loading volume coloring into a 3D texture");
+    if (errorInfo) {
+        CaretLogWarning(errorInfo->getVerboseDescription());
+        deleteTexture();
+        return false;
+    }
+    
+    m_openglContextPointer = openglContextPointer;
+    m_mapIndex = mapIndex;
+    m_modificationStamp = modificationStamp;
+    
+    return true;
+}
+
+/**
+ * @return The OpenGL texture name, zero if the texture is not loaded.
+ */
+GLuint
+GraphicsOpenGLVolumeTexture::getTextureName() const
+{
+    if (m_textureName != NULL) {
+        return m_textureName->getTextureName();
+    }
+    return 0;
+}
+
@@ -0,0 +1,79 @@
+#ifndef __GRAPHICS_OPEN_G_L_VOLUME_TEXTURE_H__
+#define __GRAPHICS_OPEN_G_L_VOLUME_TEXTURE_H__
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <memory>
+
+#include "CaretObject.h"
+#include "CaretOpenGLInclude.h"
+
+namespace caret {
+
+    class GraphicsOpenGLTextureName;
+    
+    class GraphicsOpenGLVolumeTexture : public CaretObject {
+        
+    public:
+        GraphicsOpenGLVolumeTexture();
+        
+        virtual ~GraphicsOpenGLVolumeTexture();
+        
+        bool isValid(void* openglContextPointer,
+                     const int32_t mapIndex,
+                     const int64_t modificationStamp) const;
+        
+        bool loadTexture(void* openglContextPointer,
+                         const uint8_t* voxelRGBA,
+                         const int64_t dimensions[3],
+                         const int32_t mapIndex,
+                         const int64_t modificationStamp);
+        
+        GLuint getTextureName() const;
+        
+        void deleteTexture();
+        
+        // ADD_NEW_METHODS_HERE
+
+    private:
+        GraphicsOpenGLVolumeTexture(const GraphicsOpenGLVolumeTexture&);
+
+        GraphicsOpenGLVolumeTexture& operator=(const GraphicsOpenGLVolumeTexture&);
+        
+        std::unique_ptr<GraphicsOpenGLTextureName> m_textureName;
+        
+        void* m_openglContextPointer = NULL;
+        
+        int32_t m_mapIndex = -1;
+        
+        int64_t m_modificationStamp = -1;
+        
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+    
+#ifdef __GRAPHICS_OPEN_G_L_VOLUME_TEXTURE_DECLARE__
+    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+#endif // __GRAPHICS_OPEN_G_L_VOLUME_TEXTURE_DECLARE__
+
+} // namespace
+#endif  //__GRAPHICS_OPEN_G_L_VOLUME_TEXTURE_H__
@@ -40,6 +40,7 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretPreferences.h"
+#include "CiftiConnectivityMatrixDenseDynamicFile.h"
 #include "EnumComboBoxTemplate.h"
 #include "EventGraphicsUpdateAllWindows.h"
 #include "EventManager.h"
@@ -344,6 +345,26 @@ PreferencesDialog::createMiscellaneousWidget()
     m_dynamicConnectivityComboBox->setToolTip("Sets default (checked or unchecked) for dynamic connectivity files "
                                               "on the Overlay ToolBox --> Connectivity tab.");
     
+    /*
+     * Dynamic connectivity row storage
+     */
+    m_dynamicConnectivityRowStorageComboBox = new QComboBox();
+    m_dynamicConnectivityRowStorageComboBox->addItem("Read From File",
+                                                     static_cast<int>(CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_PARENT_FILE));
+    m_dynamicConnectivityRowStorageComboBox->addItem("Float",
+                                                     static_cast<int>(CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_FLOAT));
+    m_dynamicConnectivityRowStorageComboBox->addItem("16-bit",
+                                                     static_cast<int>(CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_INT16));
+    m_dynamicConnectivityRowStorageComboBox->addItem("8-bit",
+                                                     static_cast<int>(CiftiConnectivityMatrixDenseDynamicFile::ROW_STORAGE_NORMALIZED_INT8));
+    QObject::connect(m_dynamicConnectivityRowStorageComboBox, SIGNAL(currentIndexChanged(int)),
+                     this, SLOT(miscDynamicConnectivityRowStorageComboBoxChanged(int)));
+    m_allWidgets->add(m_dynamicConnectivityRowStorageComboBox);
+    m_dynamicConnectivityRowStorageComboBox->setToolTip("How dynamic connectivity keeps the data-series rows used for correlation.  "
+                                                        "\"Read From File\" uses the least memory and is slowest, \"Float\" is exact, "
+                                                        "\"16-bit\" and \"8-bit\" use less memory with a small loss of precision.  "
+                                                        "Applies to data-series files read after the change.");
+    
     /*
      * Logging Level
      */
@@ -394,6 +415,9 @@ PreferencesDialog::createMiscellaneousWidget()
     addWidgetToLayout(gridLayout,
                       "Dynconn As Layer Default: ",
                       m_dynamicConnectivityComboBox->getWidget());
+    addWidgetToLayout(gridLayout,
+                      "Dynconn Row Storage: ",
+                      m_dynamicConnectivityRowStorageComboBox);
     addWidgetToLayout(gridLayout,
                       "Logging Level: ",
                       m_miscLoggingLevelComboBox);
@@ -425,6 +449,11 @@ PreferencesDialog::updateMiscellaneousWidget(CaretPreferences* prefs)
 {
     m_dynamicConnectivityComboBox->setStatus(prefs->isDynamicConnectivityDefaultedOn());
     
+    const int rowStorageIndex = m_dynamicConnectivityRowStorageComboBox->findData(prefs->getDynamicConnectivityRowStorage());
+    if (rowStorageIndex >= 0) {
+        m_dynamicConnectivityRowStorageComboBox->setCurrentIndex(rowStorageIndex);
+    }
+    
     const LogLevelEnum::Enum loggingLevel = prefs->getLoggingLevel();
     int indx = m_miscLoggingLevelComboBox->findData(LogLevelEnum::toIntegerCode(loggingLevel));
     if (indx >= 0) {
@@ -1056,6 +1085,17 @@ void PreferencesDialog::miscDynamicConnectivityComboBoxChanged(bool value)
     prefs->setDynamicConnectivityDefaultedOn(value);
 }
 
+/**
+ * Called when dynamic connectivity row storage changed.
+ * @param indx
+ *   Index of item selected.
+ */
+void PreferencesDialog::miscDynamicConnectivityRowStorageComboBoxChanged(int indx)
+{
+    CaretPreferences* prefs = SessionManager::get()->getCaretPreferences();
+    prefs->setDynamicConnectivityRowStorage(m_dynamicConnectivityRowStorageComboBox->itemData(indx).toInt());
+}
+
 /**
  * Called when show develop menu option changed.
  * @param value
@@ -61,6 +61,7 @@ namespace caret {
         void miscSpecFileDialogViewFilesTypeEnumComboBoxItemActivated();
         
         void miscDynamicConnectivityComboBoxChanged(bool value);
+        void miscDynamicConnectivityRowStorageComboBoxChanged(int);
         
         void openGLDrawingMethodEnumComboBoxItemActivated();
         void openGLImageCaptureMethodEnumComboBoxItemActivated();
@@ -144,6 +145,8 @@ namespace caret {
 
         WuQTrueFalseComboBox* m_dynamicConnectivityComboBox;
         
+        QComboBox* m_dynamicConnectivityRowStorageComboBox;
+        
         EnumComboBoxTemplate* m_volumeAllSlicePlanesLayoutComboBox;
         WuQTrueFalseComboBox* m_volumeAxesCrosshairsComboBox;
         WuQTrueFalseComboBox* m_volumeAxesLabelsComboBox;
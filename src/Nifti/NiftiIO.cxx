@@ -27,8 +27,11 @@ using namespace caret;
 
 void NiftiIO::openRead(const QString& filename)
 {
+    m_mappedData = NULL;
     m_file.open(filename);
     m_header.read(m_file);
+    m_positional = m_file.supportsPositionalIO();
+    m_randomAccess = m_file.supportsRandomAccess();
     if (m_header.getDataType() == DT_BINARY)
     {
         throw DataFileException("file uses the binary datatype, which is unsupported: " + filename);
@@ -44,6 +47,14 @@ void NiftiIO::openRead(const QString& filename)
     {
         throw DataFileException("nifti file is truncated: " + filename);
     }
+    const char* fileMap = m_file.getMemoryMap();//NULL for compressed files, or if mapping failed
+    double mult, offset;
+    if (fileMap != NULL && m_header.getDataType() == NIFTI_TYPE_FLOAT32 && !m_header.isSwapped() &&
+        !m_header.getDataScaling(mult, offset) && m_header.getDataOffset() % sizeof(float) == 0)
+    {
+        m_mappedData = (const float*)(fileMap + m_header.getDataOffset());
+        m_mappedCount = (filesize - m_header.getDataOffset()) / sizeof(float);
+    }
 }
 
 void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const int& version, const bool& withRead, const bool& swapEndian)
@@ -52,6 +63,7 @@ void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const
     {
         throw DataFileException("writing NIFTI with binary datatype is unsupported");
     }
+    m_mappedData = NULL;
     if (withRead)
     {
         m_file.open(filename, CaretBinaryFile::READ_WRITE_TRUNCATE);//for cifti on-disk writing, replace structure with along row needs to RMW
@@ -60,11 +72,16 @@ void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const
     }
     m_header = header;
     m_header.write(m_file, version, swapEndian);
+    m_positional = m_file.supportsPositionalIO();
+    m_randomAccess = m_file.supportsRandomAccess();
+    if (m_positional) m_file.flush();//positional writes bypass the buffered header
     m_dims = m_header.getDimensions();
 }
 
 void NiftiIO::close()
 {
+    m_mappedData = NULL;
+    m_positional = false;
     m_file.close();
     m_dims.clear();
 }
@@ -44,6 +44,10 @@ namespace caret
         std::vector<int64_t> m_dims;
         std::vector<char> m_scratch;//scratch memory for byteswapping, type conversion, etc
         CaretMutex m_mutex;//protect multithreaded calls from each other
+        const float* m_mappedData;//start of the data in the memory map, only set for native-endian unscaled FLOAT32, needs no scratch or mutex
+        int64_t m_mappedCount;//number of floats available after m_mappedData
+        bool m_positional;//file supports readAt/writeAt, so data access doesn't need the mutex or shared scratch
+        bool m_randomAccess;//reading frames out of order doesn't decompress the file again
         int numBytesPerElem();//for resizing scratch
         template<typename TO, typename FROM>
         void convertRead(TO* out, FROM* in, const int64_t& count);//for reading from file
@@ -51,7 +55,14 @@ namespace caret
         void convertWrite(TO* out, const FROM* in, const int64_t& count);//for writing to file
         template<typename TO, typename FROM>
         static TO clamp(const FROM& in);//deal with integer cast being undefined when converting from outside range
+        template<typename T>
+        static void convertMapped(T* out, const float* in, const int64_t& count);
+        template<typename T>
+        void convertFromScratch(T* dataOut, char* scratch, const int64_t& numElems);//switch on file datatype, scratch holds raw file bytes
+        template<typename T>
+        void convertToScratch(char* scratch, const T* dataIn, const int64_t& numElems);
     public:
+        NiftiIO() { m_mappedData = NULL; m_mappedCount = 0; m_positional = false; m_randomAccess = false; }
         void openRead(const QString& filename);
         void writeNew(const QString& filename, const NiftiHeader& header, const int& version = 1, const bool& withRead = false, const bool& swapEndian = false);
         QString getFilename() const { return m_file.getFilename(); }
@@ -60,6 +71,8 @@ namespace caret
         const NiftiHeader& getHeader() const { return m_header; }
         const std::vector<int64_t>& getDimensions() const { return m_dims; }
         int getNumComponents() const;
+        bool hasParallelAccess() const { return m_positional; }//readData and writeData don't serialize on the mutex
+        bool hasRandomAccess() const { return m_randomAccess; }//false for .gz files without a block index
         //to read/write 1 frame of a standard volume file, call with fullDims = 3, indexSelect containing indexes for any of dims 4-7 that exist
         //NOTE: you need to provide storage for all components within the range, if getNumComponents() == 3 and fullDims == 0, you need 3 elements allocated
         template<typename T>
@@ -86,55 +99,111 @@ namespace caret
             numSkip += indexSelect[curDim - fullDims] * numDimSkip;
             numDimSkip *= m_dims[curDim];
         }
+        if (m_mappedData != NULL)
+        {
+            if (numSkip + numElems > m_mappedCount) throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");//only possible with overridden dimensions
+            convertMapped(dataOut, m_mappedData + numSkip, numElems);//lets parallel readers proceed without the mutex
+            return;
+        }
+        int64_t numRead = 0;
+        if (m_positional)
+        {//positional reads don't touch the shared file position, so each call can use its own scratch space and skip the mutex
+            std::vector<char> scratch(numElems * numBytesPerElem());
+            m_file.readAt(numSkip * numBytesPerElem() + m_header.getDataOffset(), scratch.data(), scratch.size(), &numRead);
+            if ((numRead != (int64_t)scratch.size() && !tolerateShortRead) || numRead < 0)
+            {
+                throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");
+            }
+            convertFromScratch(dataOut, scratch.data(), numElems);
+            return;
+        }
         CaretMutexLocker locked(&m_mutex);//protect starting with resizing until we are done converting, because we use an internal variable for scratch space
         //we can't guarantee that the output memory is enough to use as scratch space, as we might be doing a narrowing conversion
         //we are doing FILE ACCESS, so cpu performance isn't really something to worry about
         m_scratch.resize(numElems * numBytesPerElem());
         m_file.seek(numSkip * numBytesPerElem() + m_header.getDataOffset());
-        int64_t numRead = 0;
         m_file.read(m_scratch.data(), m_scratch.size(), &numRead);
         if ((numRead != (int64_t)m_scratch.size() && !tolerateShortRead) || numRead < 0)//for now, assume read giving -1 is always a problem
         {
             throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");
         }
+        convertFromScratch(dataOut, m_scratch.data(), numElems);
+    }
+    
+    template<typename T>
+    void NiftiIO::writeData(const T* dataIn, const int& fullDims, const std::vector<int64_t>& indexSelect)
+    {
+        CaretAssert(fullDims >= 0 && fullDims <= (int)m_dims.size());
+        CaretAssert((size_t)fullDims + indexSelect.size() == m_dims.size());//could be >=, but should catch more stupid mistakes as ==
+        int64_t numElems = getNumComponents();//for now, calculate read size on the fly, as the read call will be the slowest part
+        int curDim;
+        for (curDim = 0; curDim < fullDims; ++curDim)
+        {
+            numElems *= m_dims[curDim];
+        }
+        int64_t numDimSkip = numElems, numSkip = 0;
+        for (; curDim < (int)m_dims.size(); ++curDim)
+        {
+            CaretAssert(indexSelect[curDim - fullDims] >= 0 && indexSelect[curDim - fullDims] < m_dims[curDim]);
+            numSkip += indexSelect[curDim - fullDims] * numDimSkip;
+            numDimSkip *= m_dims[curDim];
+        }
+        if (m_positional)
+        {//as in readData, positional writes to different locations don't need to be serialized
+            std::vector<char> scratch(numElems * numBytesPerElem());
+            convertToScratch(scratch.data(), dataIn, numElems);
+            m_file.writeAt(numSkip * numBytesPerElem() + m_header.getDataOffset(), scratch.data(), scratch.size());
+            return;
+        }
+        CaretMutexLocker locked(&m_mutex);//protect starting with resizing until we are done writing, because we use an internal variable for scratch space
+        //we are doing FILE ACCESS, so cpu performance isn't really something to worry about
+        m_scratch.resize(numElems * numBytesPerElem());
+        m_file.seek(numSkip * numBytesPerElem() + m_header.getDataOffset());
+        convertToScratch(m_scratch.data(), dataIn, numElems);
+        m_file.write(m_scratch.data(), m_scratch.size());
+    }
+    
+    template<typename T>
+    void NiftiIO::convertFromScratch(T* dataOut, char* scratch, const int64_t& numElems)
+    {
         switch (m_header.getDataType())
         {
             case NIFTI_TYPE_UINT8:
             case NIFTI_TYPE_RGB24://handled by components
-                convertRead(dataOut, (uint8_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint8_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_INT8:
-                convertRead(dataOut, (int8_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int8_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_UINT16:
-                convertRead(dataOut, (uint16_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint16_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_INT16:
-                convertRead(dataOut, (int16_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int16_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_UINT32:
-                convertRead(dataOut, (uint32_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint32_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_INT32:
-                convertRead(dataOut, (int32_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int32_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_UINT64:
-                convertRead(dataOut, (uint64_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint64_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_INT64:
-                convertRead(dataOut, (int64_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int64_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_FLOAT32:
             case NIFTI_TYPE_COMPLEX64://components
-                convertRead(dataOut, (float*)m_scratch.data(), numElems);
+                convertRead(dataOut, (float*)scratch, numElems);
                 break;
             case NIFTI_TYPE_FLOAT64:
             case NIFTI_TYPE_COMPLEX128:
-                convertRead(dataOut, (double*)m_scratch.data(), numElems);
+                convertRead(dataOut, (double*)scratch, numElems);
                 break;
             case NIFTI_TYPE_FLOAT128:
             case NIFTI_TYPE_COMPLEX256:
-                convertRead(dataOut, (long double*)m_scratch.data(), numElems);
+                convertRead(dataOut, (long double*)scratch, numElems);
                 break;
             default:
                 CaretAssert(0);
@@ -143,71 +212,51 @@ namespace caret
     }
     
     template<typename T>
-    void NiftiIO::writeData(const T* dataIn, const int& fullDims, const std::vector<int64_t>& indexSelect)
+    void NiftiIO::convertToScratch(char* scratch, const T* dataIn, const int64_t& numElems)
     {
-        CaretAssert(fullDims >= 0 && fullDims <= (int)m_dims.size());
-        CaretAssert((size_t)fullDims + indexSelect.size() == m_dims.size());//could be >=, but should catch more stupid mistakes as ==
-        int64_t numElems = getNumComponents();//for now, calculate read size on the fly, as the read call will be the slowest part
-        int curDim;
-        for (curDim = 0; curDim < fullDims; ++curDim)
-        {
-            numElems *= m_dims[curDim];
-        }
-        int64_t numDimSkip = numElems, numSkip = 0;
-        for (; curDim < (int)m_dims.size(); ++curDim)
-        {
-            CaretAssert(indexSelect[curDim - fullDims] >= 0 && indexSelect[curDim - fullDims] < m_dims[curDim]);
-            numSkip += indexSelect[curDim - fullDims] * numDimSkip;
-            numDimSkip *= m_dims[curDim];
-        }
-        CaretMutexLocker locked(&m_mutex);//protect starting with resizing until we are done writing, because we use an internal variable for scratch space
-        //we are doing FILE ACCESS, so cpu performance isn't really something to worry about
-        m_scratch.resize(numElems * numBytesPerElem());
-        m_file.seek(numSkip * numBytesPerElem() + m_header.getDataOffset());
         switch (m_header.getDataType())
         {
             case NIFTI_TYPE_UINT8:
             case NIFTI_TYPE_RGB24://handled by components
-                convertWrite((uint8_t*)m_scratch.data(), dataIn, numElems);
+                convertWrite((uint8_t*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_INT8:
-                convertWrite((int8_t*)m_scratch.data(), dataIn, numElems);
+                convertWrite((int8_t*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_UINT16:
-                convertWrite((uint16_t*)m_scratch.data(), dataIn, numElems);
+                convertWrite((uint16_t*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_INT16:
-                convertWrite((int16_t*)m_scratch.data(), dataIn, numElems);
+                convertWrite((int16_t*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_UINT32:
-                convertWrite((uint32_t*)m_scratch.data(), dataIn, numElems);
+                convertWrite((uint32_t*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_INT32:
-                convertWrite((int32_t*)m_scratch.data(), dataIn, numElems);
+                convertWrite((int32_t*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_UINT64:
-                convertWrite((uint64_t*)m_scratch.data(), dataIn, numElems);
+                convertWrite((uint64_t*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_INT64:
-                convertWrite((int64_t*)m_scratch.data(), dataIn, numElems);
+                convertWrite((int64_t*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_FLOAT32:
             case NIFTI_TYPE_COMPLEX64://components
-                convertWrite((float*)m_scratch.data(), dataIn, numElems);
+                convertWrite((float*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_FLOAT64:
             case NIFTI_TYPE_COMPLEX128:
-                convertWrite((double*)m_scratch.data(), dataIn, numElems);
+                convertWrite((double*)scratch, dataIn, numElems);
                 break;
             case NIFTI_TYPE_FLOAT128:
             case NIFTI_TYPE_COMPLEX256:
-                convertWrite((long double*)m_scratch.data(), dataIn, numElems);
+                convertWrite((long double*)scratch, dataIn, numElems);
                 break;
             default:
                 CaretAssert(0);
                 throw DataFileException("internal error, tell the developers what you just tried to do");
         }
-        m_file.write(m_scratch.data(), m_scratch.size());
     }
     
     template<typename TO, typename FROM>
@@ -285,6 +334,23 @@ namespace caret
         if (m_header.isSwapped()) ByteSwapping::swapArray(out, count);
     }
     
+    template<typename T>
+    void NiftiIO::convertMapped(T* out, const float* in, const int64_t& count)
+    {
+        if (std::numeric_limits<T>::is_integer)//same rounding as convertRead
+        {
+            for (int64_t i = 0; i < count; ++i)
+            {
+                out[i] = clamp<T, double>(floor(0.5 + in[i]));
+            }
+        } else {
+            for (int64_t i = 0; i < count; ++i)
+            {
+                out[i] = (T)in[i];
+            }
+        }
+    }
+    
     template<typename TO, typename FROM>
     TO NiftiIO::clamp(const FROM& in)
     {
@@ -24,10 +24,12 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 #include "CiftiXML.h"
 #include "MultiDimIterator.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace caret;
@@ -235,57 +237,100 @@ void OperationCiftiMath::useParameters(OperationParameters* myParams, ProgressOb
     }
     if (outXML.getNumberOfDimensions() < 1) throw OperationException("output must have at least 1 dimension");
     myCiftiOut->setCiftiXML(outXML);
-    vector<float> values(numVars), scratchRow(outDims[0]);
-    vector<vector<float> > inputRows(numVars);
+    int64_t rowLength = outDims[0];
+    vector<int64_t> iterDims(outDims.begin() + 1, outDims.end());
+    int64_t totalRows = 1;
+    for (int i = 0; i < (int)iterDims.size(); ++i) totalRows *= iterDims[i];
+    const int64_t BATCH_ELEMENTS = 1<<22;//read this much of each input before evaluating the batch in parallel
+    int batchRows = (int)max((int64_t)1, min(min((int64_t)1024, totalRows), BATCH_ELEMENTS / max(rowLength, (int64_t)1)));
+    vector<vector<vector<float> > > inputRows(numVars, vector<vector<float> >(batchRows));//[var][batch slot]
+    vector<vector<const float*> > rowPointers(batchRows, vector<const float*>(numVars, (const float*)NULL));//[batch slot][var], rows that don't change share a buffer
     vector<vector<int64_t> > loadedRow(numVars);//to detect and prevent rereading the same row
     for (int v = 0; v < numVars; ++v)
     {
-        inputRows[v].resize(varCiftiFiles[v]->getCiftiXML().getDimensionLength(CiftiXML::ALONG_ROW));
+        int64_t varRowLength = varCiftiFiles[v]->getCiftiXML().getDimensionLength(CiftiXML::ALONG_ROW);
+        for (int b = 0; b < batchRows; ++b)
+        {
+            inputRows[v][b].resize(varRowLength);
+        }
         loadedRow[v].resize(varCiftiFiles[v]->getCiftiXML().getNumberOfDimensions() - 1, -1);//we always load a full row, so ignore first dim
     }
-    for (MultiDimIterator<int64_t> iter(vector<int64_t>(outDims.begin() + 1, outDims.end())); !iter.atEnd(); ++iter)
+    vector<vector<float> > outRows(batchRows, vector<float>(rowLength));
+    vector<vector<int64_t> > batchIndices(batchRows);
+    vector<const float*> lastLoaded(numVars, (const float*)NULL);
+    MultiDimIterator<int64_t> iter(iterDims);
+    while (!iter.atEnd())
     {
-        for (int v = 0; v < numVars; ++v)//first, retrieve whichever rows are needed
+        int batchUsed = 0;
+        for (int v = 0; v < numVars; ++v)//carry the previously loaded row into slot 0, in case the next rows don't need a new one
         {
-            bool needToLoad = false;
-            for (int dim = 0; dim < (int)loadedRow[v].size(); ++dim)
+            if (lastLoaded[v] != NULL && lastLoaded[v] != inputRows[v][0].data())
             {
-                int64_t indexNeeded = -1;
-                if (selectInfo[v][dim + 1] == -1)
+                inputRows[v][0].assign(lastLoaded[v], lastLoaded[v] + inputRows[v][0].size());
+                lastLoaded[v] = inputRows[v][0].data();
+            }
+        }
+        for (; batchUsed < batchRows && !iter.atEnd(); ++batchUsed, ++iter)
+        {//reading stays sequential, in the same order as before
+            batchIndices[batchUsed] = *iter;
+            for (int v = 0; v < numVars; ++v)//first, retrieve whichever rows are needed
+            {
+                bool needToLoad = false;
+                for (int dim = 0; dim < (int)loadedRow[v].size(); ++dim)
                 {
-                    CaretAssert(dim + 1 < (int)outDims.size());//"match to output index" can't work past output dimensionality
-                    indexNeeded = (*iter)[dim];//NOTE: iter also doesn't include the first dim
-                } else {
-                    indexNeeded = selectInfo[v][dim + 1];
+                    int64_t indexNeeded = -1;
+                    if (selectInfo[v][dim + 1] == -1)
+                    {
+                        CaretAssert(dim + 1 < (int)outDims.size());//"match to output index" can't work past output dimensionality
+                        indexNeeded = (*iter)[dim];//NOTE: iter also doesn't include the first dim
+                    } else {
+                        indexNeeded = selectInfo[v][dim + 1];
+                    }
+                    if (indexNeeded != loadedRow[v][dim])
+                    {
+                        needToLoad = true;
+                        loadedRow[v][dim] = indexNeeded;
+                    }
                 }
-                if (indexNeeded != loadedRow[v][dim])
+                if (needToLoad || lastLoaded[v] == NULL)
                 {
-                    needToLoad = true;
-                    loadedRow[v][dim] = indexNeeded;
+                    varCiftiFiles[v]->getRow(inputRows[v][batchUsed].data(), loadedRow[v]);
+                    lastLoaded[v] = inputRows[v][batchUsed].data();
                 }
-            }
-            if (needToLoad)
-            {
-                varCiftiFiles[v]->getRow(inputRows[v].data(), loadedRow[v]);
+                rowPointers[batchUsed][v] = lastLoaded[v];
             }
         }
-        for (int j = 0; j < outDims[0]; ++j)
+#pragma omp CARET_PAR
         {
-            for (int v = 0; v < numVars; ++v)//now we check for select along row
+            vector<vector<float> > selectScratch(numVars);//for -select along row, the selected value repeated along the row
+            vector<const float*> evalPointers(numVars);
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int b = 0; b < batchUsed; ++b)
             {
-                if (selectInfo[v][0] == -1)
+                for (int v = 0; v < numVars; ++v)//now we check for select along row
                 {
-                    values[v] = inputRows[v][j];
-                } else {
-                    values[v] = inputRows[v][selectInfo[v][0]];
+                    if (selectInfo[v][0] == -1)
+                    {
+                        evalPointers[v] = rowPointers[b][v];
+                    } else {
+                        selectScratch[v].assign(rowLength, rowPointers[b][v][selectInfo[v][0]]);
+                        evalPointers[v] = selectScratch[v].data();
+                    }
+                }
+                float* outRow = outRows[b].data();
+                myExpr.evaluateRow(outRow, evalPointers, rowLength);
+                if (nanfix)
+                {
+                    for (int64_t j = 0; j < rowLength; ++j)
+                    {
+                        if (outRow[j] != outRow[j]) outRow[j] = nanfixval;
+                    }
                 }
             }
-            scratchRow[j] = (float)myExpr.evaluate(values);
-            if (nanfix && scratchRow[j] != scratchRow[j])
-            {
-                scratchRow[j] = nanfixval;
-            }
         }
-        myCiftiOut->setRow(scratchRow.data(), *iter);
+        for (int b = 0; b < batchUsed; ++b)
+        {
+            myCiftiOut->setRow(outRows[b].data(), batchIndices[b]);
+        }
     }
 }
@@ -21,13 +21,14 @@
 #include "OperationConvertMatrix4ToWorkbenchSparse.h"
 #include "OperationException.h"
 
-#include "CaretHeap.h"
+#include "CaretOMP.h"
 #include "CaretSparseFile.h"
 #include "CiftiFile.h"
 #include "OxfordSparseThreeFile.h"
 #include "MetricFile.h"
 #include "VolumeFile.h"
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <vector>
@@ -64,9 +65,12 @@ OperationParameters* OperationConvertMatrix4ToWorkbenchSparse::getParameters()
     volumeOpt->addCiftiParameter(1, "cifti-template", "cifti file to use the volume mappings from");
     volumeOpt->addStringParameter(2, "direction", "dimension along the cifti file to take the mapping from, ROW or COLUMN");
     
+    ret->createOptionalParameter(9, "-compress", "write the compressed wbsparse format");
+    
     ret->setHelpText(
         AString("Converts the matrix 4 output of probtrackx to workbench sparse file format.  ") +
-        "Exactly one of -surface-seeds and -volume-seeds must be specified."
+        "Exactly one of -surface-seeds and -volume-seeds must be specified.  " +
+        "The compressed format specified by -compress is much smaller, but can't be read by older versions of workbench."
     );
     return ret;
 }
@@ -84,6 +88,7 @@ void OperationConvertMatrix4ToWorkbenchSparse::useParameters(OperationParameters
     const int64_t* sparseDims = inFile.getDimensions();
     OptionalParameter* surfaceOpt = myParams->getOptionalParameter(7);
     OptionalParameter* volumeOpt = myParams->getOptionalParameter(8);
+    bool compressed = myParams->getOptionalParameter(9)->m_present;
     if (surfaceOpt->m_present == volumeOpt->m_present) throw OperationException("you must specify exactly one of -surface-seeds and -volume-seeds");//use == on booleans as xnor
     const CiftiXML& orientXML = orientationFile->getCiftiXML();
     if (orientXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS) throw OperationException("orientation file must have brain models mapping along column");
@@ -180,34 +185,50 @@ void OperationConvertMatrix4ToWorkbenchSparse::useParameters(OperationParameters
             rowReorder[i / 3] = tempInd;
         }
     }
-    CaretSparseFileWriter mywriter(outFileName, myXML);//NOTE: CaretSparseFile has a different encoding of fibers, ALWAYS use getFibersRow, etc
-    vector<int64_t> indicesIn, indicesOut;//this method knows about sparseness, does sorting of indexes in order to avoid scanning full rows
-    vector<FiberFractions> fibersIn, fibersOut;//can be slower if matrix isn't very sparse, but that is a problem for other reasons anyway
-    CaretMinHeap<FiberFractions, int64_t> myHeap;//use our heap to do heapsort, rather than coding a struct for stl sort
-    for (int64_t i = 0; i < sparseDims[1]; ++i)
+    CaretSparseFileWriter mywriter(outFileName, myXML, compressed);//NOTE: CaretSparseFile has a different encoding of fibers, ALWAYS use getFibersRow, etc
+    const int64_t BLOCK_ROWS = 1024;//rows are read and written in order, and reordered in parallel in between, so memory is bounded by the block
+    vector<vector<int64_t> > indicesIn(BLOCK_ROWS), indicesOut(BLOCK_ROWS);//this method knows about sparseness, does sorting of indexes in order to avoid scanning full rows
+    vector<vector<FiberFractions> > fibersIn(BLOCK_ROWS), fibersOut(BLOCK_ROWS);//can be slower if matrix isn't very sparse, but that is a problem for other reasons anyway
+    for (int64_t blockStart = 0; blockStart < sparseDims[1]; blockStart += BLOCK_ROWS)
     {
-        inFile.getFibersRowSparse(i, indicesIn, fibersIn);
-        size_t numNonzero = indicesIn.size();
-        myHeap.reserve(numNonzero);
-        for (size_t j = 0; j < numNonzero; ++j)
+        int64_t blockEnd = min(blockStart + BLOCK_ROWS, sparseDims[1]);
+        for (int64_t i = blockStart; i < blockEnd; ++i)
+        {
+            inFile.getFibersRowSparse(i, indicesIn[i - blockStart], fibersIn[i - blockStart]);
+        }
+#pragma omp CARET_PAR
         {
-            int64_t newIndex = rowReorder[indicesIn[j]];//reorder
-            if (newIndex != -1)
+            vector<pair<int64_t, size_t> > sortPairs;
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int64_t i = blockStart; i < blockEnd; ++i)
             {
-                myHeap.push(fibersIn[j], newIndex);//heapify
+                const vector<int64_t>& rowIndicesIn = indicesIn[i - blockStart];
+                size_t numNonzero = rowIndicesIn.size();
+                sortPairs.clear();
+                for (size_t j = 0; j < numNonzero; ++j)
+                {
+                    int64_t newIndex = rowReorder[rowIndicesIn[j]];//reorder
+                    if (newIndex != -1)
+                    {
+                        sortPairs.push_back(pair<int64_t, size_t>(newIndex, j));
+                    }
+                }
+                sort(sortPairs.begin(), sortPairs.end());
+                vector<int64_t>& rowIndicesOut = indicesOut[i - blockStart];
+                vector<FiberFractions>& rowFibersOut = fibersOut[i - blockStart];
+                rowIndicesOut.resize(sortPairs.size());
+                rowFibersOut.resize(sortPairs.size());
+                for (size_t j = 0; j < sortPairs.size(); ++j)
+                {
+                    rowIndicesOut[j] = sortPairs[j].first;
+                    rowFibersOut[j] = fibersIn[i - blockStart][sortPairs[j].second];
+                }
             }
         }
-        indicesOut.resize(myHeap.size());
-        fibersOut.resize(myHeap.size());
-        int64_t curIndex = 0;
-        while (!myHeap.isEmpty())
+        for (int64_t i = blockStart; i < blockEnd; ++i)
         {
-            int64_t newIndex;
-            fibersOut[curIndex] = myHeap.pop(&newIndex);
-            indicesOut[curIndex] = newIndex;
-            ++curIndex;
+            mywriter.writeFibersRowSparse(i, indicesOut[i - blockStart], fibersOut[i - blockStart]);
         }
-        mywriter.writeFibersRowSparse(i, indicesOut, fibersOut);
     }
     mywriter.finish();
 }
@@ -24,8 +24,10 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
+#include "CaretOMP.h"
 #include "MetricFile.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace caret;
@@ -181,7 +183,7 @@ void OperationMetricMath::useParameters(OperationParameters* myParams, ProgressO
     {
         throw OperationException("all -var options used -repeat, there is no file to get number of desired output columns from");
     }
-    vector<float> values(numVars), colScratch(numNodes);
+    vector<float> colScratch(numNodes);
     vector<const float*> columnPointers(numVars);
     myMetricOut->setNumberOfNodesAndColumns(numNodes, numColumns);
     myMetricOut->setStructure(myStructure);
@@ -197,16 +199,27 @@ void OperationMetricMath::useParameters(OperationParameters* myParams, ProgressO
                 columnPointers[v] = varMetrics[v]->getValuePointerForColumn(metricColumns[v]);
             }
         }
-        for (int i = 0; i < numNodes; ++i)
+        const int CHUNK_SIZE = 1<<14;//split the column so threads get evenly sized pieces
+        int numChunks = (numNodes + CHUNK_SIZE - 1) / CHUNK_SIZE;
+#pragma omp CARET_PAR
         {
-            for (int v = 0; v < numVars; ++v)
+            vector<const float*> chunkInputs(numVars);
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int chunk = 0; chunk < numChunks; ++chunk)
             {
-                values[v] = columnPointers[v][i];
-            }
-            colScratch[i] = (float)myExpr.evaluate(values);
-            if (nanfix && colScratch[i] != colScratch[i])
-            {
-                colScratch[i] = nanfixval;
+                int chunkStart = chunk * CHUNK_SIZE, chunkCount = min(CHUNK_SIZE, numNodes - chunkStart);
+                for (int v = 0; v < numVars; ++v)
+                {
+                    chunkInputs[v] = columnPointers[v] + chunkStart;
+                }
+                myExpr.evaluateRow(colScratch.data() + chunkStart, chunkInputs, chunkCount);
+                if (nanfix)
+                {
+                    for (int i = chunkStart; i < chunkStart + chunkCount; ++i)
+                    {
+                        if (colScratch[i] != colScratch[i]) colScratch[i] = nanfixval;
+                    }
+                }
             }
         }
         myMetricOut->setValuesForColumn(j, colScratch.data());
@@ -20,15 +20,24 @@
 
 #include "OperationProbtrackXDotConvert.h"
 #include "OperationException.h"
+#include "CaretAssert.h"
+#include "CaretHeap.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "CaretPointer.h"
 #include "CiftiFile.h"
 #include "MetricFile.h"
 #include "StructureEnum.h"
 #include "VolumeFile.h"
 
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
 #include <algorithm>
 #include <fstream>
 #include <map>
+#include <set>
 #include <vector>
 
 using namespace caret;
@@ -45,6 +54,302 @@ struct SparseValue
     }
 };
 
+namespace
+{
+    //sorts values into output row order while holding a bounded number of them in memory, sorted runs are spilled to temporary files and merged while reading
+    class DotValueSorter
+    {
+        static const int MAX_MERGE_RUNS = 64;//a merge opens every run it reads, so merge in passes to keep the number of open files bounded
+        int64_t m_runCapacity;//-1 for no limit
+        vector<SparseValue> m_buffer, m_scratch;
+        bool m_bufferSorted;
+        bool m_allSorted;
+        SparseValue m_lastAdded;
+        int64_t m_numAdded;
+        set<AString> m_tempFileNames;//every temporary file not yet removed, so they are cleaned up even on error
+        vector<AString> m_runNames;
+        vector<int64_t> m_runLengths;
+        int64_t m_memPos;
+        vector<CaretPointer<QFile> > m_runFiles;//only open while merging
+        vector<vector<SparseValue> > m_runBuffers;
+        vector<int64_t> m_runBufferPos, m_runRead;
+        CaretSimpleMinHeap<int, int32_t> m_heap;//which run has the next value, keyed by output row
+        void sortBuffer();
+        void spillBuffer();
+        CaretPointer<QFile> createRunFile();
+        void removeRunFile(const AString& fileName);
+        static void writeRunData(QFile* runFile, const vector<SparseValue>& values);
+        void startMerge(const int64_t& bufferValues);
+        bool fillRunBuffer(const int& run);
+        bool nextMerged(SparseValue& valueOut);
+        void mergePass();
+        DotValueSorter(const DotValueSorter&);
+        DotValueSorter& operator=(const DotValueSorter&);
+    public:
+        DotValueSorter(const int64_t& runCapacity) : m_runCapacity(runCapacity), m_bufferSorted(true), m_allSorted(true), m_numAdded(0), m_memPos(0) { }
+        ~DotValueSorter();
+        void add(const SparseValue& value)
+        {
+            if (m_numAdded > 0 && value < m_lastAdded)
+            {
+                m_allSorted = false;
+                if (!m_buffer.empty()) m_bufferSorted = false;//a spilled run doesn't need to be in order with the next one
+            }
+            m_lastAdded = value;
+            ++m_numAdded;
+            m_buffer.push_back(value);
+            if (m_runCapacity > 0 && (int64_t)m_buffer.size() >= m_runCapacity)
+            {
+                spillBuffer();
+            }
+        }
+        bool isSorted() const { return m_allSorted; }
+        void finishAdding();
+        bool next(SparseValue& valueOut);
+    };
+    
+    DotValueSorter::~DotValueSorter()
+    {
+        m_runFiles.clear();//close before removing
+        for (set<AString>::const_iterator iter = m_tempFileNames.begin(); iter != m_tempFileNames.end(); ++iter)
+        {
+            QFile::remove(*iter);
+        }
+    }
+    
+    void DotValueSorter::sortBuffer()
+    {//with a memory limit, sort chunks in parallel, then merge neighboring chunks pairwise, each round of merges is independent
+        if (m_bufferSorted) return;
+        int64_t numValues = (int64_t)m_buffer.size();
+        int numChunks = 1;
+#ifdef CARET_OMP
+        numChunks = omp_get_max_threads();
+#endif
+        if (numValues < (int64_t)numChunks * 65536) numChunks = 1;
+        if (m_runCapacity <= 0) numChunks = 1;//without a limit, the buffer may be most of memory, so sort in place rather than merging into a second buffer
+        vector<int64_t> bounds(numChunks + 1);
+        for (int c = 0; c <= numChunks; ++c)
+        {
+            bounds[c] = numValues * c / numChunks;
+        }
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int c = 0; c < numChunks; ++c)
+        {
+            sort(m_buffer.begin() + bounds[c], m_buffer.begin() + bounds[c + 1]);
+        }
+        if (numChunks > 1)
+        {//the run capacity leaves room for this
+            m_scratch.resize(numValues);
+            for (int width = 1; width < numChunks; width *= 2)
+            {
+                int numMerges = (numChunks + 2 * width - 1) / (2 * width);
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int m = 0; m < numMerges; ++m)
+                {
+                    int first = m * 2 * width, middle = min(first + width, numChunks), last = min(first + 2 * width, numChunks);
+                    merge(m_buffer.begin() + bounds[first], m_buffer.begin() + bounds[middle],
+                          m_buffer.begin() + bounds[middle], m_buffer.begin() + bounds[last],
+                          m_scratch.begin() + bounds[first]);
+                }
+                m_buffer.swap(m_scratch);
+            }
+        }
+        m_bufferSorted = true;
+    }
+    
+    CaretPointer<QFile> DotValueSorter::createRunFile()
+    {
+        AString fileName;
+        {
+            QTemporaryFile tempFile(QDir::tempPath() + "/wb_dot_sort.XXXXXX");
+            tempFile.setAutoRemove(false);//QTemporaryFile keeps its file handle open until deleted, so only use it to create a unique file
+            if (!tempFile.open())
+            {
+                throw OperationException("failed to create temporary file for sorting in '" + QDir::tempPath() + "'");
+            }
+            fileName = tempFile.fileName();
+        }
+        m_tempFileNames.insert(fileName);
+        CaretPointer<QFile> runFile(new QFile(fileName));
+        if (!runFile->open(QIODevice::WriteOnly))
+        {
+            throw OperationException("failed to open temporary file '" + fileName + "' for writing");
+        }
+        return runFile;
+    }
+    
+    void DotValueSorter::removeRunFile(const AString& fileName)
+    {
+        QFile::remove(fileName);
+        m_tempFileNames.erase(fileName);
+    }
+    
+    void DotValueSorter::writeRunData(QFile* runFile, const vector<SparseValue>& values)
+    {
+        qint64 numBytes = (qint64)(sizeof(SparseValue) * values.size());
+        if (runFile->write((const char*)values.data(), numBytes) != numBytes)
+        {
+            throw OperationException("failed to write temporary file '" + runFile->fileName() + "', check free space in the temporary directory");
+        }
+    }
+    
+    void DotValueSorter::spillBuffer()
+    {
+        sortBuffer();
+        CaretPointer<QFile> runFile = createRunFile();
+        writeRunData(runFile, m_buffer);
+        runFile->close();//reopened for merging, so that many runs don't use up file handles
+        if (runFile->error() != QFile::NoError)
+        {
+            throw OperationException("failed to write temporary file '" + runFile->fileName() + "', check free space in the temporary directory");
+        }
+        m_runNames.push_back(runFile->fileName());
+        m_runLengths.push_back((int64_t)m_buffer.size());
+        m_buffer.clear();//keep allocation for the next run
+        m_bufferSorted = true;
+    }
+    
+    void DotValueSorter::startMerge(const int64_t& bufferValues)
+    {//open every run in m_runNames and start merging them, using about bufferValues of memory for reading
+        int numRuns = (int)m_runNames.size();
+        CaretAssert(numRuns <= MAX_MERGE_RUNS);
+        int64_t perRunBuffer = max((int64_t)4096, bufferValues / numRuns);
+        m_runFiles.assign(numRuns, CaretPointer<QFile>());
+        m_runBuffers.assign(numRuns, vector<SparseValue>());
+        m_runBufferPos.assign(numRuns, 0);
+        m_runRead.assign(numRuns, 0);
+        m_heap.clear();
+        for (int run = 0; run < numRuns; ++run)
+        {
+            m_runFiles[run].grabNew(new QFile(m_runNames[run]));
+            if (!m_runFiles[run]->open(QIODevice::ReadOnly))
+            {
+                throw OperationException("failed to open temporary file '" + m_runNames[run] + "'");
+            }
+            m_runBuffers[run].reserve(min(perRunBuffer, m_runLengths[run]));
+            if (fillRunBuffer(run))
+            {
+                m_heap.push(run, m_runBuffers[run][0].index[1]);
+            }
+        }
+    }
+    
+    void DotValueSorter::mergePass()
+    {//merge groups of runs into longer runs, so that the final merge opens few enough files
+        vector<AString> allNames, newNames;
+        vector<int64_t> allLengths, newLengths;
+        allNames.swap(m_runNames);
+        allLengths.swap(m_runLengths);
+        int numRuns = (int)allNames.size();
+        vector<SparseValue> outBuffer;
+        outBuffer.reserve(m_runCapacity);//the input buffers get the other half of the memory
+        for (int first = 0; first < numRuns; first += MAX_MERGE_RUNS)
+        {
+            int last = min(first + MAX_MERGE_RUNS, numRuns);
+            m_runNames.assign(allNames.begin() + first, allNames.begin() + last);
+            m_runLengths.assign(allLengths.begin() + first, allLengths.begin() + last);
+            startMerge(m_runCapacity);
+            CaretPointer<QFile> outFile = createRunFile();
+            int64_t outLength = 0;
+            SparseValue value;
+            while (nextMerged(value))
+            {
+                outBuffer.push_back(value);
+                if ((int64_t)outBuffer.size() >= m_runCapacity)
+                {
+                    writeRunData(outFile, outBuffer);
+                    outLength += (int64_t)outBuffer.size();
+                    outBuffer.clear();
+                }
+            }
+            writeRunData(outFile, outBuffer);
+            outLength += (int64_t)outBuffer.size();
+            outBuffer.clear();
+            outFile->close();
+            if (outFile->error() != QFile::NoError)
+            {
+                throw OperationException("failed to write temporary file '" + outFile->fileName() + "', check free space in the temporary directory");
+            }
+            newNames.push_back(outFile->fileName());
+            newLengths.push_back(outLength);
+            m_runFiles.clear();
+            for (int run = first; run < last; ++run)
+            {
+                removeRunFile(allNames[run]);
+            }
+        }
+        m_runNames.swap(newNames);
+        m_runLengths.swap(newLengths);
+    }
+    
+    void DotValueSorter::finishAdding()
+    {
+        if (m_runNames.empty())
+        {
+            sortBuffer();
+            m_scratch = vector<SparseValue>();
+            m_memPos = 0;
+            return;
+        }
+        if (!m_buffer.empty())
+        {
+            spillBuffer();
+        }
+        m_buffer = vector<SparseValue>();//the in-memory buffers are free now, give their space to the merge
+        m_scratch = vector<SparseValue>();
+        while ((int)m_runNames.size() > MAX_MERGE_RUNS)
+        {
+            mergePass();
+        }
+        startMerge(2 * m_runCapacity);
+    }
+    
+    bool DotValueSorter::fillRunBuffer(const int& run)
+    {
+        vector<SparseValue>& runBuffer = m_runBuffers[run];
+        int64_t toRead = min((int64_t)runBuffer.capacity(), m_runLengths[run] - m_runRead[run]);
+        runBuffer.resize(toRead);
+        m_runBufferPos[run] = 0;
+        if (toRead == 0)
+        {
+            m_runFiles[run].grabNew(NULL);//done with this run, close it
+            return false;
+        }
+        qint64 numBytes = (qint64)(sizeof(SparseValue) * toRead);
+        if (m_runFiles[run]->read((char*)runBuffer.data(), numBytes) != numBytes)
+        {
+            throw OperationException("failed to read temporary file '" + m_runNames[run] + "'");
+        }
+        m_runRead[run] += toRead;
+        return true;
+    }
+    
+    bool DotValueSorter::nextMerged(SparseValue& valueOut)
+    {
+        if (m_heap.isEmpty()) return false;
+        int run = m_heap.pop();
+        valueOut = m_runBuffers[run][m_runBufferPos[run]];
+        ++m_runBufferPos[run];
+        if (m_runBufferPos[run] < (int64_t)m_runBuffers[run].size() || fillRunBuffer(run))
+        {
+            m_heap.push(run, m_runBuffers[run][m_runBufferPos[run]].index[1]);
+        }
+        return true;
+    }
+    
+    bool DotValueSorter::next(SparseValue& valueOut)
+    {
+        if (m_runNames.empty())
+        {
+            if (m_memPos >= (int64_t)m_buffer.size()) return false;
+            valueOut = m_buffer[m_memPos];
+            ++m_memPos;
+            return true;
+        }
+        return nextMerged(valueOut);
+    }
+}
+
 AString OperationProbtrackXDotConvert::getCommandSwitch()
 {
     return "-probtrackx-dot-convert";
@@ -87,10 +392,14 @@ OperationParameters* OperationProbtrackXDotConvert::getParameters()
     
     ret->createOptionalParameter(8, "-make-symmetric", "transform half-square input into full matrix output");
     
+    OptionalParameter* memLimitOpt = ret->createOptionalParameter(11, "-mem-limit", "restrict memory usage while sorting");
+    memLimitOpt->addDoubleParameter(1, "limit-GB", "memory limit in gigabytes");
+    
     AString myText = AString("NOTE: exactly one -row option and one -col option must be used.\n\n") +
         "If the input file does not have its indexes sorted in the correct ordering, this command may take longer than expected.  " +
         "Specifying -transpose will transpose the input matrix before trying to put its values into the cifti file, which is currently needed for at least matrix2 " +
         "in order to display it as intended.  " +
+        "If -mem-limit is specified, sorting is done in pieces that fit within the limit, which are written to temporary files in the system temporary directory and merged while writing the output.  " +
         "How the cifti file is displayed is based on which -row option is specified: if -row-voxels is specified, then it will display data on volume slices.  " +
         "The label names in the label volume(s) must have the following names, other names are ignored:\n\n";
     vector<StructureEnum::Enum> myStructureEnums;
@@ -116,6 +425,17 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
     OptionalParameter* colCiftiOpt = myParams->getOptionalParameter(10);
     bool transpose = myParams->getOptionalParameter(7)->m_present;
     bool halfMatrix = myParams->getOptionalParameter(8)->m_present;
+    int64_t sortRunCapacity = -1;
+    OptionalParameter* memLimitOpt = myParams->getOptionalParameter(11);
+    if (memLimitOpt->m_present)
+    {
+        double memLimitGB = memLimitOpt->getDouble(1);
+        if (memLimitGB < 0.0)
+        {
+            throw OperationException("memory limit cannot be negative");
+        }
+        sortRunCapacity = max((int64_t)65536, (int64_t)(memLimitGB * 1024 * 1024 * 1024 / (2 * sizeof(SparseValue))));//sorting a run needs a second buffer of the same size
+    }
     int numRowOpts = 0, numColOpts = 0;
     if (rowVoxelOpt->m_present) ++numRowOpts;
     if (rowSurfaceOpt->m_present) ++numRowOpts;
@@ -187,7 +507,7 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
         throw OperationException("error opening text file '" + dotFileName + "'");
     }
     SparseValue tempValue;
-    vector<SparseValue> dotFileContents;
+    DotValueSorter dotFileContents(sortRunCapacity);
     int32_t rowSize = myXML.getNumberOfColumns(), colSize = myXML.getNumberOfRows();
     if (halfMatrix && rowSize != colSize)
     {
@@ -220,13 +540,13 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
                 if (numZeros != 0) afterZero = true;
                 tempValue.index[0] -= 1;//fix for 1-indexing
                 tempValue.index[1] -= 1;
-                dotFileContents.push_back(tempValue);
+                dotFileContents.add(tempValue);
                 if (halfMatrix && tempValue.index[0] != tempValue.index[1])
                 {
                     int32_t tempIndex = tempValue.index[0];
                     tempValue.index[0] = tempValue.index[1];
                     tempValue.index[1] = tempIndex;
-                    dotFileContents.push_back(tempValue);
+                    dotFileContents.add(tempValue);
                 }
             }
         }
@@ -250,13 +570,13 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
                 if (numZeros != 0) afterZero = true;
                 tempValue.index[0] -= 1;//fix for 1-indexing
                 tempValue.index[1] -= 1;
-                dotFileContents.push_back(tempValue);
+                dotFileContents.add(tempValue);
                 if (halfMatrix && tempValue.index[0] != tempValue.index[1])
                 {
                     int32_t tempIndex = tempValue.index[0];
                     tempValue.index[0] = tempValue.index[1];
                     tempValue.index[1] = tempIndex;
-                    dotFileContents.push_back(tempValue);
+                    dotFileContents.add(tempValue);
                 }
             }
         }
@@ -269,81 +589,56 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
     {
         CaretLogWarning("found data lines after dimensionality line (which should be the last line of the file)");
     }
-    bool sorted = true;
-    int64_t numValues = (int64_t)dotFileContents.size();
-    for (int64_t i = 1; i < numValues; ++i)
+    if (!dotFileContents.isSorted() && !halfMatrix)
     {
-        if (dotFileContents[i - 1].index[1] > dotFileContents[i].index[1])
-        {
-            sorted = false;
-            if (!halfMatrix)
-            {
-                CaretLogInfo("dot file indexes are not correctly sorted, sorting them may take a minute or so...");
-            }
-            break;
-        }
+        CaretLogInfo("dot file indexes are not correctly sorted, sorting them may take a minute or so...");
     }
-    if (!sorted) sort(dotFileContents.begin(), dotFileContents.end());
-    if (!sorted && !halfMatrix)
+    dotFileContents.finishAdding();
+    if (!dotFileContents.isSorted() && !halfMatrix)
     {
         CaretLogInfo("sorting finished");
     }
     myCiftiOut->setCiftiXML(myXML);
-    int64_t cur = 0, end = (int64_t)dotFileContents.size();
+    SparseValue nextValue;
+    bool haveNext = dotFileContents.next(nextValue);
+    vector<SparseValue> rowValues;//only one row of values is needed at a time, the rest stay in the sorter
     vector<float> scratchRow(myXML.getNumberOfColumns(), 0.0f);
     vector<bool> checkDuplicate(myXML.getNumberOfColumns(), false);
     int64_t whichRow = 0;//set all rows, in case initial allocation doesn't give a zeroed matrix
     while (whichRow < myXML.getNumberOfRows())
     {
-        int64_t next = cur;
-        while (next < end && dotFileContents[next].index[1] == whichRow) ++next;
-        if (rowVoxelOpt->m_present)
+        rowValues.clear();
+        while (haveNext && nextValue.index[1] == whichRow)
         {
-            for (int64_t i = cur; i < next; ++i)
+            rowValues.push_back(nextValue);
+            haveNext = dotFileContents.next(nextValue);
+        }
+        int64_t numRowValues = (int64_t)rowValues.size();
+        for (int64_t i = 0; i < numRowValues; ++i)
+        {
+            int64_t outIndex = rowValues[i].index[0];
+            if (rowVoxelOpt->m_present)
             {
-                int64_t outIndex = rowReorderMap[dotFileContents[i].index[0]];
-                if (checkDuplicate[outIndex])
-                {
-                    AString elemString;
-                    if (transpose)
-                    {
-                        elemString = AString::number(dotFileContents[i].index[1] + 1) + ", " + AString::number(dotFileContents[i].index[0] + 1);
-                    } else {
-                        elemString = AString::number(dotFileContents[i].index[0] + 1) + ", " + AString::number(dotFileContents[i].index[1] + 1);
-                    }
-                    if (halfMatrix)
-                    {
-                        throw OperationException("element specified more than once: " + elemString + ", perhaps you should not use -make-symmetric");
-                    } else {
-                        throw OperationException("duplicate element found: " + elemString);
-                    }
-                }
-                scratchRow[outIndex] = dotFileContents[i].value;
-                checkDuplicate[outIndex] = true;
+                outIndex = rowReorderMap[outIndex];
             }
-        } else {
-            for (int64_t i = cur; i < next; ++i)
+            if (checkDuplicate[outIndex])
             {
-                int64_t outIndex = dotFileContents[i].index[0];
-                if (checkDuplicate[outIndex])
+                AString elemString;
+                if (transpose)
+                {
+                    elemString = AString::number(rowValues[i].index[1] + 1) + ", " + AString::number(rowValues[i].index[0] + 1);
+                } else {
+                    elemString = AString::number(rowValues[i].index[0] + 1) + ", " + AString::number(rowValues[i].index[1] + 1);
+                }
+                if (halfMatrix)
                 {
-                    AString elemString;
-                    if (transpose)
-                    {
-                        elemString = AString::number(dotFileContents[i].index[1] + 1) + ", " + AString::number(dotFileContents[i].index[0] + 1);
-                    } else {
-                        elemString = AString::number(dotFileContents[i].index[0] + 1) + ", " + AString::number(dotFileContents[i].index[1] + 1);
-                    }
-                    if (halfMatrix)
-                    {
-                        throw OperationException("element specified more than once: " + elemString + ", perhaps you should not use -make-symmetric");
-                    } else {
-                        throw OperationException("duplicate element found: " + elemString);
-                    }
+                    throw OperationException("element specified more than once: " + elemString + ", perhaps you should not use -make-symmetric");
+                } else {
+                    throw OperationException("duplicate element found: " + elemString);
                 }
-                scratchRow[outIndex] = dotFileContents[i].value;
-                checkDuplicate[outIndex] = true;
             }
+            scratchRow[outIndex] = rowValues[i].value;
+            checkDuplicate[outIndex] = true;
         }
         if (colVoxelOpt->m_present)
         {
@@ -351,23 +646,16 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
         } else {
             myCiftiOut->setRow(scratchRow.data(), whichRow);
         }
-        if (rowVoxelOpt->m_present)
+        for (int64_t i = 0; i < numRowValues; ++i)
         {
-            for (int64_t i = cur; i < next; ++i)
-            {
-                int64_t outIndex = rowReorderMap[dotFileContents[i].index[0]];
-                scratchRow[outIndex] = 0.0f;
-                checkDuplicate[outIndex] = false;
-            }
-        } else {
-            for (int64_t i = cur; i < next; ++i)
+            int64_t outIndex = rowValues[i].index[0];
+            if (rowVoxelOpt->m_present)
             {
-                int64_t outIndex = dotFileContents[i].index[0];
-                scratchRow[outIndex] = 0.0f;
-                checkDuplicate[outIndex] = false;
+                outIndex = rowReorderMap[outIndex];
             }
+            scratchRow[outIndex] = 0.0f;
+            checkDuplicate[outIndex] = false;
         }
-        cur = next;
         ++whichRow;
     }
 }
@@ -115,6 +115,8 @@ void OperationSurfaceGeodesicDistanceAllToAll::useParameters(OperationParameters
     myXML.setMap(CiftiXML::ALONG_ROW, myMap);
     myXML.setMap(CiftiXML::ALONG_COLUMN, myMap);
     ciftiOut->setCiftiXML(myXML);
+    ciftiOut->prepareForParallelWrites();
+    const bool parallelWrite = ciftiOut->hasParallelRowIO();//positional writes of different rows don't need to wait on each other
 #pragma omp CARET_PAR
     {
         CaretPointer<GeodesicHelper> privHelper;
@@ -144,9 +146,14 @@ void OperationSurfaceGeodesicDistanceAllToAll::useParameters(OperationParameters
                     outRow[j] = outDists[surfMap[j].m_surfaceNode];
                 }
             }
-#pragma omp critical
+            if (parallelWrite)
             {
                 ciftiOut->setRow(outRow.data(), i);
+            } else {
+#pragma omp critical
+                {
+                    ciftiOut->setRow(outRow.data(), i);
+                }
             }
         }
     }
@@ -24,8 +24,10 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
+#include "CaretOMP.h"
 #include "VolumeFile.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace caret;
@@ -200,7 +202,7 @@ void OperationVolumeMath::useParameters(OperationParameters* myParams, ProgressO
         throw OperationException("all -var options used -repeat, there is no file to get number of desired output subvolumes from");
     }
     int64_t frameSize = outDims[0] * outDims[1] * outDims[2];
-    vector<float> values(numVars), outFrame(frameSize);
+    vector<float> outFrame(frameSize);
     vector<const float*> inputFrames(numVars);
     if (toClone != NULL)
     {//don't take volume type from the selected volume, because we don't check for or copy label tables, nor do we want to (might be changing all the label keys, splitting label by roi...)
@@ -220,18 +222,28 @@ void OperationVolumeMath::useParameters(OperationParameters* myParams, ProgressO
                 inputFrames[v] = varVolumes[v]->getFrame(varSubvolumes[v]);
             }
         }
-        for (int64_t i = 0; i < frameSize; ++i)
+        const int64_t CHUNK_SIZE = 1<<14;//split the frame so threads get evenly sized pieces
+        int64_t numChunks = (frameSize + CHUNK_SIZE - 1) / CHUNK_SIZE;
+#pragma omp CARET_PAR
         {
-            for (int v = 0; v < numVars; ++v)
+            vector<const float*> chunkInputs(numVars);
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int64_t chunk = 0; chunk < numChunks; ++chunk)
             {
-                values[v] = inputFrames[v][i];
-            }
-            float tempf = (float)myExpr.evaluate(values);
-            if (nanfix && tempf != tempf)
-            {
-                tempf = nanfixval;
+                int64_t chunkStart = chunk * CHUNK_SIZE, chunkCount = min(CHUNK_SIZE, frameSize - chunkStart);
+                for (int v = 0; v < numVars; ++v)
+                {
+                    chunkInputs[v] = inputFrames[v] + chunkStart;
+                }
+                myExpr.evaluateRow(outFrame.data() + chunkStart, chunkInputs, chunkCount);
+                if (nanfix)
+                {
+                    for (int64_t i = chunkStart; i < chunkStart + chunkCount; ++i)
+                    {
+                        if (outFrame[i] != outFrame[i]) outFrame[i] = nanfixval;
+                    }
+                }
             }
-            outFrame[i] = tempf;
         }
         myVolOut->setFrame(outFrame.data(), s);
     }
@@ -39,6 +39,7 @@ OperationParameters* OperationVolumeReorient::getParameters()
 {
     OperationParameters* ret = new OperationParameters();
     ret->addVolumeParameter(1, "volume", "the volume to reorient");
+    ret->setInputModifiedInPlace(1);//reoriented in memory before writing
     ret->addStringParameter(2, "orient-string", "the desired orientation");
     ret->addStringParameter(3, "volume-out", "out - the reoriented volume");//fake the "out" parameter formatting, because copying a volume file in memory is currently a problem
     ret->setHelpText(
@@ -42,6 +42,7 @@ OperationParameters* OperationVolumeSetSpace::getParameters()
 {
     OperationParameters* ret = new OperationParameters();
     ret->addVolumeParameter(1, "volume-in", "the input volume");
+    ret->setInputModifiedInPlace(1);//the space is changed in memory before writing
     
     ret->addStringParameter(2, "volume-out", "output - the output volume");//fake the "out" parameter formatting, because copying a volume file in memory is currently a problem
     
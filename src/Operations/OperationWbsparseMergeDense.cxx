@@ -46,8 +46,11 @@ OperationParameters* OperationWbsparseMergeDense::getParameters()
     ParameterComponent* wbsparseOpt = ret->createRepeatableParameter(3, "-wbsparse", "specify an input wbsparse file");
     wbsparseOpt->addStringParameter(1, "wbsparse-in", "a wbsparse file to merge");
     
+    ret->createOptionalParameter(4, "-compress", "write the compressed wbsparse format");
+    
     ret->setHelpText(
-        AString("The input wbsparse files must have matching mappings along the direction not specified, and the mapping along the specified direction must be brain models.")
+        AString("The input wbsparse files must have matching mappings along the direction not specified, and the mapping along the specified direction must be brain models.  ") +
+        "The compressed format specified by -compress is much smaller, but can't be read by older versions of workbench."
     );
     return ret;
 }
@@ -67,6 +70,7 @@ void OperationWbsparseMergeDense::useParameters(OperationParameters* myParams, P
     }
     AString outputName = myParams->getString(2);
     const vector<ParameterComponent*>& myInstances = *(myParams->getRepeatableParameterInstances(3));
+    bool compressed = myParams->getOptionalParameter(4)->m_present;
     vector<CaretPointer<CaretSparseFile> > wbsparseList;
     int numCifti = (int)myInstances.size();
     for (int i = 0; i < numCifti; ++i)
@@ -152,7 +156,7 @@ void OperationWbsparseMergeDense::useParameters(OperationParameters* myParams, P
     int numOutModels = (int)sourceWbsparse.size();
     CaretAssert(numOutModels == (int)newDenseMap.getModelInfo().size());
     int64_t outColSize = outXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
-    CaretSparseFileWriter myWriter(outputName, outXML);
+    CaretSparseFileWriter myWriter(outputName, outXML, compressed);
     vector<CiftiBrainModelsMap::ModelInfo> outModelInfo = newDenseMap.getModelInfo();
     switch (myDir)
     {
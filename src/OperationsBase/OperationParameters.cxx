@@ -219,6 +219,19 @@ AbstractParameter* ParameterComponent::getInputParameter(const int32_t key, cons
     return NULL;
 }
 
+void ParameterComponent::setInputModifiedInPlace(const int32_t key)
+{
+    for (size_t i = 0; i < m_paramList.size(); ++i)
+    {
+        if (m_paramList[i]->m_key == key)
+        {
+            m_paramList[i]->m_modifiedInPlace = true;
+            return;
+        }
+    }
+    CaretAssertMessage(false, "Algorithm tried to mark a parameter it didn't specify");
+}
+
 OptionalParameter* ParameterComponent::getOptionalParameter(const int32_t key)
 {
     for (size_t i = 0; i < m_optionList.size(); ++i)
@@ -46,13 +46,15 @@ namespace caret {
         int32_t m_key;//identifies this parameter uniquely for this algorithm
         AString m_shortName, m_description;
         bool m_operationUsed;//check if the operation called get...() for this parameter
+        bool m_modifiedInPlace;//for input files, the operation changes the file object, so it must not be shared with other commands (see CommandFileCache)
         virtual OperationParametersEnum::Enum getType() = 0;
         virtual AbstractParameter* cloneAbstractParameter() = 0;
         AbstractParameter(int32_t key, const AString& shortName, const AString& description) :
         m_key(key),
         m_shortName(shortName),
         m_description(description),
-        m_operationUsed(false)
+        m_operationUsed(false),
+        m_modifiedInPlace(false)
         {
         };
         virtual ~AbstractParameter();
@@ -135,6 +137,9 @@ namespace caret {
         ///get a cifti with a key
         CiftiFile* getCifti(const int32_t key);
         
+        ///declare that the operation modifies the file object of an input file parameter (surface, volume, cifti), so that batch mode gives it a private copy
+        void setInputModifiedInPlace(const int32_t key);
+        
         ///add a parameter to get next item as a foci file
         void addFociParameter(const int32_t key, const AString& name, const AString& description);
         
@@ -298,6 +303,7 @@ namespace caret {
         virtual AbstractParameter* cloneAbstractParameter()
         {
             AbstractParameter* ret = new PointerTemplateParameter<T, TYPE>(m_key, m_shortName, m_description);
+            ret->m_modifiedInPlace = m_modifiedInPlace;
             return ret;
         }
         CaretPointer<T> m_parameter;//so the GUI parser and the commandline parser don't need to do different things to delete the parameter info
@@ -0,0 +1,164 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "ClusterFindHelperTest.h"
+
+#include "ClusterFindHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //flood fill from each unvisited marked element in increasing order, which gives the same cluster order as the helper
+    void bruteForceClusters(const vector<int64_t>& neighborStart, const vector<int64_t>& neighbors, const vector<float>& areas,
+                            const vector<char>& marked, vector<vector<int64_t> >& clustersOut, vector<double>& sizesOut)
+    {
+        int64_t numElements = (int64_t)marked.size();
+        clustersOut.clear();
+        sizesOut.clear();
+        vector<char> visited(numElements, 0);
+        for (int64_t seed = 0; seed < numElements; ++seed)
+        {
+            if (!marked[seed] || visited[seed]) continue;
+            vector<int64_t> members(1, seed);
+            visited[seed] = 1;
+            double size = 0.0;
+            for (size_t m = 0; m < members.size(); ++m)
+            {
+                size += areas[members[m]];
+                for (int64_t j = neighborStart[members[m]]; j < neighborStart[members[m] + 1]; ++j)
+                {
+                    int64_t neigh = neighbors[j];
+                    if (marked[neigh] && !visited[neigh])
+                    {
+                        visited[neigh] = 1;
+                        members.push_back(neigh);
+                    }
+                }
+            }
+            sort(members.begin(), members.end());
+            clustersOut.push_back(members);
+            sizesOut.push_back(size);
+        }
+    }
+}
+
+ClusterFindHelperTest::ClusterFindHelperTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void ClusterFindHelperTest::checkClusters(const ClusterFindHelper::ClusterList& result, const vector<vector<int64_t> >& expected, const vector<double>& expectedSizes,
+                                          const AString& descrip)
+{
+    if (result.getNumberOfClusters() != (int64_t)expected.size())
+    {
+        setFailed(descrip + " found " + AString::number(result.getNumberOfClusters()) + " clusters, expected " + AString::number(expected.size()));
+        return;
+    }
+    for (int64_t c = 0; c < result.getNumberOfClusters(); ++c)
+    {
+        if (result.getNumberOfMembers(c) != (int64_t)expected[c].size() ||
+            !equal(expected[c].begin(), expected[c].end(), result.getMembers(c)))
+        {
+            setFailed(descrip + " members of cluster " + AString::number(c) + " don't match");
+            return;
+        }
+        if (abs(result.sizes[c] - expectedSizes[c]) > 1e-6 * expectedSizes[c])
+        {
+            setFailed(descrip + " size of cluster " + AString::number(c) + " is " + AString::number(result.sizes[c]) + ", expected " + AString::number(expectedSizes[c]));
+            return;
+        }
+    }
+}
+
+void ClusterFindHelperTest::execute()
+{
+    const int64_t dims[3] = { 13, 11, 9 }, numVoxels = dims[0] * dims[1] * dims[2];
+    const float voxelVolume = 2.5f;
+    vector<int64_t> gridStart(1, 0), gridNeighbors;//the same grid as an explicit graph, for the reference
+    for (int64_t k = 0; k < dims[2]; ++k)
+    {
+        for (int64_t j = 0; j < dims[1]; ++j)
+        {
+            for (int64_t i = 0; i < dims[0]; ++i)
+            {
+                int64_t index = i + dims[0] * (j + dims[1] * k);
+                if (i > 0) gridNeighbors.push_back(index - 1);
+                if (i < dims[0] - 1) gridNeighbors.push_back(index + 1);
+                if (j > 0) gridNeighbors.push_back(index - dims[0]);
+                if (j < dims[1] - 1) gridNeighbors.push_back(index + dims[0]);
+                if (k > 0) gridNeighbors.push_back(index - dims[0] * dims[1]);
+                if (k < dims[2] - 1) gridNeighbors.push_back(index + dims[0] * dims[1]);
+                gridStart.push_back((int64_t)gridNeighbors.size());
+            }
+        }
+    }
+    vector<float> gridAreas(numVoxels, voxelVolume);
+    ClusterFindHelper gridHelper(dims, voxelVolume), gridGraphHelper(gridStart, gridNeighbors, gridAreas);
+    const int densities[3] = { 20, 45, 70 };//percent marked, below, near and above percolation
+    for (int d = 0; d < 3; ++d)
+    {
+        vector<char> marked(numVoxels);
+        for (int64_t i = 0; i < numVoxels; ++i)
+        {
+            marked[i] = (rand() % 100 < densities[d]);
+        }
+        vector<vector<int64_t> > expected;
+        vector<double> expectedSizes;
+        bruteForceClusters(gridStart, gridNeighbors, gridAreas, marked, expected, expectedSizes);
+        ClusterFindHelper::ClusterList result;
+        gridHelper.findClusters(marked.data(), result);
+        checkClusters(result, expected, expectedSizes, "grid mode with " + AString::number(densities[d]) + "% marked:");
+        gridGraphHelper.findClusters(marked.data(), result);
+        checkClusters(result, expected, expectedSizes, "graph mode on grid with " + AString::number(densities[d]) + "% marked:");
+    }
+    const int64_t numNodes = 2000;//irregular graph with long range edges, so unions often join existing clusters
+    vector<vector<int64_t> > adjacency(numNodes);
+    for (int64_t e = 0; e < numNodes; ++e)
+    {
+        int64_t first = rand() % numNodes;
+        int64_t second = rand() % numNodes;
+        if (first == second) continue;
+        adjacency[first].push_back(second);
+        adjacency[second].push_back(first);
+    }
+    vector<int64_t> graphStart(1, 0), graphNeighbors;
+    vector<float> graphAreas(numNodes);
+    vector<char> marked(numNodes);
+    for (int64_t i = 0; i < numNodes; ++i)
+    {
+        graphNeighbors.insert(graphNeighbors.end(), adjacency[i].begin(), adjacency[i].end());
+        graphStart.push_back((int64_t)graphNeighbors.size());
+        graphAreas[i] = 0.25f + rand() % 100 / 50.0f;
+        marked[i] = (rand() % 4 != 0);
+    }
+    vector<vector<int64_t> > expected;
+    vector<double> expectedSizes;
+    bruteForceClusters(graphStart, graphNeighbors, graphAreas, marked, expected, expectedSizes);
+    ClusterFindHelper graphHelper(graphStart, graphNeighbors, graphAreas);
+    ClusterFindHelper::ClusterList result;
+    graphHelper.findClusters(marked.data(), result);
+    checkClusters(result, expected, expectedSizes, "irregular graph:");
+}
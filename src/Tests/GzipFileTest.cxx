@@ -0,0 +1,108 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "GzipFileTest.h"
+
+#include "CaretBinaryFile.h"
+#include "CaretException.h"
+
+#include <QTemporaryDir>
+
+#include "zlib.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+GzipFileTest::GzipFileTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void GzipFileTest::execute()
+{
+    QTemporaryDir myDir;
+    if (!myDir.isValid())
+    {
+        setFailed("unable to create temporary directory");
+        return;
+    }
+    AString fileName = myDir.path() + "/gziptest.gz";
+    const int64_t DATA_SIZE = (5 << 20) + 12345;//several compression blocks, last one partial
+    vector<char> data(DATA_SIZE);
+    for (int64_t i = 0; i < DATA_SIZE; ++i)
+    {//mix of compressible runs and noise
+        data[i] = (char)((i / 1000) % 3 == 0 ? rand() : (i / 4000));
+    }
+    {
+        CaretBinaryFile writer(fileName, CaretBinaryFile::WRITE_TRUNCATE);
+        int64_t written = 0, chunk = 1;
+        while (written < DATA_SIZE)
+        {//uneven write sizes, some crossing block boundaries
+            int64_t toWrite = min(chunk, DATA_SIZE - written);
+            writer.write(data.data() + written, toWrite);
+            written += toWrite;
+            chunk = chunk * 7 + 3;
+        }
+        writer.close();
+    }
+    CaretBinaryFile reader(fileName);
+    if (reader.size() != DATA_SIZE)
+    {
+        setFailed("reported size " + AString::number(reader.size()) + ", expected " + AString::number(DATA_SIZE));
+    }
+    vector<char> readBack(DATA_SIZE);
+    reader.read(readBack.data(), DATA_SIZE);
+    if (readBack != data) setFailed("sequential read of written .gz file doesn't match");
+    const int64_t positions[5] = { DATA_SIZE - 10, 0, (1 << 20) - 3, 3 << 20, 17 };
+    for (int i = 0; i < 5; ++i)
+    {
+        const int64_t length = min((int64_t)(2 << 20), DATA_SIZE - positions[i]);
+        vector<char> piece(length);
+        reader.seek(positions[i]);
+        reader.read(piece.data(), length);
+        if (!equal(piece.begin(), piece.end(), data.begin() + positions[i]))
+        {
+            setFailed("read after seek to " + AString::number(positions[i]) + " doesn't match");
+        }
+    }
+    reader.close();
+    gzFile plainReader = gzopen(fileName.toLocal8Bit().constData(), "rb");//other gzip readers must see exactly the data, and nothing from the index member
+    if (plainReader == NULL)
+    {
+        setFailed("zlib couldn't open written .gz file");
+        return;
+    }
+    vector<char> plainData(DATA_SIZE + 1);
+    int64_t totalRead = 0;
+    int result;
+    while ((result = gzread(plainReader, plainData.data() + totalRead, (unsigned)min((int64_t)(1 << 20), DATA_SIZE + 1 - totalRead))) > 0)
+    {
+        totalRead += result;
+        if (totalRead == DATA_SIZE + 1) break;
+    }
+    gzclose(plainReader);
+    if (result < 0) setFailed("zlib reported an error reading written .gz file");
+    if (totalRead != DATA_SIZE || !equal(data.begin(), data.end(), plainData.begin()))
+    {
+        setFailed("zlib read of written .gz file doesn't match, read " + AString::number(totalRead) + " bytes");
+    }
+}
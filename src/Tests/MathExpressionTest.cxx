@@ -55,4 +55,31 @@ void MathExpressionTest::execute()
     {
         setFailed("output value incorrect, expected " + AString::number(correctresult) + ", got " + AString::number(testresult));
     }
+    CaretMathExpression rowExpr("clamp(x, -1, 2) * (y > 0.5) + !(x == y) - atan2(y, x) / -mod(x, 3) + (x < y || y >= 2 && x <= 1)");
+    varNames = rowExpr.getVarNames();
+    if (varNames.size() != 2) setFailed("incorrect number of variables found in row expression");
+    const int ROW_LENGTH = 1000;//not a multiple of the internal block size
+    vector<vector<float> > rows(2, vector<float>(ROW_LENGTH));
+    for (int i = 0; i < ROW_LENGTH; ++i)
+    {
+        rows[0][i] = (i % 37) / 7.0f - 2.0f;
+        rows[1][i] = (i % 11) / 3.0f - 1.0f;
+        if (i % 5 == 0) rows[1][i] = rows[0][i];//exercise the equality fudge factor
+    }
+    vector<const float*> rowPointers(2);
+    rowPointers[0] = rows[0].data();
+    rowPointers[1] = rows[1].data();
+    vector<float> rowResult(ROW_LENGTH);
+    rowExpr.evaluateRow(rowResult.data(), rowPointers, ROW_LENGTH);
+    for (int i = 0; i < ROW_LENGTH; ++i)
+    {
+        vars[0] = rows[0][i];
+        vars[1] = rows[1][i];
+        float single = (float)rowExpr.evaluate(vars);
+        if (single != rowResult[i] && !(single != single && rowResult[i] != rowResult[i]))//both NaN is a match
+        {
+            setFailed("row evaluation differs from single evaluation at element " + AString::number(i) + ", expected " + AString::number(single) + ", got " + AString::number(rowResult[i]));
+            break;
+        }
+    }
 }
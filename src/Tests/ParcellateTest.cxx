@@ -0,0 +1,189 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "ParcellateTest.h"
+
+#include "AlgorithmCiftiParcellate.h"
+#include "CaretException.h"
+#include "CiftiFile.h"
+#include "GiftiLabelTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //reduce with a full sort for the median, in double
+    double bruteForceReduce(vector<double> values, const ReductionEnum::Enum& method)
+    {
+        int64_t count = (int64_t)values.size();
+        if (method == ReductionEnum::MEDIAN)
+        {
+            sort(values.begin(), values.end());
+            if (count % 2 == 0) return (values[count / 2 - 1] + values[count / 2]) / 2.0;
+            return values[count / 2];
+        }
+        double sum = 0.0;
+        for (int64_t i = 0; i < count; ++i)
+        {
+            sum += values[i];
+        }
+        if (method == ReductionEnum::MEAN) return sum / count;
+        return sum;
+    }
+}
+
+ParcellateTest::ParcellateTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+//compare a parcellated output against the input reduced one parcel (or parcel pair) at a time
+bool ParcellateTest::checkOutput(const CiftiFile& output, const vector<float>& data, const int64_t& numIndices, const vector<int>& indexToParcel, const int& numParcels,
+                                 const ReductionEnum::Enum& method, const bool parcelRows, const bool parcelColumns, const float& emptyFillVal, const AString& descrip)
+{
+    int64_t outRows = (parcelRows ? numParcels : numIndices), outCols = (parcelColumns ? numParcels : numIndices);
+    vector<int64_t> outDims = output.getDimensions();
+    if (outDims.size() != 2 || outDims[0] != outCols || outDims[1] != outRows)
+    {
+        setFailed(descrip + ": output has the wrong dimensions");
+        return false;
+    }
+    vector<float> outRow(outCols);
+    for (int64_t r = 0; r < outRows; ++r)
+    {
+        output.getRow(outRow.data(), r);
+        for (int64_t c = 0; c < outCols; ++c)
+        {
+            vector<double> values;
+            for (int64_t i = 0; i < numIndices; ++i)
+            {
+                if (parcelRows ? indexToParcel[i] != r : i != r) continue;
+                for (int64_t j = 0; j < numIndices; ++j)
+                {
+                    if (parcelColumns ? indexToParcel[j] != c : j != c) continue;
+                    values.push_back(data[i * numIndices + j]);
+                }
+            }
+            double expected = (values.empty() ? emptyFillVal : bruteForceReduce(values, method));
+            if (abs(outRow[c] - expected) > 1e-4 * (1.0 + abs(expected)))
+            {
+                setFailed(descrip + ": element (" + AString::number(r) + ", " + AString::number(c) + ") is " + AString::number(outRow[c]) +
+                          ", expected " + AString::number(expected));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void ParcellateTest::execute()
+{
+    try
+    {
+        const int64_t numNodes = 37;
+        const int numLabels = 5;//the last label is used by no vertices, so its parcel is empty
+        CiftiBrainModelsMap denseMap;
+        denseMap.addSurfaceModel(numNodes, StructureEnum::CORTEX_LEFT);
+        CiftiLabelsMap labelsMap;
+        labelsMap.setLength(1);
+        GiftiLabelTable* labelTable = labelsMap.getMapLabelTable(0);
+        int32_t unassignedKey = labelTable->getUnassignedLabelKey();
+        vector<int32_t> labelKeys;
+        for (int i = 0; i < numLabels; ++i)
+        {
+            labelKeys.push_back(labelTable->addLabel(AString("parcel") + AString::number(i), 1.0f, 0.0f, 0.0f, 1.0f));
+        }
+        CiftiXML labelXML;
+        labelXML.setNumberOfDimensions(2);
+        labelXML.setMap(CiftiXML::ALONG_ROW, labelsMap);
+        labelXML.setMap(CiftiXML::ALONG_COLUMN, denseMap);
+        CiftiFile labelFile;
+        labelFile.setCiftiXML(labelXML);
+        for (int64_t i = 0; i < numNodes; ++i)
+        {
+            int which;
+            if (i < numLabels - 1)
+            {
+                which = (int)i;//every other parcel gets at least one vertex
+            } else {
+                which = rand() % numLabels;//numLabels - 1 means unassigned
+            }
+            float key = (float)(which == numLabels - 1 ? unassignedKey : labelKeys[which]);
+            labelFile.setRow(&key, i);
+        }
+        vector<int> indexToParcel;
+        int numParcels = AlgorithmCiftiParcellate::parcellateMapping(&labelFile, denseMap, indexToParcel).getLength();
+        if (numParcels != numLabels)
+        {
+            setFailed("found " + AString::number(numParcels) + " parcels, expected " + AString::number(numLabels));
+            return;
+        }
+        CiftiXML dataXML;
+        dataXML.setNumberOfDimensions(2);
+        dataXML.setMap(CiftiXML::ALONG_ROW, denseMap);
+        dataXML.setMap(CiftiXML::ALONG_COLUMN, denseMap);
+        CiftiFile dataFile;
+        dataFile.setCiftiXML(dataXML);
+        vector<float> data(numNodes * numNodes);
+        for (int64_t i = 0; i < numNodes; ++i)
+        {
+            for (int64_t j = 0; j < numNodes; ++j)
+            {
+                data[i * numNodes + j] = (rand() % 401 - 200) / 20.0f;//coarse values, so medians see ties
+            }
+            dataFile.setRow(data.data() + i * numNodes, i);
+        }
+        const float emptyFillVal = -7.5f;
+        const ReductionEnum::Enum methods[3] = { ReductionEnum::MEAN, ReductionEnum::SUM, ReductionEnum::MEDIAN };
+        for (int m = 0; m < 3; ++m)
+        {
+            for (int direction = 0; direction < 2; ++direction)
+            {
+                CiftiFile output;
+                AlgorithmCiftiParcellate(NULL, &dataFile, &labelFile, direction, &output, methods[m], -1.0f, -1.0f, false, false, emptyFillVal);
+                if (!checkOutput(output, data, numNodes, indexToParcel, numParcels, methods[m], direction == CiftiXML::ALONG_COLUMN, direction == CiftiXML::ALONG_ROW,
+                                 emptyFillVal, ReductionEnum::toName(methods[m]) + " along " + (direction == CiftiXML::ALONG_ROW ? "ROW" : "COLUMN"))) return;
+            }
+            if (methods[m] == ReductionEnum::MEDIAN) continue;//BOTH only supports MEAN and SUM
+            CiftiFile output;
+            AlgorithmCiftiParcellate(NULL, &dataFile, &labelFile, CiftiXML::ALONG_COLUMN, &output, methods[m], -1.0f, -1.0f, false, false, emptyFillVal, NULL, true);
+            if (!checkOutput(output, data, numNodes, indexToParcel, numParcels, methods[m], true, true, emptyFillVal,
+                             ReductionEnum::toName(methods[m]) + " along BOTH")) return;
+        }
+        bool caught = false;
+        try
+        {
+            CiftiFile output;
+            AlgorithmCiftiParcellate(NULL, &dataFile, &labelFile, CiftiXML::ALONG_COLUMN, &output, ReductionEnum::MEDIAN, -1.0f, -1.0f, false, false, emptyFillVal, NULL, true);
+        } catch (CaretException&) {
+            caught = true;
+        }
+        if (!caught)
+        {
+            setFailed("MEDIAN along BOTH did not throw");
+        }
+    } catch (CaretException& e) {
+        setFailed("caught exception: " + e.whatString());
+    }
+}
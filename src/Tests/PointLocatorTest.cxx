@@ -0,0 +1,126 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "PointLocatorTest.h"
+
+#include "CaretPointLocator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    float distSquared(const float* first, const float* second)
+    {
+        float ret = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            float diff = first[i] - second[i];
+            ret += diff * diff;
+        }
+        return ret;
+    }
+}
+
+PointLocatorTest::PointLocatorTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void PointLocatorTest::execute()
+{
+    vector<vector<float> > sets(3);
+    const int64_t setSizes[3] = { 3000, 1, 500 };
+    for (int s = 0; s < 3; ++s)
+    {
+        for (int64_t i = 0; i < setSizes[s] * 3; ++i)
+        {
+            float coord = 200.0f * ((float)rand()) / RAND_MAX - 100.0f;
+            if (s == 2) coord = floor(coord / 25.0f) * 25.0f;//many duplicate points, so ties and zero size boxes happen
+            sets[s].push_back(coord);
+        }
+    }
+    CaretPointLocator myLocator(sets[0]);
+    vector<int32_t> setIds(3);
+    setIds[0] = 0;
+    setIds[1] = myLocator.addPointSet(sets[1]);
+    setIds[2] = myLocator.addPointSet(sets[2]);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        vector<char> setPresent(3, 1);
+        if (pass == 1)
+        {
+            myLocator.removePointSet(setIds[1]);
+            setPresent[1] = 0;
+        }
+        const int64_t numTargets = 500;
+        vector<float> targets(numTargets * 3);
+        for (int64_t t = 0; t < numTargets * 3; ++t)
+        {
+            targets[t] = 240.0f * ((float)rand()) / RAND_MAX - 120.0f;//some targets outside the bounding box
+        }
+        vector<int64_t> batchIndices(numTargets), batchLimited(numTargets);
+        vector<LocatorInfo> batchInfo(numTargets);
+        const float maxDist = 15.0f;
+        myLocator.closestPoints(targets.data(), numTargets, batchIndices.data(), -1.0f, batchInfo.data());
+        myLocator.closestPoints(targets.data(), numTargets, batchLimited.data(), maxDist);
+        for (int64_t t = 0; t < numTargets; ++t)
+        {
+            const float* target = targets.data() + t * 3;
+            float bestDist2 = numeric_limits<float>::infinity();
+            vector<LocatorInfo> expectInRange;
+            for (int s = 0; s < 3; ++s)
+            {
+                if (!setPresent[s]) continue;
+                for (int64_t i = 0; i < setSizes[s]; ++i)
+                {
+                    float dist2 = distSquared(target, sets[s].data() + i * 3);
+                    bestDist2 = min(bestDist2, dist2);
+                    if (dist2 <= maxDist * maxDist) expectInRange.push_back(LocatorInfo(i, setIds[s], Vector3D(sets[s].data() + i * 3)));
+                }
+            }
+            LocatorInfo myInfo;
+            int64_t found = myLocator.closestPoint(target, &myInfo);
+            int foundSet = (int)(find(setIds.begin(), setIds.end(), myInfo.whichSet) - setIds.begin());
+            if (found < 0 || found != myInfo.index || foundSet == 3 || !setPresent[foundSet] || found >= setSizes[foundSet] ||
+                distSquared(target, sets[foundSet].data() + found * 3) > bestDist2 * 1.000001f)
+            {
+                setFailed("closest point to target " + AString::number(t) + " is not the nearest point");
+            }
+            if (batchIndices[t] != found || !(batchInfo[t] == myInfo)) setFailed("batched closest point differs for target " + AString::number(t));
+            bool inRange = (bestDist2 <= maxDist * maxDist);
+            int64_t limited = myLocator.closestPointLimited(target, maxDist);
+            if ((limited >= 0) != inRange || batchLimited[t] != limited) setFailed("limited closest point wrong for target " + AString::number(t));
+            if (myLocator.anyInRange(target, maxDist) != (bestDist2 < maxDist * maxDist)) setFailed("anyInRange wrong for target " + AString::number(t));
+            vector<LocatorInfo> gotInRange = myLocator.pointsInRange(target, maxDist);
+            sort(gotInRange.begin(), gotInRange.end());
+            sort(expectInRange.begin(), expectInRange.end());
+            if (gotInRange != expectInRange) setFailed("pointsInRange wrong for target " + AString::number(t));
+        }
+    }
+    myLocator.removePointSet(setIds[0]);
+    myLocator.removePointSet(setIds[2]);
+    float origin[3] = { 0.0f, 0.0f, 0.0f };
+    if (myLocator.closestPoint(origin) != -1) setFailed("locator with all point sets removed found a point");
+}
@@ -0,0 +1,253 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "RegressionHelperTest.h"
+
+#include "CaretException.h"
+#include "RegressionHelper.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //solve the normal equations of [regressors, constant] by gaussian elimination, then subtract the fit of the first numRemove regressors, after demeaning them
+    vector<double> bruteForceResidual(const vector<vector<float> >& regressors, const int64_t& numRemove, const vector<float>& data)
+    {
+        const int64_t numObs = (int64_t)data.size(), numRegs = (int64_t)regressors.size() + 1;
+        vector<vector<double> > design(numRegs, vector<double>(numObs, 1.0));
+        for (int64_t k = 0; k < numRegs - 1; ++k)
+        {
+            double mean = 0.0;
+            for (int64_t i = 0; i < numObs; ++i)
+            {
+                mean += regressors[k][i];
+            }
+            mean /= numObs;
+            for (int64_t i = 0; i < numObs; ++i)
+            {
+                design[k][i] = regressors[k][i] - mean;
+            }
+        }
+        vector<vector<double> > system(numRegs, vector<double>(numRegs + 1, 0.0));//augmented with X'y
+        for (int64_t a = 0; a < numRegs; ++a)
+        {
+            for (int64_t i = 0; i < numObs; ++i)
+            {
+                for (int64_t b = 0; b < numRegs; ++b)
+                {
+                    system[a][b] += design[a][i] * design[b][i];
+                }
+                system[a][numRegs] += design[a][i] * data[i];
+            }
+        }
+        for (int64_t col = 0; col < numRegs; ++col)
+        {
+            int64_t pivot = col;
+            for (int64_t row = col + 1; row < numRegs; ++row)
+            {
+                if (abs(system[row][col]) > abs(system[pivot][col])) pivot = row;
+            }
+            system[col].swap(system[pivot]);
+            for (int64_t row = 0; row < numRegs; ++row)
+            {
+                if (row == col) continue;
+                double factor = system[row][col] / system[col][col];
+                for (int64_t b = col; b <= numRegs; ++b)
+                {
+                    system[row][b] -= factor * system[col][b];
+                }
+            }
+        }
+        vector<double> ret(data.begin(), data.end());
+        for (int64_t k = 0; k < numRemove; ++k)
+        {
+            double coef = system[k][numRegs] / system[k][k];
+            for (int64_t i = 0; i < numObs; ++i)
+            {
+                ret[i] -= coef * design[k][i];
+            }
+        }
+        return ret;
+    }
+    
+    bool closeEnough(const float& value, const double& expected)
+    {
+        return abs(value - expected) < 1e-4 * (1.0 + abs(expected));
+    }
+}
+
+RegressionHelperTest::RegressionHelperTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void RegressionHelperTest::execute()
+{
+    const int64_t numObs = 60, numRemove = 3, numKeep = 2, numVectors = 2500;//more vectors than one block of the observation-major functions, and not a multiple of it
+    vector<vector<float> > regressors(numRemove + numKeep, vector<float>(numObs));
+    for (int64_t k = 0; k < numRemove + numKeep; ++k)
+    {
+        for (int64_t i = 0; i < numObs; ++i)
+        {
+            regressors[k][i] = 2.0f * ((float)rand()) / RAND_MAX - 1.0f + 2.0f * k;//nonzero means, which the helper must remove
+        }
+    }
+    vector<vector<float> > data(numVectors, vector<float>(numObs));
+    for (int64_t v = 0; v < numVectors; ++v)
+    {
+        vector<float> weights(numRemove + numKeep);
+        for (int64_t k = 0; k < numRemove + numKeep; ++k)
+        {
+            weights[k] = 20.0f * ((float)rand()) / RAND_MAX - 10.0f;
+        }
+        for (int64_t i = 0; i < numObs; ++i)
+        {
+            float value = 4.0f + 2.0f * ((float)rand()) / RAND_MAX;//offset and noise, so the fit isn't exact
+            for (int64_t k = 0; k < numRemove + numKeep; ++k)
+            {
+                value += weights[k] * regressors[k][i];
+            }
+            data[v][i] = value;
+        }
+    }
+    try
+    {
+        RegressionHelper myHelper(regressors, numRemove);
+        if (myHelper.getNumberOfObservations() != numObs)
+        {
+            setFailed("helper reports " + AString::number(myHelper.getNumberOfObservations()) + " observations");
+            return;
+        }
+        vector<vector<double> > expected(numVectors);
+        for (int64_t v = 0; v < numVectors; ++v)
+        {
+            expected[v] = bruteForceResidual(regressors, numRemove, data[v]);
+        }
+        {//vector-major, in place
+            vector<vector<float> > work = data;
+            vector<const float*> inPtrs(numVectors);
+            vector<float*> outPtrs(numVectors);
+            for (int64_t v = 0; v < numVectors; ++v)
+            {
+                outPtrs[v] = work[v].data();
+                inPtrs[v] = outPtrs[v];
+            }
+            myHelper.removeFit(inPtrs, outPtrs);
+            for (int64_t v = 0; v < numVectors; ++v)
+            {
+                for (int64_t i = 0; i < numObs; ++i)
+                {
+                    if (!closeEnough(work[v][i], expected[v][i]))
+                    {
+                        setFailed("removeFit gave " + AString::number(work[v][i]) + " instead of " + AString::number(expected[v][i]) +
+                                  " for vector " + AString::number(v) + ", observation " + AString::number(i));
+                        return;
+                    }
+                }
+            }
+        }
+        {//observations scattered through longer vectors, like nodes inside an roi
+            const int64_t stride = 3;
+            vector<int64_t> observationIndices(numObs);
+            for (int64_t i = 0; i < numObs; ++i)
+            {
+                observationIndices[i] = i * stride + 1;
+            }
+            vector<vector<float> > padded(numVectors, vector<float>(numObs * stride, -1.0f)), outData(numVectors, vector<float>(numObs * stride, 7.0f));
+            vector<const float*> inPtrs(numVectors);
+            vector<float*> outPtrs(numVectors);
+            for (int64_t v = 0; v < numVectors; ++v)
+            {
+                for (int64_t i = 0; i < numObs; ++i)
+                {
+                    padded[v][observationIndices[i]] = data[v][i];
+                }
+                inPtrs[v] = padded[v].data();
+                outPtrs[v] = outData[v].data();
+            }
+            myHelper.removeFit(inPtrs, outPtrs, observationIndices);
+            for (int64_t v = 0; v < numVectors; ++v)
+            {
+                for (int64_t j = 0; j < numObs * stride; ++j)
+                {
+                    bool good = (j % stride == 1 ? closeEnough(outData[v][j], expected[v][j / stride]) : outData[v][j] == 7.0f);
+                    if (!good)
+                    {
+                        setFailed("indexed removeFit gave wrong value " + AString::number(outData[v][j]) + " at element " + AString::number(j) +
+                                  " of vector " + AString::number(v));
+                        return;
+                    }
+                }
+            }
+        }
+        {//observation-major, like volume frames
+            vector<vector<float> > frames(numObs, vector<float>(numVectors));
+            vector<const float*> inPtrs(numObs);
+            for (int64_t i = 0; i < numObs; ++i)
+            {
+                for (int64_t v = 0; v < numVectors; ++v)
+                {
+                    frames[i][v] = data[v][i];
+                }
+                inPtrs[i] = frames[i].data();
+            }
+            vector<float> coefs, outFrame(numVectors);
+            myHelper.fitObservationMajor(inPtrs, numVectors, coefs);
+            for (int64_t i = 0; i < numObs; ++i)
+            {
+                myHelper.removeFitFromObservation(inPtrs[i], outFrame.data(), i, coefs, numVectors);
+                for (int64_t v = 0; v < numVectors; ++v)
+                {
+                    if (!closeEnough(outFrame[v], expected[v][i]))
+                    {
+                        setFailed("observation-major fit gave " + AString::number(outFrame[v]) + " instead of " + AString::number(expected[v][i]) +
+                                  " for element " + AString::number(v) + ", observation " + AString::number(i));
+                        return;
+                    }
+                }
+            }
+        }
+    } catch (CaretException& e) {
+        setFailed("caught exception: " + e.whatString());
+        return;
+    }
+    vector<vector<float> > dependent = regressors;
+    for (int64_t i = 0; i < numObs; ++i)
+    {
+        dependent[numRemove + numKeep - 1][i] = 2.0f * regressors[0][i] - regressors[1][i] + 3.0f;//the offset is absorbed by the constant term
+    }
+    vector<vector<float> > constant = regressors;
+    constant[1].assign(numObs, 4.0f);
+    const vector<vector<float> >* singular[2] = { &dependent, &constant };
+    for (int which = 0; which < 2; ++which)
+    {
+        bool threw = false;
+        try
+        {
+            RegressionHelper badHelper(*(singular[which]), numRemove);
+        } catch (CaretException&) {
+            threw = true;
+        }
+        if (!threw) setFailed(AString(which == 0 ? "linearly dependent" : "constant") + " regressor was not rejected");
+    }
+}
@@ -0,0 +1,257 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "SparseFileTest.h"
+
+#include "CaretException.h"
+#include "CaretOMP.h"
+#include "CaretSparseFile.h"
+#include "CiftiXML.h"
+
+#include <QTemporaryDir>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct SparseRows
+    {
+        vector<vector<int64_t> > m_indices, m_values;
+    };
+    
+    //a mix of empty, sparse and nearly full rows, with values of every size and sign
+    void makeIntegerRows(const int64_t& numCols, const int64_t& numRows, SparseRows& rowsOut)
+    {
+        rowsOut.m_indices.assign(numRows, vector<int64_t>());
+        rowsOut.m_values.assign(numRows, vector<int64_t>());
+        for (int64_t row = 0; row < numRows; ++row)
+        {
+            int density = rand() % 4 * 30;//0, 30, 60 or 90 percent
+            for (int64_t col = 0; col < numCols; ++col)
+            {
+                if (rand() % 100 >= density) continue;
+                int64_t value = rand() % 1000 + 1;
+                value <<= (rand() % 5) * 10;//up to 2^40
+                if (rand() % 2) value = -value;
+                rowsOut.m_indices[row].push_back(col);
+                rowsOut.m_values[row].push_back(value);
+            }
+        }
+    }
+    
+    //fractions in thousandths and integer distances survive encoding exactly
+    void makeFiberRows(const int64_t& numCols, const int64_t& numRows, vector<vector<int64_t> >& indicesOut, vector<vector<FiberFractions> >& valuesOut)
+    {
+        indicesOut.assign(numRows, vector<int64_t>());
+        valuesOut.assign(numRows, vector<FiberFractions>());
+        for (int64_t row = 0; row < numRows; ++row)
+        {
+            if (row % 7 == 3) continue;//some empty rows
+            for (int64_t col = 0; col < numCols; ++col)
+            {
+                if (rand() % 3 != 0) continue;
+                FiberFractions value;
+                value.totalCount = rand() % 100000 + 1;
+                int first = rand() % 1001, second = rand() % (1001 - first);
+                value.fiberFractions.push_back(first / 1000.0f);
+                value.fiberFractions.push_back(second / 1000.0f);
+                value.fiberFractions.push_back(1.0f - value.fiberFractions[0] - value.fiberFractions[1]);
+                value.distance = (float)(rand() % 1000);
+                indicesOut[row].push_back(col);
+                valuesOut[row].push_back(value);
+            }
+        }
+    }
+    
+    bool fibersMatch(const FiberFractions& left, const FiberFractions& right)
+    {
+        if (left.totalCount != right.totalCount || left.distance != right.distance) return false;
+        if (left.fiberFractions.size() != 3 || right.fiberFractions.size() != 3) return false;
+        return left.fiberFractions[0] == right.fiberFractions[0] && left.fiberFractions[1] == right.fiberFractions[1] &&
+               abs(left.fiberFractions[2] - right.fiberFractions[2]) < 0.0015f;
+    }
+    
+    CiftiXML makeXML(const int64_t& numCols, const int64_t& numRows)
+    {
+        CiftiXML ret;
+        ret.setNumberOfDimensions(2);
+        CiftiScalarsMap rowMap, columnMap;
+        rowMap.setLength(numCols);
+        columnMap.setLength(numRows);
+        ret.setMap(CiftiXML::ALONG_ROW, rowMap);
+        ret.setMap(CiftiXML::ALONG_COLUMN, columnMap);
+        return ret;
+    }
+    
+    //decode every row from several threads at once, in an order that jumps between row blocks
+    int64_t countConcurrentMismatches(const CaretSparseFile& reader, const SparseRows& expected)
+    {
+        int64_t numRows = (int64_t)expected.m_indices.size(), mismatches = 0;
+#pragma omp CARET_PAR
+        {
+            CaretSparseFile::RowBuffer rowBuffer;
+            vector<int64_t> indices, values;
+#pragma omp CARET_FOR schedule(dynamic, 1) reduction(+:mismatches)
+            for (int64_t i = 0; i < numRows; ++i)
+            {
+                int64_t row = (i * 37) % numRows;//numRows is not a multiple of 37
+                try
+                {
+                    reader.getRowSparse(row, indices, values, rowBuffer);
+                    if (indices != expected.m_indices[row] || values != expected.m_values[row]) ++mismatches;
+                } catch (...) {
+                    ++mismatches;
+                }
+            }
+        }
+        return mismatches;
+    }
+}
+
+SparseFileTest::SparseFileTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SparseFileTest::execute()
+{
+    QTemporaryDir myDir;
+    if (!myDir.isValid())
+    {
+        setFailed("unable to create temporary directory");
+        return;
+    }
+    const int64_t numCols = 150, numRows = 301;//several row blocks, the last one partial
+    SparseRows integerRows;
+    makeIntegerRows(numCols, numRows, integerRows);
+    vector<vector<int64_t> > fiberIndices;
+    vector<vector<FiberFractions> > fiberValues;
+    makeFiberRows(numCols, numRows, fiberIndices, fiberValues);
+    CiftiXML myXML = makeXML(numCols, numRows);
+    try
+    {
+        for (int compressed = 0; compressed < 2; ++compressed)
+        {
+            AString modeName = (compressed ? "compressed" : "uncompressed");
+            AString integerName = myDir.path() + "/integer" + AString::number(compressed) + ".trajTEMP.wbsparse";
+            AString fiberName = myDir.path() + "/fiber" + AString::number(compressed) + ".trajTEMP.wbsparse";
+            {
+                CaretSparseFileWriter writer(integerName, myXML, compressed != 0);
+                vector<int64_t> denseRow(numCols);
+                for (int64_t row = 0; row < numRows; ++row)
+                {
+                    if (integerRows.m_indices[row].empty() && row % 2 == 0) continue;//skipping empty rows is allowed
+                    if (row % 3 == 0)
+                    {
+                        denseRow.assign(numCols, 0);
+                        for (size_t i = 0; i < integerRows.m_indices[row].size(); ++i)
+                        {
+                            denseRow[integerRows.m_indices[row][i]] = integerRows.m_values[row][i];
+                        }
+                        writer.writeRow(row, denseRow.data());
+                    } else {
+                        writer.writeRowSparse(row, integerRows.m_indices[row], integerRows.m_values[row]);
+                    }
+                }
+                writer.finish();
+            }
+            {
+                CaretSparseFileWriter writer(fiberName, myXML, compressed != 0);
+                for (int64_t row = 0; row < numRows; ++row)
+                {
+                    writer.writeFibersRowSparse(row, fiberIndices[row], fiberValues[row]);
+                }
+                writer.finish();
+            }
+            CaretSparseFile integerReader(integerName);
+            if (integerReader.getVersion() != compressed)
+            {
+                setFailed(modeName + " file has version " + AString::number(integerReader.getVersion()));
+                return;
+            }
+            const int64_t* dims = integerReader.getDimensions();
+            if (dims[0] != numCols || dims[1] != numRows)
+            {
+                setFailed(modeName + " file has the wrong dimensions");
+                return;
+            }
+            vector<int64_t> indices, values, denseRow(numCols);
+            for (int64_t row = 0; row < numRows; ++row)
+            {
+                integerReader.getRowSparse(row, indices, values);
+                if (indices != integerRows.m_indices[row] || values != integerRows.m_values[row])
+                {
+                    setFailed(modeName + " sparse row " + AString::number(row) + " doesn't match");
+                    return;
+                }
+                integerReader.getRow(row, denseRow.data());
+                vector<int64_t> expectedDense(numCols, 0);
+                for (size_t i = 0; i < integerRows.m_indices[row].size(); ++i)
+                {
+                    expectedDense[integerRows.m_indices[row][i]] = integerRows.m_values[row][i];
+                }
+                if (denseRow != expectedDense)
+                {
+                    setFailed(modeName + " dense row " + AString::number(row) + " doesn't match");
+                    return;
+                }
+            }
+            int64_t mismatches = countConcurrentMismatches(integerReader, integerRows);
+            if (mismatches != 0)
+            {
+                setFailed(modeName + " concurrent decoding got " + AString::number(mismatches) + " rows wrong");
+                return;
+            }
+            CaretSparseFile fiberReader(fiberName);
+            vector<FiberFractions> fibers, denseFibers(numCols);
+            for (int64_t row = 0; row < numRows; ++row)
+            {
+                fiberReader.getFibersRowSparse(row, indices, fibers);
+                bool match = (indices == fiberIndices[row] && fibers.size() == fiberValues[row].size());
+                for (size_t i = 0; match && i < fibers.size(); ++i)
+                {
+                    match = fibersMatch(fibers[i], fiberValues[row][i]);
+                }
+                fiberReader.getFibersRow(row, denseFibers.data());
+                size_t next = 0;
+                for (int64_t col = 0; match && col < numCols; ++col)
+                {
+                    if (next < fiberIndices[row].size() && fiberIndices[row][next] == col)
+                    {
+                        match = fibersMatch(denseFibers[col], fiberValues[row][next]);
+                        ++next;
+                    } else {
+                        match = (denseFibers[col].totalCount == 0);
+                    }
+                }
+                if (!match)
+                {
+                    setFailed(modeName + " fiber row " + AString::number(row) + " doesn't match");
+                    return;
+                }
+            }
+        }
+    } catch (CaretException& e) {
+        setFailed("caught exception: " + e.whatString());
+    }
+}
@@ -0,0 +1,142 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "TFCEHelperTest.h"
+
+#include "TFCEHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //exact integral computed one slice at a time, with clusters found by flood fill at every distinct value
+    void bruteForceTFCE(const vector<int64_t>& neighborStart, const vector<int64_t>& neighbors, const vector<float>& areas, const vector<float>& roi,
+                        const vector<float>& data, const float& param_e, const float& param_h, vector<double>& outData)
+    {
+        int64_t numElements = (int64_t)data.size();
+        outData.assign(numElements, 0.0);
+        for (int sign = 1; sign >= -1; sign -= 2)
+        {
+            vector<float> levels;
+            for (int64_t i = 0; i < numElements; ++i)
+            {
+                if (roi[i] > 0.0f && sign * data[i] > 0.0f) levels.push_back(sign * data[i]);
+            }
+            sort(levels.begin(), levels.end());
+            levels.erase(unique(levels.begin(), levels.end()), levels.end());
+            for (int l = 0; l < (int)levels.size(); ++l)
+            {
+                double bottom = (l == 0 ? 0.0 : levels[l - 1]);
+                double slice = (pow((double)levels[l], param_h + 1.0) - pow(bottom, param_h + 1.0)) / (param_h + 1.0);
+                vector<int> label(numElements, -1);
+                for (int64_t seed = 0; seed < numElements; ++seed)
+                {
+                    if (label[seed] != -1 || roi[seed] <= 0.0f || sign * data[seed] < levels[l]) continue;
+                    vector<int64_t> members(1, seed);
+                    label[seed] = 1;
+                    double area = 0.0;
+                    for (size_t m = 0; m < members.size(); ++m)
+                    {
+                        area += areas[members[m]];
+                        for (int64_t j = neighborStart[members[m]]; j < neighborStart[members[m] + 1]; ++j)
+                        {
+                            int64_t neigh = neighbors[j];
+                            if (label[neigh] == -1 && roi[neigh] > 0.0f && sign * data[neigh] >= levels[l])
+                            {
+                                label[neigh] = 1;
+                                members.push_back(neigh);
+                            }
+                        }
+                    }
+                    for (size_t m = 0; m < members.size(); ++m)
+                    {
+                        outData[members[m]] += sign * pow(area, (double)param_e) * slice;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TFCEHelperTest::TFCEHelperTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void TFCEHelperTest::execute()
+{
+    const int64_t DIM = 24, numElements = DIM * DIM;
+    vector<int64_t> neighborStart(1, 0), neighbors;//4-connected grid
+    for (int64_t y = 0; y < DIM; ++y)
+    {
+        for (int64_t x = 0; x < DIM; ++x)
+        {
+            if (x > 0) neighbors.push_back(y * DIM + x - 1);
+            if (x < DIM - 1) neighbors.push_back(y * DIM + x + 1);
+            if (y > 0) neighbors.push_back((y - 1) * DIM + x);
+            if (y < DIM - 1) neighbors.push_back((y + 1) * DIM + x);
+            neighborStart.push_back((int64_t)neighbors.size());
+        }
+    }
+    vector<float> areas(numElements), roi(numElements), data(numElements);
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        areas[i] = 0.5f + rand() % 100 / 100.0f;
+        roi[i] = (rand() % 10 == 0 ? 0.0f : 1.0f);
+        int64_t x = i % DIM, y = i / DIM;//smooth blobs of both signs plus noise, rounded so there are many ties
+        float blob = 3.0f * sin(x * 0.4f) * cos(y * 0.3f) + (rand() % 100 - 50) / 50.0f;
+        data[i] = floor(blob * 4.0f + 0.5f) / 4.0f;
+    }
+    const float params[3][2] = { { 1.0f, 2.0f }, { 0.5f, 2.0f }, { 0.66f, 1.5f } };
+    for (int p = 0; p < 3; ++p)
+    {
+        vector<double> expected;
+        bruteForceTFCE(neighborStart, neighbors, areas, roi, data, params[p][0], params[p][1], expected);
+        TFCEHelper myTFCE(neighborStart, neighbors, areas, roi.data(), params[p][0], params[p][1]);
+        vector<float> result(numElements);
+        float maxTFCE = myTFCE.computeTFCE(data.data(), result.data());
+        double expectMax = 0.0;
+        for (int64_t i = 0; i < numElements; ++i)
+        {
+            expectMax = max(expectMax, abs(expected[i]));
+            if (abs(result[i] - expected[i]) > 1e-4 * max(1.0, abs(expected[i])))
+            {
+                setFailed("TFCE with E = " + AString::number(params[p][0]) + ", H = " + AString::number(params[p][1]) + " is " + AString::number(result[i]) +
+                          " at element " + AString::number(i) + ", expected " + AString::number(expected[i]));
+                break;
+            }
+        }
+        if (abs(maxTFCE - expectMax) > 1e-4 * max(1.0, expectMax))
+        {
+            setFailed("max TFCE is " + AString::number(maxTFCE) + ", expected " + AString::number(expectMax));
+        }
+    }
+    vector<float> zeros(numElements, 0.0f), result(numElements, 1.0f);
+    TFCEHelper myTFCE(neighborStart, neighbors, areas, NULL, 1.0f, 2.0f);
+    myTFCE.computeTFCE(zeros.data(), result.data());
+    if (*max_element(result.begin(), result.end()) != 0.0f || *min_element(result.begin(), result.end()) != 0.0f)
+    {
+        setFailed("TFCE of all zero data is not zero");
+    }
+}
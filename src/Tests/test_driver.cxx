@@ -34,17 +34,24 @@
 
 //tests
 #include "CiftiFileTest.h"
+#include "ClusterFindHelperTest.h"
 #include "DotTest.h"
 #include "GeodesicHelperTest.h"
+#include "GzipFileTest.h"
 #include "HttpTest.h"
 #include "HeapTest.h"
 #include "LookupTest.h"
 #include "MathExpressionTest.h"
 #include "NiftiTest.h"
+#include "ParcellateTest.h"
 #include "PointerTest.h"
+#include "PointLocatorTest.h"
 #include "ProgressTest.h"
 #include "QuatTest.h"
+#include "RegressionHelperTest.h"
+#include "SparseFileTest.h"
 #include "StatisticsTest.h"
+#include "TFCEHelperTest.h"
 #include "TimerTest.h"
 #include "TopologyHelperTest.h"
 #include "VolumeFileTest.h"
@@ -70,18 +77,25 @@ int main(int argc, char** argv)
         SessionManager::createSessionManager(ApplicationTypeEnum::APPLICATION_TYPE_COMMAND_LINE);
         vector<TestInterface*> mytests;
         mytests.push_back(new CiftiFileTest("ciftifile"));
+        mytests.push_back(new ClusterFindHelperTest("clusterfind"));
         mytests.push_back(new DotTest("dotsimd"));
         mytests.push_back(new GeodesicHelperTest("geohelp"));
+        mytests.push_back(new GzipFileTest("gzipfile"));
         mytests.push_back(new HeapTest("heap"));
         mytests.push_back(new HttpTest("http"));
         mytests.push_back(new LookupTest("lookup"));
         mytests.push_back(new MathExpressionTest("mathexpression"));
         mytests.push_back(new NiftiFileTest("niftifile"));
         mytests.push_back(new NiftiHeaderTest("niftiheader"));
+        mytests.push_back(new ParcellateTest("parcellate"));
         mytests.push_back(new PointerTest("pointer"));
+        mytests.push_back(new PointLocatorTest("pointlocator"));
         mytests.push_back(new ProgressTest("progress"));
         mytests.push_back(new QuatTest("quaternion"));
+        mytests.push_back(new RegressionHelperTest("regressionhelper"));
+        mytests.push_back(new SparseFileTest("sparsefile"));
         mytests.push_back(new StatisticsTest("statistics"));
+        mytests.push_back(new TFCEHelperTest("tfcehelper"));
         mytests.push_back(new TimerTest("timer"));
         mytests.push_back(new TopologyHelperTest("topohelp"));
         mytests.push_back(new VolumeFileTest("volumefile"));